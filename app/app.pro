@@ -153,6 +153,13 @@ unix:if(!macx|disable-prebuilts) {
             }
         }
     }
+
+    !disable-alsa {
+        packagesExist(alsa) {
+            CONFIG += alsa
+            PKGCONFIG += alsa
+        }
+    }
 }
 win32 {
     LIBS += -llibssl -llibcrypto -lSDL2 -lSDL2_ttf -lavcodec -lavutil -lswscale -lopus -ldxgi -ld3d11 -llibplacebo
@@ -180,8 +187,11 @@ SOURCES += \
     backend/identitymanager.cpp \
     backend/nvcomputer.cpp \
     backend/nvhttp.cpp \
+    backend/nvxmlindex.cpp \
     backend/nvpairingmanager.cpp \
     backend/computermanager.cpp \
+    backend/pollscheduler.cpp \
+    backend/hoststore.cpp \
     backend/boxartmanager.cpp \
     backend/richpresencemanager.cpp \
     cli/commandlineparser.cpp \
@@ -200,12 +210,17 @@ SOURCES += \
     streaming/input/reltouch.cpp \
     streaming/session.cpp \
     streaming/audio/audio.cpp \
+    streaming/audio/audioring.cpp \
+    streaming/audio/jitterbuffer.cpp \
+    streaming/audio/sampleconverter.cpp \
     streaming/audio/renderers/sdlaud.cpp \
     streaming/passthrough/passthroughclient.cpp \
     streaming/passthrough/deviceenumerator.cpp \
     streaming/passthrough/usbipexporter.cpp \
     streaming/passthrough/usbipdaemon.cpp \
     streaming/passthrough/bthidcapture.cpp \
+    streaming/passthrough/simulateddevice.cpp \
+    streaming/passthrough/isostream.cpp \
     gui/computermodel.cpp \
     gui/appmodel.cpp \
     streaming/bandwidth.cpp \
@@ -215,6 +230,7 @@ SOURCES += \
     settings/mappingmanager.cpp \
     gui/sdlgamepadkeynavigation.cpp \
     streaming/video/overlaymanager.cpp \
+    streaming/video/decodercache.cpp \
     backend/systemproperties.cpp \
     wm.cpp
 
@@ -230,8 +246,11 @@ HEADERS += \
     backend/identitymanager.h \
     backend/nvcomputer.h \
     backend/nvhttp.h \
+    backend/nvxmlindex.h \
     backend/nvpairingmanager.h \
     backend/computermanager.h \
+    backend/pollscheduler.h \
+    backend/hoststore.h \
     backend/boxartmanager.h \
     backend/richpresencemanager.h \
     cli/commandlineparser.h \
@@ -242,14 +261,20 @@ HEADERS += \
     settings/gamepadmapping.h \
     streaming/input/input.h \
     streaming/session.h \
+    streaming/audio/audioring.h \
+    streaming/audio/jitterbuffer.h \
+    streaming/audio/sampleconverter.h \
     streaming/audio/renderers/renderer.h \
     streaming/audio/renderers/sdl.h \
     streaming/passthrough/protocol.h \
+    streaming/passthrough/urbtrace.h \
     streaming/passthrough/passthroughclient.h \
     streaming/passthrough/deviceenumerator.h \
     streaming/passthrough/usbipexporter.h \
     streaming/passthrough/usbipdaemon.h \
     streaming/passthrough/bthidcapture.h \
+    streaming/passthrough/simulateddevice.h \
+    streaming/passthrough/isostream.h \
     gui/computermodel.h \
     gui/appmodel.h \
     streaming/video/decoder.h \
@@ -260,6 +285,7 @@ HEADERS += \
     settings/mappingmanager.h \
     gui/sdlgamepadkeynavigation.h \
     streaming/video/overlaymanager.h \
+    streaming/video/decodercache.h \
     backend/systemproperties.h
 
 # Platform-specific renderers and decoders
@@ -369,6 +395,17 @@ libplacebo {
     HEADERS += \
         streaming/video/ffmpeg-renderers/plvk.h
 }
+linux {
+    SOURCES += streaming/input/evdevmouse.cpp
+    HEADERS += streaming/input/evdevmouse.h
+}
+alsa {
+    message(ALSA audio renderer selected)
+
+    DEFINES += HAVE_ALSA
+    SOURCES += streaming/audio/renderers/alsa.cpp
+    HEADERS += streaming/audio/renderers/alsa.h
+}
 config_EGL {
     message(EGL renderer selected)
 
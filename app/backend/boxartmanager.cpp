@@ -1,52 +1,154 @@
 #include "boxartmanager.h"
 #include "../path.h"
 
+#include <QBuffer>
+#include <QDateTime>
+#include <QDirIterator>
 #include <QImageReader>
-#include <QImageWriter>
+#include <QMutex>
+#include <QSaveFile>
+
+// 4 per host is a good balance between fast loading for large
+// app grids and not crushing GFE with tons of requests.
+#define MAX_FETCHES_PER_HOST 4
+#define MAX_CONCURRENT_FETCHES 8
+
+// Least recently used box art is evicted beyond this size
+#define MAX_DISK_CACHE_BYTES (256 * 1024 * 1024)
+
+// Cached box art older than this is refetched in the background
+// the first time it's shown, in case it changed on the host.
+#define REVALIDATE_AFTER_SECS (7 * 24 * 60 * 60)
+
+// In-memory index of the on-disk cache, shared by all BoxArtManager
+// instances so lookups never need to touch the disk.
+struct BoxArtCacheEntry {
+    qint64 size;
+    qint64 lastUsedMs;
+    qint64 modifiedMs;
+    int generation;
+    bool revalidated;
+};
+
+static QMutex s_CacheLock;
+static bool s_CacheIndexed;
+static QHash<QString, BoxArtCacheEntry> s_CacheIndex;
+static qint64 s_CacheBytes;
+static int s_CacheHits;
+static int s_CacheMisses;
+static int s_CacheEvictions;
+
+// Must hold s_CacheLock
+static void indexBoxArtCache()
+{
+    if (s_CacheIndexed) {
+        return;
+    }
+
+    s_CacheIndexed = true;
+
+    // One walk over the cache directory instead of a stat per lookup
+    QDir cacheDir(Path::getBoxArtCacheDir());
+    QDirIterator it(cacheDir.absolutePath(), { "*.png" }, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+
+        QFileInfo info = it.fileInfo();
+        if (info.size() == 0) {
+            continue;
+        }
+
+        BoxArtCacheEntry entry;
+        entry.size = info.size();
+        entry.modifiedMs = info.lastModified().toMSecsSinceEpoch();
+        entry.lastUsedMs = entry.modifiedMs;
+        entry.generation = 0;
+        entry.revalidated = false;
+
+        s_CacheIndex.insert(info.dir().dirName() + "/" + info.completeBaseName(), entry);
+        s_CacheBytes += entry.size;
+    }
+
+    qInfo() << "Indexed" << s_CacheIndex.size() << "box art images totaling" << s_CacheBytes << "bytes";
+}
+
+// Must hold s_CacheLock
+static void evictBoxArt(const QString& keepKey)
+{
+    while (s_CacheBytes > MAX_DISK_CACHE_BYTES) {
+        auto oldest = s_CacheIndex.end();
+        for (auto it = s_CacheIndex.begin(); it != s_CacheIndex.end(); ++it) {
+            if (it.key() != keepKey && (oldest == s_CacheIndex.end() || it->lastUsedMs < oldest->lastUsedMs)) {
+                oldest = it;
+            }
+        }
+
+        if (oldest == s_CacheIndex.end()) {
+            break;
+        }
+
+        QString uuid = oldest.key().section('/', 0, 0);
+        int appId = oldest.key().section('/', 1).toInt();
+        QFile::remove(QDir(Path::getBoxArtCacheDir()).filePath(uuid + "/" + QString::number(appId) + ".png"));
+
+        s_CacheBytes -= oldest->size;
+        s_CacheEvictions++;
+        s_CacheIndex.erase(oldest);
+    }
+}
 
 BoxArtManager::BoxArtManager(QObject *parent) :
     QObject(parent),
-    m_BoxArtDir(Path::getBoxArtCacheDir()),
-    m_ThreadPool(this)
+    m_ThreadPool(this),
+    m_ActiveFetches(0)
 {
-    // 4 is a good balance between fast loading for large
-    // app grids and not crushing GFE with tons of requests
-    // and causing UI jank from constantly stalling to decode
-    // new images.
-    m_ThreadPool.setMaxThreadCount(4);
-    if (!m_BoxArtDir.exists()) {
-        m_BoxArtDir.mkpath(".");
+    m_ThreadPool.setMaxThreadCount(MAX_CONCURRENT_FETCHES);
+
+    QDir boxArtDir(Path::getBoxArtCacheDir());
+    if (!boxArtDir.exists()) {
+        boxArtDir.mkpath(".");
     }
 }
 
-QString
-BoxArtManager::getFilePathForBoxArt(NvComputer* computer, int appId)
+BoxArtManager::~BoxArtManager()
 {
-    QDir dir = m_BoxArtDir;
+    // Let pending saves finish before logging the final numbers
+    m_ThreadPool.waitForDone();
 
-    // Create the cache directory if it did not already exist
-    if (!dir.exists(computer->uuid)) {
-        dir.mkdir(computer->uuid);
-    }
+    QMutexLocker lock(&s_CacheLock);
+    qInfo() << "Box art cache:" << s_CacheHits << "hits," << s_CacheMisses << "misses,"
+            << s_CacheEvictions << "evictions," << s_CacheIndex.size() << "images,"
+            << s_CacheBytes << "bytes";
+}
 
-    // Change to this computer's box art cache folder
-    dir.cd(computer->uuid);
+QString
+BoxArtManager::getFilePathForBoxArt(const QString& uuid, int appId)
+{
+    // The file keeps the .png name for compatibility with existing caches,
+    // but holds whatever format the host sent. Qt sniffs the format on load.
+    return QDir(Path::getBoxArtCacheDir()).filePath(uuid + "/" + QString::number(appId) + ".png");
+}
 
-    // Try to open the cached file
-    return dir.filePath(QString::number(appId) + ".png");
+QString
+BoxArtManager::getCacheKey(NvComputer* computer, int appId)
+{
+    return computer->uuid + "/" + QString::number(appId);
 }
 
-class NetworkBoxArtLoadTask : public QObject, public QRunnable
+// Validates and stores fetched box art off the UI thread. The network request
+// itself is asynchronous and doesn't need a worker.
+class BoxArtSaveTask : public QObject, public QRunnable
 {
     Q_OBJECT
 
 public:
-    NetworkBoxArtLoadTask(BoxArtManager* boxArtManager, NvComputer* computer, NvApp& app)
-        : m_Bam(boxArtManager),
-          m_Computer(computer),
-          m_App(app)
+    BoxArtSaveTask(BoxArtManager* boxArtManager, NvComputer* computer, NvApp& app, QByteArray data, bool revalidate)
+        : m_Computer(computer),
+          m_App(app),
+          m_Data(data),
+          m_Revalidate(revalidate)
     {
-        connect(this, &NetworkBoxArtLoadTask::boxArtFetchCompleted,
+        connect(this, &BoxArtSaveTask::boxArtFetchCompleted,
                 boxArtManager, &BoxArtManager::handleBoxArtLoadComplete);
     }
 
@@ -56,31 +158,62 @@ signals:
 private:
     void run()
     {
-        QUrl image = m_Bam->loadBoxArtFromNetwork(m_Computer, m_App.id);
-        if (image.isEmpty()) {
-            // Give it another shot if it fails once
-            image = m_Bam->loadBoxArtFromNetwork(m_Computer, m_App.id);
-        }
-        emit boxArtFetchCompleted(m_Computer, m_App, image);
+        emit boxArtFetchCompleted(m_Computer, m_App,
+                                  BoxArtManager::storeBoxArt(m_Computer, m_App.id, m_Data, m_Revalidate));
     }
 
-    BoxArtManager* m_Bam;
     NvComputer* m_Computer;
     NvApp m_App;
+    QByteArray m_Data;
+    bool m_Revalidate;
 };
 
 QUrl BoxArtManager::loadBoxArt(NvComputer* computer, NvApp& app)
 {
-    // Try to open the cached file if it exists and contains data
-    QFile cacheFile(getFilePathForBoxArt(computer, app.id));
-    if (cacheFile.exists() && cacheFile.size() > 0) {
-        return QUrl::fromLocalFile(cacheFile.fileName());
+    QString key = getCacheKey(computer, app.id);
+    QUrl url;
+    bool revalidate = false;
+
+    {
+        QMutexLocker lock(&s_CacheLock);
+
+        indexBoxArtCache();
+
+        auto it = s_CacheIndex.find(key);
+        if (it != s_CacheIndex.end()) {
+            qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+            s_CacheHits++;
+            it->lastUsedMs = now;
+
+            url = QUrl::fromLocalFile(getFilePathForBoxArt(computer->uuid, app.id));
+            if (it->generation > 0) {
+                // The image changed since it was first shown, so give it a
+                // new URL to get past the QML image cache.
+                url.setQuery("v=" + QString::number(it->generation));
+            }
+
+            if (!it->revalidated && now - it->modifiedMs > REVALIDATE_AFTER_SECS * 1000LL) {
+                it->revalidated = true;
+                revalidate = true;
+            }
+        }
+        else {
+            s_CacheMisses++;
+        }
+    }
+
+    if (!url.isEmpty()) {
+        if (revalidate) {
+            queueFetch({ computer, app, 0, true, FP_REVALIDATE });
+        }
+        return url;
     }
 
-    // If we get here, we need to fetch asynchronously.
-    // Kick off a worker on our thread pool to do just that.
-    NetworkBoxArtLoadTask* netLoadTask = new NetworkBoxArtLoadTask(this, computer, app);
-    m_ThreadPool.start(netLoadTask);
+    // If we get here, we need to fetch asynchronously. The view asks for
+    // art as tiles are created, so the newest request is the most likely
+    // to be on screen and goes to the front of the queue.
+    queueFetch({ computer, app, 0, false, FP_VISIBLE });
 
     // Return the placeholder then we can notify the caller
     // later when the real image is ready.
@@ -89,6 +222,21 @@ QUrl BoxArtManager::loadBoxArt(NvComputer* computer, NvApp& app)
 
 void BoxArtManager::deleteBoxArt(NvComputer* computer)
 {
+    {
+        QMutexLocker lock(&s_CacheLock);
+
+        QString prefix = computer->uuid + "/";
+        for (auto it = s_CacheIndex.begin(); it != s_CacheIndex.end();) {
+            if (it.key().startsWith(prefix)) {
+                s_CacheBytes -= it->size;
+                it = s_CacheIndex.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+
     QDir dir(Path::getBoxArtCacheDir());
 
     // Delete everything in this computer's box art directory
@@ -99,33 +247,186 @@ void BoxArtManager::deleteBoxArt(NvComputer* computer)
 
 void BoxArtManager::handleBoxArtLoadComplete(NvComputer* computer, NvApp app, QUrl image)
 {
+    m_InFlightKeys.remove(getCacheKey(computer, app.id));
+
     if (!image.isEmpty()) {
         emit boxArtLoadComplete(computer, app, image);
     }
 }
 
-QUrl BoxArtManager::loadBoxArtFromNetwork(NvComputer* computer, int appId)
+void BoxArtManager::cancelBoxArt(NvComputer* computer, int appId)
 {
-    NvHTTP http(computer);
+    QString key = getCacheKey(computer, appId);
+
+    // Fetches already in flight are left to finish, since the art will
+    // likely be wanted again when the user scrolls back.
+    for (int i = 0; i < m_PendingFetches.size(); i++) {
+        if (getCacheKey(m_PendingFetches[i].computer, m_PendingFetches[i].app.id) == key) {
+            m_PendingFetches.removeAt(i);
+            m_InFlightKeys.remove(key);
+            break;
+        }
+    }
+}
+
+void BoxArtManager::queueFetch(BoxArtFetch fetch)
+{
+    QString key = getCacheKey(fetch.computer, fetch.app.id);
+
+    // Only fetch each image once, however many times it's asked for
+    if (m_InFlightKeys.contains(key)) {
+        if (fetch.priority == FP_VISIBLE) {
+            // Requested again by a new tile, so move it to the front if it's still queued
+            for (int i = 0; i < m_PendingFetches.size(); i++) {
+                if (getCacheKey(m_PendingFetches[i].computer, m_PendingFetches[i].app.id) == key) {
+                    BoxArtFetch existing = m_PendingFetches.takeAt(i);
+                    existing.priority = FP_VISIBLE;
+                    m_PendingFetches.prepend(existing);
+                    break;
+                }
+            }
+        }
+        return;
+    }
+    m_InFlightKeys.insert(key);
 
-    QString cachePath = getFilePathForBoxArt(computer, appId);
-    QImage image;
-    try {
-        image = http.getBoxArt(appId);
-    } catch (...) {}
+    if (fetch.priority == FP_VISIBLE) {
+        m_PendingFetches.prepend(fetch);
+    }
+    else {
+        // FIFO behind everything with an equal or higher priority
+        int i = 0;
+        while (i < m_PendingFetches.size() && m_PendingFetches[i].priority <= fetch.priority) {
+            i++;
+        }
+        m_PendingFetches.insert(i, fetch);
+    }
 
-    // Cache the box art on disk if it loaded
-    if (!image.isNull()) {
-        if (image.save(cachePath)) {
-            return QUrl::fromLocalFile(cachePath);
+    startNextFetches();
+}
+
+void BoxArtManager::startNextFetches()
+{
+    for (int i = 0; i < m_PendingFetches.size() && m_ActiveFetches < MAX_CONCURRENT_FETCHES;) {
+        // Skip fetches for hosts that are already at their limit
+        if (m_ActiveFetchesPerHost.value(m_PendingFetches[i].computer->uuid) >= MAX_FETCHES_PER_HOST) {
+            i++;
+            continue;
+        }
+
+        startFetch(m_PendingFetches.takeAt(i));
+    }
+}
+
+void BoxArtManager::startFetch(BoxArtFetch fetch)
+{
+    NvHTTP* http = new NvHTTP(fetch.computer);
+    http->setParent(this);
+
+    QString uuid = fetch.computer->uuid;
+    m_ActiveFetches++;
+    m_ActiveFetchesPerHost[uuid]++;
+    fetch.attempts++;
+
+    http->getBoxArtAsync(fetch.app.id, [this, http, fetch, uuid](const NvHttpResult& result) mutable {
+        http->deleteLater();
+        m_ActiveFetches--;
+        if (--m_ActiveFetchesPerHost[uuid] == 0) {
+            m_ActiveFetchesPerHost.remove(uuid);
+        }
+
+        QString key = getCacheKey(fetch.computer, fetch.app.id);
+        if (result.ok() && !result.data.isEmpty()) {
+            // Validating and writing the image can take a while, so keep it off our thread
+            m_ThreadPool.start(new BoxArtSaveTask(this, fetch.computer, fetch.app, result.data, fetch.revalidate));
+        }
+        else if (fetch.attempts < 2) {
+            // Give it another shot if it fails once, but behind the visible
+            // requests rather than immediately.
+            m_InFlightKeys.remove(key);
+            fetch.priority = fetch.revalidate ? FP_REVALIDATE : FP_RETRY;
+            queueFetch(fetch);
+            return;
         }
         else {
-            // A failed save() may leave a zero byte file. Make sure that's removed.
-            QFile(cachePath).remove();
+            m_InFlightKeys.remove(key);
+        }
+
+        startNextFetches();
+    });
+}
+
+QUrl BoxArtManager::storeBoxArt(NvComputer* computer, int appId, const QByteArray& data, bool revalidate)
+{
+    QString cachePath = getFilePathForBoxArt(computer->uuid, appId);
+
+    // Check the image header without paying for a full decode,
+    // since QML will decode it again anyway.
+    {
+        QBuffer buffer(const_cast<QByteArray*>(&data));
+        QImageReader reader(&buffer);
+        if (!reader.canRead() || !reader.size().isValid()) {
+            qWarning() << "Received invalid box art for app" << appId;
+            return QUrl();
         }
     }
 
-    return QUrl();
+    if (revalidate) {
+        // setFileTime() needs an open file with write access
+        QFile existingFile(cachePath);
+        if (existingFile.open(QIODevice::ReadWrite) && existingFile.readAll() == data) {
+            // Unchanged, so just reset the revalidation clock
+            QDateTime now = QDateTime::currentDateTime();
+            if (!existingFile.setFileTime(now, QFileDevice::FileModificationTime)) {
+                qWarning() << "Failed to update modification time of" << cachePath << ":" << existingFile.errorString();
+                return QUrl();
+            }
+            existingFile.close();
+
+            // Keep the index in sync with the file
+            QMutexLocker lock(&s_CacheLock);
+            auto it = s_CacheIndex.find(getCacheKey(computer, appId));
+            if (it != s_CacheIndex.end()) {
+                it->modifiedMs = now.toMSecsSinceEpoch();
+            }
+
+            return QUrl();
+        }
+    }
+
+    QDir().mkpath(QFileInfo(cachePath).absolutePath());
+
+    // Store the host's original bytes rather than re-encoding them
+    QSaveFile file(cachePath);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+        qWarning() << "Failed to save box art to" << cachePath;
+        return QUrl();
+    }
+
+    QUrl url = QUrl::fromLocalFile(cachePath);
+    QString key = getCacheKey(computer, appId);
+
+    QMutexLocker lock(&s_CacheLock);
+
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    BoxArtCacheEntry& entry = s_CacheIndex[key];
+    if (entry.size > 0) {
+        s_CacheBytes -= entry.size;
+        entry.generation++;
+        url.setQuery("v=" + QString::number(entry.generation));
+    }
+    else {
+        entry.generation = 0;
+    }
+    entry.size = data.size();
+    entry.lastUsedMs = now;
+    entry.modifiedMs = now;
+    entry.revalidated = true;
+    s_CacheBytes += entry.size;
+
+    evictBoxArt(key);
+
+    return url;
 }
 
 #include "boxartmanager.moc"
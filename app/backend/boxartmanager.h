@@ -1,23 +1,30 @@
 #pragma once
 
-#include "computermanager.h"
+#include "nvcomputer.h"
 #include <QDir>
 #include <QImage>
 #include <QThreadPool>
 #include <QRunnable>
+#include <QSet>
 
 class BoxArtManager : public QObject
 {
     Q_OBJECT
 
-    friend class NetworkBoxArtLoadTask;
+    friend class BoxArtSaveTask;
 
 public:
     explicit BoxArtManager(QObject *parent = nullptr);
 
+    virtual ~BoxArtManager();
+
     QUrl
     loadBoxArt(NvComputer* computer, NvApp& app);
 
+    // Drops a queued fetch for art that's no longer on screen
+    void
+    cancelBoxArt(NvComputer* computer, int appId);
+
     static
     void
     deleteBoxArt(NvComputer* computer);
@@ -33,12 +40,45 @@ private slots:
     handleBoxArtLoadComplete(NvComputer* computer, NvApp app, QUrl image);
 
 private:
+    // Lower values are fetched first
+    enum FetchPriority {
+        FP_VISIBLE,
+        FP_RETRY,
+        FP_REVALIDATE,
+    };
+
+    struct BoxArtFetch {
+        NvComputer* computer;
+        NvApp app;
+        int attempts;
+        bool revalidate;
+        FetchPriority priority;
+    };
+
+    void
+    queueFetch(BoxArtFetch fetch);
+
+    void
+    startNextFetches();
+
+    void
+    startFetch(BoxArtFetch fetch);
+
+    static
     QUrl
-    loadBoxArtFromNetwork(NvComputer* computer, int appId);
+    storeBoxArt(NvComputer* computer, int appId, const QByteArray& data, bool revalidate);
 
+    static
+    QString
+    getFilePathForBoxArt(const QString& uuid, int appId);
+
+    static
     QString
-    getFilePathForBoxArt(NvComputer* computer, int appId);
+    getCacheKey(NvComputer* computer, int appId);
 
-    QDir m_BoxArtDir;
     QThreadPool m_ThreadPool;
+    QList<BoxArtFetch> m_PendingFetches;
+    QSet<QString> m_InFlightKeys; // Queued or in flight
+    QHash<QString, int> m_ActiveFetchesPerHost;
+    int m_ActiveFetches;
 };
@@ -2,6 +2,7 @@
 #include "boxartmanager.h"
 #include "nvhttp.h"
 #include "nvpairingmanager.h"
+#include "hoststore.h"
 
 #include <Limelight.h>
 #include <QtEndian>
@@ -10,188 +11,43 @@
 #include <QThreadPool>
 #include <QCoreApplication>
 #include <QRandomGenerator>
+#include <QElapsedTimer>
 
-#define SER_HOSTS "hosts"
-#define SER_HOSTS_BACKUP "hostsbackup"
-
-class PcMonitorThread : public QThread
-{
-    Q_OBJECT
-
-#define TRIES_BEFORE_OFFLINING 2
-#define POLLS_PER_APPLIST_FETCH 10
-
-public:
-    PcMonitorThread(NvComputer* computer)
-        : m_Computer(computer)
-    {
-        setObjectName("Polling thread for " + computer->name);
-    }
-
-private:
-    bool tryPollComputer(QNetworkAccessManager* nam, NvAddress address, bool& changed)
-    {
-        NvHTTP http(address, 0, m_Computer->serverCert, nam);
-
-        QString serverInfo;
-        try {
-            serverInfo = http.getServerInfo(NvHTTP::NvLogLevel::NVLL_NONE, true);
-        } catch (...) {
-            return false;
-        }
-
-        NvComputer newState(http, serverInfo);
-
-        // Ensure the machine that responded is the one we intended to contact
-        if (m_Computer->uuid != newState.uuid) {
-            qInfo() << "Found unexpected PC" << newState.name << "looking for" << m_Computer->name;
-            return false;
-        }
-
-        changed = m_Computer->update(newState);
-        return true;
-    }
-
-    bool updateAppList(QNetworkAccessManager* nam, bool& changed)
-    {
-        NvHTTP http(m_Computer, nam);
-
-        QVector<NvApp> appList;
-
-        try {
-            appList = http.getAppList();
-            if (appList.isEmpty()) {
-                return false;
-            }
-        } catch (...) {
-            return false;
-        }
-
-        QWriteLocker lock(&m_Computer->lock);
-        changed = m_Computer->updateAppList(appList);
-        return true;
-    }
-
-    void run() override
-    {
-        // Reduce the power and performance impact of our
-        // computer status polling while it's running.
-        setPriority(QThread::LowPriority);
-#if QT_VERSION >= QT_VERSION_CHECK(6, 9, 0)
-        setServiceLevel(QThread::QualityOfService::Eco);
-#endif
-
-        // Share the QNetworkAccessManager to conserve resources when polling.
-        // Each instance creates a worker thread, so sharing them ensures that
-        // we are not spamming a new thread for every single polling attempt.
-        //
-        // Since QThread inherit the priority of the current thread, this also
-        // ensures that the NAM's worker thread will inherit our lower priority.
-        QNetworkAccessManager nam;
-
-        // Always fetch the applist the first time
-        int pollsSinceLastAppListFetch = POLLS_PER_APPLIST_FETCH;
-        while (!isInterruptionRequested()) {
-            bool stateChanged = false;
-            bool online = false;
-            bool wasOnline = m_Computer->state == NvComputer::CS_ONLINE;
-            for (int i = 0; i < (wasOnline ? TRIES_BEFORE_OFFLINING : 1) && !online; i++) {
-                for (auto& address : m_Computer->uniqueAddresses()) {
-                    if (isInterruptionRequested()) {
-                        return;
-                    }
-
-                    if (tryPollComputer(&nam, address, stateChanged)) {
-                        if (!wasOnline) {
-                            qInfo() << m_Computer->name << "is now online at" << m_Computer->activeAddress.toString();
-                        }
-                        online = true;
-                        break;
-                    }
-                }
-            }
-
-            // Check if we failed after all retry attempts
-            // Note: we don't need to acquire the read lock here,
-            // because we're on the writing thread.
-            if (!online && m_Computer->state != NvComputer::CS_OFFLINE) {
-                qInfo() << m_Computer->name << "is now offline";
-                m_Computer->state = NvComputer::CS_OFFLINE;
-                stateChanged = true;
-            }
-
-            // Grab the applist if it's empty or it's been long enough that we need to refresh
-            pollsSinceLastAppListFetch++;
-            if (m_Computer->state == NvComputer::CS_ONLINE &&
-                    m_Computer->pairState == NvComputer::PS_PAIRED &&
-                    (m_Computer->appList.isEmpty() || pollsSinceLastAppListFetch >= POLLS_PER_APPLIST_FETCH)) {
-                // Notify prior to the app list poll since it may take a while, and we don't
-                // want to delay onlining of a machine, especially if we already have a cached list.
-                if (stateChanged) {
-                    emit computerStateChanged(m_Computer);
-                    stateChanged = false;
-                }
-
-                if (updateAppList(&nam, stateChanged)) {
-                    pollsSinceLastAppListFetch = 0;
-                }
-            }
-
-            if (stateChanged) {
-                // Tell anyone listening that we've changed state
-                emit computerStateChanged(m_Computer);
-            }
-
-            // Wait a bit to poll again, but do it in 100 ms chunks
-            // so we can be interrupted reasonably quickly.
-            // FIXME: QWaitCondition would be better.
-            for (int i = 0; i < 30 && !isInterruptionRequested(); i++) {
-                QThread::msleep(100);
-            }
-        }
-    }
-
-signals:
-   void computerStateChanged(NvComputer* computer);
-
-private:
-    NvComputer* m_Computer;
-};
 
 ComputerManager::ComputerManager(StreamingPreferences* prefs)
     : m_Prefs(prefs),
       m_PollingRef(0),
+      m_PollScheduler(new PollScheduler(this)),
       m_MdnsBrowser(nullptr),
       m_CompatFetcher(nullptr),
-      m_NeedsDelayedFlush(false)
+      m_NeedsDelayedFlush(false),
+      m_NeedsLegacyHostRemoval(false)
 {
-    QSettings settings;
-
-    // If there's a hosts backup copy, we must have failed to commit
-    // a previous update before exiting. Restore the backup now.
-    int hosts = settings.beginReadArray(SER_HOSTS_BACKUP);
-    if (hosts == 0) {
-        // If there's no host backup, read from the primary location.
-        settings.endArray();
-        hosts = settings.beginReadArray(SER_HOSTS);
-    }
-
-    // Inflate our hosts from QSettings
-    for (int i = 0; i < hosts; i++) {
-        settings.setArrayIndex(i);
-        NvComputer* computer = new NvComputer(settings);
+    // Inflate our hosts from the host store
+    bool migrated;
+    for (NvComputer* computer : HostStore::load(migrated)) {
         m_KnownHosts[computer->uuid] = computer;
-        m_LastSerializedHosts[computer->uuid] = *computer;
+        if (!migrated) {
+            m_LastSerializedHosts[computer->uuid] = computer->serializedDigest();
+        }
     }
-    settings.endArray();
+    m_NeedsLegacyHostRemoval = migrated;
 
     // Fetch latest compatibility data asynchronously
     m_CompatFetcher.start();
 
+    connect(m_PollScheduler, &PollScheduler::computerStateChanged,
+            this, &ComputerManager::handleComputerStateChanged);
+
     // Start the delayed flush thread to handle saveHosts() calls
     m_DelayedFlushThread = new DelayedFlushThread(this);
     m_DelayedFlushThread->start();
 
+    // Write out any hosts we migrated from the legacy storage
+    if (migrated) {
+        saveHosts();
+    }
+
     // To quit in a timely manner, we must block additional requests
     // after we receive the aboutToQuit() signal. This is necessary
     // because NvHTTP uses aboutToQuit() to abort requests in progress
@@ -235,7 +91,7 @@ ComputerManager::~ComputerManager()
         entry->interrupt();
     }
 
-    // Delete all polling entries (and associated threads)
+    // Delete all polling entries
     for (ComputerPollingEntry* entry : m_PollEntries) {
         delete entry;
     }
@@ -248,6 +104,8 @@ ComputerManager::~ComputerManager()
 
 void DelayedFlushThread::run() {
     for (;;) {
+        QHash<QString, QByteArray> lastSerializedHosts;
+
         // Wait for a delayed flush request or an interruption
         {
             QMutexLocker locker(&m_ComputerManager->m_DelayedFlushMutex);
@@ -266,47 +124,67 @@ void DelayedFlushThread::run() {
             // Reset the delayed flush flag to ensure any racing saveHosts() call will set it again
             m_ComputerManager->m_NeedsDelayedFlush = false;
 
-            // Update the last serialized hosts map under the delayed flush mutex
-            m_ComputerManager->m_LastSerializedHosts.clear();
-            for (const NvComputer* computer : m_ComputerManager->m_KnownHosts) {
-                // Copy the current state of the NvComputer to allow us to check later if we need
-                // to serialize it again when attribute updates occur.
-                QReadLocker computerLock(&computer->lock);
-                m_ComputerManager->m_LastSerializedHosts[computer->uuid] = *computer;
-            }
+            lastSerializedHosts = m_ComputerManager->m_LastSerializedHosts;
         }
 
-        // Perform the flush
+        // Perform the flush, writing only hosts whose serialized form has changed
+        QElapsedTimer flushTimer;
+        flushTimer.start();
+
+        QHash<QString, QByteArray> savedHosts;
+        QStringList removedHosts;
+        qint64 bytesWritten = 0;
+        bool failed = false;
+        int hostCount;
         {
-            QSettings settings;
+            QReadLocker lock(&m_ComputerManager->m_Lock);
 
-            // First, write to the backup location
-            settings.beginWriteArray(SER_HOSTS_BACKUP);
-            {
-                QReadLocker lock(&m_ComputerManager->m_Lock);
-                int i = 0;
-                for (const NvComputer* computer : m_ComputerManager->m_KnownHosts) {
-                    settings.setArrayIndex(i++);
-                    computer->serialize(settings, false);
+            hostCount = m_ComputerManager->m_KnownHosts.size();
+            for (const NvComputer* computer : m_ComputerManager->m_KnownHosts) {
+                QByteArray digest = computer->serializedDigest();
+                if (lastSerializedHosts.value(computer->uuid) == digest) {
+                    continue;
                 }
+
+                qint64 bytes = HostStore::save(computer);
+                if (bytes < 0) {
+                    failed = true;
+                    continue;
+                }
+
+                bytesWritten += bytes;
+                savedHosts[computer->uuid] = digest;
             }
-            settings.endArray();
 
-            // Next, write to the primary location
-            settings.remove(SER_HOSTS);
-            settings.beginWriteArray(SER_HOSTS);
-            {
-                QReadLocker lock(&m_ComputerManager->m_Lock);
-                int i = 0;
-                for (const NvComputer* computer : m_ComputerManager->m_KnownHosts) {
-                    settings.setArrayIndex(i++);
-                    computer->serialize(settings, true);
+            for (auto it = lastSerializedHosts.constBegin(); it != lastSerializedHosts.constEnd(); ++it) {
+                if (!m_ComputerManager->m_KnownHosts.contains(it.key())) {
+                    HostStore::remove(it.key());
+                    removedHosts.append(it.key());
                 }
             }
-            settings.endArray();
+        }
+
+        {
+            QMutexLocker locker(&m_ComputerManager->m_DelayedFlushMutex);
+
+            for (auto it = savedHosts.constBegin(); it != savedHosts.constEnd(); ++it) {
+                m_ComputerManager->m_LastSerializedHosts[it.key()] = it.value();
+            }
+            for (const QString& uuid : removedHosts) {
+                m_ComputerManager->m_LastSerializedHosts.remove(uuid);
+            }
+        }
 
-            // Finally, delete the backup copy
-            settings.remove(SER_HOSTS_BACKUP);
+        // Drop the legacy host array only once every host has a file
+        if (m_ComputerManager->m_NeedsLegacyHostRemoval && !failed &&
+                HostStore::removeLegacyHosts()) {
+            m_ComputerManager->m_NeedsLegacyHostRemoval = false;
+        }
+
+        if (!savedHosts.isEmpty() || !removedHosts.isEmpty()) {
+            qInfo() << "Saved" << savedHosts.size() << "of" << hostCount << "hosts"
+                    << "(" << bytesWritten << "bytes ) and removed" << removedHosts.size()
+                    << "in" << flushTimer.elapsed() << "ms";
         }
     }
 }
@@ -315,8 +193,8 @@ void ComputerManager::saveHosts()
 {
     Q_ASSERT(m_DelayedFlushThread != nullptr && m_DelayedFlushThread->isRunning());
 
-    // Punt to a worker thread because QSettings on macOS can take ages (> 500 ms)
-    // to persist our host list to disk (especially when a host has a bunch of apps).
+    // Punt to a worker thread because writing hosts with a bunch of apps can
+    // still take a while, and we don't want to block the caller on disk I/O.
     QMutexLocker locker(&m_DelayedFlushMutex);
     m_NeedsDelayedFlush = true;
     m_DelayedFlushCondition.wakeOne();
@@ -384,7 +262,7 @@ void ComputerManager::startPolling()
         qWarning() << "mDNS is disabled by user preference";
     }
 
-    // Start polling threads for each known host
+    // Start polling monitors for each known host
     QMapIterator<QString, NvComputer*> i(m_KnownHosts);
     while (i.hasNext()) {
         i.next();
@@ -402,18 +280,14 @@ void ComputerManager::startPollingComputer(NvComputer* computer)
     ComputerPollingEntry* pollingEntry;
 
     if (!m_PollEntries.contains(computer->uuid)) {
-        pollingEntry = m_PollEntries[computer->uuid] = new ComputerPollingEntry();
+        pollingEntry = m_PollEntries[computer->uuid] = new ComputerPollingEntry(m_PollScheduler, computer);
     }
     else {
         pollingEntry = m_PollEntries[computer->uuid];
     }
 
     if (!pollingEntry->isActive()) {
-        PcMonitorThread* thread = new PcMonitorThread(computer);
-        connect(thread, &PcMonitorThread::computerStateChanged,
-                this, &ComputerManager::handleComputerStateChanged);
-        pollingEntry->setActiveThread(thread);
-        thread->start();
+        pollingEntry->start();
     }
 }
 
@@ -458,11 +332,10 @@ void ComputerManager::handleMdnsServiceResolved(MdnsPendingComputer* computer,
 void ComputerManager::saveHost(NvComputer *computer)
 {
     // If no serializable properties changed, don't bother saving hosts
+    QByteArray digest = computer->serializedDigest();
     QMutexLocker lock(&m_DelayedFlushMutex);
-    QReadLocker computerLock(&computer->lock);
-    if (!m_LastSerializedHosts.value(computer->uuid).isEqualSerialized(*computer)) {
-        // Queue a request for a delayed flush to QSettings outside of the lock
-        computerLock.unlock();
+    if (m_LastSerializedHosts.value(computer->uuid) != digest) {
+        // Queue a request for a delayed flush outside of the lock
         lock.unlock();
         saveHosts();
     }
@@ -517,14 +390,14 @@ public:
         // Persist the new host list with this computer deleted
         m_ComputerManager->saveHosts();
 
-        // Delete the polling entry first. This will stop all polling threads too.
+        // Delete the polling entry first. This will stop polling too.
         delete pollingEntry;
 
         // Delete cached box art
         BoxArtManager::deleteBoxArt(m_Computer);
 
         // Finally, delete the computer itself. This must be done
-        // last because the polling thread might be using it.
+        // last because the polling monitor might be using it.
         delete m_Computer;
     }
 
@@ -559,12 +432,17 @@ void ComputerManager::clientSideAttributeUpdated(NvComputer* computer)
     handleComputerStateChanged(computer);
 }
 
+void ComputerManager::setFocusedComputer(NvComputer* computer, QObject* owner)
+{
+    m_PollScheduler->setFocusedComputer(computer, owner);
+}
+
 void ComputerManager::handleAboutToQuit()
 {
     QReadLocker lock(&m_Lock);
 
-    // Interrupt polling threads immediately, so they
-    // avoid making additional requests while quitting
+    // Stop polling immediately, so we avoid
+    // making additional requests while quitting
     for (ComputerPollingEntry* entry : m_PollEntries) {
         entry->interrupt();
     }
@@ -716,7 +594,7 @@ void ComputerManager::stopPollingAsync()
     m_MdnsBrowser = nullptr;
     m_MdnsServer.reset();
 
-    // Interrupt all threads, but don't wait for them to terminate
+    // Stop all polling monitors
     for (ComputerPollingEntry* entry : m_PollEntries) {
         entry->interrupt();
     }
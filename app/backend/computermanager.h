@@ -1,6 +1,7 @@
 #pragma once
 
 #include "nvcomputer.h"
+#include "pollscheduler.h"
 #include "settings/streamingpreferences.h"
 #include "settings/compatfetcher.h"
 
@@ -138,8 +139,10 @@ private:
 class ComputerPollingEntry
 {
 public:
-    ComputerPollingEntry()
-        : m_ActiveThread(nullptr)
+    ComputerPollingEntry(PollScheduler* scheduler, NvComputer* computer)
+        : m_Scheduler(scheduler),
+          m_Computer(computer),
+          m_Active(false)
     {
 
     }
@@ -147,65 +150,33 @@ public:
     virtual ~ComputerPollingEntry()
     {
         interrupt();
-
-        // interrupt() should have taken care of this
-        Q_ASSERT(m_ActiveThread == nullptr);
-
-        for (QThread* thread : m_InactiveList) {
-            thread->wait();
-            delete thread;
-        }
     }
 
     bool isActive()
     {
-        cleanInactiveList();
-
-        return m_ActiveThread != nullptr;
+        return m_Active;
     }
 
-    void setActiveThread(QThread* thread)
+    void start()
     {
-        cleanInactiveList();
-
         Q_ASSERT(!isActive());
-        m_ActiveThread = thread;
+        m_Active = true;
+        m_Scheduler->addComputer(m_Computer);
     }
 
     void interrupt()
     {
-        cleanInactiveList();
-
-        if (m_ActiveThread != nullptr) {
-            // Interrupt the active thread
-            m_ActiveThread->requestInterruption();
-
-            // Place it on the inactive list awaiting death
-            m_InactiveList.append(m_ActiveThread);
-
-            m_ActiveThread = nullptr;
+        if (m_Active) {
+            // Returns once no request for this computer is in flight
+            m_Scheduler->removeComputer(m_Computer);
+            m_Active = false;
         }
     }
 
 private:
-    void cleanInactiveList()
-    {
-        QMutableListIterator<QThread*> i(m_InactiveList);
-
-        // Reap any threads that have finished
-        while (i.hasNext()) {
-            i.next();
-
-            QThread* thread = i.value();
-            if (thread->isFinished()) {
-                delete thread;
-                i.remove();
-            }
-        }
-    }
-
-    QThread* m_ActiveThread;
-    QList<QThread*> m_InactiveList;
+    PollScheduler* m_Scheduler;
+    NvComputer* m_Computer;
+    bool m_Active;
 };
 
 class ComputerManager : public QObject
@@ -245,6 +216,9 @@ public:
 
     void clientSideAttributeUpdated(NvComputer* computer);
 
+    // Polls this computer more frequently while owner is alive
+    void setFocusedComputer(NvComputer* computer, QObject* owner);
+
 signals:
     void computerStateChanged(NvComputer* computer);
 
@@ -275,7 +249,8 @@ private:
     QReadWriteLock m_Lock;
     QMap<QString, NvComputer*> m_KnownHosts;
     QMap<QString, ComputerPollingEntry*> m_PollEntries;
-    QHash<QString, NvComputer> m_LastSerializedHosts; // Protected by m_DelayedFlushMutex
+    PollScheduler* m_PollScheduler;
+    QHash<QString, QByteArray> m_LastSerializedHosts; // Serialized digests, protected by m_DelayedFlushMutex
     QSharedPointer<QMdnsEngine::Server> m_MdnsServer;
     QMdnsEngine::Browser* m_MdnsBrowser;
     QVector<MdnsPendingComputer*> m_PendingResolution;
@@ -284,4 +259,5 @@ private:
     QMutex m_DelayedFlushMutex; // Lock ordering: Must never be acquired while holding NvComputer lock
     QWaitCondition m_DelayedFlushCondition;
     bool m_NeedsDelayedFlush;
+    bool m_NeedsLegacyHostRemoval; // Only accessed by DelayedFlushThread after construction
 };
@@ -0,0 +1,136 @@
+#include "hoststore.h"
+#include "path.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QRegularExpression>
+
+#define SER_HOSTS "hosts"
+#define SER_HOSTS_BACKUP "hostsbackup"
+
+#define HOST_FILE_SUFFIX ".ini"
+
+// Written once every legacy host has its own file
+#define MIGRATION_MARKER "migrated"
+
+QString HostStore::getFilePath(const QString& uuid)
+{
+    // Host UUIDs come from the network, so don't trust them as file names
+    static const QRegularExpression safeName("^[A-Za-z0-9-]+$");
+
+    QString fileName = safeName.match(uuid).hasMatch() ? uuid : QString::fromLatin1(uuid.toUtf8().toHex());
+    return QDir(Path::getHostStoreDir()).absoluteFilePath(fileName + HOST_FILE_SUFFIX);
+}
+
+QString HostStore::getMigrationMarkerPath()
+{
+    return QDir(Path::getHostStoreDir()).absoluteFilePath(MIGRATION_MARKER);
+}
+
+QVector<NvComputer*> HostStore::load(bool& migrated)
+{
+    QVector<NvComputer*> computers;
+    QDir dir(Path::getHostStoreDir());
+
+    migrated = false;
+
+    QSettings legacySettings;
+
+    // If there's a hosts backup copy, we must have failed to commit
+    // a previous update before exiting. Restore the backup now.
+    const char* legacyArray = SER_HOSTS_BACKUP;
+    int legacyHosts = legacySettings.beginReadArray(legacyArray);
+    legacySettings.endArray();
+    if (legacyHosts == 0) {
+        // If there's no host backup, read from the primary location.
+        legacyArray = SER_HOSTS;
+        legacyHosts = legacySettings.beginReadArray(legacyArray);
+        legacySettings.endArray();
+    }
+
+    if (legacyHosts > 0) {
+        if (!QFile::exists(getMigrationMarkerPath())) {
+            // Any host files are from a migration that was interrupted
+            // before every host was written, so the legacy array is still
+            // the complete copy. Migrate it (again) from the start.
+            legacySettings.beginReadArray(legacyArray);
+            for (int i = 0; i < legacyHosts; i++) {
+                legacySettings.setArrayIndex(i);
+                computers.append(new NvComputer(legacySettings));
+            }
+            legacySettings.endArray();
+
+            qInfo() << "Migrating" << computers.size() << "hosts to" << dir.absolutePath();
+            migrated = true;
+            return computers;
+        }
+
+        // The migration finished but we exited before dropping the array
+        removeLegacyHosts();
+    }
+
+    for (const QFileInfo& file : dir.entryInfoList({ "*" HOST_FILE_SUFFIX }, QDir::Files)) {
+        QSettings settings(file.absoluteFilePath(), QSettings::IniFormat);
+        if (settings.status() != QSettings::NoError) {
+            qWarning() << "Failed to read host file" << file.absoluteFilePath();
+            continue;
+        }
+
+        NvComputer* computer = new NvComputer(settings);
+        if (computer->uuid.isEmpty()) {
+            qWarning() << "Ignoring invalid host file" << file.absoluteFilePath();
+            delete computer;
+            continue;
+        }
+
+        computers.append(computer);
+    }
+
+    return computers;
+}
+
+qint64 HostStore::save(const NvComputer* computer)
+{
+    QDir dir(Path::getHostStoreDir());
+    if (!dir.exists()) {
+        dir.mkpath(".");
+    }
+
+    QString filePath = getFilePath(computer->uuid);
+
+    {
+        QSettings settings(filePath, QSettings::IniFormat);
+        computer->serialize(settings, true);
+
+        // Commits atomically via QSaveFile
+        settings.sync();
+        if (settings.status() != QSettings::NoError) {
+            qWarning() << "Failed to save host file" << filePath;
+            return -1;
+        }
+    }
+
+    return QFileInfo(filePath).size();
+}
+
+void HostStore::remove(const QString& uuid)
+{
+    QFile::remove(getFilePath(uuid));
+}
+
+bool HostStore::removeLegacyHosts()
+{
+    // The marker must be durable before the legacy copy goes away
+    QSaveFile marker(getMigrationMarkerPath());
+    if (!marker.open(QIODevice::WriteOnly) || !marker.commit()) {
+        qWarning() << "Failed to write host migration marker" << marker.fileName();
+        return false;
+    }
+
+    QSettings settings;
+
+    settings.remove(SER_HOSTS);
+    settings.remove(SER_HOSTS_BACKUP);
+    return true;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "nvcomputer.h"
+
+#include <QVector>
+
+// Persists each host in its own INI file under Path::getHostStoreDir().
+//
+// Saving a host only rewrites that host's file, and QSettings commits INI
+// files through a temporary file and rename, so a crash mid-write leaves
+// the previous copy intact. This replaces the single "hosts" QSettings
+// array that had to be rewritten (twice, via a backup copy) on any change.
+class HostStore
+{
+public:
+    // Loads all stored hosts. Until a migration has completed, hosts are
+    // imported from the legacy QSettings array instead and migrated is set,
+    // so the caller can write them out and then call removeLegacyHosts().
+    static QVector<NvComputer*> load(bool& migrated);
+
+    // Returns the number of bytes written, or -1 on failure
+    static qint64 save(const NvComputer* computer);
+
+    static void remove(const QString& uuid);
+
+    // Marks the migration complete, then drops the legacy array.
+    // Returns false if the marker couldn't be written.
+    static bool removeLegacyHosts();
+
+private:
+    static QString getFilePath(const QString& uuid);
+
+    static QString getMigrationMarkerPath();
+};
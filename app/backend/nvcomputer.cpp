@@ -6,6 +6,8 @@
 #include <QHostInfo>
 #include <QNetworkInterface>
 #include <QNetworkProxy>
+#include <QCryptographicHash>
+#include <QDataStream>
 
 #define SER_NAME "hostname"
 #define SER_UUID "uuid"
@@ -105,19 +107,26 @@ void NvComputer::serialize(QSettings& settings, bool serializeApps) const
     }
 }
 
-bool NvComputer::isEqualSerialized(const NvComputer &that) const
+QByteArray NvComputer::serializedDigest() const
 {
-    return this->name == that.name &&
-           this->hasCustomName == that.hasCustomName &&
-           this->uuid == that.uuid &&
-           this->macAddress == that.macAddress &&
-           this->localAddress == that.localAddress &&
-           this->remoteAddress == that.remoteAddress &&
-           this->ipv6Address == that.ipv6Address &&
-           this->manualAddress == that.manualAddress &&
-           this->serverCert == that.serverCert &&
-           this->isNvidiaServerSoftware == that.isNvidiaServerSoftware &&
-           this->appList == that.appList;
+    QReadLocker lock(&this->lock);
+
+    QByteArray buffer;
+    QDataStream stream(&buffer, QIODevice::WriteOnly);
+
+    stream << name << hasCustomName << uuid << macAddress
+           << localAddress.address() << localAddress.port()
+           << remoteAddress.address() << remoteAddress.port()
+           << ipv6Address.address() << ipv6Address.port()
+           << manualAddress.address() << manualAddress.port()
+           << serverCert.toPem() << isNvidiaServerSoftware;
+
+    for (const NvApp& app : appList) {
+        stream << app.name << app.id << app.hdrSupported << app.isAppCollectorGame
+               << app.hidden << app.directLaunch;
+    }
+
+    return QCryptographicHash::hash(buffer, QCryptographicHash::Sha1);
 }
 
 void NvComputer::sortAppList()
@@ -129,16 +138,19 @@ void NvComputer::sortAppList()
 
 NvComputer::NvComputer(NvHTTP& http, QString serverInfo)
 {
+    // Parse the response once instead of rescanning it for each tag
+    NvXmlIndex serverInfoIndex(serverInfo);
+
     this->serverCert = http.serverCert();
 
     this->hasCustomName = false;
-    this->name = NvHTTP::getXmlString(serverInfo, "hostname");
+    this->name = serverInfoIndex.value("hostname");
     if (this->name.isEmpty()) {
         this->name = "UNKNOWN";
     }
 
-    this->uuid = NvHTTP::getXmlString(serverInfo, "uniqueid");
-    QString newMacString = NvHTTP::getXmlString(serverInfo, "mac");
+    this->uuid = serverInfoIndex.value("uniqueid");
+    QString newMacString = serverInfoIndex.value("mac");
     if (newMacString != "00:00:00:00:00:00") {
         QStringList macOctets = newMacString.split(':');
         for (const QString& macOctet : macOctets) {
@@ -146,7 +158,7 @@ NvComputer::NvComputer(NvHTTP& http, QString serverInfo)
         }
     }
 
-    QString codecSupport = NvHTTP::getXmlString(serverInfo, "ServerCodecModeSupport");
+    QString codecSupport = serverInfoIndex.value("ServerCodecModeSupport");
     if (!codecSupport.isEmpty()) {
         this->serverCodecModeSupport = codecSupport.toInt();
     }
@@ -155,7 +167,7 @@ NvComputer::NvComputer(NvHTTP& http, QString serverInfo)
         this->serverCodecModeSupport = SCM_H264;
     }
 
-    QString maxLumaPixelsHEVC = NvHTTP::getXmlString(serverInfo, "MaxLumaPixelsHEVC");
+    QString maxLumaPixelsHEVC = serverInfoIndex.value("MaxLumaPixelsHEVC");
     if (!maxLumaPixelsHEVC.isEmpty()) {
         this->maxLumaPixelsHEVC = maxLumaPixelsHEVC.toInt();
     }
@@ -163,7 +175,7 @@ NvComputer::NvComputer(NvHTTP& http, QString serverInfo)
         this->maxLumaPixelsHEVC = 0;
     }
 
-    this->displayModes = NvHTTP::getDisplayModeList(serverInfo);
+    this->displayModes = NvHTTP::getDisplayModeList(serverInfoIndex);
     std::stable_sort(this->displayModes.begin(), this->displayModes.end(),
                      [](const NvDisplayMode& mode1, const NvDisplayMode& mode2) {
         return (uint64_t)mode1.width * mode1.height * mode1.refreshRate <
@@ -171,24 +183,24 @@ NvComputer::NvComputer(NvHTTP& http, QString serverInfo)
     });
 
     // We can get an IPv4 loopback address if we're using the GS IPv6 Forwarder
-    this->localAddress = NvAddress(NvHTTP::getXmlString(serverInfo, "LocalIP"), http.httpPort());
+    this->localAddress = NvAddress(serverInfoIndex.value("LocalIP"), http.httpPort());
     if (this->localAddress.address().startsWith("127.")) {
         this->localAddress = NvAddress();
     }
 
-    QString httpsPort = NvHTTP::getXmlString(serverInfo, "HttpsPort");
+    QString httpsPort = serverInfoIndex.value("HttpsPort");
     if (httpsPort.isEmpty() || (this->activeHttpsPort = httpsPort.toUShort()) == 0) {
         this->activeHttpsPort = DEFAULT_HTTPS_PORT;
     }
 
     // This is an extension which is not present in GFE. It is present for Sunshine to be able
     // to support dynamic HTTP WAN ports without requiring the user to manually enter the port.
-    QString remotePortStr = NvHTTP::getXmlString(serverInfo, "ExternalPort");
+    QString remotePortStr = serverInfoIndex.value("ExternalPort");
     if (remotePortStr.isEmpty() || (this->externalPort = remotePortStr.toUShort()) == 0) {
         this->externalPort = http.httpPort();
     }
 
-    QString remoteAddress = NvHTTP::getXmlString(serverInfo, "ExternalIP");
+    QString remoteAddress = serverInfoIndex.value("ExternalIP");
     if (!remoteAddress.isEmpty()) {
         this->remoteAddress = NvAddress(remoteAddress, this->externalPort);
     }
@@ -199,14 +211,14 @@ NvComputer::NvComputer(NvHTTP& http, QString serverInfo)
     // Real Nvidia host software (GeForce Experience and RTX Experience) both use the 'Mjolnir'
     // codename in the state field and no version of Sunshine does. We can use this to bypass
     // some assumptions about Nvidia hardware that don't apply to Sunshine hosts.
-    this->isNvidiaServerSoftware = NvHTTP::getXmlString(serverInfo, "state").contains("MJOLNIR");
+    this->isNvidiaServerSoftware = serverInfoIndex.value("state").contains("MJOLNIR");
 
-    this->pairState = NvHTTP::getXmlString(serverInfo, "PairStatus") == "1" ?
+    this->pairState = serverInfoIndex.value("PairStatus") == "1" ?
                 PS_PAIRED : PS_NOT_PAIRED;
-    this->currentGameId = NvHTTP::getCurrentGame(serverInfo);
-    this->appVersion = NvHTTP::getXmlString(serverInfo, "appversion");
-    this->gfeVersion = NvHTTP::getXmlString(serverInfo, "GfeVersion");
-    this->gpuModel = NvHTTP::getXmlString(serverInfo, "gputype");
+    this->currentGameId = NvHTTP::getCurrentGame(serverInfoIndex);
+    this->appVersion = serverInfoIndex.value("appversion");
+    this->gfeVersion = serverInfoIndex.value("GfeVersion");
+    this->gpuModel = serverInfoIndex.value("gputype");
     this->activeAddress = http.address();
     this->state = NvComputer::CS_ONLINE;
     this->pendingQuit = false;
@@ -458,23 +470,26 @@ NvComputer::ReachabilityType NvComputer::getActiveAddressReachability() const
 }
 
 bool NvComputer::updateAppList(QVector<NvApp> newAppList) {
-    if (appList == newAppList) {
-        return false;
-    }
-
     // Propagate client-side attributes to the new app list
+    QHash<int, const NvApp*> existingApps;
+    existingApps.reserve(appList.size());
     for (const NvApp& existingApp : appList) {
-        for (NvApp& newApp : newAppList) {
-            if (existingApp.id == newApp.id) {
-                newApp.hidden = existingApp.hidden;
-                newApp.directLaunch = existingApp.directLaunch;
-            }
+        existingApps.insert(existingApp.id, &existingApp);
+    }
+    for (NvApp& newApp : newAppList) {
+        const NvApp* existingApp = existingApps.value(newApp.id);
+        if (existingApp != nullptr) {
+            newApp.hidden = existingApp->hidden;
+            newApp.directLaunch = existingApp->directLaunch;
         }
     }
 
+    // Compare after propagation and sorting, so hidden apps or a different
+    // server-side order don't count as a change.
+    QVector<NvApp> oldAppList = appList;
     appList = newAppList;
     sortAppList();
-    return true;
+    return appList != oldAppList;
 }
 
 QVector<NvAddress> NvComputer::uniqueAddresses() const
@@ -20,7 +20,7 @@ public:
 
 class NvComputer
 {
-    friend class PcMonitorThread;
+    friend class PollScheduler;
     friend class ComputerManager;
     friend class PendingQuitTask;
 
@@ -69,9 +69,9 @@ public:
     void
     serialize(QSettings& settings, bool serializeApps) const;
 
-    // Caller is responsible for synchronizing read access to both hosts
-    bool
-    isEqualSerialized(const NvComputer& that) const;
+    // Hash of everything serialize() writes, used to skip unchanged hosts
+    QByteArray
+    serializedDigest() const;
 
     enum PairState
     {
@@ -113,7 +113,7 @@ public:
     QSslCertificate serverCert;
     QVector<NvApp> appList;
     bool isNvidiaServerSoftware;
-    // Remember to update isEqualSerialized() when adding fields here!
+    // Remember to update serializedDigest() when adding fields here!
 
     // Synchronization
     mutable CopySafeReadWriteLock lock;
@@ -11,6 +11,12 @@
 #include <QImageReader>
 #include <QtEndian>
 #include <QNetworkProxy>
+#include <QMutex>
+#include <QCryptographicHash>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QCoreApplication>
 
 #define FAST_FAIL_TIMEOUT_MS 2000
 #define REQUEST_TIMEOUT_MS 5000
@@ -18,9 +24,111 @@
 #define RESUME_TIMEOUT_MS 30000
 #define QUIT_TIMEOUT_MS 30000
 
+// How long idle keep-alive connections to non-GFE hosts stay open. This
+// comfortably covers the interval between polls of a focused host.
+#define KEEPALIVE_IDLE_TIMEOUT_SECS 30
+
+static QMutex s_SharedNamLock;
+static QThread* s_NetworkThread;
+static QNetworkAccessManager* s_SharedNam;
+static bool s_SharedNamShutdown;
+
+static QAtomicInt s_RequestCount;
+static QAtomicInt s_TlsHandshakeCount;
+static QAtomicInteger<qint64> s_RequestTimeMs;
+
+// Runs a single asynchronous request on the shared network thread and
+// reports the result back to the requesting NvHTTP through a queued signal.
+// Using a signal (instead of posting to the NvHTTP directly) lets Qt drop
+// the result safely if the requester has been destroyed in the meantime.
+class NvHttpRequestTask : public QObject
+{
+    Q_OBJECT
+
+public:
+    NvHttpRequestTask(QNetworkRequest request, QString command,
+                      QSslCertificate serverCert, int timeoutMs,
+                      NvHTTP::NvLogLevel logLevel)
+        : m_Request(request),
+          m_Command(command),
+          m_ServerCert(serverCert),
+          m_TimeoutMs(timeoutMs),
+          m_LogLevel(logLevel)
+    {
+    }
+
+signals:
+    void completed(NvHttpResult result);
+
+public slots:
+    void start()
+    {
+        m_Timer.start();
+        QNetworkReply* reply = s_SharedNam->get(m_Request);
+
+        // Emitted only when a new TLS connection is established, not
+        // when a request goes out over a pooled connection.
+        connect(reply, &QNetworkReply::encrypted, this, []() {
+            s_TlsHandshakeCount.ref();
+        });
+
+        // Only accept the pinned certificate, matching NvHTTP::handleSslErrors()
+        QSslCertificate serverCert = m_ServerCert;
+        connect(reply, &QNetworkReply::sslErrors, this, [reply, serverCert](const QList<QSslError>& errors) {
+            if (serverCert.isNull()) {
+                return;
+            }
+
+            for (const QSslError& error : errors) {
+                if (serverCert != error.certificate()) {
+                    return;
+                }
+            }
+
+            reply->ignoreSslErrors(errors);
+        });
+
+        if (m_TimeoutMs) {
+            QTimer::singleShot(m_TimeoutMs, reply, [this, reply]() {
+                if (!reply->isFinished()) {
+                    if (m_LogLevel >= NvHTTP::NVLL_ERROR) {
+                        qWarning() << "Aborting timed out request for" << m_Request.url().toString();
+                    }
+                    reply->abort();
+                }
+            });
+        }
+
+        connect(reply, &QNetworkReply::finished, this, [this, reply]() {
+            NvHttpResult result;
+
+            result.error = NvHTTP::getReplyError(reply, m_Command, m_LogLevel);
+            if (!result.error) {
+                result.data = reply->readAll();
+            }
+
+            s_RequestCount.ref();
+            s_RequestTimeMs.fetchAndAddRelaxed(m_Timer.elapsed());
+
+            emit completed(result);
+            reply->deleteLater();
+            deleteLater();
+        });
+    }
+
+private:
+    QNetworkRequest m_Request;
+    QString m_Command;
+    QSslCertificate m_ServerCert;
+    int m_TimeoutMs;
+    NvHTTP::NvLogLevel m_LogLevel;
+    QElapsedTimer m_Timer;
+};
+
 NvHTTP::NvHTTP(NvAddress address, uint16_t httpsPort, QSslCertificate serverCert, QNetworkAccessManager* nam) :
-    m_Nam(nam ? nam : new QNetworkAccessManager(this)),
-    m_ServerCert(serverCert)
+    m_Nam(nam),
+    m_ServerCert(serverCert),
+    m_AllowConnectionReuse(false)
 {
     m_BaseUrlHttp.setScheme("http");
     m_BaseUrlHttps.setScheme("https");
@@ -29,14 +137,33 @@ NvHTTP::NvHTTP(NvAddress address, uint16_t httpsPort, QSslCertificate serverCert
     setHttpsPort(httpsPort);
 
     // Never use a proxy server
-    QNetworkProxy noProxy(QNetworkProxy::NoProxy);
-    m_Nam->setProxy(noProxy);
+    if (m_Nam != nullptr) {
+        m_Nam->setProxy(QNetworkProxy(QNetworkProxy::NoProxy));
+    }
 }
 
 NvHTTP::NvHTTP(NvComputer* computer, QNetworkAccessManager* nam) :
     NvHTTP(computer->activeAddress, computer->activeHttpsPort, computer->serverCert, nam)
 {
+    setConnectionReuse(isConnectionReuseSupported(computer));
+}
 
+bool NvHTTP::isConnectionReuseSupported(const NvComputer* computer)
+{
+    // Only trust the server type if we've heard from the host this session
+    return computer->state == NvComputer::CS_ONLINE && !computer->isNvidiaServerSoftware;
+}
+
+void NvHTTP::setConnectionReuse(bool allow)
+{
+    m_AllowConnectionReuse = allow;
+}
+
+void NvHTTP::takeConnectionStats(int& requests, int& tlsHandshakes, qint64& totalRequestTimeMs)
+{
+    requests = s_RequestCount.fetchAndStoreRelaxed(0);
+    tlsHandshakes = s_TlsHandshakeCount.fetchAndStoreRelaxed(0);
+    totalRequestTimeMs = s_RequestTimeMs.fetchAndStoreRelaxed(0);
 }
 
 void NvHTTP::setServerCert(QSslCertificate serverCert)
@@ -104,14 +231,20 @@ NvHTTP::parseQuad(QString quad)
 
 int
 NvHTTP::getCurrentGame(QString serverInfo)
+{
+    return getCurrentGame(NvXmlIndex(serverInfo));
+}
+
+int
+NvHTTP::getCurrentGame(const NvXmlIndex& serverInfo)
 {
     // GFE 2.8 started keeping currentgame set to the last game played. As a result, it no longer
     // has the semantics that its name would indicate. To contain the effects of this change as much
     // as possible, we'll force the current game to zero if the server isn't in a streaming session.
-    QString serverState = getXmlString(serverInfo, "state");
+    QString serverState = serverInfo.value("state");
     if (serverState != nullptr && serverState.endsWith("_SERVER_BUSY"))
     {
-        return getXmlString(serverInfo, "currentgame").toInt();
+        return serverInfo.value("currentgame").toInt();
     }
     else
     {
@@ -166,10 +299,11 @@ NvHTTP::getServerInfo(NvLogLevel logLevel, bool fastFail)
                                             nullptr,
                                             fastFail ? FAST_FAIL_TIMEOUT_MS : REQUEST_TIMEOUT_MS,
                                             logLevel);
-        verifyResponseStatus(serverInfo);
+        NvXmlIndex serverInfoIndex(serverInfo);
+        serverInfoIndex.verifyResponseStatus();
 
         // Populate the HTTPS port
-        uint16_t httpsPort = getXmlString(serverInfo, "HttpsPort").toUShort();
+        uint16_t httpsPort = serverInfoIndex.value("HttpsPort").toUShort();
         if (httpsPort == 0) {
             httpsPort = DEFAULT_HTTPS_PORT;
         }
@@ -260,24 +394,29 @@ NvHTTP::quitApp()
 QVector<NvDisplayMode>
 NvHTTP::getDisplayModeList(QString serverInfo)
 {
-    QXmlStreamReader xmlReader(serverInfo);
+    return getDisplayModeList(NvXmlIndex(serverInfo));
+}
+
+QVector<NvDisplayMode>
+NvHTTP::getDisplayModeList(const NvXmlIndex& serverInfo)
+{
     QVector<NvDisplayMode> modes;
 
-    while (!xmlReader.atEnd()) {
-        while (xmlReader.readNextStartElement()) {
-            auto name = xmlReader.name();
-            if (name == QString("DisplayMode")) {
-                modes.append(NvDisplayMode());
-            }
-            else if (name == QString("Width")) {
-                modes.last().width = xmlReader.readElementText().toInt();
-            }
-            else if (name == QString("Height")) {
-                modes.last().height = xmlReader.readElementText().toInt();
-            }
-            else if (name == QString("RefreshRate")) {
-                modes.last().refreshRate = xmlReader.readElementText().toInt();
-            }
+    for (const NvXmlIndex::Element& element : serverInfo.elements()) {
+        if (element.name == QLatin1String("DisplayMode")) {
+            modes.append(NvDisplayMode());
+        }
+        else if (modes.isEmpty()) {
+            continue;
+        }
+        else if (element.name == QLatin1String("Width")) {
+            modes.last().width = element.value.toInt();
+        }
+        else if (element.name == QLatin1String("Height")) {
+            modes.last().height = element.value.toInt();
+        }
+        else if (element.name == QLatin1String("RefreshRate")) {
+            modes.last().refreshRate = element.value.toInt();
         }
     }
 
@@ -294,6 +433,12 @@ NvHTTP::getAppList()
                                             NvLogLevel::NVLL_ERROR);
     verifyResponseStatus(appxml);
 
+    return parseAppList(appxml);
+}
+
+QVector<NvApp>
+NvHTTP::parseAppList(QString appxml)
+{
     QXmlStreamReader xmlReader(appxml);
     QVector<NvApp> apps;
     while (!xmlReader.atEnd()) {
@@ -328,40 +473,7 @@ NvHTTP::getAppList()
 void
 NvHTTP::verifyResponseStatus(QString xml)
 {
-    QXmlStreamReader xmlReader(xml);
-
-    while (xmlReader.readNextStartElement())
-    {
-        if (xmlReader.name() == QString("root"))
-        {
-            // Status code can be 0xFFFFFFFF in some rare cases on GFE 3.20.3, and
-            // QString::toInt() will fail in that case, so use QString::toUInt()
-            // and cast the result to an int instead.
-            int statusCode = (int)xmlReader.attributes().value("status_code").toUInt();
-            if (statusCode == 200)
-            {
-                // Successful
-                return;
-            }
-            else
-            {
-                QString statusMessage = xmlReader.attributes().value("status_message").toString();
-                if (statusCode != 401) {
-                    // 401 is expected for unpaired PCs when we fetch serverinfo over HTTPS
-                    qWarning() << "Request failed:" << statusCode << statusMessage;
-                }
-                if (statusCode == -1 && statusMessage == "Invalid") {
-                    // Special case handling an audio capture error which GFE doesn't
-                    // provide any useful status message for.
-                    statusCode = 418;
-                    statusMessage = tr("Missing audio capture device. Reinstalling GeForce Experience should resolve this error.");
-                }
-                throw GfeHttpResponseException(statusCode, statusMessage);
-            }
-        }
-    }
-
-    throw GfeHttpResponseException(-1, "Malformed XML (missing root element)");
+    NvXmlIndex(xml).verifyResponseStatus();
 }
 
 QImage
@@ -383,35 +495,14 @@ QByteArray
 NvHTTP::getXmlStringFromHex(QString xml,
                             QString tagName)
 {
-    QString str = getXmlString(xml, tagName);
-    if (str == nullptr)
-    {
-        return nullptr;
-    }
-
-    return QByteArray::fromHex(str.toLatin1());
+    return NvXmlIndex(xml).valueFromHex(tagName);
 }
 
 QString
 NvHTTP::getXmlString(QString xml,
                      QString tagName)
 {
-    QXmlStreamReader xmlReader(xml);
-
-    while (!xmlReader.atEnd())
-    {
-        if (xmlReader.readNext() != QXmlStreamReader::StartElement)
-        {
-            continue;
-        }
-
-        if (xmlReader.name() == tagName)
-        {
-            return xmlReader.readElementText();
-        }
-    }
-
-    return nullptr;
+    return NvXmlIndex(xml).value(tagName);
 }
 
 void NvHTTP::handleSslErrors(QNetworkReply* reply, const QList<QSslError>& errors)
@@ -460,12 +551,10 @@ NvHTTP::openConnectionToString(QUrl baseUrl,
     return ret;
 }
 
-QNetworkReply*
-NvHTTP::openConnection(QUrl baseUrl,
-                       QString command,
-                       QString arguments,
-                       int timeoutMs,
-                       NvLogLevel logLevel)
+QNetworkRequest
+NvHTTP::buildRequest(QUrl baseUrl,
+                     QString command,
+                     QString arguments)
 {
     // Port must be set
     Q_ASSERT(baseUrl.port(0) != 0);
@@ -484,7 +573,13 @@ NvHTTP::openConnection(QUrl baseUrl,
     QNetworkRequest request(url);
 
     // Add our client certificate
-    request.setSslConfiguration(IdentityManager::get()->getSslConfig());
+    QSslConfiguration sslConfig = IdentityManager::get()->getSslConfig();
+    if (m_AllowConnectionReuse) {
+        // Let new connections resume a previous TLS session instead of
+        // doing a full handshake with our client certificate each time.
+        sslConfig.setSslOption(QSsl::SslOptionDisableSessionPersistence, false);
+    }
+    request.setSslConfiguration(sslConfig);
 
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
     // Disable HTTP/2 (GFE 3.22 doesn't like it) and Qt 6 enables it by default
@@ -494,10 +589,57 @@ NvHTTP::openConnection(QUrl baseUrl,
 #if QT_VERSION >= QT_VERSION_CHECK(6, 3, 0)
     // Use fine-grained idle timeouts to avoid calling QNetworkAccessManager::clearAccessCache(),
     // which tears down the NAM's global thread each time. We must not keep persistent connections
-    // or GFE will puke.
-    request.setAttribute(QNetworkRequest::ConnectionCacheExpiryTimeoutSecondsAttribute, 0);
+    // or GFE will puke, but other hosts can keep them around for a while.
+    request.setAttribute(QNetworkRequest::ConnectionCacheExpiryTimeoutSecondsAttribute,
+                         m_AllowConnectionReuse ? KEEPALIVE_IDLE_TIMEOUT_SECS : 0);
 #endif
 
+    return request;
+}
+
+std::exception_ptr
+NvHTTP::getReplyError(QNetworkReply* reply,
+                      QString command,
+                      NvLogLevel logLevel)
+{
+    if (reply->error() == QNetworkReply::NoError) {
+        return nullptr;
+    }
+
+    if (logLevel >= NvLogLevel::NVLL_ERROR) {
+        qWarning() << command << "request failed with error:" << reply->error();
+    }
+
+    if (reply->error() == QNetworkReply::SslHandshakeFailedError) {
+        // This will trigger falling back to HTTP for the serverinfo query
+        // then pairing again to get the updated certificate.
+        return std::make_exception_ptr(GfeHttpResponseException(401, "Server certificate mismatch"));
+    }
+    else if (reply->error() == QNetworkReply::OperationCanceledError) {
+        return std::make_exception_ptr(QtNetworkReplyException(QNetworkReply::TimeoutError, "Request timed out"));
+    }
+    else {
+        return std::make_exception_ptr(QtNetworkReplyException(reply->error(), reply->errorString()));
+    }
+}
+
+QNetworkReply*
+NvHTTP::openConnection(QUrl baseUrl,
+                       QString command,
+                       QString arguments,
+                       int timeoutMs,
+                       NvLogLevel logLevel)
+{
+    if (m_Nam == nullptr) {
+        m_Nam = new QNetworkAccessManager(this);
+
+        // Never use a proxy server
+        m_Nam->setProxy(QNetworkProxy(QNetworkProxy::NoProxy));
+    }
+
+    QNetworkRequest request = buildRequest(baseUrl, command, arguments);
+    QUrl url = request.url();
+
     auto sslErrorsConnection = connect(m_Nam, &QNetworkAccessManager::sslErrors, this, &NvHTTP::handleSslErrors);
     QNetworkReply* reply = m_Nam->get(request);
 
@@ -524,35 +666,242 @@ NvHTTP::openConnection(QUrl baseUrl,
 
 #if QT_VERSION < QT_VERSION_CHECK(6, 3, 0)
     // If we couldn't use fine-grained connection idle timeouts, kill them all now
-    m_Nam->clearAccessCache();
+    if (!m_AllowConnectionReuse) {
+        m_Nam->clearAccessCache();
+    }
 #endif
     disconnect(sslErrorsConnection);
 
     // Handle error
-    if (reply->error() != QNetworkReply::NoError)
-    {
-        if (logLevel >= NvLogLevel::NVLL_ERROR) {
-            qWarning() << command << "request failed with error:" << reply->error();
-        }
+    std::exception_ptr error = getReplyError(reply, command, logLevel);
+    if (error) {
+        delete reply;
+        std::rethrow_exception(error);
+    }
 
-        if (reply->error() == QNetworkReply::SslHandshakeFailedError) {
-            // This will trigger falling back to HTTP for the serverinfo query
-            // then pairing again to get the updated certificate.
-            GfeHttpResponseException exception(401, "Server certificate mismatch");
-            delete reply;
-            throw exception;
-        }
-        else if (reply->error() == QNetworkReply::OperationCanceledError) {
-            QtNetworkReplyException exception(QNetworkReply::TimeoutError, "Request timed out");
-            delete reply;
-            throw exception;
-        }
-        else {
-            QtNetworkReplyException exception(reply->error(), reply->errorString());
-            delete reply;
-            throw exception;
+    return reply;
+}
+
+QNetworkAccessManager*
+NvHTTP::sharedNetworkManager()
+{
+    QMutexLocker locker(&s_SharedNamLock);
+
+    if (s_SharedNamShutdown) {
+        return nullptr;
+    }
+
+    if (s_SharedNam == nullptr) {
+        qRegisterMetaType<NvHttpResult>();
+
+        s_NetworkThread = new QThread();
+        s_NetworkThread->setObjectName("NvHTTP Network Thread");
+
+        s_SharedNam = new QNetworkAccessManager();
+        s_SharedNam->setProxy(QNetworkProxy(QNetworkProxy::NoProxy));
+        s_SharedNam->moveToThread(s_NetworkThread);
+
+        s_NetworkThread->start();
+
+        // Abort outstanding requests so they don't hold up termination
+        connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit,
+                &NvHTTP::shutdownSharedNetworkManager);
+    }
+
+    return s_SharedNam;
+}
+
+void
+NvHTTP::shutdownSharedNetworkManager()
+{
+    QMutexLocker locker(&s_SharedNamLock);
+
+    s_SharedNamShutdown = true;
+
+    if (s_SharedNam == nullptr) {
+        return;
+    }
+
+    // Deleting the NAM destroys any outstanding replies. Their tasks never
+    // complete, which is fine since nobody is left to receive the results.
+    QNetworkAccessManager* nam = s_SharedNam;
+    QMetaObject::invokeMethod(nam, [nam]() {
+        delete nam;
+    }, Qt::BlockingQueuedConnection);
+
+    s_NetworkThread->quit();
+    s_NetworkThread->wait();
+    delete s_NetworkThread;
+
+    s_SharedNam = nullptr;
+    s_NetworkThread = nullptr;
+}
+
+void
+NvHTTP::openConnectionAsync(QUrl baseUrl,
+                            QString command,
+                            QString arguments,
+                            int timeoutMs,
+                            NvLogLevel logLevel,
+                            ResultCallback callback)
+{
+    QNetworkRequest request = buildRequest(baseUrl, command, arguments);
+
+#if QT_VERSION < QT_VERSION_CHECK(6, 3, 0)
+    // The shared NAM can't have its access cache cleared after each request
+    // without disrupting other hosts, so ask the server to close instead.
+    if (!m_AllowConnectionReuse) {
+        request.setRawHeader("Connection", "close");
+    }
+#endif
+
+    if (logLevel >= NvLogLevel::NVLL_VERBOSE) {
+        qInfo() << "Executing request:" << request.url().toString();
+    }
+
+    NvHttpRequestTask* task = new NvHttpRequestTask(request, command, m_ServerCert, timeoutMs, logLevel);
+    connect(task, &NvHttpRequestTask::completed, this, [callback](NvHttpResult result) {
+        callback(result);
+    });
+
+    QNetworkAccessManager* nam = sharedNetworkManager();
+    if (nam == nullptr) {
+        // We're quitting, so fail the request the same way an abort would
+        NvHttpResult result;
+        result.error = std::make_exception_ptr(QtNetworkReplyException(QNetworkReply::OperationCanceledError, "Request canceled"));
+        delete task;
+        QMetaObject::invokeMethod(this, [callback, result]() {
+            callback(result);
+        }, Qt::QueuedConnection);
+        return;
+    }
+
+    task->moveToThread(nam->thread());
+    QMetaObject::invokeMethod(task, "start", Qt::QueuedConnection);
+}
+
+void
+NvHTTP::getServerInfoAsync(NvLogLevel logLevel, bool fastFail, ResultCallback callback)
+{
+    int timeoutMs = fastFail ? FAST_FAIL_TIMEOUT_MS : REQUEST_TIMEOUT_MS;
+
+    // Mirrors the verification getServerInfo() does after each request
+    auto verify = [](NvHttpResult result) {
+        if (result.ok()) {
+            try {
+                verifyResponseStatus(result.toString());
+            } catch (...) {
+                result.error = std::current_exception();
+            }
         }
+        return result;
+    };
+
+    // Check if we have a pinned cert and HTTPS port for this host yet
+    if (!m_ServerCert.isNull() && httpsPort() != 0)
+    {
+        // Always try HTTPS first, since it properly reports
+        // pairing status (and a few other attributes).
+        openConnectionAsync(m_BaseUrlHttps, "serverinfo", nullptr, timeoutMs, logLevel,
+                            [this, logLevel, timeoutMs, verify, callback](const NvHttpResult& httpsResult) {
+            NvHttpResult result = verify(httpsResult);
+
+            bool certError = false;
+            try {
+                result.rethrowIfFailed();
+            } catch (const GfeHttpResponseException& e) {
+                certError = e.getStatusCode() == 401;
+            } catch (...) {}
+
+            if (certError) {
+                // Certificate validation error, fallback to HTTP
+                openConnectionAsync(m_BaseUrlHttp, "serverinfo", nullptr, timeoutMs, logLevel,
+                                    [verify, callback](const NvHttpResult& httpResult) {
+                    callback(verify(httpResult));
+                });
+            }
+            else {
+                callback(result);
+            }
+        });
     }
+    else
+    {
+        // Only use HTTP prior to pairing or fetching HTTPS port
+        openConnectionAsync(m_BaseUrlHttp, "serverinfo", nullptr, timeoutMs, logLevel,
+                            [this, logLevel, fastFail, verify, callback](const NvHttpResult& httpResult) {
+            NvHttpResult result = verify(httpResult);
+            if (!result.ok()) {
+                callback(result);
+                return;
+            }
 
-    return reply;
+            // Populate the HTTPS port
+            uint16_t httpsPort = NvXmlIndex(result.toString()).value("HttpsPort").toUShort();
+            if (httpsPort == 0) {
+                httpsPort = DEFAULT_HTTPS_PORT;
+            }
+            setHttpsPort(httpsPort);
+
+            // If we just needed to determine the HTTPS port, we'll try again over
+            // HTTPS now that we have the port number
+            if (!m_ServerCert.isNull()) {
+                getServerInfoAsync(logLevel, fastFail, callback);
+                return;
+            }
+
+            callback(result);
+        });
+    }
+}
+
+void
+NvHTTP::getAppListAsync(AppListCallback callback)
+{
+    getAppListAsync(QByteArray(), [callback](const NvHttpResult& result, const QVector<NvApp>& apps, const QByteArray&) {
+        callback(result, apps);
+    });
 }
+
+void
+NvHTTP::getAppListAsync(QByteArray knownDigest, AppListDigestCallback callback)
+{
+    openConnectionAsync(m_BaseUrlHttps, "applist", nullptr, REQUEST_TIMEOUT_MS, NvLogLevel::NVLL_ERROR,
+                        [knownDigest, callback](const NvHttpResult& response) {
+        NvHttpResult result = response;
+        QVector<NvApp> apps;
+        QByteArray digest;
+
+        if (result.ok()) {
+            digest = QCryptographicHash::hash(result.data, QCryptographicHash::Sha1);
+
+            // Parsing large app lists isn't free, so skip it if nothing changed
+            if (knownDigest.isEmpty() || digest != knownDigest) {
+                try {
+                    QString appxml = result.toString();
+                    verifyResponseStatus(appxml);
+                    apps = parseAppList(appxml);
+                } catch (...) {
+                    result.error = std::current_exception();
+                    digest.clear();
+                }
+            }
+        }
+
+        callback(result, apps, digest);
+    });
+}
+
+void
+NvHTTP::getBoxArtAsync(int appId, ResultCallback callback)
+{
+    openConnectionAsync(m_BaseUrlHttps,
+                        "appasset",
+                        "appid="+QString::number(appId)+
+                        "&AssetType=2&AssetIdx=0",
+                        REQUEST_TIMEOUT_MS,
+                        NvLogLevel::NVLL_VERBOSE,
+                        callback);
+}
+
+#include "nvhttp.moc"
@@ -3,10 +3,17 @@
 #include "identitymanager.h"
 #include "nvapp.h"
 #include "nvaddress.h"
+#include "nvxmlindex.h"
 
 #include <Limelight.h>
 
+#include <exception>
+#include <functional>
+
 #include <QUrl>
+#include <QMetaType>
+#include <QHash>
+#include <QVector>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 
@@ -98,10 +105,39 @@ private:
     QString m_ErrorText;
 };
 
+// Outcome of an asynchronous NvHTTP request. On failure, error holds the
+// same exception the synchronous API would have thrown.
+class NvHttpResult
+{
+public:
+    bool ok() const
+    {
+        return !error;
+    }
+
+    void rethrowIfFailed() const
+    {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    QString toString() const
+    {
+        return QString::fromUtf8(data);
+    }
+
+    QByteArray data;
+    std::exception_ptr error;
+};
+Q_DECLARE_METATYPE(NvHttpResult)
+
 class NvHTTP : public QObject
 {
     Q_OBJECT
 
+    friend class NvHttpRequestTask;
+
 public:
     enum NvLogLevel {
         NVLL_NONE,
@@ -109,6 +145,12 @@ public:
         NVLL_VERBOSE
     };
 
+    // Async callbacks run on the thread this NvHTTP object lives on and are
+    // dropped if the object is destroyed before the request completes.
+    typedef std::function<void(const NvHttpResult&)> ResultCallback;
+    typedef std::function<void(const NvHttpResult&, const QVector<NvApp>&)> AppListCallback;
+    typedef std::function<void(const NvHttpResult&, const QVector<NvApp>&, const QByteArray&)> AppListDigestCallback;
+
     explicit NvHTTP(NvAddress address, uint16_t httpsPort, QSslCertificate serverCert, QNetworkAccessManager* nam = nullptr);
 
     explicit NvHTTP(NvComputer* computer, QNetworkAccessManager* nam = nullptr);
@@ -117,9 +159,18 @@ public:
     int
     getCurrentGame(QString serverInfo);
 
+    static
+    int
+    getCurrentGame(const NvXmlIndex& serverInfo);
+
     QString
     getServerInfo(NvLogLevel logLevel, bool fastFail = false);
 
+    // Same HTTPS-then-HTTP logic as getServerInfo(). The response status has
+    // already been verified when the callback sees a successful result.
+    void
+    getServerInfoAsync(NvLogLevel logLevel, bool fastFail, ResultCallback callback);
+
     static
     void
     verifyResponseStatus(QString xml);
@@ -143,6 +194,20 @@ public:
 
     void setServerCert(QSslCertificate serverCert);
 
+    // GFE breaks if connections are kept alive, so persistent connections
+    // and TLS session resumption are only used for hosts known to be
+    // running other server software.
+    static
+    bool
+    isConnectionReuseSupported(const NvComputer* computer);
+
+    void setConnectionReuse(bool allow);
+
+    // Totals for asynchronous requests since the last call
+    static
+    void
+    takeConnectionStats(int& requests, int& tlsHandshakes, qint64& totalRequestTimeMs);
+
     void setAddress(NvAddress address);
     void setHttpsPort(uint16_t port);
 
@@ -175,13 +240,33 @@ public:
     QVector<NvApp>
     getAppList();
 
+    void
+    getAppListAsync(AppListCallback callback);
+
+    // Skips parsing if the response hashes to knownDigest. The callback gets
+    // the digest of this response, and apps is left empty when it matches.
+    void
+    getAppListAsync(QByteArray knownDigest, AppListDigestCallback callback);
+
+    static
+    QVector<NvApp>
+    parseAppList(QString appxml);
+
     QImage
     getBoxArt(int appId);
 
+    // Result data holds the encoded image as served by the host
+    void
+    getBoxArtAsync(int appId, ResultCallback callback);
+
     static
     QVector<NvDisplayMode>
     getDisplayModeList(QString serverInfo);
 
+    static
+    QVector<NvDisplayMode>
+    getDisplayModeList(const NvXmlIndex& serverInfo);
+
     QUrl m_BaseUrlHttp;
     QUrl m_BaseUrlHttps;
 private:
@@ -195,7 +280,37 @@ private:
                    int timeoutMs,
                    NvLogLevel logLevel);
 
+    void
+    openConnectionAsync(QUrl baseUrl,
+                        QString command,
+                        QString arguments,
+                        int timeoutMs,
+                        NvLogLevel logLevel,
+                        ResultCallback callback);
+
+    QNetworkRequest
+    buildRequest(QUrl baseUrl,
+                 QString command,
+                 QString arguments);
+
+    static
+    std::exception_ptr
+    getReplyError(QNetworkReply* reply,
+                  QString command,
+                  NvLogLevel logLevel);
+
+    // All asynchronous requests share one QNetworkAccessManager that
+    // lives on a dedicated network thread.
+    static
+    QNetworkAccessManager*
+    sharedNetworkManager();
+
+    static
+    void
+    shutdownSharedNetworkManager();
+
     NvAddress m_Address;
     QNetworkAccessManager* m_Nam;
     QSslCertificate m_ServerCert;
+    bool m_AllowConnectionReuse;
 };
@@ -219,14 +219,15 @@ NvPairingManager::pair(QString appVersion, QString pin, QSslCertificate& serverC
                                                     "devicename=roth&updateState=1&phrase=getservercert&salt=" +
                                                     salt.toHex() + "&clientcert=" + IdentityManager::get()->getCertificate().toHex(),
                                                     0);
-    NvHTTP::verifyResponseStatus(getCert);
-    if (NvHTTP::getXmlString(getCert, "paired") != "1")
+    NvXmlIndex getCertIndex(getCert);
+    getCertIndex.verifyResponseStatus();
+    if (getCertIndex.value("paired") != "1")
     {
         qCritical() << "Failed pairing at stage #1";
         return PairState::FAILED;
     }
 
-    QByteArray serverCertStr = NvHTTP::getXmlStringFromHex(getCert, "plaincert");
+    QByteArray serverCertStr = getCertIndex.valueFromHex("plaincert");
     if (serverCertStr == nullptr)
     {
         qCritical() << "Server likely already pairing";
@@ -254,15 +255,16 @@ NvPairingManager::pair(QString appVersion, QString pin, QSslCertificate& serverC
                                                          "devicename=roth&updateState=1&clientchallenge=" +
                                                          encryptedChallenge.toHex(),
                                                          REQUEST_TIMEOUT_MS);
-    NvHTTP::verifyResponseStatus(challengeXml);
-    if (NvHTTP::getXmlString(challengeXml, "paired") != "1")
+    NvXmlIndex challengeXmlIndex(challengeXml);
+    challengeXmlIndex.verifyResponseStatus();
+    if (challengeXmlIndex.value("paired") != "1")
     {
         qCritical() << "Failed pairing at stage #2";
         m_Http.openConnectionToString(m_Http.m_BaseUrlHttp, "unpair", nullptr, REQUEST_TIMEOUT_MS);
         return PairState::FAILED;
     }
 
-    QByteArray challengeResponseData = decrypt(m_Http.getXmlStringFromHex(challengeXml, "challengeresponse"), aesKey);
+    QByteArray challengeResponseData = decrypt(challengeXmlIndex.valueFromHex("challengeresponse"), aesKey);
     QByteArray clientSecretData = generateRandomBytes(16);
     QByteArray challengeResponse;
     QByteArray serverResponse(challengeResponseData.data(), hashLength);
@@ -289,15 +291,16 @@ NvPairingManager::pair(QString appVersion, QString pin, QSslCertificate& serverC
                                                     "devicename=roth&updateState=1&serverchallengeresp=" +
                                                     encryptedChallengeResponseHash.toHex(),
                                                     REQUEST_TIMEOUT_MS);
-    NvHTTP::verifyResponseStatus(respXml);
-    if (NvHTTP::getXmlString(respXml, "paired") != "1")
+    NvXmlIndex respXmlIndex(respXml);
+    respXmlIndex.verifyResponseStatus();
+    if (respXmlIndex.value("paired") != "1")
     {
         qCritical() << "Failed pairing at stage #3";
         m_Http.openConnectionToString(m_Http.m_BaseUrlHttp, "unpair", nullptr, REQUEST_TIMEOUT_MS);
         return PairState::FAILED;
     }
 
-    QByteArray pairingSecret = NvHTTP::getXmlStringFromHex(respXml, "pairingsecret");
+    QByteArray pairingSecret = respXmlIndex.valueFromHex("pairingsecret");
     QByteArray serverSecret = pairingSecret.left(16);
     QByteArray serverSignature = pairingSecret.mid(16);
 
@@ -330,8 +333,9 @@ NvPairingManager::pair(QString appVersion, QString pin, QSslCertificate& serverC
                                                           "devicename=roth&updateState=1&clientpairingsecret=" +
                                                           clientPairingSecret.toHex(),
                                                           REQUEST_TIMEOUT_MS);
-    NvHTTP::verifyResponseStatus(secretRespXml);
-    if (NvHTTP::getXmlString(secretRespXml, "paired") != "1")
+    NvXmlIndex secretRespXmlIndex(secretRespXml);
+    secretRespXmlIndex.verifyResponseStatus();
+    if (secretRespXmlIndex.value("paired") != "1")
     {
         qCritical() << "Failed pairing at stage #4";
         m_Http.openConnectionToString(m_Http.m_BaseUrlHttp, "unpair", nullptr, REQUEST_TIMEOUT_MS);
@@ -342,8 +346,9 @@ NvPairingManager::pair(QString appVersion, QString pin, QSslCertificate& serverC
                                                              "pair",
                                                              "devicename=roth&updateState=1&phrase=pairchallenge",
                                                              REQUEST_TIMEOUT_MS);
-    NvHTTP::verifyResponseStatus(pairChallengeXml);
-    if (NvHTTP::getXmlString(pairChallengeXml, "paired") != "1")
+    NvXmlIndex pairChallengeXmlIndex(pairChallengeXml);
+    pairChallengeXmlIndex.verifyResponseStatus();
+    if (pairChallengeXmlIndex.value("paired") != "1")
     {
         qCritical() << "Failed pairing at stage #5";
         m_Http.openConnectionToString(m_Http.m_BaseUrlHttp, "unpair", nullptr, REQUEST_TIMEOUT_MS);
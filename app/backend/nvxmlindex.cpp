@@ -0,0 +1,114 @@
+#include "nvxmlindex.h"
+#include "nvhttp.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QXmlStreamReader>
+
+NvXmlIndex::NvXmlIndex(const QString& xml)
+    : m_HasRoot(false)
+{
+    QXmlStreamReader xmlReader(xml);
+
+    // Indexes into m_Elements of the currently open elements
+    QVector<int> openElements;
+    QVector<bool> openHasChildren;
+
+    while (!xmlReader.atEnd()) {
+        switch (xmlReader.readNext()) {
+        case QXmlStreamReader::StartElement:
+        {
+            if (!openHasChildren.isEmpty()) {
+                openHasChildren.last() = true;
+            }
+
+            QString name = xmlReader.name().toString();
+            if (!m_HasRoot && name == QLatin1String("root")) {
+                m_HasRoot = true;
+
+                // Status code can be 0xFFFFFFFF in some rare cases on GFE 3.20.3, so
+                // keep it as text and let verifyResponseStatus() parse it as unsigned.
+                m_StatusCode = xmlReader.attributes().value("status_code").toString();
+                m_StatusMessage = xmlReader.attributes().value("status_message").toString();
+            }
+
+            if (!m_FirstIndex.contains(name)) {
+                m_FirstIndex.insert(name, m_Elements.size());
+            }
+
+            openElements.append(m_Elements.size());
+            openHasChildren.append(false);
+            m_Elements.append({ name, QString() });
+            break;
+        }
+
+        case QXmlStreamReader::Characters:
+            if (!openElements.isEmpty() && !openHasChildren.last()) {
+                m_Elements[openElements.last()].value += xmlReader.text();
+            }
+            break;
+
+        case QXmlStreamReader::EndElement:
+            if (!openElements.isEmpty()) {
+                if (openHasChildren.last()) {
+                    m_Elements[openElements.last()].value.clear();
+                }
+                openElements.removeLast();
+                openHasChildren.removeLast();
+            }
+            break;
+
+        default:
+            break;
+        }
+    }
+}
+
+void NvXmlIndex::verifyResponseStatus() const
+{
+    if (!m_HasRoot) {
+        throw GfeHttpResponseException(-1, "Malformed XML (missing root element)");
+    }
+
+    // Status code can be 0xFFFFFFFF in some rare cases on GFE 3.20.3, and
+    // QString::toInt() will fail in that case, so use QString::toUInt()
+    // and cast the result to an int instead.
+    int statusCode = (int)m_StatusCode.toUInt();
+    if (statusCode == 200) {
+        // Successful
+        return;
+    }
+
+    QString statusMessage = m_StatusMessage;
+    if (statusCode != 401) {
+        // 401 is expected for unpaired PCs when we fetch serverinfo over HTTPS
+        qWarning() << "Request failed:" << statusCode << statusMessage;
+    }
+    if (statusCode == -1 && statusMessage == "Invalid") {
+        // Special case handling an audio capture error which GFE doesn't
+        // provide any useful status message for.
+        statusCode = 418;
+        statusMessage = QCoreApplication::translate("NvHTTP", "Missing audio capture device. Reinstalling GeForce Experience should resolve this error.");
+    }
+    throw GfeHttpResponseException(statusCode, statusMessage);
+}
+
+QString NvXmlIndex::value(const QString& tagName) const
+{
+    auto it = m_FirstIndex.constFind(tagName);
+    if (it == m_FirstIndex.constEnd()) {
+        return nullptr;
+    }
+
+    return m_Elements[it.value()].value;
+}
+
+QByteArray NvXmlIndex::valueFromHex(const QString& tagName) const
+{
+    QString str = value(tagName);
+    if (str == nullptr) {
+        return nullptr;
+    }
+
+    return QByteArray::fromHex(str.toLatin1());
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+// Single-pass index over an XML response from the host. Tokenizing once
+// and answering every lookup from the index avoids rescanning the whole
+// document for each tag, which adds up on serverinfo polls.
+class NvXmlIndex
+{
+public:
+    struct Element
+    {
+        QString name;
+        QString value;  // Empty for elements with child elements
+    };
+
+    explicit NvXmlIndex(const QString& xml);
+
+    // Throws GfeHttpResponseException if the root status isn't 200
+    void verifyResponseStatus() const;
+
+    // Text of the first element with this name, or a null QString
+    QString value(const QString& tagName) const;
+
+    QByteArray valueFromHex(const QString& tagName) const;
+
+    // All elements in document order
+    const QVector<Element>& elements() const
+    {
+        return m_Elements;
+    }
+
+private:
+    QVector<Element> m_Elements;
+    QHash<QString, int> m_FirstIndex;
+    bool m_HasRoot;
+    QString m_StatusCode;
+    QString m_StatusMessage;
+};
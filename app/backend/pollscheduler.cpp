@@ -0,0 +1,406 @@
+#include "pollscheduler.h"
+#include "nvhttp.h"
+
+#include <QThread>
+
+#include <algorithm>
+#include <climits>
+
+#define MAX_CONCURRENT_POLLS 8
+#define TRIES_BEFORE_OFFLINING 2
+
+#define FOCUSED_POLL_INTERVAL_MS 1000
+#define POLL_INTERVAL_MS 3000
+#define MAX_OFFLINE_POLL_INTERVAL_MS 30000
+#define FOCUSED_APPLIST_FETCH_INTERVAL_MS 10000
+#define MISSING_APPLIST_RETRY_INTERVAL_MS 5000
+
+#define METRICS_LOG_INTERVAL_MS 60000
+
+PollScheduler::PollScheduler(QObject* parent)
+    : QObject(parent),
+      m_FocusedComputer(nullptr),
+      m_ActivePolls(0),
+      m_MetricsStartMs(0),
+      m_PollsCompleted(0),
+      m_RequestsSent(0),
+      m_Wakeups(0),
+      m_TotalPollTimeMs(0)
+{
+    m_WakeTimer.setSingleShot(true);
+    m_WakeTimer.setTimerType(Qt::CoarseTimer);
+    connect(&m_WakeTimer, &QTimer::timeout, this, &PollScheduler::handleWakeup);
+
+    m_Clock.start();
+}
+
+PollScheduler::~PollScheduler()
+{
+    for (Host* host : m_Hosts) {
+        cancelRequests(host);
+        delete host;
+    }
+}
+
+void PollScheduler::addComputer(NvComputer* computer)
+{
+    if (thread() == QThread::currentThread()) {
+        handleAddComputer(computer);
+    }
+    else {
+        QMetaObject::invokeMethod(this, [this, computer]() {
+            handleAddComputer(computer);
+        }, Qt::QueuedConnection);
+    }
+}
+
+void PollScheduler::removeComputer(NvComputer* computer)
+{
+    if (thread() == QThread::currentThread()) {
+        handleRemoveComputer(computer);
+    }
+    else {
+        // This is ordered after any queued addComputer() call for the same host
+        QMetaObject::invokeMethod(this, [this, computer]() {
+            handleRemoveComputer(computer);
+        }, Qt::BlockingQueuedConnection);
+    }
+}
+
+void PollScheduler::setFocusedComputer(NvComputer* computer, QObject* owner)
+{
+    Q_ASSERT(thread() == QThread::currentThread());
+
+    m_FocusedComputer = computer;
+    m_FocusOwner = owner;
+
+    // Refresh the newly focused host and its app list right away
+    Host* host = m_Hosts.value(computer);
+    if (host != nullptr) {
+        host->lastAppListFetchMs = -1;
+        if (!host->polling) {
+            host->nextPollMs = std::min(host->nextPollMs, m_Clock.elapsed());
+            schedule();
+        }
+    }
+}
+
+void PollScheduler::handleAddComputer(NvComputer* computer)
+{
+    if (m_Hosts.contains(computer)) {
+        return;
+    }
+
+    Host* host = new Host();
+    host->computer = computer;
+    host->nextPollMs = m_Clock.elapsed();
+    host->consecutiveFailures = 0;
+    host->lastAppListFetchMs = -1;
+    host->polling = false;
+    host->pollStartMs = 0;
+    host->wasOnline = false;
+    host->stateChanged = false;
+    host->triesRemaining = 0;
+    m_Hosts.insert(computer, host);
+
+    schedule();
+}
+
+void PollScheduler::handleRemoveComputer(NvComputer* computer)
+{
+    Host* host = m_Hosts.take(computer);
+    if (host == nullptr) {
+        return;
+    }
+
+    // Dropping the NvHTTP objects also drops their pending callbacks
+    cancelRequests(host);
+    if (host->polling) {
+        m_ActivePolls--;
+    }
+
+    if (m_FocusedComputer == computer) {
+        m_FocusedComputer = nullptr;
+        m_FocusOwner.clear();
+    }
+
+    delete host;
+
+    // A poll slot may have opened up
+    schedule();
+}
+
+void PollScheduler::handleWakeup()
+{
+    m_Wakeups++;
+    schedule();
+}
+
+void PollScheduler::schedule()
+{
+    qint64 now = m_Clock.elapsed();
+
+    logMetrics(now);
+
+    // Start the most overdue polls first
+    QVector<Host*> dueHosts;
+    for (Host* host : m_Hosts) {
+        if (!host->polling && host->nextPollMs <= now) {
+            dueHosts.append(host);
+        }
+    }
+    std::sort(dueHosts.begin(), dueHosts.end(), [](const Host* a, const Host* b) {
+        return a->nextPollMs < b->nextPollMs;
+    });
+    for (Host* host : dueHosts) {
+        if (m_ActivePolls >= MAX_CONCURRENT_POLLS) {
+            break;
+        }
+        startPoll(host);
+    }
+
+    // If we're at capacity, the next completed poll will reschedule us
+    if (m_ActivePolls >= MAX_CONCURRENT_POLLS) {
+        m_WakeTimer.stop();
+        return;
+    }
+
+    qint64 nextWakeMs = -1;
+    for (Host* host : m_Hosts) {
+        if (!host->polling && (nextWakeMs < 0 || host->nextPollMs < nextWakeMs)) {
+            nextWakeMs = host->nextPollMs;
+        }
+    }
+
+    if (nextWakeMs < 0) {
+        m_WakeTimer.stop();
+    }
+    else {
+        m_WakeTimer.start((int)std::max<qint64>(0, nextWakeMs - now));
+    }
+}
+
+void PollScheduler::startPoll(Host* host)
+{
+    Q_ASSERT(!host->polling);
+
+    host->polling = true;
+    host->pollStartMs = m_Clock.elapsed();
+    host->wasOnline = host->computer->state == NvComputer::CS_ONLINE;
+    host->stateChanged = false;
+    host->triesRemaining = host->wasOnline ? TRIES_BEFORE_OFFLINING : 1;
+    m_ActivePolls++;
+
+    startAddressRace(host);
+}
+
+void PollScheduler::startAddressRace(Host* host)
+{
+    QVector<NvAddress> addresses = host->computer->uniqueAddresses();
+    if (addresses.isEmpty()) {
+        finishPoll(host, false);
+        return;
+    }
+
+    // Query every candidate address at once and take the first valid response
+    for (const NvAddress& address : addresses) {
+        NvHTTP* http = new NvHTTP(address, 0, host->computer->serverCert);
+        http->setConnectionReuse(NvHTTP::isConnectionReuseSupported(host->computer));
+        http->setParent(this);
+        host->requests.append(http);
+        m_RequestsSent++;
+
+        http->getServerInfoAsync(NvHTTP::NvLogLevel::NVLL_NONE, true,
+                                 [this, host, http](const NvHttpResult& result) {
+            handleServerInfo(host, http, result);
+        });
+    }
+}
+
+void PollScheduler::handleServerInfo(Host* host, NvHTTP* http, const NvHttpResult& result)
+{
+    host->requests.removeOne(http);
+    http->deleteLater();
+
+    if (result.ok()) {
+        NvComputer newState(*http, result.toString());
+
+        // Ensure the machine that responded is the one we intended to contact
+        if (host->computer->uuid == newState.uuid) {
+            // We have a winner, so stop the other requests in the race
+            cancelRequests(host);
+
+            if (host->computer->update(newState)) {
+                host->stateChanged = true;
+            }
+
+            finishPoll(host, true);
+            return;
+        }
+
+        qInfo() << "Found unexpected PC" << newState.name << "looking for" << host->computer->name;
+    }
+
+    // Wait for the rest of the race to finish
+    if (!host->requests.isEmpty()) {
+        return;
+    }
+
+    if (--host->triesRemaining > 0) {
+        startAddressRace(host);
+    }
+    else {
+        finishPoll(host, false);
+    }
+}
+
+void PollScheduler::finishPoll(Host* host, bool online)
+{
+    NvComputer* computer = host->computer;
+
+    if (online) {
+        if (!host->wasOnline) {
+            qInfo() << computer->name << "is now online at" << computer->activeAddress.toString();
+        }
+        host->consecutiveFailures = 0;
+    }
+    else {
+        host->consecutiveFailures++;
+
+        // Note: we don't need to acquire the read lock here,
+        // because we're on the writing thread.
+        if (computer->state != NvComputer::CS_OFFLINE) {
+            qInfo() << computer->name << "is now offline";
+            computer->state = NvComputer::CS_OFFLINE;
+            host->stateChanged = true;
+        }
+    }
+
+    // App lists are only refreshed on demand: when we don't have one yet, or
+    // periodically while the user is looking at this host's apps. Failed
+    // fetches also start the interval, so a host that can't serve its app
+    // list isn't asked for it again on every poll.
+    qint64 now = m_Clock.elapsed();
+    qint64 sinceAppListFetchMs = host->lastAppListFetchMs < 0 ? LLONG_MAX : now - host->lastAppListFetchMs;
+    if (computer->state == NvComputer::CS_ONLINE &&
+            computer->pairState == NvComputer::PS_PAIRED &&
+            ((computer->appList.isEmpty() && sinceAppListFetchMs >= MISSING_APPLIST_RETRY_INTERVAL_MS) ||
+             (isFocused(host) && sinceAppListFetchMs >= FOCUSED_APPLIST_FETCH_INTERVAL_MS))) {
+        // Notify prior to the app list poll since it may take a while, and we don't
+        // want to delay onlining of a machine, especially if we already have a cached list.
+        if (host->stateChanged) {
+            emit computerStateChanged(computer);
+            host->stateChanged = false;
+        }
+
+        NvHTTP* http = new NvHTTP(computer);
+        http->setParent(this);
+        host->requests.append(http);
+        m_RequestsSent++;
+
+        http->getAppListAsync(host->appListDigest,
+                              [this, host, http](const NvHttpResult& result, const QVector<NvApp>& appList, const QByteArray& digest) {
+            host->requests.removeOne(http);
+            http->deleteLater();
+
+            // Successful or not, don't ask again until the next interval
+            host->lastAppListFetchMs = m_Clock.elapsed();
+
+            // An unchanged digest means there's nothing new to parse
+            if (result.ok() && digest != host->appListDigest && !appList.isEmpty()) {
+                QWriteLocker lock(&host->computer->lock);
+                if (host->computer->updateAppList(appList)) {
+                    host->stateChanged = true;
+                }
+                host->appListDigest = digest;
+            }
+
+            completePoll(host);
+        });
+    }
+    else {
+        completePoll(host);
+    }
+}
+
+void PollScheduler::completePoll(Host* host)
+{
+    if (host->stateChanged) {
+        // Tell anyone listening that we've changed state
+        emit computerStateChanged(host->computer);
+        host->stateChanged = false;
+    }
+
+    qint64 now = m_Clock.elapsed();
+
+    host->polling = false;
+    host->nextPollMs = now + getPollInterval(host);
+    m_ActivePolls--;
+
+    m_PollsCompleted++;
+    m_TotalPollTimeMs += now - host->pollStartMs;
+
+    schedule();
+}
+
+void PollScheduler::cancelRequests(Host* host)
+{
+    // Deleting the NvHTTP disconnects its pending callback
+    for (NvHTTP* http : host->requests) {
+        delete http;
+    }
+    host->requests.clear();
+}
+
+bool PollScheduler::isFocused(Host* host)
+{
+    return !m_FocusOwner.isNull() && host->computer == m_FocusedComputer;
+}
+
+int PollScheduler::getPollInterval(Host* host)
+{
+    if (host->consecutiveFailures > 0) {
+        // Back off exponentially for hosts that aren't responding
+        int shift = std::min(host->consecutiveFailures - 1, 4);
+        return std::min(POLL_INTERVAL_MS << shift, MAX_OFFLINE_POLL_INTERVAL_MS);
+    }
+    else if (isFocused(host)) {
+        return FOCUSED_POLL_INTERVAL_MS;
+    }
+    else {
+        return POLL_INTERVAL_MS;
+    }
+}
+
+void PollScheduler::logMetrics(qint64 nowMs)
+{
+    qint64 elapsedMs = nowMs - m_MetricsStartMs;
+    if (elapsedMs < METRICS_LOG_INTERVAL_MS) {
+        return;
+    }
+
+    // Includes requests from outside the scheduler, like box art fetches
+    int requests, tlsHandshakes;
+    qint64 totalRequestTimeMs;
+    NvHTTP::takeConnectionStats(requests, tlsHandshakes, totalRequestTimeMs);
+
+    if (m_PollsCompleted > 0) {
+        qInfo().nospace() << "Host polling: " << m_Hosts.size() << " hosts, "
+                          << QString::number(m_PollsCompleted * 1000.0 / elapsedMs, 'f', 2) << " polls/sec, "
+                          << QString::number(m_RequestsSent * 1000.0 / elapsedMs, 'f', 2) << " requests/sec, "
+                          << QString::number(m_Wakeups * 1000.0 / elapsedMs, 'f', 2) << " wakeups/sec, "
+                          << m_TotalPollTimeMs / m_PollsCompleted << " ms average poll";
+    }
+
+    if (requests > 0) {
+        qInfo().nospace() << "NvHTTP: " << requests << " requests, "
+                          << tlsHandshakes << " TLS handshakes, "
+                          << totalRequestTimeMs / requests << " ms average request";
+    }
+
+    m_MetricsStartMs = nowMs;
+    m_PollsCompleted = 0;
+    m_RequestsSent = 0;
+    m_Wakeups = 0;
+    m_TotalPollTimeMs = 0;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "nvcomputer.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+
+class NvHTTP;
+class NvHttpResult;
+
+// Central scheduler for host status polling.
+//
+// All hosts are polled from a single timer on the owning thread using
+// asynchronous NvHTTP requests, instead of one sleeping thread per host.
+// At most MAX_CONCURRENT_POLLS polls are in flight at once and each host
+// gets its own interval: hosts shown in the UI are polled quickly, online
+// hosts at the normal rate and offline hosts back off exponentially.
+//
+// A poll races serverinfo requests to all of the host's candidate
+// addresses and takes the first valid response. App lists are fetched
+// only when a host has none or its apps are on screen, and unchanged
+// lists are detected by hash without being parsed.
+class PollScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PollScheduler(QObject* parent = nullptr);
+
+    virtual ~PollScheduler();
+
+    // May be called from any thread
+    void addComputer(NvComputer* computer);
+
+    // May be called from any thread. Returns once no request for this
+    // computer is in flight, so the caller may delete it afterwards.
+    void removeComputer(NvComputer* computer);
+
+    // Poll this computer at the fast rate while owner is alive
+    void setFocusedComputer(NvComputer* computer, QObject* owner);
+
+signals:
+    void computerStateChanged(NvComputer* computer);
+
+private slots:
+    void handleWakeup();
+
+private:
+    struct Host {
+        NvComputer* computer;
+        qint64 nextPollMs;
+        int consecutiveFailures;
+        qint64 lastAppListFetchMs;
+        QByteArray appListDigest;
+
+        // Per-poll state
+        bool polling;
+        qint64 pollStartMs;
+        bool wasOnline;
+        bool stateChanged;
+        int triesRemaining;
+        QVector<NvHTTP*> requests;
+    };
+
+    void handleAddComputer(NvComputer* computer);
+
+    void handleRemoveComputer(NvComputer* computer);
+
+    void schedule();
+
+    void startPoll(Host* host);
+
+    void startAddressRace(Host* host);
+
+    void handleServerInfo(Host* host, NvHTTP* http, const NvHttpResult& result);
+
+    void finishPoll(Host* host, bool online);
+
+    void completePoll(Host* host);
+
+    void cancelRequests(Host* host);
+
+    bool isFocused(Host* host);
+
+    int getPollInterval(Host* host);
+
+    void logMetrics(qint64 nowMs);
+
+    QHash<NvComputer*, Host*> m_Hosts;
+    QPointer<QObject> m_FocusOwner;
+    NvComputer* m_FocusedComputer;
+    QTimer m_WakeTimer;
+    QElapsedTimer m_Clock;
+    int m_ActivePolls;
+
+    // Metrics since the last log
+    qint64 m_MetricsStartMs;
+    int m_PollsCompleted;
+    int m_RequestsSent;
+    int m_Wakeups;
+    qint64 m_TotalPollTimeMs;
+};
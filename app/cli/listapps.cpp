@@ -92,17 +92,22 @@ public:
                     // ComputerManager is yet to update the app list, we will explicitly fetch the latest app list.
                     // Otherwise, it becomes complicated as we would have to guess whether ComputerManager
                     // would emit 1 signal (the list did not change) or 2 signals (indicating that the list has changed)
-                    try {
-                        NvHTTP http{m_Computer};
+                    NvHTTP* http = new NvHTTP(m_Computer);
+                    http->setParent(q);
+                    http->getAppListAsync([this, http](const NvHttpResult& result, const QVector<NvApp>& appList) {
+                        http->deleteLater();
+
+                        try {
+                            result.rethrowIfFailed();
+                        } catch (std::exception& exception) {
+                            fprintf(stderr, "%s\n", exception.what());
+                            QCoreApplication::exit(1);
+                            return;
+                        }
 
-                        const auto appList = http.getAppList();
                         m_Arguments.isPrintCSV() ? printAppsCSV(appList) : printApps(appList);
-
                         QCoreApplication::exit(0);
-                    } catch (std::exception& exception) {
-                        fprintf(stderr, "%s\n", exception.what());
-                        QCoreApplication::exit(1);
-                    }
+                    });
                 } else {
                     m_State = StateFailure;
                     fprintf(stderr, "%s\n", qPrintable(QObject::tr("Computer %1 has not been paired. "
@@ -333,6 +333,8 @@ Item {
 
                 opacity: model.hidden ? 0.4 : 1.0
 
+                Component.onDestruction: if (appModel) appModel.releaseBoxArt(delegateAppId)
+
                 Image {
                     property bool isPlaceholder: false
 
@@ -645,9 +647,13 @@ Item {
                 width: appListView.width
                 height: Math.round(60 * tileScale)
 
+                property int delegateAppId: model.appid
+
                 opacity: model.hidden ? 0.4 : 1.0
                 highlighted: appListView.activeFocus && appListView.currentIndex === index
 
+                Component.onDestruction: if (appModel) appModel.releaseBoxArt(delegateAppId)
+
                 function activate() {
                     if (!model.running) {
                         listLaunchOrResumeApp(index, model.name, model.appid, true)
@@ -18,6 +18,8 @@ Item {
     property int sortMode: 0       // 0=default, 1=name, 2=VID:PID, 3=last added, 4=class
     property int filterTransport: 0 // 0=all, 1=USB only, 2=BT only
     property int filterClass: 0     // 0=all, 1=keyboard, 2=mouse, 3=gamepad, 5=storage, 6=audio, 7=webcam
+    property bool showUrbStats: false
+    property var urbStats: []
 
     signal closeRequested()
 
@@ -80,6 +82,11 @@ Item {
                     }
                 }
 
+                Button {
+                    text: showUrbStats ? qsTr("Hide stats") : qsTr("URB stats")
+                    onClicked: showUrbStats = !showUrbStats
+                }
+
                 Button {
                     text: qsTr("Close")
                     onClicked: closeRequested()
@@ -108,6 +115,104 @@ Item {
                 }
             }
 
+            // ─── per-endpoint URB statistics ───
+            Rectangle {
+                Layout.fillWidth: true
+                Layout.preferredHeight: visible ? Math.min(urbStatsColumn.implicitHeight + 16, 220) : 0
+                visible: showUrbStats
+                color: "#262626"
+                radius: 4
+                border.color: "#505050"
+                border.width: 1
+                clip: true
+
+                Timer {
+                    interval: 1000
+                    repeat: true
+                    triggeredOnStart: true
+                    running: showUrbStats && passthroughView.visible
+                    onTriggered: urbStats = passthroughClient ? passthroughClient.urbEndpointStats() : []
+                }
+
+                Flickable {
+                    anchors.fill: parent
+                    anchors.margins: 8
+                    contentHeight: urbStatsColumn.implicitHeight
+                    clip: true
+
+                    ScrollBar.vertical: ScrollBar {}
+
+                    ColumnLayout {
+                        id: urbStatsColumn
+                        width: parent.width
+                        spacing: 2
+
+                        RowLayout {
+                            Layout.fillWidth: true
+
+                            Label {
+                                text: qsTr("Device / endpoint     Type   URBs/s   KB/s   avg ms   p99 ms   max ms   done   err   pending")
+                                font.pointSize: 8
+                                font.family: "Consolas,monospace"
+                                color: "#B0B0B0"
+                                Layout.fillWidth: true
+                            }
+
+                            Button {
+                                text: qsTr("Save trace")
+                                onClicked: {
+                                    if (!passthroughClient) return
+                                    var path = passthroughClient.saveUrbTrace()
+                                    traceSavedLabel.text = path !== "" ? qsTr("Saved to %1").arg(path)
+                                                                       : qsTr("Failed to save trace")
+                                }
+                            }
+                        }
+
+                        Repeater {
+                            model: urbStats
+
+                            Label {
+                                text: ("#" + modelData.deviceId + " " + modelData.endpoint).padEnd(22) +
+                                      modelData.transferType.padEnd(7) +
+                                      modelData.urbsPerSec.toFixed(0).padStart(6) +
+                                      modelData.kbPerSec.toFixed(1).padStart(9) +
+                                      modelData.avgLatencyMs.toFixed(2).padStart(9) +
+                                      modelData.p99LatencyMs.toFixed(2).padStart(9) +
+                                      modelData.maxLatencyMs.toFixed(2).padStart(9) +
+                                      ("" + modelData.completed).padStart(7) +
+                                      ("" + modelData.errors).padStart(6) +
+                                      ("" + modelData.inFlight).padStart(10) +
+                                      (modelData.isoDepth !== undefined
+                                           ? "  iso depth " + modelData.isoDepth +
+                                             " under " + modelData.isoUnderruns +
+                                             " over " + modelData.isoOverruns
+                                           : "")
+                                font.pointSize: 8
+                                font.family: "Consolas,monospace"
+                                color: modelData.errors > 0 ? "#FFB74D" : "#D0D0D0"
+                            }
+                        }
+
+                        Label {
+                            visible: urbStats.length === 0
+                            text: qsTr("No URB traffic recorded yet.")
+                            font.pointSize: 8
+                            color: "#808080"
+                        }
+
+                        Label {
+                            id: traceSavedLabel
+                            visible: text !== ""
+                            font.pointSize: 8
+                            color: "#70A0D0"
+                            elide: Text.ElideMiddle
+                            Layout.fillWidth: true
+                        }
+                    }
+                }
+            }
+
             // ─── search & filter bar ───
             RowLayout {
                 Layout.fillWidth: true
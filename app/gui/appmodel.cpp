@@ -2,6 +2,7 @@
 #include "settings/streamingpreferences.h"
 
 #include <QSettings>
+#include <QSet>
 #include <algorithm>
 
 AppModel::AppModel(QObject *parent)
@@ -33,6 +34,9 @@ void AppModel::initialize(ComputerManager* computerManager, const QString& compu
     }
     Q_ASSERT(m_Computer != nullptr);
 
+    // Keep this host's status fresh while we're showing its apps
+    m_ComputerManager->setFocusedComputer(m_Computer, this);
+
     m_CurrentGameId = m_Computer->currentGameId;
     m_ShowHiddenGames = showHiddenGames;
 
@@ -232,10 +236,77 @@ void AppModel::updateAppList(QVector<NvApp> newList)
         });
     }
 
-    // Full model reset for simplicity
-    beginResetModel();
-    m_VisibleApps = newVisibleList;
-    endResetModel();
+    setVisibleApps(newVisibleList);
+}
+
+void AppModel::setVisibleApps(const QVector<NvApp>& newList)
+{
+    QSet<int> newIds;
+    newIds.reserve(newList.count());
+    for (const NvApp& app : newList) {
+        newIds.insert(app.id);
+    }
+
+    // Remove apps that are gone, back to front so indices stay valid
+    for (int i = m_VisibleApps.count() - 1; i >= 0; i--) {
+        if (!newIds.contains(m_VisibleApps[i].id)) {
+            int last = i;
+            while (i > 0 && !newIds.contains(m_VisibleApps[i - 1].id)) {
+                i--;
+            }
+
+            beginRemoveRows(QModelIndex(), i, last);
+            m_VisibleApps.remove(i, last - i + 1);
+            endRemoveRows();
+        }
+    }
+
+    QSet<int> oldIds;
+    oldIds.reserve(m_VisibleApps.count());
+    for (const NvApp& app : m_VisibleApps) {
+        oldIds.insert(app.id);
+    }
+
+    // Inserts alone are only enough if the remaining apps kept their order.
+    // Otherwise (like after a sort mode change), reset the whole model.
+    int oldIndex = 0;
+    for (const NvApp& app : newList) {
+        if (oldIds.contains(app.id)) {
+            if (m_VisibleApps[oldIndex].id != app.id) {
+                beginResetModel();
+                m_VisibleApps = newList;
+                endResetModel();
+                return;
+            }
+            oldIndex++;
+        }
+    }
+
+    // Insert new apps and refresh changed ones in place, so the view
+    // keeps its delegates and scroll position.
+    for (int i = 0; i < newList.count(); i++) {
+        if (oldIds.contains(newList[i].id)) {
+            Q_ASSERT(m_VisibleApps[i].id == newList[i].id);
+            if (m_VisibleApps[i] != newList[i]) {
+                m_VisibleApps[i] = newList[i];
+                emit dataChanged(createIndex(i, 0), createIndex(i, 0));
+            }
+        }
+        else {
+            int last = i;
+            while (last + 1 < newList.count() && !oldIds.contains(newList[last + 1].id)) {
+                last++;
+            }
+
+            beginInsertRows(QModelIndex(), i, last);
+            for (int j = i; j <= last; j++) {
+                m_VisibleApps.insert(j, newList[j]);
+            }
+            endInsertRows();
+
+            i = last;
+        }
+    }
 }
 
 void AppModel::sortVisibleApps()
@@ -330,6 +401,14 @@ void AppModel::loadCustomOrder()
     }
 }
 
+void AppModel::releaseBoxArt(int appId)
+{
+    // Don't waste a fetch slot on art that scrolled out of view
+    if (m_Computer) {
+        m_BoxArtManager.cancelBoxArt(m_Computer, appId);
+    }
+}
+
 void AppModel::setAppHidden(int appIndex, bool hidden)
 {
     Q_ASSERT(appIndex < m_VisibleApps.count());
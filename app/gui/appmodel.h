@@ -45,6 +45,9 @@ public:
 
     Q_INVOKABLE void setAppDirectLaunch(int appIndex, bool directLaunch);
 
+    // Called when a tile showing this app's box art is destroyed
+    Q_INVOKABLE void releaseBoxArt(int appId);
+
     // Sort mode management
     Q_INVOKABLE void setSortMode(int mode);
     Q_INVOKABLE int getSortMode() const;
@@ -79,6 +82,9 @@ signals:
 private:
     void updateAppList(QVector<NvApp> newList);
 
+    // Applies the new list with row inserts/removals where possible
+    void setVisibleApps(const QVector<NvApp>& newList);
+
     QVector<NvApp> getVisibleApps(const QVector<NvApp>& appList);
 
     bool isAppCurrentlyVisible(const NvApp& app);
@@ -5,10 +5,21 @@
 #include "renderers/slaud.h"
 #endif
 
+#ifdef HAVE_ALSA
+#include "renderers/alsa.h"
+#endif
+
 #include "renderers/sdl.h"
 
 #include <Limelight.h>
 
+// Bits 7-3 of an Opus TOC byte select the frame configuration:
+// 0-11 are SILK-only, 12-15 are hybrid, and 16-31 are CELT-only.
+// This is the first byte of a multistream packet too, since every
+// stream but the last uses self-delimited framing.
+#define OPUS_TOC_CONFIG(toc) (((unsigned char)(toc)) >> 3)
+#define OPUS_TOC_FIRST_CELT_CONFIG 16
+
 #define TRY_INIT_RENDERER(renderer, opusConfig)        \
 {                                                      \
     IAudioRenderer* __renderer = new renderer();       \
@@ -30,6 +41,14 @@ IAudioRenderer* Session::createAudioRenderer(const POPUS_MULTISTREAM_CONFIGURATI
         TRY_INIT_RENDERER(SLAudioRenderer, opusConfig)
         return nullptr;
     }
+#endif
+#if defined(HAVE_ALSA)
+    else if (mlAudio == "alsa") {
+        // ALSA is never selected automatically. Most desktops route audio through
+        // a sound server, and SDL already talks to those directly.
+        TRY_INIT_RENDERER(AlsaAudioRenderer, opusConfig)
+        return nullptr;
+    }
 #endif
     else if (!mlAudio.isEmpty()) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
@@ -87,6 +106,9 @@ bool Session::initializeAudioRenderer()
         return false;
     }
 
+    // Underrun counts are per renderer instance
+    m_LastAudioUnderrunCount = 0;
+
     SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
                 "Audio stream has %d channels",
                 m_ActiveAudioConfig.channelCount);
@@ -140,6 +162,10 @@ int Session::arInit(int /* audioConfiguration */,
 
 void Session::arCleanup()
 {
+    // Include the partial window at the end of the stream
+    addAudioStats(s_ActiveSession->m_ActiveWndAudioStats, s_ActiveSession->m_GlobalAudioStats);
+    logAudioStats(s_ActiveSession->m_GlobalAudioStats, "Global audio stats");
+
     delete s_ActiveSession->m_AudioRenderer;
     s_ActiveSession->m_AudioRenderer = nullptr;
 
@@ -147,10 +173,97 @@ void Session::arCleanup()
     s_ActiveSession->m_OpusDecoder = nullptr;
 }
 
-void Session::arDecodeAndPlaySample(char* sampleData, int sampleLength)
+void Session::decodeAndPlayAudioFrame(unsigned char* sampleData, int sampleLength, bool decodeFec)
 {
     int samplesDecoded;
 
+    // The renderer may have been torn down by a previous frame in this sample
+    if (m_AudioRenderer == nullptr) {
+        return;
+    }
+
+    int sampleSize = m_AudioRenderer->getAudioBufferSampleSize();
+    int frameSize = sampleSize * m_ActiveAudioConfig.channelCount;
+    int desiredBufferSize = frameSize * m_ActiveAudioConfig.samplesPerFrame;
+    void* buffer = m_AudioRenderer->getAudioBuffer(&desiredBufferSize);
+    if (buffer == nullptr) {
+        return;
+    }
+
+    // A null sample invokes Opus packet loss concealment. When decoding FEC
+    // data, the frame size must match the duration of the lost frame exactly.
+    uint64_t decodeStartUs = LiGetMicroseconds();
+    if (m_AudioRenderer->getAudioBufferFormat() == IAudioRenderer::AudioFormat::Float32NE) {
+        samplesDecoded = opus_multistream_decode_float(m_OpusDecoder,
+                                                       sampleData,
+                                                       sampleLength,
+                                                       (float*)buffer,
+                                                       desiredBufferSize / frameSize,
+                                                       decodeFec ? 1 : 0);
+    }
+    else {
+        samplesDecoded = opus_multistream_decode(m_OpusDecoder,
+                                                 sampleData,
+                                                 sampleLength,
+                                                 (short*)buffer,
+                                                 desiredBufferSize / frameSize,
+                                                 decodeFec ? 1 : 0);
+    }
+
+    // Update desiredSize with the number of bytes actually populated by the decoding operation
+    if (samplesDecoded > 0) {
+        SDL_assert(desiredBufferSize >= frameSize * samplesDecoded);
+        desiredBufferSize = frameSize * samplesDecoded;
+
+        m_ActiveWndAudioStats.decodedFrames++;
+        m_ActiveWndAudioStats.totalDecodeTimeUs += LiGetMicroseconds() - decodeStartUs;
+    }
+    else {
+        desiredBufferSize = 0;
+    }
+
+    // Don't queue if there's already too much audio data waiting in
+    // Moonlight's audio queue. We still decode to keep Opus state intact.
+    int pendingAudioMs = LiGetPendingAudioDuration();
+    if (desiredBufferSize > 0 && pendingAudioMs > m_AudioRenderer->getMaxPendingAudioMs()) {
+        m_ActiveWndAudioStats.pendingAudioDrops++;
+        desiredBufferSize = 0;
+    }
+
+    bool rendererOk = m_AudioRenderer->submitAudio(desiredBufferSize);
+
+    m_ActiveWndAudioStats.queueSamples++;
+    m_ActiveWndAudioStats.totalPendingAudioMs += pendingAudioMs;
+
+    int rendererQueueMs = m_AudioRenderer->getBufferedLatencyMs();
+    if (rendererQueueMs >= 0) {
+        m_ActiveWndAudioStats.rendererQueueSamples++;
+        m_ActiveWndAudioStats.totalRendererQueueMs += rendererQueueMs;
+    }
+
+    int underruns = m_AudioRenderer->getUnderrunCount();
+    m_ActiveWndAudioStats.underruns += underruns - m_LastAudioUnderrunCount;
+    m_LastAudioUnderrunCount = underruns;
+
+    m_ActiveWndAudioStats.rateCorrectionPpm = m_AudioRenderer->getRateCorrectionPpm();
+
+    if (!rendererOk) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
+                    "Reinitializing audio renderer after failure");
+
+        // The new decoder won't have any state to recover the lost frame from
+        m_PendingLostAudioFrames = 0;
+
+        opus_multistream_decoder_destroy(m_OpusDecoder);
+        m_OpusDecoder = nullptr;
+
+        delete m_AudioRenderer;
+        m_AudioRenderer = nullptr;
+    }
+}
+
+void Session::arDecodeAndPlaySample(char* sampleData, int sampleLength)
+{
 #ifndef STEAM_LINK
     // Set this thread to high priority to reduce the chance of missing
     // our sample delivery time. On Steam Link, this causes starvation
@@ -175,62 +288,61 @@ void Session::arDecodeAndPlaySample(char* sampleData, int sampleLength)
                         "Audio drop window has ended");
         }
         else {
-            // We're still in the drop window
+            // We're still in the drop window. Losses from before it
+            // must not be concealed into the first decoded frame after.
+            s_ActiveSession->m_PendingLostAudioFrames = 0;
             return;
         }
     }
 
     s_ActiveSession->m_AudioSampleCount++;
 
+    if (sampleData == nullptr) {
+        s_ActiveSession->m_ActiveWndAudioStats.lostPackets++;
+    }
+    else {
+        s_ActiveSession->m_ActiveWndAudioStats.receivedPackets++;
+    }
+
+    s_ActiveSession->updateAudioStatsWindow();
+
     // If audio is muted, don't decode or play the audio
     if (s_ActiveSession->m_AudioMuted) {
+        s_ActiveSession->m_PendingLostAudioFrames = 0;
         return;
     }
 
     if (s_ActiveSession->m_AudioRenderer != nullptr) {
-        int sampleSize = s_ActiveSession->m_AudioRenderer->getAudioBufferSampleSize();
-        int frameSize = sampleSize * s_ActiveSession->m_ActiveAudioConfig.channelCount;
-        int desiredBufferSize = frameSize * s_ActiveSession->m_ActiveAudioConfig.samplesPerFrame;
-        void* buffer = s_ActiveSession->m_AudioRenderer->getAudioBuffer(&desiredBufferSize);
-        if (buffer == nullptr) {
-            return;
-        }
-
-        if (s_ActiveSession->m_AudioRenderer->getAudioBufferFormat() == IAudioRenderer::AudioFormat::Float32NE) {
-            samplesDecoded = opus_multistream_decode_float(s_ActiveSession->m_OpusDecoder,
-                                                           (unsigned char*)sampleData,
-                                                           sampleLength,
-                                                           (float*)buffer,
-                                                           desiredBufferSize / frameSize,
-                                                           0);
-        }
-        else {
-            samplesDecoded = opus_multistream_decode(s_ActiveSession->m_OpusDecoder,
-                                                     (unsigned char*)sampleData,
-                                                     sampleLength,
-                                                     (short*)buffer,
-                                                     desiredBufferSize / frameSize,
-                                                     0);
-        }
-
-        // Update desiredSize with the number of bytes actually populated by the decoding operation
-        if (samplesDecoded > 0) {
-            SDL_assert(desiredBufferSize >= frameSize * samplesDecoded);
-            desiredBufferSize = frameSize * samplesDecoded;
+        if (sampleData == nullptr) {
+            // The streaming library passes an empty sample for each lost packet.
+            // Opus in-band FEC data for a lost frame rides along in the packet
+            // after it, so hold off on the most recent loss until that packet
+            // arrives. Older losses in a burst can only be concealed.
+            if (s_ActiveSession->m_PendingLostAudioFrames > 0) {
+                s_ActiveSession->m_ActiveWndAudioStats.concealedFrames++;
+                s_ActiveSession->decodeAndPlayAudioFrame(nullptr, 0, false);
+            }
+            else {
+                s_ActiveSession->m_PendingLostAudioFrames++;
+            }
         }
         else {
-            desiredBufferSize = 0;
-        }
-
-        if (!s_ActiveSession->m_AudioRenderer->submitAudio(desiredBufferSize)) {
-            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
-                        "Reinitializing audio renderer after failure");
-
-            opus_multistream_decoder_destroy(s_ActiveSession->m_OpusDecoder);
-            s_ActiveSession->m_OpusDecoder = nullptr;
-
-            delete s_ActiveSession->m_AudioRenderer;
-            s_ActiveSession->m_AudioRenderer = nullptr;
+            if (s_ActiveSession->m_PendingLostAudioFrames > 0) {
+                s_ActiveSession->m_PendingLostAudioFrames = 0;
+
+                // In-band FEC only exists in SILK and hybrid mode packets. For CELT-only
+                // packets (which is what low-latency 5 ms frames use), decoding with FEC
+                // just falls back to concealment, so don't count it as recovered.
+                if (sampleLength > 0 && OPUS_TOC_CONFIG(sampleData[0]) < OPUS_TOC_FIRST_CELT_CONFIG) {
+                    s_ActiveSession->m_ActiveWndAudioStats.recoveredFrames++;
+                }
+                else {
+                    s_ActiveSession->m_ActiveWndAudioStats.concealedFrames++;
+                }
+                s_ActiveSession->decodeAndPlayAudioFrame((unsigned char*)sampleData, sampleLength, true);
+            }
+
+            s_ActiveSession->decodeAndPlayAudioFrame((unsigned char*)sampleData, sampleLength, false);
         }
     }
 
@@ -253,3 +365,169 @@ void Session::arDecodeAndPlaySample(char* sampleData, int sampleLength)
         }
     }
 }
+
+void Session::updateAudioStatsWindow()
+{
+    uint64_t nowUs = LiGetMicroseconds();
+
+    if (m_ActiveWndAudioStats.measurementStartUs == 0) {
+        m_ActiveWndAudioStats.measurementStartUs = nowUs;
+        return;
+    }
+
+    // Flip stats windows roughly every second, like the video stats
+    if (nowUs < m_ActiveWndAudioStats.measurementStartUs + 1000000) {
+        return;
+    }
+
+    AUDIO_STATS lastTwoWndStats = {};
+    addAudioStats(m_LastWndAudioStats, lastTwoWndStats);
+    addAudioStats(m_ActiveWndAudioStats, lastTwoWndStats);
+
+    SDL_AtomicLock(&m_OverlayAudioStatsLock);
+    m_OverlayAudioStats = lastTwoWndStats;
+    SDL_AtomicUnlock(&m_OverlayAudioStatsLock);
+
+    // Accumulate these values into the global stats
+    addAudioStats(m_ActiveWndAudioStats, m_GlobalAudioStats);
+
+    // Move this window into the last window slot and clear it for next window
+    m_LastWndAudioStats = m_ActiveWndAudioStats;
+    SDL_zero(m_ActiveWndAudioStats);
+    m_ActiveWndAudioStats.measurementStartUs = nowUs;
+}
+
+void Session::addAudioStats(AUDIO_STATS& src, AUDIO_STATS& dst)
+{
+    dst.receivedPackets += src.receivedPackets;
+    dst.lostPackets += src.lostPackets;
+    dst.recoveredFrames += src.recoveredFrames;
+    dst.concealedFrames += src.concealedFrames;
+    dst.decodedFrames += src.decodedFrames;
+    dst.pendingAudioDrops += src.pendingAudioDrops;
+    dst.underruns += src.underruns;
+    dst.queueSamples += src.queueSamples;
+    dst.rendererQueueSamples += src.rendererQueueSamples;
+    dst.totalDecodeTimeUs += src.totalDecodeTimeUs;
+    dst.totalPendingAudioMs += src.totalPendingAudioMs;
+    dst.totalRendererQueueMs += src.totalRendererQueueMs;
+
+    // The source window is the more recent one
+    if (src.queueSamples != 0) {
+        dst.rateCorrectionPpm = src.rateCorrectionPpm;
+    }
+
+    uint32_t rttVariance;
+    if (!LiGetEstimatedRttInfo(&dst.lastRtt, &rttVariance)) {
+        dst.lastRtt = 0;
+    }
+
+    if (!dst.measurementStartUs) {
+        dst.measurementStartUs = src.measurementStartUs;
+    }
+}
+
+void Session::stringifyAudioStats(AUDIO_STATS& stats, char* output, int length)
+{
+    int offset = 0;
+    int ret;
+
+    if (length <= 0) {
+        return;
+    }
+
+    output[0] = 0;
+
+    if (stats.queueSamples == 0 || stats.decodedFrames == 0) {
+        return;
+    }
+
+    double pendingAudioMs = (double)stats.totalPendingAudioMs / stats.queueSamples;
+    double decodeTimeMs = (double)(stats.totalDecodeTimeUs / 1000.0) / stats.decodedFrames;
+
+    // Renderers that don't track their output buffer are left out of the estimate
+    double rendererQueueMs = 0;
+    if (stats.rendererQueueSamples != 0) {
+        rendererQueueMs = (double)stats.totalRendererQueueMs / stats.rendererQueueSamples;
+    }
+
+    ret = snprintf(&output[offset],
+                   length - offset,
+                   "Audio queue delay: %.1f ms (output buffer: %.1f ms)\n"
+                   "Average audio decoding time: %.2f ms\n",
+                   pendingAudioMs + rendererQueueMs,
+                   rendererQueueMs,
+                   decodeTimeMs);
+    if (ret < 0 || ret >= length - offset) {
+        SDL_assert(false);
+        return;
+    }
+
+    offset += ret;
+
+    // One-way network latency is estimated as half the round trip
+    if (stats.lastRtt != 0) {
+        ret = snprintf(&output[offset],
+                       length - offset,
+                       "Estimated end-to-end audio latency: %.1f ms\n",
+                       stats.lastRtt / 2.0 + pendingAudioMs + decodeTimeMs + rendererQueueMs);
+        if (ret < 0 || ret >= length - offset) {
+            SDL_assert(false);
+            return;
+        }
+
+        offset += ret;
+    }
+
+    ret = snprintf(&output[offset],
+                   length - offset,
+                   "Audio packets lost: %.2f%% (%u recovered with FEC, %u concealed)\n"
+                   "Audio underruns: %u, frames dropped due to queued audio: %u\n",
+                   (float)stats.lostPackets / (stats.receivedPackets + stats.lostPackets) * 100,
+                   stats.recoveredFrames,
+                   stats.concealedFrames,
+                   stats.underruns,
+                   stats.pendingAudioDrops);
+    if (ret < 0 || ret >= length - offset) {
+        SDL_assert(false);
+        return;
+    }
+
+    offset += ret;
+
+    if (stats.rateCorrectionPpm != 0) {
+        ret = snprintf(&output[offset],
+                       length - offset,
+                       "Audio clock drift correction: %+.3f%%\n",
+                       stats.rateCorrectionPpm / 10000.0);
+        if (ret < 0 || ret >= length - offset) {
+            SDL_assert(false);
+            return;
+        }
+
+        offset += ret;
+    }
+}
+
+void Session::stringifyAudioStats(char* output, int length)
+{
+    AUDIO_STATS stats;
+
+    SDL_AtomicLock(&m_OverlayAudioStatsLock);
+    stats = m_OverlayAudioStats;
+    SDL_AtomicUnlock(&m_OverlayAudioStatsLock);
+
+    stringifyAudioStats(stats, output, length);
+}
+
+void Session::logAudioStats(AUDIO_STATS& stats, const char* title)
+{
+    if (stats.decodedFrames != 0) {
+        char audioStatsStr[1024];
+        stringifyAudioStats(stats, audioStatsStr, sizeof(audioStatsStr));
+
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                    "\n%s\n------------------\n%s",
+                    title, audioStatsStr);
+    }
+}
@@ -0,0 +1,110 @@
+#include "audioring.h"
+
+AudioRing::AudioRing()
+    : m_Buffer(nullptr),
+      m_SlotBytes(nullptr),
+      m_SlotCount(0),
+      m_SlotSize(0),
+      m_ReadOffset(0)
+{
+    SDL_AtomicSet(&m_WriteIndex, 0);
+    SDL_AtomicSet(&m_ReadIndex, 0);
+    SDL_AtomicSet(&m_QueuedBytes, 0);
+}
+
+AudioRing::~AudioRing()
+{
+    SDL_free(m_Buffer);
+    SDL_free(m_SlotBytes);
+}
+
+bool AudioRing::initialize(int slotCount, int slotSize)
+{
+    SDL_assert(m_Buffer == nullptr);
+    SDL_assert(slotCount > 0 && (slotCount & (slotCount - 1)) == 0);
+
+    m_Buffer = (Uint8*)SDL_malloc(slotCount * slotSize);
+    m_SlotBytes = (int*)SDL_calloc(slotCount, sizeof(*m_SlotBytes));
+    if (m_Buffer == nullptr || m_SlotBytes == nullptr) {
+        return false;
+    }
+
+    m_SlotCount = slotCount;
+    m_SlotSize = slotSize;
+    return true;
+}
+
+void* AudioRing::beginWrite()
+{
+    int writeIndex = SDL_AtomicGet(&m_WriteIndex);
+
+    // The indices are free-running, so the difference is the number of filled slots
+    if (writeIndex - SDL_AtomicGet(&m_ReadIndex) >= m_SlotCount) {
+        return nullptr;
+    }
+
+    return &m_Buffer[(writeIndex & (m_SlotCount - 1)) * m_SlotSize];
+}
+
+void AudioRing::commitWrite(int bytesWritten)
+{
+    SDL_assert(bytesWritten <= m_SlotSize);
+
+    if (bytesWritten <= 0) {
+        return;
+    }
+
+    int writeIndex = SDL_AtomicGet(&m_WriteIndex);
+    m_SlotBytes[writeIndex & (m_SlotCount - 1)] = bytesWritten;
+
+    // SDL_AtomicSet() is a full barrier, so the slot contents and length
+    // are visible to the consumer before the slot itself is.
+    SDL_AtomicAdd(&m_QueuedBytes, bytesWritten);
+    SDL_AtomicSet(&m_WriteIndex, writeIndex + 1);
+}
+
+int AudioRing::read(void* dest, int length)
+{
+    return consume(dest, length);
+}
+
+int AudioRing::discard(int length)
+{
+    return consume(nullptr, length);
+}
+
+int AudioRing::consume(void* dest, int length)
+{
+    int readIndex = SDL_AtomicGet(&m_ReadIndex);
+    int writeIndex = SDL_AtomicGet(&m_WriteIndex);
+    int bytesConsumed = 0;
+
+    while (bytesConsumed < length && readIndex != writeIndex) {
+        int slot = readIndex & (m_SlotCount - 1);
+        int bytesToCopy = SDL_min(length - bytesConsumed, m_SlotBytes[slot] - m_ReadOffset);
+
+        if (dest != nullptr) {
+            memcpy((Uint8*)dest + bytesConsumed, &m_Buffer[slot * m_SlotSize + m_ReadOffset], bytesToCopy);
+        }
+
+        bytesConsumed += bytesToCopy;
+        m_ReadOffset += bytesToCopy;
+
+        // Move to the next slot once this one is drained
+        if (m_ReadOffset == m_SlotBytes[slot]) {
+            m_ReadOffset = 0;
+            readIndex++;
+        }
+    }
+
+    // Hand the drained slots back to the producer
+    SDL_AtomicAdd(&m_QueuedBytes, -bytesConsumed);
+    SDL_AtomicSet(&m_ReadIndex, readIndex);
+
+    return bytesConsumed;
+}
+
+int AudioRing::getQueuedBytes()
+{
+    return SDL_AtomicGet(&m_QueuedBytes);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "SDL_compat.h"
+
+// Single-producer, single-consumer ring of audio frames.
+//
+// The producer (the audio decoder thread) decodes straight into the next free
+// slot and commits it. The consumer (the audio device callback) reads an
+// arbitrary number of bytes spanning slots. Neither side ever blocks or takes
+// a lock, so the device callback can't be stalled by the decoder or vice versa.
+class AudioRing
+{
+public:
+    AudioRing();
+    ~AudioRing();
+
+    // slotCount must be a power of 2
+    bool initialize(int slotCount, int slotSize);
+
+    // Producer side: returns nullptr if the ring is full
+    void* beginWrite();
+    void commitWrite(int bytesWritten);
+
+    // Consumer side: returns the number of bytes copied to dest
+    int read(void* dest, int length);
+
+    // Consumer side: discards up to length bytes from the head of the ring
+    int discard(int length);
+
+    // Safe to call from either side
+    int getQueuedBytes();
+
+private:
+    int consume(void* dest, int length);
+
+    Uint8* m_Buffer;
+    int* m_SlotBytes;
+    int m_SlotCount;
+    int m_SlotSize;
+
+    // Written only by the producer
+    SDL_atomic_t m_WriteIndex;
+
+    // Written only by the consumer
+    SDL_atomic_t m_ReadIndex;
+    int m_ReadOffset;
+
+    SDL_atomic_t m_QueuedBytes;
+};
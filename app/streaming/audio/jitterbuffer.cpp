@@ -0,0 +1,153 @@
+#include "jitterbuffer.h"
+
+// Never change the playback rate by more than 0.5%. This is plenty to absorb
+// real clock drift (typically well under 0.1%) and is inaudible.
+#define MAX_RATE_CORRECTION 0.005
+
+// Queue depth is smoothed over about a second, so network jitter and the
+// sawtooth of frames arriving and being played out don't move the rate.
+#define DEPTH_SMOOTHING_SECS 1.0
+
+// A queue depth of twice the target speeds playback up by 0.2% right away,
+// and the integral term removes whatever steady-state error remains.
+#define RATE_KP 0.002
+#define RATE_KI 0.0005
+
+// Queued audio kept on top of what the device and the Opus frame in flight
+// need, to ride out network jitter
+#define LATENCY_MARGIN_MS 5
+
+AudioJitterBuffer::AudioJitterBuffer()
+    : m_ChannelCount(0),
+      m_SampleRate(0),
+      m_TargetFrames(0),
+      m_InputFrames(0),
+      m_Phase(0),
+      m_Started(false),
+      m_Ratio(1.0),
+      m_SmoothedDepth(0),
+      m_Integral(0)
+{
+    SDL_AtomicSet(&m_LatencyMs, 0);
+    SDL_AtomicSet(&m_CorrectionPpm, 0);
+}
+
+int AudioJitterBuffer::getMinimumTargetLatencyMs(int sampleRate, int deviceFrames, int frameSamples)
+{
+    // The device pulls a whole buffer per read, so the queue must hold at
+    // least that plus the frame still in flight, or nearly every read runs dry
+    int minFrames = deviceFrames + frameSamples + sampleRate * LATENCY_MARGIN_MS / 1000;
+    return (minFrames * 1000 + sampleRate - 1) / sampleRate;
+}
+
+bool AudioJitterBuffer::initialize(int channelCount, int sampleRate, int targetLatencyMs, int maxFramesPerRead)
+{
+    m_ChannelCount = channelCount;
+    m_SampleRate = sampleRate;
+    m_TargetFrames = SDL_max(1, sampleRate * targetLatencyMs / 1000);
+    m_SmoothedDepth = m_TargetFrames;
+
+    // Allocate up front since read() runs in the audio callback. At the maximum
+    // rate, one read consumes up to 0.5% more frames than it produces, plus
+    // the 2 frames interpolation needs on either side of the read position.
+    int maxInputFrames = (int)(maxFramesPerRead * (1.0 + MAX_RATE_CORRECTION)) + 3;
+    m_Input.resize((size_t)maxInputFrames * channelCount);
+
+    return true;
+}
+
+double AudioJitterBuffer::getQueuedFrames(AudioRing& ring)
+{
+    int frameSize = m_ChannelCount * sizeof(float);
+    return ring.getQueuedBytes() / frameSize + m_InputFrames - m_Phase;
+}
+
+void AudioJitterBuffer::updateRate(AudioRing& ring, int frameCount)
+{
+    double depth = getQueuedFrames(ring);
+    double dt = (double)frameCount / m_SampleRate;
+
+    m_SmoothedDepth += (depth - m_SmoothedDepth) * SDL_min(1.0, dt / DEPTH_SMOOTHING_SECS);
+
+    double error = (m_SmoothedDepth - m_TargetFrames) / m_TargetFrames;
+    m_Integral = SDL_clamp(m_Integral + error * RATE_KI * dt, -MAX_RATE_CORRECTION, MAX_RATE_CORRECTION);
+    m_Ratio = 1.0 + SDL_clamp(error * RATE_KP + m_Integral, -MAX_RATE_CORRECTION, MAX_RATE_CORRECTION);
+
+    SDL_AtomicSet(&m_LatencyMs, (int)(m_SmoothedDepth * 1000 / m_SampleRate));
+    SDL_AtomicSet(&m_CorrectionPpm, (int)((m_Ratio - 1.0) * 1000000));
+}
+
+int AudioJitterBuffer::read(AudioRing& ring, float* output, int frameCount)
+{
+    int frameSize = m_ChannelCount * sizeof(float);
+
+    // Hold off playback until the queue first reaches the target. Starting
+    // on the first frame would leave nothing to absorb the device pulling a
+    // whole buffer at once, and we'd run dry right away.
+    if (!m_Started) {
+        if (getQueuedFrames(ring) < m_TargetFrames) {
+            memset(output, 0, (size_t)frameCount * frameSize);
+            return 0;
+        }
+
+        m_Started = true;
+    }
+
+    updateRate(ring, frameCount);
+
+    // Pull in enough input to interpolate every output frame. Ring slots
+    // always hold whole frames, so reads never split a frame.
+    int framesNeeded = SDL_min((int)(m_Phase + (frameCount - 1) * m_Ratio) + 2,
+                               (int)(m_Input.size() / m_ChannelCount));
+    if (m_InputFrames < framesNeeded) {
+        m_InputFrames += ring.read(&m_Input[(size_t)m_InputFrames * m_ChannelCount],
+                                   (framesNeeded - m_InputFrames) * frameSize) / frameSize;
+    }
+
+    // Linearly interpolate between input frames at our adjusted rate
+    int framesProduced = 0;
+    for (; framesProduced < frameCount; framesProduced++) {
+        double position = m_Phase + framesProduced * m_Ratio;
+        int index = (int)position;
+        if (index + 1 >= m_InputFrames) {
+            break;
+        }
+
+        float fraction = (float)(position - index);
+        const float* a = &m_Input[(size_t)index * m_ChannelCount];
+        const float* b = a + m_ChannelCount;
+        float* out = &output[(size_t)framesProduced * m_ChannelCount];
+        for (int i = 0; i < m_ChannelCount; i++) {
+            out[i] = a[i] + (b[i] - a[i]) * fraction;
+        }
+    }
+
+    // Pad any shortfall with silence
+    if (framesProduced < frameCount) {
+        memset(&output[(size_t)framesProduced * m_ChannelCount], 0,
+               (size_t)(frameCount - framesProduced) * frameSize);
+    }
+
+    // Drop the input frames we've moved past and keep the fractional position
+    double endPosition = m_Phase + framesProduced * m_Ratio;
+    int framesConsumed = SDL_min((int)endPosition, m_InputFrames);
+    m_Phase = endPosition - framesConsumed;
+    m_InputFrames -= framesConsumed;
+    if (framesConsumed > 0 && m_InputFrames > 0) {
+        memmove(m_Input.data(),
+                &m_Input[(size_t)framesConsumed * m_ChannelCount],
+                (size_t)m_InputFrames * frameSize);
+    }
+
+    return framesProduced;
+}
+
+int AudioJitterBuffer::getBufferedLatencyMs()
+{
+    return SDL_AtomicGet(&m_LatencyMs);
+}
+
+int AudioJitterBuffer::getRateCorrectionPpm()
+{
+    return SDL_AtomicGet(&m_CorrectionPpm);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "audioring.h"
+
+#include <vector>
+
+// Plays float audio out of an AudioRing while holding the amount of audio
+// queued ahead of the device near a target latency.
+//
+// The host's audio clock and our output device's clock never run at exactly
+// the same rate, so the queue slowly grows or drains over a long session.
+// Rather than correcting that with audible drops or gaps, we resample by up
+// to +/-0.5% to gently speed up or slow down playback until the queue depth
+// settles back at the target.
+class AudioJitterBuffer
+{
+public:
+    AudioJitterBuffer();
+
+    bool initialize(int channelCount, int sampleRate, int targetLatencyMs, int maxFramesPerRead);
+
+    // The lowest target that keeps a device pulling deviceFrames per read fed
+    // while the next frameSamples Opus frame is still in flight, plus a small
+    // margin for network jitter
+    static int getMinimumTargetLatencyMs(int sampleRate, int deviceFrames, int frameSamples);
+
+    // Consumer side: always fills frameCount frames, padding with silence if
+    // the ring runs dry. Returns the number of frames of real audio produced,
+    // which is 0 until the queue first fills up to the target.
+    int read(AudioRing& ring, float* output, int frameCount);
+
+    // Safe to call from any thread
+    int getBufferedLatencyMs();
+    int getRateCorrectionPpm();
+
+private:
+    double getQueuedFrames(AudioRing& ring);
+    void updateRate(AudioRing& ring, int frameCount);
+
+    int m_ChannelCount;
+    int m_SampleRate;
+    int m_TargetFrames;
+
+    // Input frames pulled from the ring but not yet fully consumed
+    std::vector<float> m_Input;
+    int m_InputFrames;
+    double m_Phase;
+    bool m_Started;
+
+    double m_Ratio;
+    double m_SmoothedDepth;
+    double m_Integral;
+
+    SDL_atomic_t m_LatencyMs;
+    SDL_atomic_t m_CorrectionPpm;
+};
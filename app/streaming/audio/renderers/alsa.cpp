@@ -0,0 +1,456 @@
+#include "alsa.h"
+#include "streaming/audio/sampleconverter.h"
+
+#include <opus.h>
+
+// Amount of audio we prefill before starting the device, which is also the
+// amount we try to keep queued to ride out network jitter. It can be
+// overridden with ML_AUDIO_LATENCY_MS, just like the SDL renderer.
+#define DEFAULT_TARGET_LATENCY_MS 10
+
+// Frames that arrive when the device queue is above this multiple of the
+// target are dropped to keep latency bounded.
+#define MAX_LATENCY_MULTIPLIER 4
+
+// Number of periods in the device buffer. This must cover the latency cap.
+#define MIN_PERIOD_COUNT 4
+
+AlsaAudioRenderer::AlsaAudioRenderer()
+    : m_Pcm(nullptr),
+      m_DeviceFormat(AudioFormat::Float32NE),
+      m_Mmap(false),
+      m_SampleRate(0),
+      m_ChannelCount(0),
+      m_SampleFrameSize(0),
+      m_PeriodFrames(0),
+      m_BufferFrames(0),
+      m_StartFrames(0),
+      m_MaxDelayFrames(0),
+      m_AudioBuffer(nullptr),
+      m_AudioBufferSize(0),
+      m_ConvertBuffer(nullptr),
+      m_SoftClipMem(nullptr),
+      m_DelayFrames(-1),
+      m_TotalDelayFrames(0),
+      m_DelaySamples(0),
+      m_Underruns(0),
+      m_DroppedFrames(0)
+{
+}
+
+bool AlsaAudioRenderer::prepareForPlayback(const OPUS_MULTISTREAM_CONFIGURATION* opusConfig)
+{
+    int err;
+
+    // PipeWire and PulseAudio are reachable through their ALSA plugins via
+    // the default device, but a hw: or plughw: device bypasses the sound server.
+    const char* deviceName = SDL_getenv("ML_ALSA_DEVICE");
+    if (deviceName == nullptr) {
+        deviceName = "default";
+    }
+
+    // Non-blocking so a stalled device can never hold up the audio thread
+    err = snd_pcm_open(&m_Pcm, deviceName, SND_PCM_STREAM_PLAYBACK, SND_PCM_NONBLOCK);
+    if (err < 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "snd_pcm_open(%s) failed: %s",
+                     deviceName,
+                     snd_strerror(err));
+        m_Pcm = nullptr;
+        return false;
+    }
+
+    if (!configureHwParams(opusConfig) || !configureSwParams()) {
+        return false;
+    }
+
+    err = snd_pcm_prepare(m_Pcm);
+    if (err < 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "snd_pcm_prepare() failed: %s",
+                     snd_strerror(err));
+        return false;
+    }
+
+    m_AudioBufferSize = opusConfig->samplesPerFrame * m_SampleFrameSize;
+    m_AudioBuffer = SDL_malloc(m_AudioBufferSize);
+    if (m_AudioBuffer == nullptr) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "Failed to allocate audio buffer");
+        return false;
+    }
+
+    if (m_DeviceFormat == AudioFormat::Sint16NE) {
+        m_ConvertBuffer = (short*)SDL_malloc(opusConfig->samplesPerFrame * m_ChannelCount * sizeof(short));
+        m_SoftClipMem = (float*)SDL_calloc(m_ChannelCount, sizeof(float));
+        if (m_ConvertBuffer == nullptr || m_SoftClipMem == nullptr) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                         "Failed to allocate audio conversion buffer");
+            return false;
+        }
+    }
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                "Using ALSA renderer on '%s': %s %s, %lu frame periods, %lu frame buffer, starting at %lu frames",
+                deviceName,
+                m_DeviceFormat == AudioFormat::Float32NE ? "float" : "s16",
+                m_Mmap ? "mmap" : "read/write",
+                m_PeriodFrames,
+                m_BufferFrames,
+                m_StartFrames);
+
+    return true;
+}
+
+bool AlsaAudioRenderer::configureHwParams(const OPUS_MULTISTREAM_CONFIGURATION* opusConfig)
+{
+    snd_pcm_hw_params_t* hwParams;
+    int err;
+
+    snd_pcm_hw_params_alloca(&hwParams);
+
+    err = snd_pcm_hw_params_any(m_Pcm, hwParams);
+    if (err < 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "snd_pcm_hw_params_any() failed: %s",
+                     snd_strerror(err));
+        return false;
+    }
+
+    // Prefer mmap access so ALSA copies straight into the device buffer
+    m_Mmap = snd_pcm_hw_params_set_access(m_Pcm, hwParams, SND_PCM_ACCESS_MMAP_INTERLEAVED) == 0;
+    if (!m_Mmap) {
+        err = snd_pcm_hw_params_set_access(m_Pcm, hwParams, SND_PCM_ACCESS_RW_INTERLEAVED);
+        if (err < 0) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                         "No supported ALSA access mode: %s",
+                         snd_strerror(err));
+            return false;
+        }
+    }
+
+    // Opus decodes natively to float, but fall back to 16-bit for devices that
+    // lack it. We still decode to float in that case and convert it ourselves.
+    if (snd_pcm_hw_params_set_format(m_Pcm, hwParams, SND_PCM_FORMAT_FLOAT) == 0) {
+        m_DeviceFormat = AudioFormat::Float32NE;
+    }
+    else {
+        err = snd_pcm_hw_params_set_format(m_Pcm, hwParams, SND_PCM_FORMAT_S16);
+        if (err < 0) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                         "No supported ALSA sample format: %s",
+                         snd_strerror(err));
+            return false;
+        }
+
+        m_DeviceFormat = AudioFormat::Sint16NE;
+    }
+
+    err = snd_pcm_hw_params_set_channels(m_Pcm, hwParams, opusConfig->channelCount);
+    if (err < 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "Unable to set %d ALSA channels: %s",
+                     opusConfig->channelCount,
+                     snd_strerror(err));
+        return false;
+    }
+
+    // We don't resample ourselves, so allow the plug layer to do it if needed
+    snd_pcm_hw_params_set_rate_resample(m_Pcm, hwParams, 1);
+    m_SampleRate = opusConfig->sampleRate;
+    err = snd_pcm_hw_params_set_rate(m_Pcm, hwParams, m_SampleRate, 0);
+    if (err < 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "Unable to set ALSA sample rate to %u: %s",
+                     m_SampleRate,
+                     snd_strerror(err));
+        return false;
+    }
+
+    m_ChannelCount = opusConfig->channelCount;
+    m_SampleFrameSize = m_ChannelCount * getAudioBufferSampleSize();
+
+    bool ok;
+    int targetLatencyMs = qEnvironmentVariableIntValue("ML_AUDIO_LATENCY_MS", &ok);
+    if (!ok || targetLatencyMs <= 0) {
+        targetLatencyMs = DEFAULT_TARGET_LATENCY_MS;
+    }
+
+    // One Opus frame per period, so each submitted frame is one period of work for the device
+    m_PeriodFrames = opusConfig->samplesPerFrame;
+    err = snd_pcm_hw_params_set_period_size_near(m_Pcm, hwParams, &m_PeriodFrames, nullptr);
+    if (err < 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "Unable to set ALSA period size: %s",
+                     snd_strerror(err));
+        return false;
+    }
+
+    m_StartFrames = SDL_max((snd_pcm_uframes_t)m_SampleRate * targetLatencyMs / 1000,
+                            (snd_pcm_uframes_t)opusConfig->samplesPerFrame);
+    m_MaxDelayFrames = m_StartFrames * MAX_LATENCY_MULTIPLIER;
+
+    m_BufferFrames = SDL_max(m_PeriodFrames * MIN_PERIOD_COUNT,
+                             (snd_pcm_uframes_t)m_MaxDelayFrames + m_PeriodFrames);
+    err = snd_pcm_hw_params_set_buffer_size_near(m_Pcm, hwParams, &m_BufferFrames);
+    if (err < 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "Unable to set ALSA buffer size: %s",
+                     snd_strerror(err));
+        return false;
+    }
+
+    err = snd_pcm_hw_params(m_Pcm, hwParams);
+    if (err < 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "snd_pcm_hw_params() failed: %s",
+                     snd_strerror(err));
+        return false;
+    }
+
+    snd_pcm_hw_params_get_period_size(hwParams, &m_PeriodFrames, nullptr);
+    snd_pcm_hw_params_get_buffer_size(hwParams, &m_BufferFrames);
+
+    // The device may have given us a smaller buffer than we asked for
+    m_StartFrames = SDL_min(m_StartFrames, m_BufferFrames);
+    m_MaxDelayFrames = SDL_min(m_MaxDelayFrames, (snd_pcm_sframes_t)(m_BufferFrames - m_PeriodFrames));
+
+    return true;
+}
+
+bool AlsaAudioRenderer::configureSwParams()
+{
+    snd_pcm_sw_params_t* swParams;
+    int err;
+
+    snd_pcm_sw_params_alloca(&swParams);
+
+    err = snd_pcm_sw_params_current(m_Pcm, swParams);
+    if (err < 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "snd_pcm_sw_params_current() failed: %s",
+                     snd_strerror(err));
+        return false;
+    }
+
+    // Start playback automatically once the target latency is queued. This
+    // also applies after recovering from an underrun, so we rebuild the
+    // cushion rather than underrunning again on the next late packet.
+    err = snd_pcm_sw_params_set_start_threshold(m_Pcm, swParams, m_StartFrames);
+    if (err < 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "Unable to set ALSA start threshold: %s",
+                     snd_strerror(err));
+        return false;
+    }
+
+    err = snd_pcm_sw_params_set_avail_min(m_Pcm, swParams, m_PeriodFrames);
+    if (err < 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "Unable to set ALSA minimum available frames: %s",
+                     snd_strerror(err));
+        return false;
+    }
+
+    err = snd_pcm_sw_params(m_Pcm, swParams);
+    if (err < 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "snd_pcm_sw_params() failed: %s",
+                     snd_strerror(err));
+        return false;
+    }
+
+    return true;
+}
+
+AlsaAudioRenderer::~AlsaAudioRenderer()
+{
+    if (m_Pcm != nullptr) {
+        if (m_DelaySamples > 0) {
+            SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                        "ALSA audio stats: %d underruns, %d ms dropped to bound latency, %d ms average device delay",
+                        m_Underruns,
+                        (int)((Sint64)m_DroppedFrames * 1000 / m_SampleRate),
+                        (int)(m_TotalDelayFrames * 1000 / m_SampleRate / m_DelaySamples));
+        }
+
+        snd_pcm_drop(m_Pcm);
+        snd_pcm_close(m_Pcm);
+    }
+
+    if (m_AudioBuffer != nullptr) {
+        SDL_free(m_AudioBuffer);
+    }
+
+    if (m_ConvertBuffer != nullptr) {
+        SDL_free(m_ConvertBuffer);
+    }
+
+    if (m_SoftClipMem != nullptr) {
+        SDL_free(m_SoftClipMem);
+    }
+}
+
+void AlsaAudioRenderer::remapChannels(POPUS_MULTISTREAM_CONFIGURATION opusConfig)
+{
+    OPUS_MULTISTREAM_CONFIGURATION originalConfig = *opusConfig;
+
+    // Moonlight's default channel order is FL,FR,C,LFE,RL,RR,SL,SR
+    // ALSA expects FL,FR,RL,RR,C,LFE,SL,SR for 5.1/7.1 so we swap the channels around to match
+    if (opusConfig->channelCount >= 6) {
+        opusConfig->mapping[2] = originalConfig.mapping[4];
+        opusConfig->mapping[3] = originalConfig.mapping[5];
+        opusConfig->mapping[4] = originalConfig.mapping[2];
+        opusConfig->mapping[5] = originalConfig.mapping[3];
+    }
+}
+
+void* AlsaAudioRenderer::getAudioBuffer(int* size)
+{
+    SDL_assert(*size <= m_AudioBufferSize);
+    return m_AudioBuffer;
+}
+
+snd_pcm_sframes_t AlsaAudioRenderer::writeFrames(snd_pcm_uframes_t frames)
+{
+    const void* buffer = m_DeviceFormat == AudioFormat::Sint16NE ? (const void*)m_ConvertBuffer : m_AudioBuffer;
+
+    if (m_Mmap) {
+        return snd_pcm_mmap_writei(m_Pcm, buffer, frames);
+    }
+    else {
+        return snd_pcm_writei(m_Pcm, buffer, frames);
+    }
+}
+
+int AlsaAudioRenderer::recoverDevice(int err)
+{
+    if (err == -EPIPE) {
+        m_Underruns++;
+        return snd_pcm_prepare(m_Pcm);
+    }
+    else if (err == -ESTRPIPE) {
+        // snd_pcm_recover() sleeps until a suspended device finishes resuming,
+        // which would stall the audio thread. Poll instead: -EAGAIN means it's
+        // still resuming, and we'll try again with the next frame.
+        err = snd_pcm_resume(m_Pcm);
+        if (err == -EAGAIN) {
+            return err;
+        }
+        else if (err < 0) {
+            // The hardware can't resume, so restart the stream instead
+            return snd_pcm_prepare(m_Pcm);
+        }
+
+        return 0;
+    }
+
+    return err;
+}
+
+bool AlsaAudioRenderer::submitAudio(int bytesWritten)
+{
+    snd_pcm_sframes_t avail, delay;
+    int err;
+
+    if (bytesWritten == 0) {
+        // Nothing to do
+        return true;
+    }
+
+    snd_pcm_uframes_t frames = bytesWritten / m_SampleFrameSize;
+
+    err = snd_pcm_avail_delay(m_Pcm, &avail, &delay);
+    if (err < 0) {
+        // Returns an error if the device underran or was suspended
+        err = recoverDevice(err);
+        if (err == -EAGAIN) {
+            m_DelayFrames = 0;
+            m_DroppedFrames += frames;
+            return true;
+        }
+        else if (err < 0) {
+            // The device is gone, so we need to reinitialize
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                         "Unable to recover ALSA device: %s",
+                         snd_strerror(err));
+            return false;
+        }
+
+        delay = 0;
+    }
+    else if (snd_pcm_state(m_Pcm) == SND_PCM_STATE_RUNNING) {
+        m_TotalDelayFrames += delay;
+        m_DelaySamples++;
+    }
+    else {
+        // The device is still prefilling
+        delay = SDL_max(delay, (snd_pcm_sframes_t)0);
+    }
+
+    m_DelayFrames = delay;
+
+    // A burst of audio after a network stall would otherwise sit in
+    // the device buffer as latency for the rest of the session.
+    if (delay > m_MaxDelayFrames) {
+        m_DroppedFrames += frames;
+        return true;
+    }
+
+    if (m_DeviceFormat == AudioFormat::Sint16NE) {
+        // Opus decoding to 16-bit soft clips before converting, so peaks
+        // above full scale are compressed rather than flattened. Do the same.
+        opus_pcm_soft_clip((float*)m_AudioBuffer, (int)frames, m_ChannelCount, m_SoftClipMem);
+        AudioSampleConverter::floatToS16((const float*)m_AudioBuffer, m_ConvertBuffer, (int)frames * m_ChannelCount);
+    }
+
+    snd_pcm_sframes_t written = writeFrames(frames);
+    if (written == -EPIPE || written == -ESTRPIPE) {
+        err = recoverDevice((int)written);
+        if (err == -EAGAIN) {
+            written = err;
+        }
+        else if (err < 0) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                         "Unable to recover ALSA device: %s",
+                         snd_strerror(err));
+            return false;
+        }
+        else {
+            written = writeFrames(frames);
+        }
+    }
+
+    if (written == -EAGAIN) {
+        // The device buffer is full or the device is still resuming
+        written = 0;
+    }
+    else if (written < 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "Failed to write ALSA audio: %s",
+                     snd_strerror((int)written));
+        return false;
+    }
+
+    m_DroppedFrames += frames - written;
+    return true;
+}
+
+IAudioRenderer::AudioFormat AlsaAudioRenderer::getAudioBufferFormat()
+{
+    return AudioFormat::Float32NE;
+}
+
+int AlsaAudioRenderer::getBufferedLatencyMs()
+{
+    if (m_DelayFrames < 0) {
+        return -1;
+    }
+
+    return (int)(m_DelayFrames * 1000 / m_SampleRate);
+}
+
+int AlsaAudioRenderer::getUnderrunCount()
+{
+    return m_Underruns;
+}
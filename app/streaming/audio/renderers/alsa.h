@@ -0,0 +1,59 @@
+#pragma once
+
+#include "renderer.h"
+#include "SDL_compat.h"
+
+#include <alsa/asoundlib.h>
+
+class AlsaAudioRenderer : public IAudioRenderer
+{
+public:
+    AlsaAudioRenderer();
+
+    virtual ~AlsaAudioRenderer();
+
+    virtual bool prepareForPlayback(const OPUS_MULTISTREAM_CONFIGURATION* opusConfig);
+
+    virtual void* getAudioBuffer(int* size);
+
+    virtual bool submitAudio(int bytesWritten);
+
+    virtual AudioFormat getAudioBufferFormat();
+
+    virtual void remapChannels(POPUS_MULTISTREAM_CONFIGURATION opusConfig);
+
+    virtual int getBufferedLatencyMs();
+
+    virtual int getUnderrunCount();
+
+private:
+    bool configureHwParams(const OPUS_MULTISTREAM_CONFIGURATION* opusConfig);
+
+    bool configureSwParams();
+
+    snd_pcm_sframes_t writeFrames(snd_pcm_uframes_t frames);
+
+    int recoverDevice(int err);
+
+    snd_pcm_t* m_Pcm;
+    AudioFormat m_DeviceFormat;
+    bool m_Mmap;
+    unsigned int m_SampleRate;
+    int m_ChannelCount;
+    int m_SampleFrameSize;
+    snd_pcm_uframes_t m_PeriodFrames;
+    snd_pcm_uframes_t m_BufferFrames;
+    snd_pcm_uframes_t m_StartFrames;
+    snd_pcm_sframes_t m_MaxDelayFrames;
+
+    void* m_AudioBuffer;
+    int m_AudioBufferSize;
+    short* m_ConvertBuffer;
+    float* m_SoftClipMem;
+
+    snd_pcm_sframes_t m_DelayFrames;
+    Sint64 m_TotalDelayFrames;
+    int m_DelaySamples;
+    int m_Underruns;
+    int m_DroppedFrames;
+};
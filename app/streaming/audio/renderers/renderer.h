@@ -3,6 +3,26 @@
 #include <Limelight.h>
 #include <QtGlobal>
 
+#include <stdint.h>
+
+typedef struct _AUDIO_STATS {
+    uint32_t receivedPackets;
+    uint32_t lostPackets;                      // signaled by the streaming library
+    uint32_t recoveredFrames;                  // rebuilt from Opus in-band FEC
+    uint32_t concealedFrames;                  // synthesized by Opus packet loss concealment
+    uint32_t decodedFrames;                    // including recovered and concealed frames
+    uint32_t pendingAudioDrops;                // too much audio queued in the streaming library
+    uint32_t underruns;                        // reported by the renderer
+    uint32_t queueSamples;
+    uint32_t rendererQueueSamples;
+    uint32_t lastRtt;                          // low-res from enet (1ms)
+    int32_t rateCorrectionPpm;                 // latest value from the renderer
+    uint64_t totalDecodeTimeUs;                // high-res (1us)
+    uint64_t totalPendingAudioMs;              // low-res (1ms)
+    uint64_t totalRendererQueueMs;             // low-res (1ms)
+    uint64_t measurementStartUs;               // microseconds
+} AUDIO_STATS, *PAUDIO_STATS;
+
 class IAudioRenderer
 {
 public:
@@ -31,6 +51,27 @@ public:
     };
     virtual AudioFormat getAudioBufferFormat() = 0;
 
+    // Audio queued ahead of the output device, or -1 if the renderer doesn't track it
+    virtual int getBufferedLatencyMs() {
+        return -1;
+    }
+
+    // Playback rate adjustment currently applied to compensate for clock drift
+    virtual int getRateCorrectionPpm() {
+        return 0;
+    }
+
+    // Total underruns since the renderer was created
+    virtual int getUnderrunCount() {
+        return 0;
+    }
+
+    // Decoded frames are dropped instead of submitted while the streaming
+    // library has more than this much audio waiting behind them
+    virtual int getMaxPendingAudioMs() {
+        return 30;
+    }
+
     int getAudioBufferSampleSize() {
         switch (getAudioBufferFormat()) {
         case IAudioRenderer::AudioFormat::Sint16NE:
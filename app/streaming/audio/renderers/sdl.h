@@ -1,6 +1,8 @@
 #pragma once
 
 #include "renderer.h"
+#include "streaming/audio/audioring.h"
+#include "streaming/audio/jitterbuffer.h"
 #include "SDL_compat.h"
 
 class SdlAudioRenderer : public IAudioRenderer
@@ -18,8 +20,33 @@ public:
 
     virtual AudioFormat getAudioBufferFormat();
 
+    virtual int getBufferedLatencyMs();
+
+    virtual int getRateCorrectionPpm();
+
+    virtual int getUnderrunCount();
+
 private:
+    static void SDLCALL audioCallback(void* userdata, Uint8* stream, int len);
+
+    void trimLatency(int callbackBytes);
+
     SDL_AudioDeviceID m_AudioDevice;
-    void* m_AudioBuffer;
+    AudioRing m_Ring;
+    AudioJitterBuffer m_JitterBuffer;
     int m_FrameSize;
+    int m_SampleFrameSize;
+    int m_BytesPerSecond;
+    int m_MaxQueuedBytes;
+    void* m_OverrunBuffer;
+    bool m_RingWritePending;
+
+    // Owned by the audio callback
+    bool m_PlaybackStarted;
+    int m_MinQueuedBytes;
+    int m_WindowBytes;
+
+    SDL_atomic_t m_Underruns;
+    SDL_atomic_t m_Overruns;
+    SDL_atomic_t m_DroppedBytes;
 };
@@ -2,10 +2,34 @@
 
 #include <Limelight.h>
 
+#include <climits>
+
+// Enough for 160 ms of 5 ms frames. This grows if the device buffer forces a
+// latency target high enough that the ring couldn't hold the maximum queue.
+#define RING_SLOT_COUNT 32
+
+// If a burst of audio leaves the queue above this multiple of the target for
+// a whole measurement window, it's more than the rate correction can drain
+// in reasonable time, so we drop the excess instead.
+#define MAX_LATENCY_MULTIPLIER 4
+#define LATENCY_WINDOW_MS 1000
+
 SdlAudioRenderer::SdlAudioRenderer()
     : m_AudioDevice(0),
-      m_AudioBuffer(nullptr)
+      m_FrameSize(0),
+      m_SampleFrameSize(0),
+      m_BytesPerSecond(0),
+      m_MaxQueuedBytes(0),
+      m_OverrunBuffer(nullptr),
+      m_RingWritePending(false),
+      m_PlaybackStarted(false),
+      m_MinQueuedBytes(INT_MAX),
+      m_WindowBytes(0)
 {
+    SDL_AtomicSet(&m_Underruns, 0);
+    SDL_AtomicSet(&m_Overruns, 0);
+    SDL_AtomicSet(&m_DroppedBytes, 0);
+
     SDL_assert(!SDL_WasInit(SDL_INIT_AUDIO));
 
     if (SDL_InitSubSystem(SDL_INIT_AUDIO) != 0) {
@@ -24,6 +48,8 @@ bool SdlAudioRenderer::prepareForPlayback(const OPUS_MULTISTREAM_CONFIGURATION*
     want.freq = opusConfig->sampleRate;
     want.format = AUDIO_F32SYS;
     want.channels = opusConfig->channelCount;
+    want.callback = audioCallback;
+    want.userdata = this;
 
     // On PulseAudio systems, setting a value too small can cause underruns for other
     // applications sharing this output device. We impose a floor of 480 samples (10 ms)
@@ -32,9 +58,9 @@ bool SdlAudioRenderer::prepareForPlayback(const OPUS_MULTISTREAM_CONFIGURATION*
     // The buffering helps avoid audio underruns due to network jitter.
     want.samples = SDL_max(480, opusConfig->samplesPerFrame * 3);
 
-    m_FrameSize = opusConfig->samplesPerFrame *
-                  opusConfig->channelCount *
-                  getAudioBufferSampleSize();
+    m_SampleFrameSize = opusConfig->channelCount * getAudioBufferSampleSize();
+    m_FrameSize = opusConfig->samplesPerFrame * m_SampleFrameSize;
+    m_BytesPerSecond = opusConfig->sampleRate * m_SampleFrameSize;
 
     m_AudioDevice = SDL_OpenAudioDevice(NULL, 0, &want, &have, 0);
     if (m_AudioDevice == 0) {
@@ -44,13 +70,59 @@ bool SdlAudioRenderer::prepareForPlayback(const OPUS_MULTISTREAM_CONFIGURATION*
         return false;
     }
 
-    m_AudioBuffer = SDL_malloc(m_FrameSize);
-    if (m_AudioBuffer == nullptr) {
+    // The device starts paused, so we have the buffer size before any
+    // callback can run and can size everything else from it. The jitter
+    // buffer holds the queue at the target by adjusting the playback rate.
+    // ML_AUDIO_LATENCY_MS can raise the target, but never below the floor.
+    int targetLatencyMs = AudioJitterBuffer::getMinimumTargetLatencyMs(have.freq, have.samples,
+                                                                       opusConfig->samplesPerFrame);
+
+    bool ok;
+    int latencyOverrideMs = qEnvironmentVariableIntValue("ML_AUDIO_LATENCY_MS", &ok);
+    if (ok && latencyOverrideMs > 0) {
+        if (latencyOverrideMs < targetLatencyMs) {
+            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
+                        "Audio target latency override of %d ms is below the %d ms minimum for a %u sample device buffer",
+                        latencyOverrideMs,
+                        targetLatencyMs,
+                        have.samples);
+        }
+        else {
+            SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                        "Using audio target latency override: %d ms",
+                        latencyOverrideMs);
+            targetLatencyMs = latencyOverrideMs;
+        }
+    }
+
+    int targetQueuedBytes = m_BytesPerSecond / 1000 * targetLatencyMs;
+    m_MaxQueuedBytes = targetQueuedBytes * MAX_LATENCY_MULTIPLIER;
+
+    // Leave room for bursts above the maximum before it gets trimmed
+    int slotCount = RING_SLOT_COUNT;
+    while (slotCount * m_FrameSize < m_MaxQueuedBytes * 2) {
+        slotCount *= 2;
+    }
+
+    // The Opus decoder writes directly into the ring, one frame per slot.
+    // The overrun buffer is only used to decode frames we must drop.
+    m_OverrunBuffer = SDL_malloc(m_FrameSize);
+    if (!m_Ring.initialize(slotCount, m_FrameSize) || m_OverrunBuffer == nullptr) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
                      "Failed to allocate audio buffer");
         return false;
     }
 
+    if (!m_JitterBuffer.initialize(have.channels, have.freq, targetLatencyMs, have.samples)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "Failed to allocate jitter buffer");
+        return false;
+    }
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                "Audio target latency: %d ms",
+                targetLatencyMs);
+
     SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
                 "Desired audio buffer: %u samples (%u bytes)",
                 want.samples,
@@ -74,65 +146,121 @@ bool SdlAudioRenderer::prepareForPlayback(const OPUS_MULTISTREAM_CONFIGURATION*
 SdlAudioRenderer::~SdlAudioRenderer()
 {
     if (m_AudioDevice != 0) {
-        // Stop playback
+        // Stop playback. Closing the device also waits for the callback to return.
         SDL_PauseAudioDevice(m_AudioDevice, 1);
         SDL_CloseAudioDevice(m_AudioDevice);
+
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                    "Audio ring stats: %d underruns, %d overruns, %d ms dropped to bound latency",
+                    SDL_AtomicGet(&m_Underruns),
+                    SDL_AtomicGet(&m_Overruns),
+                    (int)((Sint64)SDL_AtomicGet(&m_DroppedBytes) * 1000 / m_BytesPerSecond));
     }
 
-    if (m_AudioBuffer != nullptr) {
-        SDL_free(m_AudioBuffer);
+    if (m_OverrunBuffer != nullptr) {
+        SDL_free(m_OverrunBuffer);
     }
 
     SDL_QuitSubSystem(SDL_INIT_AUDIO);
     SDL_assert(!SDL_WasInit(SDL_INIT_AUDIO));
 }
 
-void* SdlAudioRenderer::getAudioBuffer(int*)
+void* SdlAudioRenderer::getAudioBuffer(int* size)
 {
-    return m_AudioBuffer;
+    SDL_assert(*size <= m_FrameSize);
+
+    void* buffer = m_Ring.beginWrite();
+    m_RingWritePending = buffer != nullptr;
+    if (buffer == nullptr) {
+        // The device isn't consuming audio, so this frame will be dropped. We
+        // still need to get to submitAudio() to detect if the device is gone.
+        SDL_AtomicIncRef(&m_Overruns);
+        buffer = m_OverrunBuffer;
+    }
+
+    return buffer;
 }
 
 bool SdlAudioRenderer::submitAudio(int bytesWritten)
 {
+    // Our device may enter a permanent error status upon removal, so we need
+    // to recreate the audio device to pick up the new default audio device.
+    if (SDL_GetAudioDeviceStatus(m_AudioDevice) == SDL_AUDIO_STOPPED) {
+        return false;
+    }
+
     if (bytesWritten == 0) {
         // Nothing to do
         return true;
     }
 
-    // Don't queue if there's already more than 30 ms of audio data waiting
-    // in Moonlight's audio queue.
-    if (LiGetPendingAudioDuration() > 30) {
-        return true;
+    if (m_RingWritePending) {
+        m_Ring.commitWrite(bytesWritten);
     }
 
-    // Provide backpressure on the queue to ensure too many frames don't build up
-    // in SDL's audio queue, but don't wait forever to avoid a deadlock if the
-    // audio device fails.
-    for (int i = 0; i < 100; i++) {
-        // Our device may enter a permanent error status upon removal, so we need
-        // to recreate the audio device to pick up the new default audio device.
-        if (SDL_GetAudioDeviceStatus(m_AudioDevice) == SDL_AUDIO_STOPPED) {
-            return false;
-        }
+    return true;
+}
 
-        // Only queue more samples where there are 10 frames or less in SDL's queue
-        if (SDL_GetQueuedAudioSize(m_AudioDevice) / m_FrameSize <= 10) {
-            break;
+void SDLCALL SdlAudioRenderer::audioCallback(void* userdata, Uint8* stream, int len)
+{
+    SdlAudioRenderer* me = reinterpret_cast<SdlAudioRenderer*>(userdata);
+
+    int frameCount = len / me->m_SampleFrameSize;
+    int framesRead = me->m_JitterBuffer.read(me->m_Ring, (float*)stream, frameCount);
+    if (framesRead < frameCount) {
+        // Running dry before the first frame arrives isn't an underrun
+        if (me->m_PlaybackStarted) {
+            SDL_AtomicIncRef(&me->m_Underruns);
         }
+    }
 
-        SDL_Delay(1);
+    if (framesRead > 0) {
+        me->m_PlaybackStarted = true;
     }
 
-    if (SDL_QueueAudio(m_AudioDevice, m_AudioBuffer, bytesWritten) < 0) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
-                     "Failed to queue audio sample: %s",
-                     SDL_GetError());
+    me->trimLatency(len);
+}
+
+void SdlAudioRenderer::trimLatency(int callbackBytes)
+{
+    // Track the shallowest the queue gets over each window. Jitter makes the
+    // queue depth swing around, but if it never drops below the limit for a
+    // whole window, the extra audio is just latency we can safely discard.
+    m_MinQueuedBytes = SDL_min(m_MinQueuedBytes, m_Ring.getQueuedBytes());
+    m_WindowBytes += callbackBytes;
+
+    if ((Sint64)m_WindowBytes * 1000 < (Sint64)m_BytesPerSecond * LATENCY_WINDOW_MS) {
+        return;
     }
 
-    return true;
+    if (m_MinQueuedBytes > m_MaxQueuedBytes) {
+        int excessBytes = m_MinQueuedBytes - m_MaxQueuedBytes;
+
+        // Never split a sample frame
+        excessBytes -= excessBytes % m_SampleFrameSize;
+        SDL_AtomicAdd(&m_DroppedBytes, m_Ring.discard(excessBytes));
+    }
+
+    m_MinQueuedBytes = INT_MAX;
+    m_WindowBytes = 0;
 }
 
 IAudioRenderer::AudioFormat SdlAudioRenderer::getAudioBufferFormat()
 {
     return AudioFormat::Float32NE;
 }
+
+int SdlAudioRenderer::getBufferedLatencyMs()
+{
+    return m_JitterBuffer.getBufferedLatencyMs();
+}
+
+int SdlAudioRenderer::getRateCorrectionPpm()
+{
+    return m_JitterBuffer.getRateCorrectionPpm();
+}
+
+int SdlAudioRenderer::getUnderrunCount()
+{
+    return SDL_AtomicGet(&m_Underruns);
+}
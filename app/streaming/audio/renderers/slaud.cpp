@@ -101,19 +101,17 @@ bool SLAudioRenderer::submitAudio(int bytesWritten)
         return true;
     }
 
-    if (LiGetPendingAudioDuration() < m_MaxQueuedAudioMs) {
-        SLAudio_SubmitFrame(m_AudioStream);
-        m_AudioBuffer = nullptr;
-    }
-    else {
-        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
-                    "Too many queued audio frames: %d",
-                    LiGetPendingAudioFrames());
-    }
+    SLAudio_SubmitFrame(m_AudioStream);
+    m_AudioBuffer = nullptr;
 
     return true;
 }
 
+int SLAudioRenderer::getMaxPendingAudioMs()
+{
+    return m_MaxQueuedAudioMs;
+}
+
 IAudioRenderer::AudioFormat SLAudioRenderer::getAudioBufferFormat()
 {
     return AudioFormat::Sint16NE;
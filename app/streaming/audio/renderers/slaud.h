@@ -20,6 +20,8 @@ public:
 
     virtual void remapChannels(POPUS_MULTISTREAM_CONFIGURATION opusConfig);
 
+    virtual int getMaxPendingAudioMs();
+
 private:
     static void slLogCallback(void* context, ESLAudioLog logLevel, const char* message);
 
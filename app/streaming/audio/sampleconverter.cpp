@@ -0,0 +1,59 @@
+#include "sampleconverter.h"
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HAVE_SSE2_CONVERSION
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define HAVE_NEON_CONVERSION
+#endif
+
+void AudioSampleConverter::floatToS16(const float* input, short* output, int sampleCount)
+{
+    int i = 0;
+
+#if defined(HAVE_SSE2_CONVERSION)
+    const __m128 scale = _mm_set1_ps(32768.0f);
+    const __m128 minValue = _mm_set1_ps(-32768.0f);
+    const __m128 maxValue = _mm_set1_ps(32767.0f);
+
+    // 8 samples per iteration. Clamping before the conversion matters because
+    // out of range floats convert to INT_MIN, which would wrap to full negative.
+    for (; i + 8 <= sampleCount; i += 8) {
+        __m128 lo = _mm_mul_ps(_mm_loadu_ps(&input[i]), scale);
+        __m128 hi = _mm_mul_ps(_mm_loadu_ps(&input[i + 4]), scale);
+
+        lo = _mm_min_ps(_mm_max_ps(lo, minValue), maxValue);
+        hi = _mm_min_ps(_mm_max_ps(hi, minValue), maxValue);
+
+        // Rounds to nearest in the default MXCSR mode
+        __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(lo), _mm_cvtps_epi32(hi));
+        _mm_storeu_si128((__m128i*)&output[i], packed);
+    }
+#elif defined(HAVE_NEON_CONVERSION)
+    // 8 samples per iteration. The narrowing move saturates for us.
+    for (; i + 8 <= sampleCount; i += 8) {
+        int32x4_t lo = vcvtnq_s32_f32(vmulq_n_f32(vld1q_f32(&input[i]), 32768.0f));
+        int32x4_t hi = vcvtnq_s32_f32(vmulq_n_f32(vld1q_f32(&input[i + 4]), 32768.0f));
+
+        vst1q_s16(&output[i], vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+    }
+#endif
+
+    // Handle the remainder (or everything, if we have no SIMD path)
+    for (; i < sampleCount; i++) {
+        float sample = input[i] * 32768.0f;
+
+        if (sample >= 32767.0f) {
+            output[i] = 32767;
+        }
+        else if (sample <= -32768.0f) {
+            output[i] = -32768;
+        }
+        else {
+            output[i] = (short)lrintf(sample);
+        }
+    }
+}
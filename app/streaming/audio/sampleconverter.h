@@ -0,0 +1,16 @@
+#pragma once
+
+// Sample format conversion for renderers whose output device can't take
+// the float samples that Opus decodes natively.
+//
+// Opus decoding to 16-bit does this conversion internally, one sample at a
+// time, after running opus_pcm_soft_clip() on the float output. Callers
+// should soft clip first too, since this only hard clips. Doing it here lets
+// us use SIMD, which matters for 7.1 streams on low-end clients.
+class AudioSampleConverter
+{
+public:
+    // Converts interleaved float samples in [-1.0, 1.0] to native-endian 16-bit,
+    // rounding to nearest and clipping anything out of range
+    static void floatToS16(const float* input, short* output, int sampleCount);
+};
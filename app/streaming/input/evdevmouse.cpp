@@ -0,0 +1,272 @@
+#include "evdevmouse.h"
+
+#include <Limelight.h>
+
+#include <QtGlobal>
+
+#include <climits>
+#include <cstdio>
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <linux/input.h>
+
+#define BITS_PER_LONG (sizeof(unsigned long) * 8)
+#define NBITS(x) ((((x) - 1) / BITS_PER_LONG) + 1)
+#define TEST_BIT(bit, array) ((array[(bit) / BITS_PER_LONG] >> ((bit) % BITS_PER_LONG)) & 1)
+
+EvdevMouse::EvdevMouse()
+    : m_WakeFd(-1),
+      m_Thread(nullptr),
+      m_MotionReports(0),
+      m_TotalInputAgeUs(0),
+      m_MaxInputAgeUs(0)
+{
+    SDL_AtomicSet(&m_Enabled, 0);
+    SDL_AtomicSet(&m_Stopping, 0);
+}
+
+EvdevMouse::~EvdevMouse()
+{
+    if (m_Thread != nullptr) {
+        SDL_AtomicSet(&m_Stopping, 1);
+
+        uint64_t wake = 1;
+        if (write(m_WakeFd, &wake, sizeof(wake)) < 0) {
+            SDL_assert(false);
+        }
+
+        SDL_WaitThread(m_Thread, nullptr);
+
+        if (m_MotionReports > 0) {
+            SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                        "evdev mouse input age: %.3f ms average, %.3f ms max over %u reports",
+                        m_TotalInputAgeUs / 1000.0 / m_MotionReports,
+                        m_MaxInputAgeUs / 1000.0,
+                        m_MotionReports);
+        }
+    }
+
+    for (const Device& device : m_Devices) {
+        close(device.fd);
+    }
+
+    if (m_WakeFd >= 0) {
+        close(m_WakeFd);
+    }
+}
+
+bool EvdevMouse::start()
+{
+    if (qEnvironmentVariableIntValue("ML_EVDEV_MOUSE") == 0) {
+        return false;
+    }
+
+    openDevices();
+    if (m_Devices.empty()) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
+                    "No readable evdev mice found. Is this user in the 'input' group?");
+        return false;
+    }
+
+    m_WakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (m_WakeFd < 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "eventfd() failed: %d",
+                     errno);
+        return false;
+    }
+
+    m_Thread = SDL_CreateThread(EvdevMouse::inputThreadProc, "Input", this);
+    if (m_Thread == nullptr) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "Unable to create input thread: %s",
+                     SDL_GetError());
+        return false;
+    }
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                "Reading relative mouse motion from %d evdev device(s)",
+                (int)m_Devices.size());
+    return true;
+}
+
+void EvdevMouse::openDevices()
+{
+    DIR* dir = opendir("/dev/input");
+    if (dir == nullptr) {
+        return;
+    }
+
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (strncmp(entry->d_name, "event", 5) != 0) {
+            continue;
+        }
+
+        char path[300];
+        snprintf(path, sizeof(path), "/dev/input/%s", entry->d_name);
+
+        int fd = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+
+        // We only want devices that report relative X and Y motion
+        unsigned long evBits[NBITS(EV_MAX)] = {};
+        unsigned long relBits[NBITS(REL_MAX)] = {};
+        if (ioctl(fd, EVIOCGBIT(0, sizeof(evBits)), evBits) < 0 ||
+                !TEST_BIT(EV_REL, evBits) ||
+                ioctl(fd, EVIOCGBIT(EV_REL, sizeof(relBits)), relBits) < 0 ||
+                !TEST_BIT(REL_X, relBits) || !TEST_BIT(REL_Y, relBits)) {
+            close(fd);
+            continue;
+        }
+
+        // Timestamp events with the same clock we use to measure input age
+        int clockId = CLOCK_MONOTONIC;
+        if (ioctl(fd, EVIOCSCLOCKID, &clockId) < 0) {
+            close(fd);
+            continue;
+        }
+
+        char name[128] = {};
+        ioctl(fd, EVIOCGNAME(sizeof(name) - 1), name);
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                    "Found evdev mouse: %s (%s)",
+                    name,
+                    path);
+
+        m_Devices.push_back({ fd, false, 0, 0 });
+    }
+
+    closedir(dir);
+}
+
+int EvdevMouse::inputThreadProc(void* context)
+{
+    EvdevMouse* me = reinterpret_cast<EvdevMouse*>(context);
+
+    // Mouse motion is latency-critical and each report is cheap to handle
+    SDL_SetThreadPriority(SDL_THREAD_PRIORITY_TIME_CRITICAL);
+
+    std::vector<struct pollfd> pollFds(me->m_Devices.size() + 1);
+    for (size_t i = 0; i < me->m_Devices.size(); i++) {
+        pollFds[i].fd = me->m_Devices[i].fd;
+        pollFds[i].events = POLLIN;
+    }
+    pollFds.back().fd = me->m_WakeFd;
+    pollFds.back().events = POLLIN;
+
+    while (!SDL_AtomicGet(&me->m_Stopping)) {
+        if (poll(pollFds.data(), pollFds.size(), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                         "poll() failed on evdev mice: %d",
+                         errno);
+            break;
+        }
+
+        for (size_t i = 0; i < me->m_Devices.size(); i++) {
+            if (pollFds[i].revents & (POLLERR | POLLHUP | POLLNVAL)) {
+                // The device was unplugged, so stop polling it
+                pollFds[i].fd = -1;
+            }
+            else if (pollFds[i].revents & POLLIN) {
+                me->readDevice((int)i);
+            }
+        }
+    }
+
+    return 0;
+}
+
+void EvdevMouse::readDevice(int index)
+{
+    Device& device = m_Devices[index];
+    struct input_event events[64];
+
+    for (;;) {
+        ssize_t bytesRead = read(device.fd, events, sizeof(events));
+        if (bytesRead <= 0) {
+            break;
+        }
+
+        for (size_t i = 0; i < bytesRead / sizeof(events[0]); i++) {
+            const struct input_event& event = events[i];
+
+            if (event.type == EV_SYN) {
+                if (event.code == SYN_DROPPED) {
+                    // The kernel buffer overflowed, so this report is incomplete
+                    device.dropped = true;
+                }
+                else if (event.code == SYN_REPORT) {
+                    if (!device.dropped) {
+                        sendMotion(device, event.time);
+                    }
+
+                    device.dropped = false;
+                    device.pendingX = device.pendingY = 0;
+                }
+            }
+            else if (event.type == EV_REL && !device.dropped) {
+                if (event.code == REL_X) {
+                    device.pendingX += event.value;
+                }
+                else if (event.code == REL_Y) {
+                    device.pendingY += event.value;
+                }
+            }
+        }
+    }
+}
+
+void EvdevMouse::sendMotion(Device& device, const struct timeval& eventTime)
+{
+    if ((device.pendingX == 0 && device.pendingY == 0) || !SDL_AtomicGet(&m_Enabled)) {
+        return;
+    }
+
+    // Large deltas are split to fit the protocol's 16-bit fields
+    int x = device.pendingX, y = device.pendingY;
+    while (x != 0 || y != 0) {
+        short sendX = (short)SDL_clamp(x, SHRT_MIN, SHRT_MAX);
+        short sendY = (short)SDL_clamp(y, SHRT_MIN, SHRT_MAX);
+
+        LiSendMouseMoveEvent(sendX, sendY);
+
+        x -= sendX;
+        y -= sendY;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    Sint64 ageUs = ((Sint64)now.tv_sec - eventTime.tv_sec) * 1000000 +
+                   (now.tv_nsec / 1000 - eventTime.tv_usec);
+    if (ageUs >= 0) {
+        m_MotionReports++;
+        m_TotalInputAgeUs += ageUs;
+        m_MaxInputAgeUs = SDL_max(m_MaxInputAgeUs, (Uint64)ageUs);
+    }
+}
+
+void EvdevMouse::setEnabled(bool enabled)
+{
+    SDL_AtomicSet(&m_Enabled, enabled ? 1 : 0);
+}
+
+bool EvdevMouse::isEnabled()
+{
+    return SDL_AtomicGet(&m_Enabled) != 0;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "SDL_compat.h"
+
+#include <vector>
+
+// Reads relative mouse motion straight from evdev on a dedicated thread and
+// sends it to the host without going through the SDL event loop. The event
+// loop also renders frames, so with a 1000+ Hz mouse, motion can otherwise
+// wait behind a slow frame. Buttons and the wheel still go through SDL.
+//
+// The keyboard deliberately stays on SDL. Key input runs at a few events a
+// second, so the frame wait matters far less than for motion. Reading it
+// here would bypass the keymap and layout translation and the capture and
+// quit combos in keyboard.cpp. Every key would also arrive twice unless the
+// SDL copy were suppressed. And it would record keystrokes meant for other
+// windows whenever the focus check lagged behind.
+//
+// This needs read access to /dev/input, so it's opt-in with ML_EVDEV_MOUSE=1.
+class EvdevMouse
+{
+public:
+    EvdevMouse();
+
+    ~EvdevMouse();
+
+    // Returns false if disabled or no usable mouse could be opened
+    bool start();
+
+    // Motion is only sent while enabled, which tracks relative mouse capture
+    void setEnabled(bool enabled);
+
+    bool isEnabled();
+
+private:
+    static int inputThreadProc(void* context);
+
+    void openDevices();
+
+    void readDevice(int index);
+
+    struct Device {
+        int fd;
+        bool dropped;
+
+        // Motion accumulated since the last SYN_REPORT
+        int pendingX;
+        int pendingY;
+    };
+
+    void sendMotion(Device& device, const struct timeval& eventTime);
+
+    std::vector<Device> m_Devices;
+    int m_WakeFd;
+    SDL_Thread* m_Thread;
+    SDL_atomic_t m_Enabled;
+    SDL_atomic_t m_Stopping;
+
+    // Owned by the input thread until it's joined
+    Uint32 m_MotionReports;
+    Uint64 m_TotalInputAgeUs;
+    Uint64 m_MaxInputAgeUs;
+};
@@ -80,6 +80,9 @@ void SdlInputHandler::sendGamepadState(GamepadState* state)
     if (!m_MultiController) {
         for (int i = 0; i < MAX_GAMEPADS; i++) {
             if (m_GamepadState[i].index == state->index) {
+                // The merged state we're about to send covers this gamepad too
+                m_GamepadState[i].stateSendPending = false;
+
                 buttons |= m_GamepadState[i].buttons;
                 if (lt < m_GamepadState[i].lt) {
                     lt = m_GamepadState[i].lt;
@@ -102,6 +105,22 @@ void SdlInputHandler::sendGamepadState(GamepadState* state)
         }
     }
 
+    // This state is now current, whether or not we need to send it
+    state->stateSendPending = false;
+
+    // Skip updates that don't change anything, like a stick moving within
+    // its deadzone or an axis event that another controller's state masks.
+    SentGamepadState& sent = m_SentGamepadState[state->index];
+    if (sent.valid &&
+            sent.activeGamepadMask == m_GamepadMask &&
+            sent.buttons == buttons &&
+            sent.lt == lt && sent.rt == rt &&
+            sent.lsX == lsX && sent.lsY == lsY &&
+            sent.rsX == rsX && sent.rsY == rsY) {
+        m_GamepadPacketsSaved++;
+        return;
+    }
+
     LiSendMultiControllerEvent(state->index,
                                m_GamepadMask,
                                buttons,
@@ -111,6 +130,76 @@ void SdlInputHandler::sendGamepadState(GamepadState* state)
                                lsY,
                                rsX,
                                rsY);
+
+    sent.valid = true;
+    sent.activeGamepadMask = m_GamepadMask;
+    sent.buttons = buttons;
+    sent.lt = lt;
+    sent.rt = rt;
+    sent.lsX = lsX;
+    sent.lsY = lsY;
+    sent.rsX = rsX;
+    sent.rsY = rsY;
+
+    state->lastStateSendTime = SDL_GetTicks();
+    m_GamepadPacketsSent++;
+}
+
+void SdlInputHandler::queueGamepadState(GamepadState* state, Uint32 eventTimestamp)
+{
+    // Send right away if this controller hasn't sent anything within the window
+    if (m_GamepadCoalesceMs == 0 ||
+            SDL_TICKS_PASSED(SDL_GetTicks(), state->lastStateSendTime + m_GamepadCoalesceMs)) {
+        sendGamepadState(state);
+        recordInputAge(eventTimestamp);
+        return;
+    }
+
+    if (state->stateSendPending) {
+        // This update replaces one that was never sent
+        m_GamepadPacketsSaved++;
+    }
+    else {
+        state->stateSendPending = true;
+        state->pendingStateTimestamp = eventTimestamp;
+    }
+
+    if (m_GamepadFlushTimer == 0) {
+        Uint32 delayMs = state->lastStateSendTime + m_GamepadCoalesceMs - SDL_GetTicks();
+        m_GamepadFlushTimer = SDL_AddTimer(SDL_max(delayMs, 1U), SdlInputHandler::gamepadFlushTimerCallback, nullptr);
+    }
+}
+
+void SdlInputHandler::flushPendingGamepadState()
+{
+    m_GamepadFlushTimer = 0;
+
+    for (int i = 0; i < MAX_GAMEPADS; i++) {
+        GamepadState* state = &m_GamepadState[i];
+
+        if (state->controller != nullptr && state->stateSendPending && state->mouseEmulationTimer == 0) {
+            sendGamepadState(state);
+            recordInputAge(state->pendingStateTimestamp);
+        }
+
+        state->stateSendPending = false;
+    }
+}
+
+void SdlInputHandler::invalidateSentGamepadState(short index)
+{
+    m_SentGamepadState[index].valid = false;
+}
+
+Uint32 SdlInputHandler::gamepadFlushTimerCallback(Uint32, void*)
+{
+    // Gamepad state is only touched on the main thread
+    SDL_Event event = {};
+    event.type = SDL_USEREVENT;
+    event.user.code = SDL_CODE_GAMECONTROLLER_FLUSH_STATE;
+    SDL_PushEvent(&event);
+
+    return 0;
 }
 
 void SdlInputHandler::sendGamepadBatteryState(GamepadState* state, SDL_JoystickPowerLevel level)
@@ -198,6 +287,7 @@ void SdlInputHandler::handleControllerAxisEvent(SDL_ControllerAxisEvent* event)
     }
 
     // Batch all pending axis motion events for this gamepad to save CPU time
+    Uint32 timestamp = event->timestamp;
     SDL_Event nextEvent;
     for (;;) {
         switch (event->axis)
@@ -249,7 +339,7 @@ void SdlInputHandler::handleControllerAxisEvent(SDL_ControllerAxisEvent* event)
 
     // Only send the gamepad state to the host if it's not in mouse emulation mode
     if (state->mouseEmulationTimer == 0) {
-        sendGamepadState(state);
+        queueGamepadState(state, timestamp);
     }
 }
 
@@ -378,6 +468,7 @@ void SdlInputHandler::handleControllerButtonEvent(SDL_ControllerButtonEvent* eve
         // Clear buttons down on this gamepad
         LiSendMultiControllerEvent(state->index, m_GamepadMask,
                                    0, 0, 0, 0, 0, 0, 0);
+        invalidateSentGamepadState(state->index);
         return;
     }
 
@@ -393,12 +484,14 @@ void SdlInputHandler::handleControllerButtonEvent(SDL_ControllerButtonEvent* eve
         // Clear buttons down on this gamepad
         LiSendMultiControllerEvent(state->index, m_GamepadMask,
                                    0, 0, 0, 0, 0, 0, 0);
+        invalidateSentGamepadState(state->index);
         return;
     }
 
     // Only send the gamepad state to the host if it's not in mouse emulation mode
     if (state->mouseEmulationTimer == 0) {
         sendGamepadState(state);
+        recordInputAge(event->timestamp);
     }
 }
 
@@ -758,6 +851,7 @@ void SdlInputHandler::handleControllerDeviceEvent(SDL_ControllerDeviceEvent* eve
             type == LI_CTYPE_PS;
 
         LiSendControllerArrivalEvent(state->index, m_GamepadMask, type, supportedButtonFlags, capabilities);
+        invalidateSentGamepadState(state->index);
 #else
 
         // Send an empty event to tell the PC we've arrived
@@ -801,6 +895,7 @@ void SdlInputHandler::handleControllerDeviceEvent(SDL_ControllerDeviceEvent* eve
             // Send a final event to let the PC know this gamepad is gone
             LiSendMultiControllerEvent(state->index, m_GamepadMask,
                                        0, 0, 0, 0, 0, 0, 0);
+            invalidateSentGamepadState(state->index);
 
             // Preserve the GUID so this controller can reclaim the same slot on reconnect
             char savedGuid[33];
@@ -6,16 +6,26 @@
 #include "path.h"
 #include "utils.h"
 
+#ifdef Q_OS_LINUX
+#include "evdevmouse.h"
+#endif
+
 #include <QtGlobal>
 #include <QDir>
 #include <QGuiApplication>
 
+// Analog stick and trigger updates are coalesced per controller for up to this
+// long. Button changes are never delayed. It can be overridden (or disabled
+// with 0) using ML_GAMEPAD_COALESCE_MS.
+#define DEFAULT_GAMEPAD_COALESCE_MS 4
+
 SdlInputHandler::SdlInputHandler(StreamingPreferences& prefs, int streamWidth, int streamHeight, const QString& clientUuid)
     : m_MultiController(prefs.multiController),
       m_GamepadMouse(prefs.gamepadMouse),
       m_SwapMouseButtons(prefs.swapMouseButtons),
       m_ReverseScrollDirection(prefs.reverseScrollDirection),
       m_SwapFaceButtons(prefs.swapFaceButtons),
+      m_WindowFocused(true),
       m_MouseWasInVideoRegion(false),
       m_PendingMouseButtonsAllUpOnVideoRegionLeave(false),
       m_PointerRegionLockActive(false),
@@ -34,7 +44,16 @@ SdlInputHandler::SdlInputHandler(StreamingPreferences& prefs, int streamWidth, i
       m_RightButtonReleaseTimer(0),
       m_DragTimer(0),
       m_DragButton(0),
-      m_NumFingersDown(0)
+      m_NumFingersDown(0),
+      m_GamepadFlushTimer(0),
+      m_GamepadPacketsSent(0),
+      m_GamepadPacketsSaved(0),
+#ifdef Q_OS_LINUX
+      m_EvdevMouse(nullptr),
+#endif
+      m_InputAgeSamples(0),
+      m_TotalInputAgeMs(0),
+      m_MaxInputAgeMs(0)
 {
     // System keys are always captured when running without a DE
     if (!WMUtils::isRunningDesktopEnvironment()) {
@@ -67,6 +86,27 @@ SdlInputHandler::SdlInputHandler(StreamingPreferences& prefs, int streamWidth, i
     SDL_SetHint(SDL_HINT_JOYSTICK_HIDAPI_PS4_RUMBLE, "1");
     SDL_SetHint(SDL_HINT_JOYSTICK_HIDAPI_PS5_RUMBLE, "1");
 
+    bool ok;
+    m_GamepadCoalesceMs = qEnvironmentVariableIntValue("ML_GAMEPAD_COALESCE_MS", &ok);
+    if (!ok || m_GamepadCoalesceMs < 0) {
+        m_GamepadCoalesceMs = DEFAULT_GAMEPAD_COALESCE_MS;
+    }
+    m_GamepadStatsStartTime = SDL_GetTicks();
+
+#ifdef Q_OS_WIN32
+    // Read raw input and XInput devices on SDL's own thread, so controller
+    // state is sampled on time even while the event loop is rendering.
+    SDL_SetHint(SDL_HINT_JOYSTICK_THREAD, "1");
+#endif
+
+#ifdef Q_OS_LINUX
+    m_EvdevMouse = new EvdevMouse();
+    if (!m_EvdevMouse->start()) {
+        delete m_EvdevMouse;
+        m_EvdevMouse = nullptr;
+    }
+#endif
+
     // Populate special key combo configuration
     m_SpecialKeyCombos[KeyComboQuit].keyCombo = KeyComboQuit;
     m_SpecialKeyCombos[KeyComboQuit].keyCode = SDLK_q;
@@ -199,6 +239,7 @@ SdlInputHandler::SdlInputHandler(StreamingPreferences& prefs, int streamWidth, i
     m_GamepadMask = getAttachedGamepadMask();
 
     SDL_zero(m_GamepadState);
+    SDL_zero(m_SentGamepadState);
     SDL_zero(m_LastTouchDownEvent);
     SDL_zero(m_LastTouchUpEvent);
     SDL_zero(m_TouchDownEvent);
@@ -206,6 +247,30 @@ SdlInputHandler::SdlInputHandler(StreamingPreferences& prefs, int streamWidth, i
 
 SdlInputHandler::~SdlInputHandler()
 {
+#ifdef Q_OS_LINUX
+    // Stop sending motion before we tear anything else down
+    delete m_EvdevMouse;
+#endif
+
+    if (m_InputAgeSamples > 0) {
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                    "SDL input age: %.1f ms average, %u ms max over %u events",
+                    (double)m_TotalInputAgeMs / m_InputAgeSamples,
+                    m_MaxInputAgeMs,
+                    m_InputAgeSamples);
+    }
+
+    Uint32 gamepadStatsDurationMs = SDL_GetTicks() - m_GamepadStatsStartTime;
+    if (m_GamepadPacketsSent > 0 && gamepadStatsDurationMs > 0) {
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                    "Gamepad state: %u packets sent, %u coalesced or unchanged (%.1f packets/sec saved)",
+                    m_GamepadPacketsSent,
+                    m_GamepadPacketsSaved,
+                    m_GamepadPacketsSaved * 1000.0 / gamepadStatsDurationMs);
+    }
+
+    SDL_RemoveTimer(m_GamepadFlushTimer);
+
     for (int i = 0; i < MAX_GAMEPADS; i++) {
         if (m_GamepadState[i].mouseEmulationTimer != 0) {
             if (Session::get() != nullptr) {
@@ -311,6 +376,10 @@ void SdlInputHandler::notifyFocusLost()
     // used in shortcuts that cause focus loss (such as Alt+Tab) may get stuck down.
     raiseAllKeys();
 
+    // evdev sees motion regardless of focus, so we must stop it ourselves
+    m_WindowFocused = false;
+    updateEvdevMouseState();
+
 #ifdef Q_OS_WIN32
     // Re-enable text input when window loses focus as a workaround for an SDL bug.
     // See #1617 for details.
@@ -320,6 +389,9 @@ void SdlInputHandler::notifyFocusLost()
 
 void SdlInputHandler::notifyFocusGained()
 {
+    m_WindowFocused = true;
+    updateEvdevMouseState();
+
 #ifdef Q_OS_WIN32
     // Disable text input when window gains focus to prevent IME popup interference.
     // See #1617 for details.
@@ -443,6 +515,34 @@ void SdlInputHandler::setCaptureActive(bool active)
 
     // Now update the keyboard grab
     updateKeyboardGrabState();
+
+    updateEvdevMouseState();
+}
+
+void SdlInputHandler::updateEvdevMouseState()
+{
+#ifdef Q_OS_LINUX
+    if (m_EvdevMouse != nullptr) {
+        // evdev only provides relative motion, so absolute mode stays on SDL
+        m_EvdevMouse->setEnabled(m_WindowFocused && !m_AbsoluteMouseMode && isCaptureActive());
+    }
+#endif
+}
+
+void SdlInputHandler::recordInputAge(Uint32 eventTimestamp)
+{
+    // SDL timestamps are when the event was queued, which is at best
+    // when the OS delivered it to us, and only have 1 ms resolution.
+    Uint32 ageMs = SDL_GetTicks() - eventTimestamp;
+
+    // Synthetic events may not have a meaningful timestamp
+    if (eventTimestamp == 0 || ageMs > 1000) {
+        return;
+    }
+
+    m_InputAgeSamples++;
+    m_TotalInputAgeMs += ageMs;
+    m_MaxInputAgeMs = SDL_max(m_MaxInputAgeMs, ageMs);
 }
 
 void SdlInputHandler::handleTouchFingerEvent(SDL_TouchFingerEvent* event)
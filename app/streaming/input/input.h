@@ -5,6 +5,10 @@
 
 #include "SDL_compat.h"
 
+#ifdef Q_OS_LINUX
+class EvdevMouse;
+#endif
+
 struct GamepadState {
     SDL_GameController* controller;
     SDL_JoystickID jsId;
@@ -37,8 +41,26 @@ struct GamepadState {
     short lsX, lsY;
     short rsX, rsY;
     unsigned char lt, rt;
+
+    // Axis updates within the coalescing window are held here until it ends
+    uint32_t lastStateSendTime;
+    uint32_t pendingStateTimestamp;
+    bool stateSendPending;
+};
+
+// Last state sent to the host for a controller number
+struct SentGamepadState {
+    bool valid;
+    short activeGamepadMask;
+    int buttons;
+    short lsX, lsY;
+    short rsX, rsY;
+    unsigned char lt, rt;
 };
 
+// Pushed by the coalescing timer so pending gamepad state is sent from the main thread
+#define SDL_CODE_GAMECONTROLLER_FLUSH_STATE 106
+
 
 struct DualSenseOutputReport{
     uint8_t validFlag0;
@@ -120,6 +142,8 @@ public:
 
     void handleJoystickArrivalEvent(SDL_JoyDeviceEvent* event);
 
+    void flushPendingGamepadState();
+
     void sendText(QString& string);
 
     void rumble(uint16_t controllerNumber, uint16_t lowFreqMotor, uint16_t highFreqMotor);
@@ -180,6 +204,11 @@ private:
 
     void sendGamepadState(GamepadState* state);
 
+    void queueGamepadState(GamepadState* state, Uint32 eventTimestamp);
+
+    // Call after sending controller state outside of sendGamepadState()
+    void invalidateSentGamepadState(short index);
+
     void sendGamepadBatteryState(GamepadState* state, SDL_JoystickPowerLevel level);
 
     void handleAbsoluteFingerEvent(SDL_TouchFingerEvent* event);
@@ -192,12 +221,20 @@ private:
 
     void performSpecialKeyCombo(KeyCombo combo);
 
+    void updateEvdevMouseState();
+
+    // Measures how long input sat in the SDL event queue before we sent it
+    void recordInputAge(Uint32 eventTimestamp);
+
     static
     Uint32 longPressTimerCallback(Uint32 interval, void* param);
 
     static
     Uint32 mouseEmulationTimerCallback(Uint32 interval, void* param);
 
+    static
+    Uint32 gamepadFlushTimerCallback(Uint32 interval, void* param);
+
     static
     Uint32 releaseLeftButtonTimerCallback(Uint32 interval, void* param);
 
@@ -214,6 +251,7 @@ private:
     bool m_ReverseScrollDirection;
     bool m_SwapFaceButtons;
 
+    bool m_WindowFocused;
     bool m_MouseWasInVideoRegion;
     bool m_PendingMouseButtonsAllUpOnVideoRegionLeave;
     bool m_PointerRegionLockActive;
@@ -221,6 +259,12 @@ private:
 
     int m_GamepadMask;
     GamepadState m_GamepadState[MAX_GAMEPADS];
+    SentGamepadState m_SentGamepadState[MAX_GAMEPADS];
+    int m_GamepadCoalesceMs;
+    SDL_TimerID m_GamepadFlushTimer;
+    Uint32 m_GamepadStatsStartTime;
+    Uint32 m_GamepadPacketsSent;
+    Uint32 m_GamepadPacketsSaved;
     QSet<short> m_KeysDown;
     bool m_FakeCaptureActive;
     QString m_OldIgnoreDevices;
@@ -253,5 +297,13 @@ private:
     char m_DragButton;
     int m_NumFingersDown;
 
+#ifdef Q_OS_LINUX
+    EvdevMouse* m_EvdevMouse;
+#endif
+
+    Uint32 m_InputAgeSamples;
+    Uint64 m_TotalInputAgeMs;
+    Uint32 m_MaxInputAgeMs;
+
     static const int k_ButtonMap[];
 };
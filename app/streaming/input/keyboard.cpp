@@ -468,4 +468,5 @@ void SdlInputHandler::handleKeyEvent(SDL_KeyboardEvent* event)
                             KEY_ACTION_DOWN : KEY_ACTION_UP,
                         modifiers,
                         shouldNotConvertToScanCodeOnServer ? SS_KBE_FLAG_NON_NORMALIZED : 0);
+    recordInputAge(event->timestamp);
 }
@@ -66,6 +66,7 @@ void SdlInputHandler::handleMouseButtonEvent(SDL_MouseButtonEvent* event)
                                BUTTON_ACTION_PRESS :
                                BUTTON_ACTION_RELEASE,
                            button);
+    recordInputAge(event->timestamp);
 }
 
 void SdlInputHandler::handleMouseMotionEvent(SDL_MouseMotionEvent* event)
@@ -80,6 +81,7 @@ void SdlInputHandler::handleMouseMotionEvent(SDL_MouseMotionEvent* event)
     }
 
     // Batch all pending mouse motion events to save CPU time
+    Uint32 timestamp = event->timestamp;
     Sint32 x = event->x, y = event->y, xrel = event->xrel, yrel = event->yrel;
     SDL_Event nextEvent;
     while (SDL_PeepEvents(&nextEvent, 1, SDL_GETEVENT, SDL_MOUSEMOTION, SDL_MOUSEMOTION) > 0) {
@@ -135,6 +137,7 @@ void SdlInputHandler::handleMouseMotionEvent(SDL_MouseMotionEvent* event)
         }
         if (mouseInVideoRegion || m_MouseWasInVideoRegion || m_PendingMouseButtonsAllUpOnVideoRegionLeave) {
             LiSendMousePositionEvent((short)x, (short)y, dst.w, dst.h);
+            recordInputAge(timestamp);
         }
 
         // Adjust the cursor visibility if applicable
@@ -149,8 +152,14 @@ void SdlInputHandler::handleMouseMotionEvent(SDL_MouseMotionEvent* event)
 
         m_MouseWasInVideoRegion = mouseInVideoRegion;
     }
+#ifdef Q_OS_LINUX
+    else if (m_EvdevMouse != nullptr && m_EvdevMouse->isEnabled()) {
+        // The evdev thread has already sent this motion
+    }
+#endif
     else {
         LiSendMouseMoveEvent(xrel, yrel);
+        recordInputAge(timestamp);
     }
 }
 
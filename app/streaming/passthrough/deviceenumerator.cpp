@@ -1,4 +1,5 @@
 #include "deviceenumerator.h"
+#include "simulateddevice.h"
 
 #include <QtDebug>
 #include <QRegularExpression>
@@ -142,6 +143,7 @@ void DeviceEnumerator::enumerate()
 
     enumerateUsb();
     enumerateBluetooth();
+    enumerateSimulated();
 
     // Restore auto-forward flags from saved settings
     loadAutoForwardList();
@@ -702,6 +704,37 @@ void DeviceEnumerator::enumerateBluetooth()
 }
 #endif
 
+// ─── Simulated devices (MLPT_SIMULATED_DEVICES) ───
+
+void DeviceEnumerator::enumerateSimulated()
+{
+    for (const SimulatedUsbDevice::Config& config : SimulatedUsbDevice::configuredDevices()) {
+        PassthroughDevice dev;
+        dev.deviceId = m_NextDeviceId++;
+        dev.vendorId = SimulatedUsbDevice::VENDOR_ID;
+        dev.productId = config.productId;
+        dev.name = config.name;
+        dev.manufacturer = "Moonlight";
+        dev.serialNumber = QString("SIM-%1").arg(static_cast<int>(config.kind));
+        dev.driver = SimulatedUsbDevice::DRIVER_NAME;
+        dev.transport = MlptProtocol::TRANSPORT_USB;
+        switch (config.kind) {
+        case SimulatedUsbDevice::KIND_HID_MOUSE: dev.deviceClass = MlptProtocol::DEVCLASS_HID_MOUSE; break;
+        case SimulatedUsbDevice::KIND_ISO_AUDIO: dev.deviceClass = MlptProtocol::DEVCLASS_AUDIO; break;
+        default: dev.deviceClass = MlptProtocol::DEVCLASS_OTHER; break;
+        }
+        dev.isForwarding = false;
+        dev.autoForward = false;
+        dev.addedTime = QDateTime::currentDateTime();
+        dev.storageSizeBytes = 0;
+        dev.batteryPercent = -1;
+        dev.rssi = 0;
+        dev.btPaired = false;
+        dev.btConnected = false;
+        m_Devices.append(dev);
+    }
+}
+
 // ─── Hot-plug polling ───
 
 void DeviceEnumerator::startHotplugPolling(int intervalMs)
@@ -745,6 +778,7 @@ void DeviceEnumerator::pollHotplug()
     m_NextDeviceId = 1;
     enumerateUsb();
     enumerateBluetooth();
+    enumerateSimulated();
     QList<PassthroughDevice> freshDevices = m_Devices;
 
     // Build fingerprints of freshly-enumerated devices
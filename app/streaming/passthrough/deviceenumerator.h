@@ -109,6 +109,7 @@ public slots:
 private:
     void enumerateUsb();
     void enumerateBluetooth();
+    void enumerateSimulated();
 
     uint32_t m_NextDeviceId;
     QList<PassthroughDevice> m_Devices;
@@ -0,0 +1,436 @@
+#include "isostream.h"
+
+#include <QtDebug>
+
+#include <libusb.h>
+
+#include <algorithm>
+#include <cmath>
+
+// Transfers kept in flight on the device (MLPT_ISO_TRANSFERS overrides)
+static constexpr int DEFAULT_NUM_TRANSFERS = 4;
+
+// Extra headroom on top of the measured turnaround when sizing the buffer
+static constexpr double TURNAROUND_MARGIN = 1.5;
+
+IsoInStream::IsoInStream(libusb_device_handle* handle, uint8_t endpointAddress,
+                         uint32_t packetSize, int packetsPerTransfer, CompletionFn onComplete)
+    : m_Handle(handle)
+    , m_EndpointAddress(endpointAddress)
+    , m_PacketSize(packetSize)
+    , m_PacketsPerTransfer(qMax(packetsPerTransfer, 1))
+    , m_NumTransfers(DEFAULT_NUM_TRANSFERS)
+    , m_OnComplete(std::move(onComplete))
+    , m_Running(false)
+    , m_ActiveTransfers(0)
+    , m_Primed(false)
+    , m_TurnaroundUs(0)
+    , m_LastTransferUs(0)
+    , m_PacketIntervalUs(0)
+    , m_DevicePackets(0)
+    , m_HostUrbsServed(0)
+    , m_Underruns(0)
+    , m_Overruns(0)
+{
+    int transfers = qEnvironmentVariableIntValue("MLPT_ISO_TRANSFERS");
+    if (transfers > 0) {
+        m_NumTransfers = qBound(2, transfers, 32);
+    }
+
+    // Start with one host URB worth of packets until turnaround is measured,
+    // and never hold more than four refills of the whole in-flight ring
+    m_MinDepth = m_PacketsPerTransfer;
+    m_MaxDepth = m_PacketsPerTransfer * m_NumTransfers * 4;
+    m_TargetDepth = m_MinDepth;
+
+    m_Clock.start();
+}
+
+IsoInStream::~IsoInStream()
+{
+    // Only reached once the ring is idle or the event thread has stopped,
+    // so no callback can touch the remaining transfers anymore
+    for (libusb_transfer* xfer : m_Transfers) {
+        if (xfer) {
+            free(xfer->buffer);
+            libusb_free_transfer(xfer);
+        }
+    }
+}
+
+bool IsoInStream::start()
+{
+    QMutexLocker lock(&m_Mutex);
+
+    int bufLen = static_cast<int>(m_PacketSize) * m_PacketsPerTransfer;
+    m_Running = true;
+
+    if (!m_Handle) {
+        // Fed by deliverPackets()
+        return true;
+    }
+
+    for (int i = 0; i < m_NumTransfers; i++) {
+        libusb_transfer* xfer = libusb_alloc_transfer(m_PacketsPerTransfer);
+        unsigned char* buf = static_cast<unsigned char*>(malloc(bufLen));
+        if (!xfer || !buf) {
+            free(buf);
+            if (xfer) libusb_free_transfer(xfer);
+            break;
+        }
+
+        libusb_fill_iso_transfer(xfer, m_Handle, m_EndpointAddress, buf, bufLen,
+                                 m_PacketsPerTransfer, transferCallback, this, 1000);
+        libusb_set_iso_packet_lengths(xfer, m_PacketSize);
+
+        int rc = libusb_submit_transfer(xfer);
+        if (rc != 0) {
+            qWarning() << "IsoInStream: submit failed on ep"
+                       << QString::asprintf("0x%02x", m_EndpointAddress) << ":"
+                       << libusb_strerror(static_cast<libusb_error>(rc));
+            free(buf);
+            libusb_free_transfer(xfer);
+            break;
+        }
+
+        m_Transfers.push_back(xfer);
+        m_ActiveTransfers++;
+    }
+
+    if (m_ActiveTransfers == 0) {
+        m_Running = false;
+        return false;
+    }
+
+    qInfo() << "IsoInStream: streaming ep" << QString::asprintf("0x%02x", m_EndpointAddress)
+            << "with" << m_ActiveTransfers << "x" << m_PacketsPerTransfer
+            << "packets of" << m_PacketSize << "bytes";
+    return true;
+}
+
+void IsoInStream::stop()
+{
+    std::vector<Completion> failed;
+
+    {
+        QMutexLocker lock(&m_Mutex);
+        if (!m_Running) return;
+        m_Running = false;
+
+        for (libusb_transfer* xfer : m_Transfers) {
+            if (xfer) {
+                libusb_cancel_transfer(xfer);
+            }
+        }
+
+        // Waiting host URBs can no longer be served
+        for (const HostUrb& urb : m_HostUrbs) {
+            Completion c;
+            c.header = urb.header;
+            c.header.status = -2; // Unlinked
+            c.header.dataLen = 0;
+            failed.push_back(c);
+        }
+        m_HostUrbs.clear();
+        m_Buffer.clear();
+    }
+
+    for (const Completion& c : failed) {
+        m_OnComplete(c.header, c.data);
+    }
+
+    Stats s = stats();
+    qInfo() << "IsoInStream: stopped ep" << QString::asprintf("0x%02x", s.endpointAddress)
+            << "device packets:" << s.devicePackets
+            << "host URBs:" << s.hostUrbs
+            << "underruns:" << s.underruns
+            << "overruns:" << s.overruns
+            << "target depth:" << s.targetDepth
+            << "turnaround:" << s.turnaroundMs << "ms";
+}
+
+bool IsoInStream::isRunning() const
+{
+    QMutexLocker lock(&m_Mutex);
+    return m_Running;
+}
+
+bool IsoInStream::isIdle() const
+{
+    QMutexLocker lock(&m_Mutex);
+    return !m_Running && m_ActiveTransfers == 0;
+}
+
+void IsoInStream::submitHostUrb(const MlptProtocol::UsbIpHeader& header, const QByteArray& isoDescs)
+{
+    HostUrb urb;
+    urb.header = header;
+    for (uint32_t i = 0; i < header.numIsoPackets; i++) {
+        MlptProtocol::UsbIpIsoPacket iso;
+        if (static_cast<int>((i + 1) * sizeof(iso)) <= isoDescs.size()) {
+            memcpy(&iso, isoDescs.constData() + i * sizeof(iso), sizeof(iso));
+            urb.lengths.push_back(iso.length);
+        } else {
+            urb.lengths.push_back(header.dataLen / header.numIsoPackets);
+        }
+    }
+
+    std::vector<Completion> out;
+
+    {
+        QMutexLocker lock(&m_Mutex);
+
+        // Turnaround: the host resubmits from its completion handler, so the
+        // oldest unmatched completion pairs with this submit
+        qint64 now = m_Clock.nsecsElapsed() / 1000;
+        if (!m_CompletionTimesUs.empty()) {
+            double sample = static_cast<double>(now - m_CompletionTimesUs.front());
+            m_CompletionTimesUs.pop_front();
+            m_TurnaroundUs = m_TurnaroundUs == 0 ? sample : m_TurnaroundUs * 0.9 + sample * 0.1;
+            updateTargetDepthLocked();
+        }
+
+        if (m_Primed && m_HostUrbs.empty() && m_Buffer.size() < urb.lengths.size()) {
+            // Ran dry: hold host URBs until the buffer refills. Hosts that keep
+            // several URBs in flight expect the later ones to wait for data,
+            // so only a URB with nothing ahead of it counts.
+            m_Underruns++;
+            m_Primed = false;
+        }
+
+        m_HostUrbs.push_back(std::move(urb));
+        serveLocked(out);
+    }
+
+    for (const Completion& c : out) {
+        m_OnComplete(c.header, c.data);
+    }
+}
+
+bool IsoInStream::unlinkHostUrb(uint32_t seqNum)
+{
+    Completion c;
+
+    {
+        QMutexLocker lock(&m_Mutex);
+        auto it = std::find_if(m_HostUrbs.begin(), m_HostUrbs.end(),
+                               [seqNum](const HostUrb& urb) { return urb.header.seqNum == seqNum; });
+        if (it == m_HostUrbs.end()) {
+            return false;
+        }
+
+        c.header = it->header;
+        c.header.status = -2; // Unlinked
+        c.header.dataLen = 0;
+        m_HostUrbs.erase(it);
+    }
+
+    m_OnComplete(c.header, c.data);
+    return true;
+}
+
+IsoInStream::Stats IsoInStream::stats() const
+{
+    QMutexLocker lock(&m_Mutex);
+
+    Stats s;
+    s.endpointAddress = m_EndpointAddress;
+    s.devicePackets = m_DevicePackets;
+    s.hostUrbs = m_HostUrbsServed;
+    s.underruns = m_Underruns;
+    s.overruns = m_Overruns;
+    s.bufferedPackets = static_cast<int>(m_Buffer.size());
+    s.targetDepth = m_TargetDepth;
+    s.turnaroundMs = m_TurnaroundUs / 1000.0;
+    return s;
+}
+
+// ─── libusb callback ───
+
+void MLPT_LIBUSB_CALL IsoInStream::transferCallback(libusb_transfer* transfer)
+{
+    static_cast<IsoInStream*>(transfer->user_data)->handleTransferComplete(transfer);
+}
+
+void IsoInStream::handleTransferComplete(libusb_transfer* transfer)
+{
+    std::vector<Completion> out;
+
+    {
+        QMutexLocker lock(&m_Mutex);
+
+        if (transfer->status == LIBUSB_TRANSFER_COMPLETED && m_Running) {
+            std::vector<Packet> packets;
+            unsigned char* base = transfer->buffer;
+            for (int i = 0; i < transfer->num_iso_packets; i++) {
+                const libusb_iso_packet_descriptor& pkt = transfer->iso_packet_desc[i];
+
+                Packet p;
+                p.status = pkt.status == LIBUSB_TRANSFER_COMPLETED ? 0 : -18; // EXDEV
+                if (p.status == 0 && pkt.actual_length > 0) {
+                    p.data = QByteArray(reinterpret_cast<const char*>(base), static_cast<int>(pkt.actual_length));
+                }
+                base += pkt.length;
+
+                packets.push_back(std::move(p));
+            }
+
+            queuePacketsLocked(packets, out);
+        }
+
+        bool resubmit = m_Running &&
+                        (transfer->status == LIBUSB_TRANSFER_COMPLETED ||
+                         transfer->status == LIBUSB_TRANSFER_TIMED_OUT);
+        if (resubmit && libusb_submit_transfer(transfer) == 0) {
+            transfer = nullptr;
+        }
+
+        if (transfer) {
+            int lastStatus = transfer->status;
+
+            // Retire this transfer; the engine falls idle once all are back
+            for (libusb_transfer*& slot : m_Transfers) {
+                if (slot == transfer) {
+                    slot = nullptr;
+                }
+            }
+            free(transfer->buffer);
+            libusb_free_transfer(transfer);
+            m_ActiveTransfers--;
+
+            if (m_Running && m_ActiveTransfers == 0) {
+                // Every transfer failed (stall, unplug, alt setting gone):
+                // stop so the exporter falls back to one-off transfers
+                qWarning() << "IsoInStream: ring on ep" << QString::asprintf("0x%02x", m_EndpointAddress)
+                           << "collapsed, last transfer status:" << lastStatus;
+                m_Running = false;
+                for (const HostUrb& urb : m_HostUrbs) {
+                    Completion c;
+                    c.header = urb.header;
+                    c.header.status = -71; // EPROTO
+                    c.header.dataLen = 0;
+                    out.push_back(c);
+                }
+                m_HostUrbs.clear();
+            }
+        }
+    }
+
+    for (const Completion& c : out) {
+        m_OnComplete(c.header, c.data);
+    }
+}
+
+void IsoInStream::deliverPackets(const QList<QByteArray>& packets)
+{
+    std::vector<Completion> out;
+
+    {
+        QMutexLocker lock(&m_Mutex);
+        if (!m_Running || packets.isEmpty()) {
+            return;
+        }
+
+        std::vector<Packet> received;
+        for (const QByteArray& data : packets) {
+            received.push_back({ data.left(static_cast<int>(m_PacketSize)), 0 });
+        }
+
+        queuePacketsLocked(received, out);
+    }
+
+    for (const Completion& c : out) {
+        m_OnComplete(c.header, c.data);
+    }
+}
+
+// ─── Jitter buffer ───
+
+void IsoInStream::queuePacketsLocked(std::vector<Packet>& packets, std::vector<Completion>& out)
+{
+    qint64 now = m_Clock.nsecsElapsed() / 1000;
+    if (m_LastTransferUs != 0) {
+        double sample = static_cast<double>(now - m_LastTransferUs) / packets.size();
+        m_PacketIntervalUs = m_PacketIntervalUs == 0 ? sample : m_PacketIntervalUs * 0.9 + sample * 0.1;
+    }
+    m_LastTransferUs = now;
+
+    for (Packet& p : packets) {
+        m_Buffer.push_back(std::move(p));
+        m_DevicePackets++;
+    }
+
+    // Full buffer: the host is consuming slower than the device
+    // produces, so drop the oldest packets to bound latency
+    while (static_cast<int>(m_Buffer.size()) > m_MaxDepth) {
+        m_Buffer.pop_front();
+        m_Overruns++;
+    }
+
+    serveLocked(out);
+}
+
+void IsoInStream::updateTargetDepthLocked()
+{
+    if (m_PacketIntervalUs <= 0) {
+        return;
+    }
+
+    // Enough packets to cover the host's turnaround plus one of its URBs
+    int depth = static_cast<int>(std::ceil(m_TurnaroundUs * TURNAROUND_MARGIN / m_PacketIntervalUs)) +
+                m_PacketsPerTransfer;
+    m_TargetDepth = qBound(m_MinDepth, depth, m_MaxDepth);
+}
+
+void IsoInStream::serveLocked(std::vector<Completion>& out)
+{
+    if (!m_Primed) {
+        if (static_cast<int>(m_Buffer.size()) < m_TargetDepth) {
+            return;
+        }
+        m_Primed = true;
+    }
+
+    while (!m_HostUrbs.empty() && m_Buffer.size() >= m_HostUrbs.front().lengths.size()) {
+        out.push_back(buildCompletionLocked(m_HostUrbs.front()));
+        m_HostUrbs.pop_front();
+    }
+}
+
+IsoInStream::Completion IsoInStream::buildCompletionLocked(const HostUrb& urb)
+{
+    Completion c;
+    c.header = urb.header;
+    c.header.status = 0;
+    c.header.startFrame = 0;
+
+    // Packed data for every packet, then one descriptor per packet
+    QByteArray isoDescs;
+    uint32_t offset = 0;
+    uint32_t totalActual = 0;
+    for (uint32_t length : urb.lengths) {
+        Packet p = std::move(m_Buffer.front());
+        m_Buffer.pop_front();
+
+        MlptProtocol::UsbIpIsoPacket iso;
+        iso.offset = offset;
+        iso.length = length;
+        iso.actualLength = qMin<uint32_t>(static_cast<uint32_t>(p.data.size()), length);
+        iso.status = p.status;
+        isoDescs.append(reinterpret_cast<const char*>(&iso), sizeof(iso));
+
+        c.data.append(p.data.constData(), static_cast<int>(iso.actualLength));
+        offset += length;
+        totalActual += iso.actualLength;
+    }
+    c.data.append(isoDescs);
+    c.header.dataLen = totalActual;
+
+    m_HostUrbsServed++;
+    m_CompletionTimesUs.push_back(m_Clock.nsecsElapsed() / 1000);
+    if (m_CompletionTimesUs.size() > 64) {
+        m_CompletionTimesUs.pop_front();
+    }
+
+    return c;
+}
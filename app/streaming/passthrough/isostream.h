@@ -0,0 +1,144 @@
+// IsoInStream — Continuous isochronous IN streaming for UsbIpExporter.
+//
+// One-off libusb ISO transfers per host URB leave gaps on the device side
+// whenever the network delays the host's next URB, which webcams and USB
+// audio interfaces see as dropped frames. Instead, a ring of ISO transfers
+// is kept in flight on the local device and completed packets are queued
+// in a jitter buffer. Host ISO URBs are then served from that buffer.
+//
+// The buffer target depth tracks the measured host turnaround (the time
+// between completing a host URB and the host submitting its replacement),
+// so a slower link holds more packets. Running dry counts as an underrun
+// and re-primes the buffer; overflowing drops the oldest packets and
+// counts as an overrun.
+//
+// A stream created without a device handle has no transfer ring of its own;
+// its packets are fed in with deliverPackets() instead (SimulatedUsbDevice).
+#pragma once
+
+#include <QMutex>
+#include <QByteArray>
+#include <QList>
+#include <QElapsedTimer>
+
+#include <deque>
+#include <functional>
+#include <vector>
+
+#include "protocol.h"
+
+struct libusb_device_handle;
+struct libusb_transfer;
+
+#ifndef MLPT_LIBUSB_CALL
+#ifdef _WIN32
+#define MLPT_LIBUSB_CALL __stdcall
+#else
+#define MLPT_LIBUSB_CALL
+#endif
+#endif
+
+class IsoInStream
+{
+public:
+    struct Stats {
+        uint8_t  endpointAddress;
+        uint64_t devicePackets;   // Packets received from the device
+        uint64_t hostUrbs;        // Host URBs served
+        uint64_t underruns;       // Buffer ran dry while the host was waiting
+        uint64_t overruns;        // Packets dropped because the buffer was full
+        int      bufferedPackets;
+        int      targetDepth;     // Packets
+        double   turnaroundMs;    // Smoothed host URB turnaround
+    };
+
+    using CompletionFn = std::function<void(const MlptProtocol::UsbIpHeader&, const QByteArray&)>;
+
+    IsoInStream(libusb_device_handle* handle, uint8_t endpointAddress,
+                uint32_t packetSize, int packetsPerTransfer, CompletionFn onComplete);
+    ~IsoInStream();
+
+    // Submit the transfer ring. Returns false if the device rejects it,
+    // in which case the caller should fall back to one-off transfers.
+    bool start();
+
+    // Queue packets produced outside of libusb, in device order. An empty
+    // packet is a frame in which the device sent nothing.
+    void deliverPackets(const QList<QByteArray>& packets);
+
+    // Cancel the ring and fail any waiting host URBs. The object may only be
+    // destroyed once isIdle() (or the libusb event thread has stopped).
+    void stop();
+    bool isRunning() const;
+    bool isIdle() const;
+
+    uint8_t endpointAddress() const { return m_EndpointAddress; }
+
+    // Queue a host ISO IN URB; iso descriptors (host order) follow in isoDescs
+    void submitHostUrb(const MlptProtocol::UsbIpHeader& header, const QByteArray& isoDescs);
+
+    // Complete a waiting host URB as unlinked. Returns false if not queued here.
+    bool unlinkHostUrb(uint32_t seqNum);
+
+    Stats stats() const;
+
+private:
+    struct Packet {
+        QByteArray data;
+        int32_t status;
+    };
+
+    struct HostUrb {
+        MlptProtocol::UsbIpHeader header;
+        std::vector<uint32_t> lengths;
+    };
+
+    struct Completion {
+        MlptProtocol::UsbIpHeader header;
+        QByteArray data;
+    };
+
+    static void MLPT_LIBUSB_CALL transferCallback(libusb_transfer* transfer);
+    void handleTransferComplete(libusb_transfer* transfer);
+
+    // Add one transfer's worth of device packets to the buffer (m_Mutex held)
+    void queuePacketsLocked(std::vector<Packet>& packets, std::vector<Completion>& out);
+
+    // Serve queued host URBs from the buffer (m_Mutex held)
+    void serveLocked(std::vector<Completion>& out);
+    Completion buildCompletionLocked(const HostUrb& urb);
+    void updateTargetDepthLocked();
+
+    libusb_device_handle* m_Handle;
+    uint8_t m_EndpointAddress;
+    uint32_t m_PacketSize;
+    int m_PacketsPerTransfer;
+    int m_NumTransfers;
+    CompletionFn m_OnComplete;
+
+    mutable QMutex m_Mutex;
+    bool m_Running;
+    int m_ActiveTransfers;
+    std::vector<libusb_transfer*> m_Transfers;
+
+    std::deque<Packet> m_Buffer;
+    std::deque<HostUrb> m_HostUrbs;
+    bool m_Primed;
+    int m_TargetDepth;
+    int m_MinDepth;
+    int m_MaxDepth;
+
+    // Host turnaround measurement
+    QElapsedTimer m_Clock;
+    std::deque<qint64> m_CompletionTimesUs;
+    double m_TurnaroundUs;
+
+    // Device packet interval, measured from transfer completions
+    qint64 m_LastTransferUs;
+    double m_PacketIntervalUs;
+
+    uint64_t m_DevicePackets;
+    uint64_t m_HostUrbsServed;
+    uint64_t m_Underruns;
+    uint64_t m_Overruns;
+};
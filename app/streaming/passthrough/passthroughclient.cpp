@@ -2,8 +2,12 @@
 #include "usbipexporter.h"
 #include "bthidcapture.h"
 #include "usbipdaemon.h"
+#include "path.h"
 
+#include <QDateTime>
+#include <QDir>
 #include <QRandomGenerator>
+#include <QVariantMap>
 #include <QtDebug>
 
 PassthroughClient::PassthroughClient(QObject* parent)
@@ -12,7 +16,9 @@ PassthroughClient::PassthroughClient(QObject* parent)
     , m_Connected(false)
     , m_VhciAvailable(false)
     , m_StatusText(tr("Not connected"))
+    , m_UrbTrace(MlptTrace::BUS_CLIENT)
     , m_Daemon(nullptr)
+    , m_NativeDaemon(nullptr)
     , m_ServerBackend(MlptProtocol::VHCI_BACKEND_LEGACY)
     , m_ReconnectAttempts(0)
 {
@@ -37,6 +43,34 @@ PassthroughClient::PassthroughClient(QObject* parent)
     m_ReconnectTimer.setSingleShot(true);
     connect(&m_ReconnectTimer, &QTimer::timeout, this, &PassthroughClient::onReconnectTimer);
 
+    // MLPT_USBIP_PORT=<port> (3240 is the usbip default) serves forwarded
+    // devices to stock USB/IP clients while no Moonlight server is connected.
+    // It only listens on loopback unless MLPT_USBIP_BIND=<address> is set.
+    int nativePort = qEnvironmentVariableIntValue("MLPT_USBIP_PORT");
+    if (nativePort > 0 && nativePort <= 65535) {
+        QHostAddress bindAddress(QHostAddress::LocalHost);
+        if (qEnvironmentVariableIsSet("MLPT_USBIP_BIND") &&
+                !bindAddress.setAddress(qEnvironmentVariable("MLPT_USBIP_BIND"))) {
+            qWarning() << "Passthrough: ignoring invalid MLPT_USBIP_BIND" << qEnvironmentVariable("MLPT_USBIP_BIND");
+            bindAddress = QHostAddress::LocalHost;
+        }
+
+        m_NativeDaemon = new UsbIpDaemon(this);
+        if (!m_NativeDaemon->start(static_cast<uint16_t>(nativePort), bindAddress)) {
+            qWarning() << "Passthrough: failed to start native USB/IP daemon on port" << nativePort;
+            delete m_NativeDaemon;
+            m_NativeDaemon = nullptr;
+        }
+    }
+
+    // With simulated devices the point is usually benchmarking, so log
+    // per-endpoint latency and throughput periodically
+    if (SimulatedUsbDevice::isEnabled()) {
+        m_UrbStatsLogTimer.setInterval(5000);
+        connect(&m_UrbStatsLogTimer, &QTimer::timeout, this, &PassthroughClient::logUrbStats);
+        m_UrbStatsLogTimer.start();
+    }
+
     // Initialize device enumeration
     m_DeviceEnumerator.enumerate();
 
@@ -60,6 +94,11 @@ PassthroughClient::~PassthroughClient()
         delete m_Daemon;
         m_Daemon = nullptr;
     }
+    if (m_NativeDaemon) {
+        m_NativeDaemon->stop();
+        delete m_NativeDaemon;
+        m_NativeDaemon = nullptr;
+    }
 }
 
 void PassthroughClient::connectToServer(const QString& address, uint16_t port)
@@ -105,7 +144,7 @@ void PassthroughClient::disconnectFromServer()
 
 void PassthroughClient::attachDevice(uint32_t deviceId)
 {
-    if (!m_Connected) {
+    if (!m_Connected && !m_NativeDaemon) {
         qWarning() << "Cannot attach device: not connected";
         return;
     }
@@ -147,8 +186,22 @@ void PassthroughClient::attachDevice(uint32_t deviceId)
         // Open device with libusb
         auto* exporter = new UsbIpExporter(this);
         exporter->setDeviceId(deviceId);
+        exporter->setUrbTrace(&m_UrbTrace);
+
+        bool opened;
+        if (devInfo->driver == SimulatedUsbDevice::DRIVER_NAME) {
+            opened = false;
+            for (const SimulatedUsbDevice::Config& config : SimulatedUsbDevice::configuredDevices()) {
+                if (config.productId == devInfo->productId) {
+                    opened = exporter->openSimulatedDevice(config.kind);
+                    break;
+                }
+            }
+        } else {
+            opened = exporter->openDevice(devInfo->vendorId, devInfo->productId, devInfo->serialNumber);
+        }
 
-        if (!exporter->openDevice(devInfo->vendorId, devInfo->productId, devInfo->serialNumber)) {
+        if (!opened) {
             qWarning() << "Failed to open device" << deviceId
                        << devInfo->name
                        << QString::asprintf("(%04x:%04x)", devInfo->vendorId, devInfo->productId)
@@ -169,7 +222,11 @@ void PassthroughClient::attachDevice(uint32_t deviceId)
             return;
         }
 
-        if (m_ServerBackend == MlptProtocol::VHCI_BACKEND_WIN2 && m_Daemon) {
+        if (!m_Connected) {
+            // Native mode: no Moonlight server, a stock usbip client
+            // (e.g. Linux `usbip attach`) imports the device directly.
+            m_NativeDaemon->exportDevice(UsbIpDaemon::makeBusid(deviceId), deviceId, exporter);
+        } else if (m_ServerBackend == MlptProtocol::VHCI_BACKEND_WIN2 && m_Daemon) {
             // Win2 mode: register device with the USB/IP daemon.
             // The VHCI driver will connect directly to our daemon for URB exchange.
             // No URB routing through MLPT TCP is needed.
@@ -197,6 +254,14 @@ void PassthroughClient::attachDevice(uint32_t deviceId)
 
         m_Exporters.insert(deviceId, exporter);
 
+        if (!m_Connected) {
+            m_DeviceEnumerator.setDeviceForwarding(deviceId, true);
+            qInfo() << "Exported USB device" << deviceId << devInfo->name
+                    << "for native USB/IP as busid" << UsbIpDaemon::makeBusid(deviceId)
+                    << "on port" << m_NativeDaemon->port();
+            return;
+        }
+
         // Send DEVICE_ATTACH with USB descriptors
         sendDeviceAttachWithDescriptors(deviceId, exporter);
         startAttachTimeout(deviceId);
@@ -208,6 +273,13 @@ void PassthroughClient::attachDevice(uint32_t deviceId)
                 << (m_ServerBackend == MlptProtocol::VHCI_BACKEND_WIN2 ? "[win2]" : "[legacy]");
 
     } else if (devInfo->transport == MlptProtocol::TRANSPORT_BLUETOOTH) {
+        if (!m_Connected) {
+            // BtHidCapture is not a UsbIpExporter, so the daemon can't serve it
+            m_DeviceEnumerator.setDeviceError(deviceId, tr("Bluetooth devices require a Moonlight passthrough server"));
+            emit deviceAttachFailed(deviceId, MlptProtocol::ATTACH_ERR_FAILED);
+            return;
+        }
+
         // Check if this is a HID-capable BT device
         uint8_t dc = devInfo->deviceClass;
         if (dc != MlptProtocol::DEVCLASS_HID_KEYBOARD &&
@@ -289,6 +361,8 @@ void PassthroughClient::detachDevice(uint32_t deviceId)
     m_DeviceEnumerator.setDeviceError(deviceId, QString());
 
     if (!m_Connected) {
+        // Native USB/IP exports live without a server connection
+        cleanupExporter(deviceId);
         return;
     }
 
@@ -334,6 +408,90 @@ void PassthroughClient::autoAttachDevices()
     }
 }
 
+QVariantList PassthroughClient::urbEndpointStats() const
+{
+    QVariantList result;
+
+    for (const MlptTrace::EndpointStats& s : m_UrbTrace.aggregate()) {
+        QVariantMap entry;
+        entry["deviceId"] = s.deviceId;
+        entry["endpoint"] = QString::asprintf("0x%02x", s.endpointAddress);
+        entry["transferType"] = QString::fromLatin1(MlptTrace::UrbTraceRing::transferTypeName(s.transferType));
+        entry["completed"] = static_cast<qulonglong>(s.completed);
+        entry["errors"] = static_cast<qulonglong>(s.errors);
+        entry["inFlight"] = static_cast<qulonglong>(s.inFlight);
+        entry["avgLatencyMs"] = s.avgLatencyUs() / 1000.0;
+        entry["minLatencyMs"] = s.minLatencyUs / 1000.0;
+        entry["maxLatencyMs"] = s.maxLatencyUs / 1000.0;
+        entry["p50LatencyMs"] = s.p50LatencyUs / 1000.0;
+        entry["p99LatencyMs"] = s.p99LatencyUs / 1000.0;
+        entry["urbsPerSec"] = s.urbsPerSec();
+        entry["kbPerSec"] = s.bytesPerSec() / 1024.0;
+
+        // Jitter buffer counters if this endpoint is served by an ISO stream
+        auto exporterIt = m_Exporters.constFind(s.deviceId);
+        if (exporterIt != m_Exporters.constEnd()) {
+            for (const IsoInStream::Stats& iso : exporterIt.value()->isoStreamStats()) {
+                if (iso.endpointAddress == s.endpointAddress) {
+                    entry["isoUnderruns"] = static_cast<qulonglong>(iso.underruns);
+                    entry["isoOverruns"] = static_cast<qulonglong>(iso.overruns);
+                    entry["isoDepth"] = iso.targetDepth;
+                }
+            }
+        }
+
+        result.append(entry);
+    }
+
+    return result;
+}
+
+void PassthroughClient::logUrbStats()
+{
+    for (const MlptTrace::EndpointStats& s : m_UrbTrace.aggregate()) {
+        if (s.completed == 0 && s.inFlight == 0) {
+            continue;
+        }
+
+        qInfo().noquote() << QString::asprintf(
+            "Passthrough: dev %u ep 0x%02x %-4s %8.1f URB/s %9.1f KB/s  "
+            "p50 %.2f ms  p99 %.2f ms  max %.2f ms  errors %llu  in-flight %llu",
+            s.deviceId, s.endpointAddress,
+            MlptTrace::UrbTraceRing::transferTypeName(s.transferType),
+            s.urbsPerSec(), s.bytesPerSec() / 1024.0,
+            s.p50LatencyUs / 1000.0, s.p99LatencyUs / 1000.0, s.maxLatencyUs / 1000.0,
+            static_cast<unsigned long long>(s.errors),
+            static_cast<unsigned long long>(s.inFlight));
+    }
+
+    for (auto it = m_Exporters.constBegin(); it != m_Exporters.constEnd(); ++it) {
+        for (const IsoInStream::Stats& iso : it.value()->isoStreamStats()) {
+            qInfo().noquote() << QString::asprintf(
+                "Passthrough: dev %u ep 0x%02x ISO stream  buffered %d/%d packets  "
+                "turnaround %.2f ms  underruns %llu  overruns %llu",
+                it.key(), iso.endpointAddress, iso.bufferedPackets, iso.targetDepth,
+                iso.turnaroundMs,
+                static_cast<unsigned long long>(iso.underruns),
+                static_cast<unsigned long long>(iso.overruns));
+        }
+    }
+}
+
+QString PassthroughClient::saveUrbTrace()
+{
+    QString path = QDir(Path::getLogDir()).filePath(
+        QString("Moonlight-URBs-%1.pcap").arg(QDateTime::currentSecsSinceEpoch()));
+
+    if (!m_UrbTrace.writePcap(QDir::toNativeSeparators(path).toLocal8Bit().constData())) {
+        qWarning() << "Passthrough: failed to write URB trace to" << path;
+        return QString();
+    }
+
+    qInfo() << "Passthrough: wrote" << qMin<quint64>(m_UrbTrace.totalRecords(), m_UrbTrace.capacity())
+            << "URB trace records to" << path;
+    return path;
+}
+
 // ─── Socket event handlers ───
 
 void PassthroughClient::onSocketConnected()
@@ -713,10 +871,13 @@ void PassthroughClient::cleanupExporter(uint32_t deviceId)
 {
     auto it = m_Exporters.find(deviceId);
     if (it != m_Exporters.end()) {
-        // Unexport from daemon if in win2 mode
+        // Unexport from daemon if in win2 or native mode
         if (m_Daemon) {
             m_Daemon->unexportDevice(UsbIpDaemon::makeBusid(deviceId));
         }
+        if (m_NativeDaemon) {
+            m_NativeDaemon->unexportDevice(UsbIpDaemon::makeBusid(deviceId));
+        }
         (*it)->closeDevice();
         (*it)->deleteLater();
         m_Exporters.erase(it);
@@ -725,10 +886,12 @@ void PassthroughClient::cleanupExporter(uint32_t deviceId)
 
 void PassthroughClient::cleanupAllExporters()
 {
-    if (m_Daemon) {
+    for (UsbIpDaemon* daemon : { m_Daemon, m_NativeDaemon }) {
+        if (!daemon) continue;
+
         // Unexport all devices from daemon
         for (auto it = m_Exporters.begin(); it != m_Exporters.end(); ++it) {
-            m_Daemon->unexportDevice(UsbIpDaemon::makeBusid(it.key()));
+            daemon->unexportDevice(UsbIpDaemon::makeBusid(it.key()));
         }
     }
     for (auto* exporter : m_Exporters) {
@@ -789,7 +952,9 @@ void PassthroughClient::processMessage(const MlptProtocol::Header& header, const
                 m_Daemon = new UsbIpDaemon(this);
             }
             if (!m_Daemon->isRunning()) {
-                if (!m_Daemon->start(0)) {
+                // Only the server we're talking to needs to reach the daemon
+                m_Daemon->setAllowedPeer(m_Socket.peerAddress());
+                if (!m_Daemon->start(0, m_Socket.localAddress())) {
                     qWarning() << "Passthrough: failed to start USB/IP daemon";
                 } else {
                     qInfo() << "Passthrough: USB/IP daemon started on port" << m_Daemon->port();
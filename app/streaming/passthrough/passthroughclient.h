@@ -6,8 +6,10 @@
 #include <QByteArray>
 #include <QList>
 #include <QHash>
+#include <QVariantList>
 
 #include "protocol.h"
+#include "urbtrace.h"
 #include "deviceenumerator.h"
 
 class UsbIpExporter;
@@ -43,6 +45,13 @@ public:
     // Auto-attach all devices marked for auto-forward
     void autoAttachDevices();
 
+    // Per-endpoint URB latency/throughput aggregated from the trace ring
+    Q_INVOKABLE QVariantList urbEndpointStats() const;
+
+    // Dump the URB trace ring as a usbmon pcap file in the log directory.
+    // Returns the file path, or an empty string on failure.
+    Q_INVOKABLE QString saveUrbTrace();
+
 signals:
     void connectedChanged();
     void vhciAvailableChanged();
@@ -79,10 +88,12 @@ private:
     void scheduleReconnect();
     void startAttachTimeout(uint32_t deviceId);
     void cancelAttachTimeout(uint32_t deviceId);
+    void logUrbStats();
 
     QTcpSocket m_Socket;
     QTimer m_KeepaliveTimer;
     QTimer m_ReconnectTimer;
+    QTimer m_UrbStatsLogTimer;
 
     QString m_ServerAddress;
     uint16_t m_ServerPort;
@@ -96,6 +107,9 @@ private:
 
     DeviceEnumerator m_DeviceEnumerator;
 
+    // URB submit/complete trace shared by all exporters
+    MlptTrace::UrbTraceRing m_UrbTrace;
+
     // Active device exporters: deviceId → UsbIpExporter*
     QHash<uint32_t, UsbIpExporter*> m_Exporters;
 
@@ -104,6 +118,9 @@ private:
 
     // Win2 mode: USB/IP daemon for direct driver connections
     UsbIpDaemon* m_Daemon;
+
+    // Native mode (MLPT_USBIP_PORT): USB/IP daemon for stock usbip clients
+    UsbIpDaemon* m_NativeDaemon;
     uint8_t m_ServerBackend;  // MlptProtocol::VhciBackend
 
     int m_ReconnectAttempts;
@@ -0,0 +1,502 @@
+#include "simulateddevice.h"
+
+#include <QRandomGenerator>
+#include <QtDebug>
+
+// 48 kHz * 2 channels * 2 bytes per 1 ms frame
+static constexpr int ISO_AUDIO_FRAME_BYTES = 192;
+static constexpr int BULK_MAX_PACKET = 512;
+
+// Boot mouse with wheel: 3 buttons, X, Y, wheel (4 byte report)
+static const uint8_t k_MouseReportDescriptor[] = {
+    0x05, 0x01, 0x09, 0x02, 0xA1, 0x01, 0x09, 0x01,
+    0xA1, 0x00, 0x05, 0x09, 0x19, 0x01, 0x29, 0x03,
+    0x15, 0x00, 0x25, 0x01, 0x95, 0x03, 0x75, 0x01,
+    0x81, 0x02, 0x95, 0x01, 0x75, 0x05, 0x81, 0x03,
+    0x05, 0x01, 0x09, 0x30, 0x09, 0x31, 0x09, 0x38,
+    0x15, 0x81, 0x25, 0x7F, 0x75, 0x08, 0x95, 0x03,
+    0x81, 0x06, 0xC0, 0xC0,
+};
+
+QList<SimulatedUsbDevice::Config> SimulatedUsbDevice::configuredDevices()
+{
+    QList<Config> result;
+
+    QByteArray env = qgetenv("MLPT_SIMULATED_DEVICES");
+    for (const QByteArray& token : env.split(',')) {
+        QByteArray kind = token.trimmed().toLower();
+        if (kind == "hid") {
+            result.append({ KIND_HID_MOUSE, "Simulated HID Mouse (1000 Hz)", 0x0001 });
+        } else if (kind == "bulk") {
+            result.append({ KIND_BULK, "Simulated Bulk Source/Sink", 0x0002 });
+        } else if (kind == "iso") {
+            result.append({ KIND_ISO_AUDIO, "Simulated Isochronous Audio", 0x0003 });
+        } else if (!kind.isEmpty()) {
+            qWarning() << "SimulatedUsbDevice: unknown device kind" << kind;
+        }
+    }
+
+    return result;
+}
+
+bool SimulatedUsbDevice::isEnabled()
+{
+    return !configuredDevices().isEmpty();
+}
+
+SimulatedUsbDevice::SimulatedUsbDevice(Kind kind, QObject* parent)
+    : QObject(parent)
+    , m_Kind(kind)
+    , m_UsbSpeed(kind == KIND_BULK ? 3 : 2)
+    , m_CurrentConfig(0)
+    , m_CurrentAltSetting(0)
+    , m_LatencyUs(qEnvironmentVariableIntValue("MLPT_SIM_LATENCY_MS") * 1000LL)
+    , m_LossPercent(qBound(0, qEnvironmentVariableIntValue("MLPT_SIM_LOSS_PERCENT"), 100))
+    , m_NextHidSlotUs(0)
+    , m_NextIsoSlotUs(0)
+    , m_MouseStep(0)
+    , m_IsoFrameNumber(0)
+    , m_IsoStreamPackets(0)
+{
+    buildDescriptors();
+
+    m_Clock.start();
+
+    m_TickTimer.setTimerType(Qt::PreciseTimer);
+    m_TickTimer.setInterval(1);
+    connect(&m_TickTimer, &QTimer::timeout, this, &SimulatedUsbDevice::onTick);
+
+    qInfo() << "SimulatedUsbDevice: created kind" << kind
+            << "latency:" << m_LatencyUs / 1000 << "ms"
+            << "loss:" << m_LossPercent << "%";
+}
+
+SimulatedUsbDevice::~SimulatedUsbDevice()
+{
+    m_TickTimer.stop();
+}
+
+// ============================================================================
+// USB Descriptor synthesis
+// ============================================================================
+
+void SimulatedUsbDevice::buildDescriptors()
+{
+    uint16_t productId = 0;
+    for (const Config& config : configuredDevices()) {
+        if (config.kind == m_Kind) {
+            productId = config.productId;
+        }
+    }
+
+    m_DeviceDescriptor.resize(18);
+    uint8_t* dd = reinterpret_cast<uint8_t*>(m_DeviceDescriptor.data());
+    dd[0] = 18;           // bLength
+    dd[1] = 0x01;         // bDescriptorType (DEVICE)
+    dd[2] = 0x00; dd[3] = 0x02; // bcdUSB = 2.00
+    dd[4] = 0x00;         // bDeviceClass (per interface)
+    dd[5] = 0x00;         // bDeviceSubClass
+    dd[6] = 0x00;         // bDeviceProtocol
+    dd[7] = 64;           // bMaxPacketSize0
+    dd[8] = VENDOR_ID & 0xFF; dd[9] = (VENDOR_ID >> 8) & 0xFF; // idVendor
+    dd[10] = productId & 0xFF; dd[11] = (productId >> 8) & 0xFF; // idProduct
+    dd[12] = 0x00; dd[13] = 0x01; // bcdDevice = 1.00
+    dd[14] = 1;           // iManufacturer
+    dd[15] = 2;           // iProduct
+    dd[16] = 3;           // iSerialNumber
+    dd[17] = 1;           // bNumConfigurations
+
+    QByteArray body;
+    auto append = [&body](std::initializer_list<uint8_t> bytes) {
+        for (uint8_t b : bytes) body.append(static_cast<char>(b));
+    };
+
+    uint8_t numInterfaces = 1;
+
+    switch (m_Kind) {
+    case KIND_HID_MOUSE: {
+        m_HidReportDescriptor = QByteArray(reinterpret_cast<const char*>(k_MouseReportDescriptor),
+                                           sizeof(k_MouseReportDescriptor));
+        uint16_t rdLen = static_cast<uint16_t>(m_HidReportDescriptor.size());
+
+        append({ 9, 0x04, 0, 0, 1, 0x03, 0x01, 0x02, 0 });    // Interface: HID boot mouse
+        append({ 9, 0x21, 0x11, 0x01, 0, 1, 0x22,
+                 static_cast<uint8_t>(rdLen & 0xFF), static_cast<uint8_t>(rdLen >> 8) }); // HID
+        append({ 7, 0x05, 0x81, 0x03, 4, 0, 1 });              // EP 1 IN, interrupt, 4 bytes, 1 ms
+        break;
+    }
+
+    case KIND_BULK:
+        append({ 9, 0x04, 0, 0, 2, 0xFF, 0x00, 0x00, 0 });    // Interface: vendor specific
+        append({ 7, 0x05, 0x81, 0x02, BULK_MAX_PACKET & 0xFF, BULK_MAX_PACKET >> 8, 0 }); // EP 1 IN, bulk
+        append({ 7, 0x05, 0x02, 0x02, BULK_MAX_PACKET & 0xFF, BULK_MAX_PACKET >> 8, 0 }); // EP 2 OUT, bulk
+        break;
+
+    case KIND_ISO_AUDIO:
+        // Alt 0 has no bandwidth, alt 1 streams (like a UAC streaming interface)
+        append({ 9, 0x04, 0, 0, 0, 0xFF, 0x00, 0x00, 0 });
+        append({ 9, 0x04, 0, 1, 1, 0xFF, 0x00, 0x00, 0 });
+        append({ 7, 0x05, 0x83, 0x05, ISO_AUDIO_FRAME_BYTES & 0xFF, ISO_AUDIO_FRAME_BYTES >> 8, 1 }); // EP 3 IN, iso async
+        break;
+    }
+
+    uint16_t totalLen = static_cast<uint16_t>(9 + body.size());
+    m_ConfigDescriptor.clear();
+    m_ConfigDescriptor.append(static_cast<char>(9));       // bLength
+    m_ConfigDescriptor.append(static_cast<char>(0x02));    // bDescriptorType (CONFIGURATION)
+    m_ConfigDescriptor.append(static_cast<char>(totalLen & 0xFF));
+    m_ConfigDescriptor.append(static_cast<char>(totalLen >> 8));
+    m_ConfigDescriptor.append(static_cast<char>(numInterfaces));
+    m_ConfigDescriptor.append(static_cast<char>(1));       // bConfigurationValue
+    m_ConfigDescriptor.append(static_cast<char>(0));       // iConfiguration
+    m_ConfigDescriptor.append(static_cast<char>(0x80));    // bmAttributes (bus powered)
+    m_ConfigDescriptor.append(static_cast<char>(50));      // bMaxPower (100mA)
+    m_ConfigDescriptor.append(body);
+}
+
+QByteArray SimulatedUsbDevice::stringDescriptor(uint8_t index) const
+{
+    QString str;
+    switch (index) {
+    case 0: {
+        // Supported language IDs: English (US)
+        QByteArray langs(4, 0);
+        langs[0] = 4;
+        langs[1] = 0x03;
+        langs[2] = 0x09;
+        langs[3] = 0x04;
+        return langs;
+    }
+    case 1:
+        str = QStringLiteral("Moonlight");
+        break;
+    case 2:
+        for (const Config& config : configuredDevices()) {
+            if (config.kind == m_Kind) {
+                str = config.name;
+            }
+        }
+        break;
+    case 3:
+        str = QStringLiteral("SIM-%1").arg(static_cast<int>(m_Kind));
+        break;
+    default:
+        return QByteArray();
+    }
+
+    QByteArray desc;
+    desc.append(static_cast<char>(2 + str.size() * 2));
+    desc.append(static_cast<char>(0x03));
+    for (QChar c : str) {
+        desc.append(static_cast<char>(c.unicode() & 0xFF));
+        desc.append(static_cast<char>(c.unicode() >> 8));
+    }
+    return desc;
+}
+
+// ============================================================================
+// URB handling
+// ============================================================================
+
+void SimulatedUsbDevice::submitUrb(const MlptProtocol::UsbIpHeader& header, const QByteArray& data)
+{
+    Q_UNUSED(data);
+
+    if (header.endpoint == 0) {
+        handleControlUrb(header);
+    } else {
+        handleDataUrb(header);
+    }
+}
+
+void SimulatedUsbDevice::unlinkUrb(uint32_t seqNum)
+{
+    for (int i = 0; i < m_Pending.size(); i++) {
+        if (m_Pending[i].header.seqNum == seqNum) {
+            PendingUrb urb = m_Pending.takeAt(i);
+            urb.header.status = -2; // Unlinked, same as a cancelled libusb transfer
+            urb.header.dataLen = 0;
+            emit urbCompleted(urb.header, QByteArray());
+            return;
+        }
+    }
+}
+
+void SimulatedUsbDevice::cancelAll()
+{
+    stopIsoStream();
+    while (!m_Pending.isEmpty()) {
+        unlinkUrb(m_Pending.first().header.seqNum);
+    }
+    m_TickTimer.stop();
+}
+
+bool SimulatedUsbDevice::startIsoStream(uint8_t endpointAddress, int packetsPerTransfer, IsoPacketSink sink)
+{
+    if (m_Kind != KIND_ISO_AUDIO || endpointAddress != 0x83 ||
+        m_CurrentAltSetting != 1 || packetsPerTransfer <= 0) {
+        return false;
+    }
+
+    m_IsoSink = std::move(sink);
+    m_IsoStreamPackets = packetsPerTransfer;
+    m_NextIsoSlotUs = qMax(m_NextIsoSlotUs, m_Clock.nsecsElapsed() / 1000) + packetsPerTransfer * 1000;
+
+    if (!m_TickTimer.isActive()) {
+        m_TickTimer.start();
+    }
+    return true;
+}
+
+void SimulatedUsbDevice::stopIsoStream()
+{
+    m_IsoSink = nullptr;
+    m_IsoStreamPackets = 0;
+}
+
+void SimulatedUsbDevice::handleControlUrb(const MlptProtocol::UsbIpHeader& header)
+{
+    const uint8_t* setup = header.setupPacket;
+    uint8_t bmRequestType = setup[0];
+    uint8_t bRequest = setup[1];
+    uint16_t wValue = setup[2] | (setup[3] << 8);
+    uint16_t wLength = setup[6] | (setup[7] << 8);
+
+    qint64 due = m_Clock.nsecsElapsed() / 1000 + m_LatencyUs;
+
+    // GET_DESCRIPTOR
+    if ((bmRequestType == 0x80 || bmRequestType == 0x81) && bRequest == 0x06) {
+        uint8_t descType = (wValue >> 8) & 0xFF;
+        QByteArray desc;
+
+        switch (descType) {
+        case 0x01: desc = m_DeviceDescriptor; break;
+        case 0x02: desc = m_ConfigDescriptor; break;
+        case 0x03: desc = stringDescriptor(wValue & 0xFF); break;
+        case 0x21: desc = m_Kind == KIND_HID_MOUSE ? m_ConfigDescriptor.mid(9 + 9, 9) : QByteArray(); break;
+        case 0x22: desc = m_HidReportDescriptor; break;
+        }
+
+        if (desc.isEmpty()) {
+            schedule(header, -32, QByteArray(), due); // EPIPE (stall)
+        } else {
+            schedule(header, 0, desc.left(wLength), due);
+        }
+        return;
+    }
+
+    switch (bRequest) {
+    case 0x00: // GET_STATUS
+        if (bmRequestType & 0x80) {
+            schedule(header, 0, QByteArray(2, 0).left(wLength), due);
+            return;
+        }
+        break;
+
+    case 0x08: // GET_CONFIGURATION
+        if (bmRequestType == 0x80) {
+            schedule(header, 0, QByteArray(1, static_cast<char>(m_CurrentConfig)), due);
+            return;
+        }
+        break;
+
+    case 0x09: // SET_CONFIGURATION
+        if (bmRequestType == 0x00) {
+            m_CurrentConfig = wValue & 0xFF;
+            m_CurrentAltSetting = 0;
+            schedule(header, 0, QByteArray(), due);
+            return;
+        }
+        break;
+
+    case 0x0A: // GET_INTERFACE / HID SET_IDLE
+        if (bmRequestType == 0x81) {
+            schedule(header, 0, QByteArray(1, static_cast<char>(m_CurrentAltSetting)), due);
+            return;
+        }
+        if (bmRequestType == 0x21) {
+            schedule(header, 0, QByteArray(), due);
+            return;
+        }
+        break;
+
+    case 0x0B: // SET_INTERFACE / HID SET_PROTOCOL
+        if (bmRequestType == 0x01) {
+            m_CurrentAltSetting = wValue & 0xFF;
+            schedule(header, 0, QByteArray(), due);
+            return;
+        }
+        if (bmRequestType == 0x21) {
+            schedule(header, 0, QByteArray(), due);
+            return;
+        }
+        break;
+
+    case 0x01: // CLEAR_FEATURE / HID GET_REPORT
+        if (bmRequestType == 0xA1) {
+            schedule(header, 0, QByteArray(4, 0).left(wLength), due);
+            return;
+        }
+        if ((bmRequestType & 0x80) == 0) {
+            schedule(header, 0, QByteArray(), due);
+            return;
+        }
+        break;
+
+    case 0x05: // SET_ADDRESS
+    case 0x03: // SET_FEATURE
+        if ((bmRequestType & 0x80) == 0) {
+            schedule(header, 0, QByteArray(), due);
+            return;
+        }
+        break;
+    }
+
+    // Anything else (BOS, device qualifier, vendor requests) stalls
+    schedule(header, -32, QByteArray(), due);
+}
+
+void SimulatedUsbDevice::handleDataUrb(const MlptProtocol::UsbIpHeader& header)
+{
+    qint64 now = m_Clock.nsecsElapsed() / 1000;
+    bool isIn = header.direction == MlptProtocol::USB_DIR_IN;
+
+    if (m_LossPercent > 0 && static_cast<int>(QRandomGenerator::global()->bounded(100)) < m_LossPercent) {
+        schedule(header, -71, QByteArray(), now + m_LatencyUs); // EPROTO
+        return;
+    }
+
+    switch (m_Kind) {
+    case KIND_HID_MOUSE:
+        if (isIn && header.endpoint == 1) {
+            // One report per 1 ms frame, like a 1000 Hz gaming mouse
+            m_NextHidSlotUs = qMax(m_NextHidSlotUs + 1000, now);
+            schedule(header, 0, nextMouseReport().left(header.dataLen), m_NextHidSlotUs + m_LatencyUs);
+            return;
+        }
+        break;
+
+    case KIND_BULK:
+        if (isIn && header.endpoint == 1) {
+            QByteArray payload(static_cast<int>(header.dataLen), 0);
+            for (int i = 0; i < payload.size(); i++) {
+                payload[i] = static_cast<char>(i % 63);
+            }
+            schedule(header, 0, payload, now + m_LatencyUs);
+            return;
+        }
+        if (!isIn && header.endpoint == 2) {
+            schedule(header, 0, QByteArray(), now + m_LatencyUs);
+            return;
+        }
+        break;
+
+    case KIND_ISO_AUDIO:
+        if (isIn && header.endpoint == 3 && m_CurrentAltSetting == 1) {
+            // Each packet is one 1 ms frame; the URB completes once all its frames have elapsed
+            uint32_t packets = qMax<uint32_t>(header.numIsoPackets, 1);
+            m_NextIsoSlotUs = qMax(m_NextIsoSlotUs, now) + packets * 1000;
+            MlptProtocol::UsbIpHeader resp = header;
+            resp.numIsoPackets = packets;
+
+            // Packed frame data followed by one descriptor per packet
+            QByteArray frames;
+            QByteArray isoDescs;
+            uint32_t perPacket = header.dataLen / packets;
+            for (uint32_t i = 0; i < packets; i++) {
+                MlptProtocol::UsbIpIsoPacket iso;
+                iso.offset = i * perPacket;
+                iso.length = perPacket;
+                iso.actualLength = qMin<uint32_t>(perPacket, ISO_AUDIO_FRAME_BYTES);
+                iso.status = 0;
+                frames.append(nextIsoFrame(static_cast<int>(iso.actualLength)));
+                isoDescs.append(reinterpret_cast<const char*>(&iso), sizeof(iso));
+            }
+            schedule(resp, 0, frames + isoDescs, m_NextIsoSlotUs + m_LatencyUs);
+            return;
+        }
+        break;
+    }
+
+    schedule(header, -32, QByteArray(), now + m_LatencyUs);
+}
+
+QByteArray SimulatedUsbDevice::nextMouseReport()
+{
+    // Trace a slow square so the cursor visibly moves on the host
+    static const int8_t k_Dx[] = { 1, 0, -1, 0 };
+    static const int8_t k_Dy[] = { 0, 1, 0, -1 };
+    int side = (m_MouseStep++ / 500) % 4;
+
+    QByteArray report(4, 0);
+    report[1] = static_cast<char>(k_Dx[side]);
+    report[2] = static_cast<char>(k_Dy[side]);
+    return report;
+}
+
+QByteArray SimulatedUsbDevice::nextIsoFrame(int size)
+{
+    // Silence, except that each frame starts with its frame number so
+    // dropped or reordered frames can be spotted on the other end
+    QByteArray frame(size, 0);
+    uint32_t number = m_IsoFrameNumber++;
+    memcpy(frame.data(), &number, qMin<size_t>(sizeof(number), static_cast<size_t>(size)));
+    return frame;
+}
+
+void SimulatedUsbDevice::schedule(const MlptProtocol::UsbIpHeader& header, int32_t status,
+                                  const QByteArray& data, qint64 dueUs)
+{
+    PendingUrb urb;
+    urb.header = header;
+    urb.header.status = status;
+    if (status != 0) {
+        urb.header.dataLen = 0;
+    } else if (header.direction == MlptProtocol::USB_DIR_IN) {
+        // ISO descriptors trail the data and don't count towards actual_length
+        urb.header.dataLen = static_cast<uint32_t>(data.size());
+        if (header.transferType == MlptProtocol::USB_XFER_ISOCHRONOUS) {
+            urb.header.dataLen -= header.numIsoPackets * static_cast<uint32_t>(sizeof(MlptProtocol::UsbIpIsoPacket));
+        }
+    }
+    // OUT transfers report the full requested length as written
+    urb.data = status == 0 ? data : QByteArray();
+    urb.status = status;
+    urb.dueUs = dueUs;
+    m_Pending.append(urb);
+
+    if (!m_TickTimer.isActive()) {
+        m_TickTimer.start();
+    }
+}
+
+void SimulatedUsbDevice::onTick()
+{
+    qint64 now = m_Clock.nsecsElapsed() / 1000;
+
+    for (int i = 0; i < m_Pending.size();) {
+        if (m_Pending[i].dueUs <= now) {
+            PendingUrb urb = m_Pending.takeAt(i);
+            emit urbCompleted(urb.header, urb.data);
+        } else {
+            i++;
+        }
+    }
+
+    // Complete one transfer's worth of frames for each interval that has elapsed
+    while (m_IsoSink && m_NextIsoSlotUs <= now) {
+        QList<QByteArray> packets;
+        for (int i = 0; i < m_IsoStreamPackets; i++) {
+            packets.append(nextIsoFrame(ISO_AUDIO_FRAME_BYTES));
+        }
+        m_NextIsoSlotUs += m_IsoStreamPackets * 1000;
+
+        // The sink may stop the stream from inside the call
+        IsoPacketSink sink = m_IsoSink;
+        sink(packets);
+    }
+
+    if (m_Pending.isEmpty() && !m_IsoSink) {
+        m_TickTimer.stop();
+    }
+}
@@ -0,0 +1,114 @@
+// SimulatedUsbDevice — Scripted fake USB device for exercising the passthrough
+// stack without real hardware.
+//
+// Enabled with MLPT_SIMULATED_DEVICES=hid,bulk,iso. The listed devices show up
+// in the passthrough device list and are served by UsbIpExporter like any
+// libusb device, so the full client → daemon/relay → server path is measured.
+// MLPT_SIM_LATENCY_MS and MLPT_SIM_LOSS_PERCENT inject per-URB device latency
+// and a percentage of URBs failing with EPROTO.
+#pragma once
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QByteArray>
+#include <QList>
+#include <QString>
+
+#include <functional>
+
+#include "protocol.h"
+
+class SimulatedUsbDevice : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Kind {
+        KIND_HID_MOUSE,     // Boot mouse, interrupt IN at 1000 Hz
+        KIND_BULK,          // Vendor-specific bulk source/sink (gadget-zero style)
+        KIND_ISO_AUDIO,     // Vendor-specific ISO IN stream, 48 kHz stereo s16
+    };
+
+    // Used as PassthroughDevice::driver so the client knows to open the simulator
+    static constexpr const char* DRIVER_NAME = "simulated";
+    static constexpr uint16_t VENDOR_ID = 0x1209;  // pid.codes test VID
+
+    struct Config {
+        Kind kind;
+        QString name;
+        uint16_t productId;
+    };
+
+    // Devices requested by MLPT_SIMULATED_DEVICES (empty if unset)
+    static QList<Config> configuredDevices();
+    static bool isEnabled();
+
+    explicit SimulatedUsbDevice(Kind kind, QObject* parent = nullptr);
+    ~SimulatedUsbDevice();
+
+    QByteArray deviceDescriptor() const { return m_DeviceDescriptor; }
+    QByteArray configDescriptor() const { return m_ConfigDescriptor; }
+    uint8_t usbSpeed() const { return m_UsbSpeed; }
+
+    void submitUrb(const MlptProtocol::UsbIpHeader& header, const QByteArray& data);
+    void unlinkUrb(uint32_t seqNum);
+    void cancelAll();
+
+    // Continuously produce ISO IN packets, packetsPerTransfer at a time, the
+    // way a libusb transfer ring on a real device completes. Returns false
+    // if the endpoint isn't currently streaming.
+    using IsoPacketSink = std::function<void(const QList<QByteArray>&)>;
+    bool startIsoStream(uint8_t endpointAddress, int packetsPerTransfer, IsoPacketSink sink);
+    void stopIsoStream();
+
+signals:
+    void urbCompleted(const MlptProtocol::UsbIpHeader& header, const QByteArray& data);
+
+private slots:
+    void onTick();
+
+private:
+    struct PendingUrb {
+        MlptProtocol::UsbIpHeader header;
+        QByteArray data;       // Response data (IN)
+        int32_t status;
+        qint64 dueUs;
+    };
+
+    void buildDescriptors();
+    void handleControlUrb(const MlptProtocol::UsbIpHeader& header);
+    void handleDataUrb(const MlptProtocol::UsbIpHeader& header);
+    void schedule(const MlptProtocol::UsbIpHeader& header, int32_t status,
+                  const QByteArray& data, qint64 dueUs);
+    QByteArray stringDescriptor(uint8_t index) const;
+    QByteArray nextMouseReport();
+    QByteArray nextIsoFrame(int size);
+
+    Kind m_Kind;
+    uint8_t m_UsbSpeed;
+    QByteArray m_DeviceDescriptor;
+    QByteArray m_ConfigDescriptor;
+    QByteArray m_HidReportDescriptor;
+
+    uint8_t m_CurrentConfig;
+    uint8_t m_CurrentAltSetting;
+
+    // Injected impairments
+    qint64 m_LatencyUs;
+    int m_LossPercent;
+
+    // Paced endpoints: next free 1 ms slot for HID reports / ISO frames
+    qint64 m_NextHidSlotUs;
+    qint64 m_NextIsoSlotUs;
+    uint32_t m_MouseStep;
+    uint32_t m_IsoFrameNumber;
+
+    // Active ISO stream, if any
+    IsoPacketSink m_IsoSink;
+    int m_IsoStreamPackets;
+
+    QElapsedTimer m_Clock;
+    QTimer m_TickTimer;
+    QList<PendingUrb> m_Pending;
+};
@@ -0,0 +1,474 @@
+// URB trace ring - Shared between client and server
+// No Qt dependency - pure C++ with standard headers only
+//
+// Records every URB submit/complete into a fixed-size lock-free ring so
+// the hot path (libusb event thread, VHCI read thread) never blocks.
+// The ring can be dumped as a Wireshark-compatible usbmon pcap file
+// (LINKTYPE_USB_LINUX_MMAPPED) and aggregated into per-endpoint stats.
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "protocol.h"
+
+namespace MlptTrace {
+
+// usbmon event types
+enum EventType : uint8_t {
+    EVENT_SUBMIT   = 'S',
+    EVENT_COMPLETE = 'C',
+    EVENT_ERROR    = 'E',  // Submission error (URB never reached the device)
+};
+
+// Conventional bus numbers so client and server captures can be merged
+// in Wireshark without their device addresses colliding
+static constexpr uint16_t BUS_CLIENT = 1;
+static constexpr uint16_t BUS_SERVER = 2;
+
+struct Record {
+    uint64_t timestampUs;     // Monotonic, relative to ring creation
+    uint32_t seqNum;
+    uint32_t deviceId;
+    uint32_t length;          // Requested length (submit) or actual length (complete)
+    int32_t  status;
+    uint32_t startFrame;
+    uint32_t numIsoPackets;
+    uint8_t  event;           // EventType
+    uint8_t  direction;       // MlptProtocol::UsbDirection
+    uint8_t  endpoint;        // Endpoint number without direction bit
+    uint8_t  transferType;    // MlptProtocol::UsbTransferType
+    uint8_t  hasSetup;
+    uint8_t  setupPacket[8];
+};
+
+// Aggregated per-endpoint statistics computed from the ring contents
+struct EndpointStats {
+    uint32_t deviceId = 0;
+    uint8_t  endpointAddress = 0;  // Endpoint number | 0x80 for IN
+    uint8_t  transferType = 0;
+    uint64_t completed = 0;
+    uint64_t errors = 0;
+    uint64_t inFlight = 0;
+    uint64_t bytes = 0;
+    uint64_t totalLatencyUs = 0;
+    uint64_t minLatencyUs = UINT64_MAX;
+    uint64_t maxLatencyUs = 0;
+    uint64_t p50LatencyUs = 0;
+    uint64_t p99LatencyUs = 0;
+    uint64_t firstUs = 0;
+    uint64_t lastUs = 0;
+
+    double avgLatencyUs() const {
+        return completed ? static_cast<double>(totalLatencyUs) / completed : 0.0;
+    }
+
+    double urbsPerSec() const {
+        return lastUs > firstUs ? completed * 1000000.0 / (lastUs - firstUs) : 0.0;
+    }
+
+    double bytesPerSec() const {
+        return lastUs > firstUs ? bytes * 1000000.0 / (lastUs - firstUs) : 0.0;
+    }
+};
+
+#pragma pack(push, 1)
+
+// usbmon binary header (struct usbmon_packet from Documentation/usb/usbmon.rst)
+struct UsbmonPacket {
+    uint64_t id;
+    uint8_t  type;
+    uint8_t  xferType;        // 0=ISO, 1=INTR, 2=CTRL, 3=BULK
+    uint8_t  epnum;
+    uint8_t  devnum;
+    uint16_t busnum;
+    char     flagSetup;       // 0 if setup is valid
+    char     flagData;        // 0 if data is captured
+    int64_t  tsSec;
+    int32_t  tsUsec;
+    int32_t  status;
+    uint32_t length;
+    uint32_t lenCap;
+    uint8_t  setup[8];        // For ISO: int32 error_count, int32 numdesc
+    int32_t  interval;
+    int32_t  startFrame;
+    uint32_t xferFlags;
+    uint32_t ndesc;           // ISO descriptors that follow in the captured data
+};
+
+struct PcapGlobalHeader {
+    uint32_t magic;
+    uint16_t versionMajor;
+    uint16_t versionMinor;
+    int32_t  thisZone;
+    uint32_t sigFigs;
+    uint32_t snapLen;
+    uint32_t network;
+};
+
+struct PcapRecordHeader {
+    uint32_t tsSec;
+    uint32_t tsUsec;
+    uint32_t inclLen;
+    uint32_t origLen;
+};
+
+#pragma pack(pop)
+
+static_assert(sizeof(UsbmonPacket) == 64, "UsbmonPacket must be 64 bytes");
+
+static constexpr uint32_t LINKTYPE_USB_LINUX_MMAPPED = 220;
+
+class UrbTraceRing {
+public:
+    // Capacity is rounded to a power of two. 16K records is ~1 MB and holds
+    // several seconds of a 1000 Hz HID device or a burst of storage traffic.
+    explicit UrbTraceRing(uint16_t busNumber, size_t capacity = 16384)
+        : m_BusNumber(busNumber)
+        , m_Head(0)
+        , m_ActiveWriters(0)
+        , m_Clearing(false)
+        , m_Enabled(true)
+        , m_SteadyBase(std::chrono::steady_clock::now())
+        , m_WallBase(std::chrono::system_clock::now())
+    {
+        size_t cap = 1;
+        while (cap < capacity) cap <<= 1;
+        m_Mask = cap - 1;
+        m_Slots.reset(new Slot[cap]);
+    }
+
+    UrbTraceRing(const UrbTraceRing&) = delete;
+    UrbTraceRing& operator=(const UrbTraceRing&) = delete;
+
+    void setEnabled(bool enabled) { m_Enabled.store(enabled, std::memory_order_relaxed); }
+    bool isEnabled() const { return m_Enabled.load(std::memory_order_relaxed); }
+
+    size_t capacity() const { return m_Mask + 1; }
+
+    // Total number of records ever written (including overwritten ones)
+    uint64_t totalRecords() const { return m_Head.load(std::memory_order_relaxed); }
+
+    void recordSubmit(const MlptProtocol::UsbIpHeader& hdr)
+    {
+        record(EVENT_SUBMIT, hdr, hdr.dataLen, 0);
+    }
+
+    void recordComplete(const MlptProtocol::UsbIpHeader& hdr)
+    {
+        record(EVENT_COMPLETE, hdr, hdr.dataLen, hdr.status);
+    }
+
+    void recordError(const MlptProtocol::UsbIpHeader& hdr, int32_t status)
+    {
+        record(EVENT_ERROR, hdr, 0, status);
+    }
+
+    // Safe to call concurrently from any number of threads
+    void record(EventType event, const MlptProtocol::UsbIpHeader& hdr,
+                uint32_t length, int32_t status)
+    {
+        if (!m_Enabled.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        // Writers never wait. While clear() holds the gate, the record is
+        // dropped instead (both sides are seq_cst, so either clear() sees
+        // us in m_ActiveWriters or we see m_Clearing).
+        m_ActiveWriters.fetch_add(1);
+        if (m_Clearing.load()) {
+            m_ActiveWriters.fetch_sub(1, std::memory_order_release);
+            return;
+        }
+
+        uint64_t idx = m_Head.fetch_add(1, std::memory_order_relaxed);
+        Slot& slot = m_Slots[idx & m_Mask];
+
+        // Seqlock: odd = write in progress, even = holds record (seq / 2 - 1)
+        slot.seq.store(idx * 2 + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        Record& r = slot.rec;
+        r.timestampUs = nowUs();
+        r.seqNum = hdr.seqNum;
+        r.deviceId = hdr.deviceId;
+        r.length = length;
+        r.status = status;
+        r.startFrame = hdr.startFrame;
+        r.numIsoPackets = hdr.numIsoPackets;
+        r.event = event;
+        r.direction = hdr.direction;
+        r.endpoint = hdr.endpoint & 0x7F;
+        r.transferType = hdr.transferType;
+        r.hasSetup = (hdr.transferType == MlptProtocol::USB_XFER_CONTROL && event == EVENT_SUBMIT) ? 1 : 0;
+        memcpy(r.setupPacket, hdr.setupPacket, sizeof(r.setupPacket));
+
+        slot.seq.store(idx * 2 + 2, std::memory_order_release);
+
+        m_ActiveWriters.fetch_sub(1, std::memory_order_release);
+    }
+
+    // Copy out all consistent records, oldest first. Records that are being
+    // overwritten while we read are skipped rather than waited for.
+    std::vector<Record> snapshot() const
+    {
+        std::lock_guard<std::mutex> lock(m_ControlLock);
+        return snapshotLocked();
+    }
+
+    // Drops all records and restarts the clock. Concurrent writers are
+    // shut out until the reset is complete rather than racing with it.
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(m_ControlLock);
+
+        m_Clearing.store(true);
+        while (m_ActiveWriters.load(std::memory_order_acquire) != 0) {
+            std::this_thread::yield();
+        }
+
+        // Invalidate every slot so snapshot() ignores stale entries
+        for (size_t i = 0; i <= m_Mask; i++) {
+            m_Slots[i].seq.store(0, std::memory_order_relaxed);
+        }
+        m_Head.store(0, std::memory_order_relaxed);
+        m_SteadyBase = std::chrono::steady_clock::now();
+        m_WallBase = std::chrono::system_clock::now();
+
+        m_Clearing.store(false);
+    }
+
+    // Match submits to completions and aggregate per device endpoint
+    std::vector<EndpointStats> aggregate() const
+    {
+        std::vector<Record> records = snapshot();
+
+        // Key: deviceId << 8 | endpoint address
+        std::map<uint64_t, EndpointStats> stats;
+        // Key: deviceId << 32 | seqNum -> (submit timestamp, endpoint key)
+        std::unordered_map<uint64_t, std::pair<uint64_t, uint64_t>> pendingSubmits;
+        // Matched latencies per endpoint key, for percentiles
+        std::unordered_map<uint64_t, std::vector<uint64_t>> latencies;
+
+        for (const Record& r : records) {
+            uint8_t epAddr = r.endpoint | (r.direction == MlptProtocol::USB_DIR_IN ? 0x80 : 0x00);
+            uint64_t epKey = (static_cast<uint64_t>(r.deviceId) << 8) | epAddr;
+            uint64_t urbKey = (static_cast<uint64_t>(r.deviceId) << 32) | r.seqNum;
+
+            EndpointStats& s = stats[epKey];
+            s.deviceId = r.deviceId;
+            s.endpointAddress = epAddr;
+            s.transferType = r.transferType;
+            if (s.firstUs == 0 || r.timestampUs < s.firstUs) {
+                s.firstUs = r.timestampUs;
+            }
+            if (r.timestampUs > s.lastUs) {
+                s.lastUs = r.timestampUs;
+            }
+
+            switch (r.event) {
+            case EVENT_SUBMIT:
+                pendingSubmits[urbKey] = { r.timestampUs, epKey };
+                break;
+
+            case EVENT_COMPLETE: {
+                if (r.status != 0) {
+                    s.errors++;
+                }
+                s.completed++;
+                s.bytes += r.length;
+
+                auto it = pendingSubmits.find(urbKey);
+                if (it != pendingSubmits.end()) {
+                    uint64_t latency = r.timestampUs - it->second.first;
+                    s.totalLatencyUs += latency;
+                    if (latency < s.minLatencyUs) s.minLatencyUs = latency;
+                    if (latency > s.maxLatencyUs) s.maxLatencyUs = latency;
+                    latencies[epKey].push_back(latency);
+                    pendingSubmits.erase(it);
+                }
+                break;
+            }
+
+            case EVENT_ERROR:
+                s.errors++;
+                pendingSubmits.erase(urbKey);
+                break;
+            }
+        }
+
+        for (const auto& pending : pendingSubmits) {
+            stats[pending.second.second].inFlight++;
+        }
+
+        std::vector<EndpointStats> out;
+        out.reserve(stats.size());
+        for (auto& entry : stats) {
+            if (entry.second.completed == 0) {
+                entry.second.minLatencyUs = 0;
+            }
+
+            auto it = latencies.find(entry.first);
+            if (it != latencies.end()) {
+                std::vector<uint64_t>& v = it->second;
+                std::nth_element(v.begin(), v.begin() + v.size() / 2, v.end());
+                entry.second.p50LatencyUs = v[v.size() / 2];
+                std::nth_element(v.begin(), v.begin() + (v.size() * 99) / 100, v.end());
+                entry.second.p99LatencyUs = v[(v.size() * 99) / 100];
+            }
+            out.push_back(entry.second);
+        }
+        return out;
+    }
+
+    // Write the ring contents as a usbmon pcap file. Payloads are not
+    // captured, so each packet carries the header only (lenCap = 0). That
+    // includes ISO descriptors: the packet count is reported in the header's
+    // ISO fields, but ndesc is 0 since no descriptors follow.
+    bool writePcap(const char* path) const
+    {
+        std::lock_guard<std::mutex> lock(m_ControlLock);
+
+        FILE* f = fopen(path, "wb");
+        if (!f) {
+            return false;
+        }
+
+        PcapGlobalHeader gh{};
+        gh.magic = 0xa1b2c3d4;
+        gh.versionMajor = 2;
+        gh.versionMinor = 4;
+        gh.snapLen = 65535;
+        gh.network = LINKTYPE_USB_LINUX_MMAPPED;
+        bool ok = fwrite(&gh, sizeof(gh), 1, f) == 1;
+
+        int64_t wallBaseUs = std::chrono::duration_cast<std::chrono::microseconds>(
+            m_WallBase.time_since_epoch()).count();
+
+        for (const Record& r : snapshotLocked()) {
+            if (!ok) break;
+
+            int64_t tsUs = wallBaseUs + static_cast<int64_t>(r.timestampUs);
+
+            UsbmonPacket pkt;
+            memset(&pkt, 0, sizeof(pkt));
+            pkt.id = (static_cast<uint64_t>(r.deviceId) << 32) | r.seqNum;
+            pkt.type = r.event;
+            pkt.xferType = toUsbmonXferType(r.transferType);
+            pkt.epnum = r.endpoint | (r.direction == MlptProtocol::USB_DIR_IN ? 0x80 : 0x00);
+            pkt.devnum = static_cast<uint8_t>(r.deviceId & 0x7F);
+            pkt.busnum = m_BusNumber;
+            pkt.flagSetup = r.hasSetup ? 0 : '-';
+            pkt.flagData = r.direction == MlptProtocol::USB_DIR_IN ? '<' : '>';
+            pkt.tsSec = tsUs / 1000000;
+            pkt.tsUsec = static_cast<int32_t>(tsUs % 1000000);
+            pkt.status = r.status;
+            pkt.length = r.length;
+            pkt.lenCap = 0;
+            if (r.hasSetup) {
+                memcpy(pkt.setup, r.setupPacket, sizeof(pkt.setup));
+            }
+            else if (r.transferType == MlptProtocol::USB_XFER_ISOCHRONOUS) {
+                int32_t iso[2] = { 0, static_cast<int32_t>(r.numIsoPackets) };
+                memcpy(pkt.setup, iso, sizeof(pkt.setup));
+            }
+            pkt.startFrame = static_cast<int32_t>(r.startFrame);
+            pkt.ndesc = 0;
+
+            PcapRecordHeader rh;
+            rh.tsSec = static_cast<uint32_t>(pkt.tsSec);
+            rh.tsUsec = static_cast<uint32_t>(pkt.tsUsec);
+            rh.inclLen = sizeof(pkt);
+            rh.origLen = sizeof(pkt) + r.length;
+
+            ok = fwrite(&rh, sizeof(rh), 1, f) == 1 &&
+                 fwrite(&pkt, sizeof(pkt), 1, f) == 1;
+        }
+
+        ok = (fclose(f) == 0) && ok;
+        return ok;
+    }
+
+    static const char* transferTypeName(uint8_t transferType)
+    {
+        switch (transferType) {
+        case MlptProtocol::USB_XFER_CONTROL:     return "CTRL";
+        case MlptProtocol::USB_XFER_ISOCHRONOUS: return "ISO";
+        case MlptProtocol::USB_XFER_BULK:        return "BULK";
+        case MlptProtocol::USB_XFER_INTERRUPT:   return "INTR";
+        default:                                 return "?";
+        }
+    }
+
+private:
+    // Must hold m_ControlLock
+    std::vector<Record> snapshotLocked() const
+    {
+        std::vector<Record> out;
+        uint64_t head = m_Head.load(std::memory_order_acquire);
+        uint64_t start = head > capacity() ? head - capacity() : 0;
+        out.reserve(static_cast<size_t>(head - start));
+
+        for (uint64_t idx = start; idx < head; idx++) {
+            const Slot& slot = m_Slots[idx & m_Mask];
+            uint64_t before = slot.seq.load(std::memory_order_acquire);
+            if (before != idx * 2 + 2) {
+                continue;
+            }
+            Record copy = slot.rec;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) != before) {
+                continue;
+            }
+            out.push_back(copy);
+        }
+
+        return out;
+    }
+
+    struct Slot {
+        std::atomic<uint64_t> seq{0};
+        Record rec;
+    };
+
+    // usbmon uses a different numbering than the USB spec bmAttributes
+    static uint8_t toUsbmonXferType(uint8_t transferType)
+    {
+        switch (transferType) {
+        case MlptProtocol::USB_XFER_ISOCHRONOUS: return 0;
+        case MlptProtocol::USB_XFER_INTERRUPT:   return 1;
+        case MlptProtocol::USB_XFER_CONTROL:     return 2;
+        default:                                 return 3;
+        }
+    }
+
+    uint64_t nowUs() const
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - m_SteadyBase).count());
+    }
+
+    uint16_t m_BusNumber;
+    size_t m_Mask;
+    std::unique_ptr<Slot[]> m_Slots;
+    std::atomic<uint64_t> m_Head;
+    std::atomic<uint32_t> m_ActiveWriters;
+    std::atomic<bool> m_Clearing;
+    std::atomic<bool> m_Enabled;
+    mutable std::mutex m_ControlLock;
+    std::chrono::steady_clock::time_point m_SteadyBase;
+    std::chrono::system_clock::time_point m_WallBase;
+};
+
+} // namespace MlptTrace
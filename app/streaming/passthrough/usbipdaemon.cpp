@@ -1,5 +1,6 @@
 // UsbIpDaemon — USB/IP server implementation for client-side device export
-// Handles connections from usbip-win2 VHCI driver and forwards URBs via libusb
+// Handles connections from the usbip-win2 VHCI driver or a Linux usbip
+// client and forwards URBs via libusb
 
 #include "usbipdaemon.h"
 #include "usbipexporter.h"
@@ -72,20 +73,22 @@ UsbIpDaemon::~UsbIpDaemon()
 // Start / Stop
 // ============================================================================
 
-bool UsbIpDaemon::start(uint16_t port)
+bool UsbIpDaemon::start(uint16_t port, const QHostAddress& address)
 {
     if (m_Server.isListening()) {
         return true;
     }
 
-    // Listen on all interfaces so the server's VHCI driver can connect
-    if (!m_Server.listen(QHostAddress::Any, port)) {
-        qWarning("[UsbIpDaemon] Failed to listen on port %u: %s",
-                 port, qPrintable(m_Server.errorString()));
+    // Anyone who can reach this port can drive the exported devices, so
+    // only listen where the VHCI driver is expected to connect from
+    if (!m_Server.listen(address, port)) {
+        qWarning("[UsbIpDaemon] Failed to listen on %s:%u: %s",
+                 qPrintable(address.toString()), port, qPrintable(m_Server.errorString()));
         return false;
     }
 
-    qInfo("[UsbIpDaemon] Listening on port %u", m_Server.serverPort());
+    qInfo("[UsbIpDaemon] Listening on %s:%u",
+          qPrintable(address.toString()), m_Server.serverPort());
     return true;
 }
 
@@ -153,6 +156,14 @@ void UsbIpDaemon::unexportDevice(const QString& busid)
 void UsbIpDaemon::onNewConnection()
 {
     while (QTcpSocket* socket = m_Server.nextPendingConnection()) {
+        if (!m_AllowedPeer.isNull() && !socket->peerAddress().isEqual(m_AllowedPeer)) {
+            qWarning("[UsbIpDaemon] Rejected connection from %s:%u",
+                     qPrintable(socket->peerAddress().toString()), socket->peerPort());
+            socket->abort();
+            socket->deleteLater();
+            continue;
+        }
+
         qInfo("[UsbIpDaemon] New connection from %s:%u",
               qPrintable(socket->peerAddress().toString()), socket->peerPort());
 
@@ -178,8 +189,8 @@ void UsbIpDaemon::onSessionReadyRead()
     session->recvBuffer.append(socket->readAll());
 
     if (!session->importDone) {
-        // Waiting for OP_REQ_IMPORT
-        handleImportRequest(session);
+        // Waiting for OP_REQ_DEVLIST or OP_REQ_IMPORT
+        handleOpRequest(session);
     } else {
         // URB exchange phase
         handleUrbData(session);
@@ -202,7 +213,12 @@ void UsbIpDaemon::onSessionDisconnected()
         disconnect(session->exporter, nullptr, this, nullptr);
     }
 
-    m_DeviceSessions.remove(session->deviceId);
+    // Only drop the routing entry if it belongs to this session; a rejected
+    // (busy) import must not tear down the active one
+    auto deviceSessionIt = m_DeviceSessions.find(session->deviceId);
+    if (deviceSessionIt != m_DeviceSessions.end() && deviceSessionIt.value() == session) {
+        m_DeviceSessions.erase(deviceSessionIt);
+    }
     m_Sessions.erase(sessionIt);
 
     if (session->deviceId != 0) {
@@ -214,86 +230,48 @@ void UsbIpDaemon::onSessionDisconnected()
 }
 
 // ============================================================================
-// OP_REQ_IMPORT handling
+// Operation requests (OP_REQ_DEVLIST / OP_REQ_IMPORT)
 // ============================================================================
 
-bool UsbIpDaemon::handleImportRequest(DaemonDeviceSession* session)
+bool UsbIpDaemon::handleOpRequest(DaemonDeviceSession* session)
 {
-    constexpr int importReqSize = sizeof(UsbIpOpCommon) + sizeof(UsbIpOpImportRequest);
-
-    if (session->recvBuffer.size() < importReqSize) {
+    if (session->recvBuffer.size() < static_cast<int>(sizeof(UsbIpOpCommon))) {
         return false;  // Not enough data yet
     }
 
-    // Parse the import request
     UsbIpOpCommon opCommon;
     memcpy(&opCommon, session->recvBuffer.constData(), sizeof(opCommon));
-    opCommon.version = fromBE16(opCommon.version);
     opCommon.code = fromBE16(opCommon.code);
-    opCommon.status = fromBE32(opCommon.status);
-
-    if (opCommon.code != OP_REQ_IMPORT) {
-        qWarning("[UsbIpDaemon] Expected OP_REQ_IMPORT (0x%04X), got 0x%04X",
-                 OP_REQ_IMPORT, opCommon.code);
-        session->socket->close();
-        return false;
-    }
-
-    UsbIpOpImportRequest importReq;
-    memcpy(&importReq, session->recvBuffer.constData() + sizeof(UsbIpOpCommon), sizeof(importReq));
-    session->recvBuffer.remove(0, importReqSize);
-
-    QString busid = QString::fromUtf8(importReq.busid,
-        static_cast<int>(strnlen(importReq.busid, sizeof(importReq.busid))));
-
-    qInfo("[UsbIpDaemon] OP_REQ_IMPORT for busid '%s'", qPrintable(busid));
-
-    // Look up the exported device
-    UsbIpExporter* exporter = nullptr;
-    uint32_t deviceId = 0;
-    {
-        QMutexLocker lock(&m_ExportMutex);
-        auto it = m_Exports.find(busid);
-        if (it != m_Exports.end()) {
-            exporter = it->exporter;
-            deviceId = it->deviceId;
-        }
-    }
 
-    // Build OP_REP_IMPORT reply
-    QByteArray reply;
-    reply.resize(sizeof(UsbIpOpCommon) + sizeof(UsbIpUsbDevice));
-    memset(reply.data(), 0, reply.size());
+    switch (opCommon.code) {
+    case OP_REQ_DEVLIST:
+        session->recvBuffer.remove(0, sizeof(UsbIpOpCommon));
+        handleDevlistRequest(session);
+        return true;
 
-    auto* repCommon = reinterpret_cast<UsbIpOpCommon*>(reply.data());
-    repCommon->version = bswap16(USBIP_VERSION);
-    repCommon->code = bswap16(OP_REP_IMPORT);
+    case OP_REQ_IMPORT:
+        return handleImportRequest(session);
 
-    if (!exporter || !exporter->isOpen()) {
-        // Device not found or not open
-        repCommon->status = bswap32(1);  // ST_NA
-        session->socket->write(reply.constData(), sizeof(UsbIpOpCommon));
-        qWarning("[UsbIpDaemon] Device not found for busid '%s'", qPrintable(busid));
+    default:
+        qWarning("[UsbIpDaemon] Unexpected operation 0x%04X", opCommon.code);
         session->socket->close();
         return false;
     }
+}
 
-    // Fill device info from the exporter's USB descriptors
-    repCommon->status = bswap32(0);  // ST_OK
-
-    auto* udev = reinterpret_cast<UsbIpUsbDevice*>(reply.data() + sizeof(UsbIpOpCommon));
+void UsbIpDaemon::fillUsbDevice(UsbIpUsbDevice* udev, const QString& busid,
+                                uint32_t deviceId, const UsbIpExporter* exporter)
+{
     memset(udev, 0, sizeof(UsbIpUsbDevice));
 
     // path and busid
     QByteArray busidUtf8 = busid.toUtf8();
     strncpy(udev->busid, busidUtf8.constData(), sizeof(udev->busid) - 1);
-    strncpy(udev->path, "/virtual/0", sizeof(udev->path) - 1);
+    snprintf(udev->path, sizeof(udev->path), "/virtual/moonlight/%u", deviceId);
 
     // Generate devid from deviceId: busnum=0, devnum=deviceId
-    uint32_t busnum = 0;
-    uint32_t devnum = deviceId & 0xFFFF;
-    udev->busnum = bswap32(busnum);
-    udev->devnum = bswap32(devnum);
+    udev->busnum = bswap32(0);
+    udev->devnum = bswap32(deviceId & 0xFFFF);
 
     // Extract info from the device descriptor
     QByteArray devDesc = exporter->deviceDescriptor();
@@ -325,6 +303,121 @@ bool UsbIpDaemon::handleImportRequest(DaemonDeviceSession* session)
         udev->bConfigurationValue = c[5];
         udev->bNumInterfaces = c[4];
     }
+}
+
+void UsbIpDaemon::handleDevlistRequest(DaemonDeviceSession* session)
+{
+    QByteArray reply(sizeof(UsbIpOpCommon) + sizeof(UsbIpOpDevlistReply), 0);
+    uint32_t ndev = 0;
+
+    {
+        QMutexLocker lock(&m_ExportMutex);
+        for (auto it = m_Exports.constBegin(); it != m_Exports.constEnd(); ++it) {
+            if (!it->exporter || !it->exporter->isOpen()) {
+                continue;
+            }
+
+            QByteArray entry(sizeof(UsbIpUsbDevice), 0);
+            fillUsbDevice(reinterpret_cast<UsbIpUsbDevice*>(entry.data()),
+                          it.key(), it->deviceId, it->exporter);
+
+            // One usbip_usb_interface per interface (alternate setting 0),
+            // bNumInterfaces of them as announced in the device entry
+            uint8_t numInterfaces = reinterpret_cast<const UsbIpUsbDevice*>(entry.constData())->bNumInterfaces;
+            QByteArray confDesc = it->exporter->configDescriptor();
+            auto* c = reinterpret_cast<const uint8_t*>(confDesc.constData());
+            int found = 0;
+            for (int off = 0; off + 2 <= confDesc.size() && found < numInterfaces; off += c[off]) {
+                if (c[off] == 0) break;
+                if (c[off + 1] == 0x04 && off + 9 <= confDesc.size() && c[off + 3] == 0) {
+                    UsbIpUsbInterface uinf = { c[off + 5], c[off + 6], c[off + 7], 0 };
+                    entry.append(reinterpret_cast<const char*>(&uinf), sizeof(uinf));
+                    found++;
+                }
+            }
+            for (; found < numInterfaces; found++) {
+                UsbIpUsbInterface uinf = {};
+                entry.append(reinterpret_cast<const char*>(&uinf), sizeof(uinf));
+            }
+
+            reply.append(entry);
+            ndev++;
+        }
+    }
+
+    auto* repCommon = reinterpret_cast<UsbIpOpCommon*>(reply.data());
+    repCommon->version = bswap16(USBIP_VERSION);
+    repCommon->code = bswap16(OP_REP_DEVLIST);
+    repCommon->status = bswap32(USBIP_ST_OK);
+    reinterpret_cast<UsbIpOpDevlistReply*>(reply.data() + sizeof(UsbIpOpCommon))->ndev = bswap32(ndev);
+
+    qInfo("[UsbIpDaemon] OP_REQ_DEVLIST: reporting %u device(s)", ndev);
+
+    // The devlist exchange is one-shot; the peer reconnects to import
+    session->socket->write(reply);
+    session->socket->disconnectFromHost();
+}
+
+bool UsbIpDaemon::handleImportRequest(DaemonDeviceSession* session)
+{
+    constexpr int importReqSize = sizeof(UsbIpOpCommon) + sizeof(UsbIpOpImportRequest);
+
+    if (session->recvBuffer.size() < importReqSize) {
+        return false;  // Not enough data yet
+    }
+
+    UsbIpOpImportRequest importReq;
+    memcpy(&importReq, session->recvBuffer.constData() + sizeof(UsbIpOpCommon), sizeof(importReq));
+    session->recvBuffer.remove(0, importReqSize);
+
+    QString busid = QString::fromUtf8(importReq.busid,
+        static_cast<int>(strnlen(importReq.busid, sizeof(importReq.busid))));
+
+    qInfo("[UsbIpDaemon] OP_REQ_IMPORT for busid '%s'", qPrintable(busid));
+
+    // Look up the exported device
+    UsbIpExporter* exporter = nullptr;
+    uint32_t deviceId = 0;
+    {
+        QMutexLocker lock(&m_ExportMutex);
+        auto it = m_Exports.find(busid);
+        if (it != m_Exports.end()) {
+            exporter = it->exporter;
+            deviceId = it->deviceId;
+        }
+    }
+
+    // Build OP_REP_IMPORT reply
+    QByteArray reply;
+    reply.resize(sizeof(UsbIpOpCommon) + sizeof(UsbIpUsbDevice));
+    memset(reply.data(), 0, reply.size());
+
+    auto* repCommon = reinterpret_cast<UsbIpOpCommon*>(reply.data());
+    repCommon->version = bswap16(USBIP_VERSION);
+    repCommon->code = bswap16(OP_REP_IMPORT);
+
+    if (!exporter || !exporter->isOpen()) {
+        // Device not found or not open
+        repCommon->status = bswap32(USBIP_ST_NA);
+        session->socket->write(reply.constData(), sizeof(UsbIpOpCommon));
+        qWarning("[UsbIpDaemon] Device not found for busid '%s'", qPrintable(busid));
+        session->socket->disconnectFromHost();
+        return false;
+    }
+
+    if (m_DeviceSessions.contains(deviceId)) {
+        // A second importer would steal URB completions from the first
+        repCommon->status = bswap32(USBIP_ST_DEV_BUSY);
+        session->socket->write(reply.constData(), sizeof(UsbIpOpCommon));
+        qWarning("[UsbIpDaemon] Device for busid '%s' is already imported", qPrintable(busid));
+        session->socket->disconnectFromHost();
+        return false;
+    }
+
+    // Fill device info from the exporter's USB descriptors
+    repCommon->status = bswap32(USBIP_ST_OK);
+    fillUsbDevice(reinterpret_cast<UsbIpUsbDevice*>(reply.data() + sizeof(UsbIpOpCommon)),
+                  busid, deviceId, exporter);
 
     session->socket->write(reply);
 
@@ -332,7 +425,9 @@ bool UsbIpDaemon::handleImportRequest(DaemonDeviceSession* session)
     session->busid = busid;
     session->deviceId = deviceId;
     session->exporter = exporter;
-    session->devid = (busnum << 16) | devnum;
+    session->devid = deviceId & 0xFFFF;  // busnum (0) << 16 | devnum
+    parseEndpoints(exporter->configDescriptor(), session->altSettings,
+                   session->endpointTypes, session->endpointMaxPacketBytes);
     session->importDone = true;
 
     m_DeviceSessions[deviceId] = session;
@@ -341,8 +436,8 @@ bool UsbIpDaemon::handleImportRequest(DaemonDeviceSession* session)
     connect(exporter, &UsbIpExporter::urbCompleted,
             this, &UsbIpDaemon::onUrbCompleted);
 
-    qInfo("[UsbIpDaemon] Device %u (busid '%s') imported successfully",
-          deviceId, qPrintable(busid));
+    qInfo("[UsbIpDaemon] Device %u (busid '%s') imported successfully, %d endpoints mapped",
+          deviceId, qPrintable(busid), static_cast<int>(session->endpointTypes.size()));
     emit deviceImported(busid, deviceId);
 
     // Process any remaining data in the buffer (could be URBs already)
@@ -368,6 +463,13 @@ void UsbIpDaemon::handleUrbData(DaemonDeviceSession* session)
         int totalSize = sizeof(UsbIpWireHeader);
 
         if (hdr.command == USBIP_CMD_SUBMIT) {
+            // The lengths below size our receive buffer, so reject anything
+            // the endpoint could never transfer before waiting for it
+            if (!validateCmdSubmit(session, hdr, nullptr)) {
+                dropSession(session, "invalid CMD_SUBMIT header");
+                return;
+            }
+
             // For OUT transfers, data follows the header
             bool isOut = (hdr.direction == 0);
             int32_t bufLen = hdr.u.cmd_submit.transfer_buffer_length;
@@ -396,6 +498,11 @@ void UsbIpDaemon::handleUrbData(DaemonDeviceSession* session)
         }
         session->recvBuffer.remove(0, totalSize);
 
+        if (hdr.command == USBIP_CMD_SUBMIT && !validateCmdSubmit(session, hdr, &trailingData)) {
+            dropSession(session, "invalid ISO packet descriptors");
+            return;
+        }
+
         // Process
         if (hdr.command == USBIP_CMD_SUBMIT) {
             processCmdSubmit(session, hdr, trailingData);
@@ -420,43 +527,81 @@ void UsbIpDaemon::processCmdSubmit(DaemonDeviceSession* session,
     mlptHdr.direction = static_cast<uint8_t>(hdr.direction);
     mlptHdr.endpoint = static_cast<uint8_t>(hdr.ep);
 
-    // Determine transfer type from endpoint
-    if (hdr.ep == 0) {
-        mlptHdr.transferType = MlptProtocol::USB_XFER_CONTROL;
-    } else {
-        // Use the exporter's endpoint type knowledge
-        // For now, use heuristic based on the submit fields
-        if (hdr.u.cmd_submit.number_of_packets > 0) {
-            mlptHdr.transferType = MlptProtocol::USB_XFER_ISOCHRONOUS;
-        } else if (hdr.u.cmd_submit.interval > 0) {
-            mlptHdr.transferType = MlptProtocol::USB_XFER_INTERRUPT;
-        } else {
-            mlptHdr.transferType = MlptProtocol::USB_XFER_BULK;
+    mlptHdr.dataLen = static_cast<uint32_t>(
+        hdr.u.cmd_submit.transfer_buffer_length > 0 ?
+        hdr.u.cmd_submit.transfer_buffer_length : 0);
+    mlptHdr.status = 0;
+
+    mlptHdr.transferType = transferTypeFor(session, hdr);
+    uint8_t epAddr = static_cast<uint8_t>(hdr.ep) | (hdr.direction ? 0x80 : 0x00);
+    if (hdr.ep != 0 && !session->endpointTypes.contains(epAddr)) {
+        qWarning("[UsbIpDaemon] URB for unknown endpoint 0x%02X on device %u",
+                 epAddr, session->deviceId);
+        // Remember the guess so the warning is logged once per endpoint
+        session->endpointTypes.insert(epAddr, mlptHdr.transferType);
+    }
+
+    QByteArray payload = data;
+
+    switch (mlptHdr.transferType) {
+    case MlptProtocol::USB_XFER_CONTROL: {
+        // Control URBs always carry a setup packet
+        mlptHdr.flags = 1;
+        memcpy(mlptHdr.setupPacket, hdr.u.cmd_submit.setup, 8);
+
+        const uint8_t* setup = mlptHdr.setupPacket;
+        if (setup[0] == 0x01 && setup[1] == 0x0B) {
+            // SET_INTERFACE: switch the endpoint table once the device accepts it
+            session->pendingSetInterface.insert(hdr.seqnum,
+                static_cast<uint16_t>((setup[4] << 8) | setup[2]));
+        } else if (setup[0] == 0x00 && setup[1] == 0x09) {
+            // SET_CONFIGURATION resets every interface to alternate setting 0
+            session->pendingSetInterface.insert(hdr.seqnum, 0xFFFF);
         }
+        break;
     }
 
-    // Check if setup packet is present
-    bool hasSetup = false;
-    for (int i = 0; i < 8; i++) {
-        if (hdr.u.cmd_submit.setup[i] != 0) {
-            hasSetup = true;
-            break;
+    case MlptProtocol::USB_XFER_BULK:
+    case MlptProtocol::USB_XFER_INTERRUPT:
+        break;
+
+    case MlptProtocol::USB_XFER_ISOCHRONOUS: {
+        if (hdr.u.cmd_submit.number_of_packets <= 0) {
+            // Can't schedule an ISO transfer without packets; fail it here
+            // instead of letting the device time it out
+            mlptHdr.status = -22; // EINVAL
+            mlptHdr.dataLen = 0;
+            sendRetSubmit(session, mlptHdr, QByteArray());
+            return;
+        }
+
+        mlptHdr.startFrame = static_cast<uint32_t>(hdr.u.cmd_submit.start_frame);
+        mlptHdr.numIsoPackets = static_cast<uint32_t>(hdr.u.cmd_submit.number_of_packets);
+
+        // ISO packet descriptors follow the OUT data on the wire (big-endian);
+        // MLPT carries them in host order after the data as well
+        int descOffset = (hdr.direction == 0) ? static_cast<int>(mlptHdr.dataLen) : 0;
+        payload = data.left(descOffset);
+
+        for (uint32_t i = 0; i < mlptHdr.numIsoPackets; i++) {
+            UsbIpWireIsoPacket wire;
+            memcpy(&wire, data.constData() + descOffset + i * sizeof(wire), sizeof(wire));
+
+            MlptProtocol::UsbIpIsoPacket iso;
+            iso.offset = fromBE32(wire.offset);
+            iso.length = fromBE32(wire.length);
+            iso.actualLength = 0;
+            iso.status = 0;
+            payload.append(reinterpret_cast<const char*>(&iso), sizeof(iso));
         }
+        break;
+    }
     }
-    mlptHdr.flags = hasSetup ? 1 : 0;
 
-    mlptHdr.dataLen = static_cast<uint32_t>(
-        hdr.u.cmd_submit.transfer_buffer_length > 0 ?
-        hdr.u.cmd_submit.transfer_buffer_length : 0);
-    mlptHdr.status = 0;
-    mlptHdr.startFrame = static_cast<uint32_t>(hdr.u.cmd_submit.start_frame);
-    mlptHdr.numIsoPackets = static_cast<uint32_t>(
-        hdr.u.cmd_submit.number_of_packets > 0 ?
-        hdr.u.cmd_submit.number_of_packets : 0);
-    memcpy(mlptHdr.setupPacket, hdr.u.cmd_submit.setup, 8);
+    session->inFlight.insert(hdr.seqnum);
 
     // Submit the URB via the exporter (libusb)
-    session->exporter->submitUrb(mlptHdr, data);
+    session->exporter->submitUrb(mlptHdr, payload);
 }
 
 void UsbIpDaemon::processCmdUnlink(DaemonDeviceSession* session,
@@ -465,10 +610,150 @@ void UsbIpDaemon::processCmdUnlink(DaemonDeviceSession* session,
     if (!session->exporter) return;
 
     uint32_t unlinkSeqnum = hdr.u.cmd_unlink.seqnum;
+
+    if (!session->inFlight.contains(unlinkSeqnum)) {
+        // Already completed (RET_SUBMIT is on the wire): nothing to unlink
+        sendRetUnlink(session, hdr.seqnum, 0);
+        return;
+    }
+
+    // RET_UNLINK is sent once the cancellation completes, in place of
+    // the RET_SUBMIT for the unlinked URB
+    session->pendingUnlinks.insert(unlinkSeqnum, hdr.seqnum);
     session->exporter->unlinkUrb(unlinkSeqnum);
+}
+
+// ============================================================================
+// Endpoint table
+// ============================================================================
 
-    // Send RET_UNLINK immediately
-    sendRetUnlink(session, hdr.seqnum, 0);
+uint8_t UsbIpDaemon::transferTypeFor(const DaemonDeviceSession* session, const UsbIpWireHeader& hdr)
+{
+    // Transfer type comes from the endpoint table for the active alternate
+    // settings; the submit fields are only a fallback for unknown endpoints
+    if (hdr.ep == 0) {
+        return MlptProtocol::USB_XFER_CONTROL;
+    }
+
+    uint8_t epAddr = static_cast<uint8_t>(hdr.ep) | (hdr.direction ? 0x80 : 0x00);
+    auto epIt = session->endpointTypes.find(epAddr);
+    if (epIt != session->endpointTypes.end()) {
+        return epIt.value();
+    } else if (hdr.u.cmd_submit.number_of_packets > 0) {
+        return MlptProtocol::USB_XFER_ISOCHRONOUS;
+    } else if (hdr.u.cmd_submit.interval > 0) {
+        return MlptProtocol::USB_XFER_INTERRUPT;
+    } else {
+        return MlptProtocol::USB_XFER_BULK;
+    }
+}
+
+void UsbIpDaemon::parseEndpoints(const QByteArray& configDescriptor,
+                                 const QHash<uint8_t, uint8_t>& altSettings,
+                                 QHash<uint8_t, uint8_t>& types,
+                                 QHash<uint8_t, uint32_t>& maxPacketBytes)
+{
+    types.clear();
+    maxPacketBytes.clear();
+
+    auto* desc = reinterpret_cast<const uint8_t*>(configDescriptor.constData());
+    int len = configDescriptor.size();
+
+    // Endpoints belong to the interface descriptor preceding them; only
+    // those of each interface's active alternate setting are mapped
+    bool activeAlt = false;
+    int lastEndpoint = -1;
+    int offset = 0;
+    while (offset + 2 <= len) {
+        uint8_t bLength = desc[offset];
+        uint8_t bDescriptorType = desc[offset + 1];
+
+        if (bLength < 2 || offset + bLength > len) break;
+
+        if (bDescriptorType == 0x04 && bLength >= 9) {
+            // Interface descriptor: bInterfaceNumber at 2, bAlternateSetting at 3
+            activeAlt = desc[offset + 3] == altSettings.value(desc[offset + 2], 0);
+            lastEndpoint = -1;
+        } else if (bDescriptorType == 0x05 && bLength >= 7 && activeAlt) {
+            // Endpoint descriptor: bEndpointAddress at 2, bmAttributes at 3,
+            // wMaxPacketSize at 4 (bits 12:11 are extra high-speed transactions)
+            uint16_t wMaxPacketSize = static_cast<uint16_t>(desc[offset + 4] | (desc[offset + 5] << 8));
+            lastEndpoint = desc[offset + 2];
+            types.insert(desc[offset + 2], desc[offset + 3] & 0x03);
+            maxPacketBytes.insert(desc[offset + 2],
+                                  (wMaxPacketSize & 0x7FF) * (1 + ((wMaxPacketSize >> 11) & 0x03)));
+        } else if (bDescriptorType == 0x30 && bLength >= 6 && lastEndpoint >= 0) {
+            // SuperSpeed endpoint companion: wBytesPerInterval at 4
+            uint16_t wBytesPerInterval = static_cast<uint16_t>(desc[offset + 4] | (desc[offset + 5] << 8));
+            if (wBytesPerInterval != 0) {
+                maxPacketBytes.insert(static_cast<uint8_t>(lastEndpoint), wBytesPerInterval);
+            }
+        }
+
+        offset += bLength;
+    }
+}
+
+// ============================================================================
+// Input validation
+// ============================================================================
+
+bool UsbIpDaemon::validateCmdSubmit(DaemonDeviceSession* session,
+                                    const UsbIpWireHeader& hdr,
+                                    const QByteArray* data)
+{
+    int32_t bufLen = hdr.u.cmd_submit.transfer_buffer_length;
+    int32_t numPackets = hdr.u.cmd_submit.number_of_packets;
+
+    // Linux sends -1 (0xffffffff) packets for non-ISO URBs
+    if (bufLen < 0 || bufLen > USBIP_MAX_TRANSFER_LENGTH ||
+            numPackets < -1 || numPackets > USBIP_MAX_ISO_PACKETS) {
+        qWarning("[UsbIpDaemon] CMD_SUBMIT seqnum %u: bad length %d or packet count %d",
+                 hdr.seqnum, bufLen, numPackets);
+        return false;
+    }
+
+    if (transferTypeFor(session, hdr) != MlptProtocol::USB_XFER_ISOCHRONOUS || numPackets <= 0) {
+        return true;
+    }
+
+    uint8_t epAddr = static_cast<uint8_t>(hdr.ep) | (hdr.direction ? 0x80 : 0x00);
+    uint32_t maxPacket = session->endpointMaxPacketBytes.value(epAddr, USBIP_MAX_ISO_PACKET_BYTES);
+    if (static_cast<uint64_t>(bufLen) > static_cast<uint64_t>(maxPacket) * numPackets) {
+        qWarning("[UsbIpDaemon] CMD_SUBMIT seqnum %u: %d bytes exceeds %d packets of %u bytes",
+                 hdr.seqnum, bufLen, numPackets, maxPacket);
+        return false;
+    }
+
+    if (data == nullptr) {
+        return true;
+    }
+
+    // Each packet must lie inside the transfer buffer and fit the endpoint
+    int descOffset = (hdr.direction == 0) ? bufLen : 0;
+    for (int32_t i = 0; i < numPackets; i++) {
+        UsbIpWireIsoPacket wire;
+        memcpy(&wire, data->constData() + descOffset + i * sizeof(wire), sizeof(wire));
+
+        uint32_t offset = fromBE32(wire.offset);
+        uint32_t length = fromBE32(wire.length);
+        if (length > maxPacket || static_cast<uint64_t>(offset) + length > static_cast<uint64_t>(bufLen)) {
+            qWarning("[UsbIpDaemon] CMD_SUBMIT seqnum %u: ISO packet %d at %u+%u is out of range",
+                     hdr.seqnum, i, offset, length);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void UsbIpDaemon::dropSession(DaemonDeviceSession* session, const char* reason)
+{
+    qWarning("[UsbIpDaemon] Disconnecting device %u: %s", session->deviceId, reason);
+
+    // abort() emits disconnected() synchronously, which deletes the session
+    session->recvBuffer.clear();
+    session->socket->abort();
 }
 
 // ============================================================================
@@ -483,6 +768,40 @@ void UsbIpDaemon::onUrbCompleted(uint32_t deviceId,
     if (sessionIt == m_DeviceSessions.end()) return;
 
     auto* session = sessionIt.value();
+    session->inFlight.remove(header.seqNum);
+
+    auto altIt = session->pendingSetInterface.find(header.seqNum);
+    if (altIt != session->pendingSetInterface.end()) {
+        uint16_t change = altIt.value();
+        session->pendingSetInterface.erase(altIt);
+
+        if (header.status == 0) {
+            if (change == 0xFFFF) {
+                session->altSettings.clear();
+            } else {
+                session->altSettings[static_cast<uint8_t>(change >> 8)] = static_cast<uint8_t>(change & 0xFF);
+            }
+            parseEndpoints(session->exporter->configDescriptor(), session->altSettings,
+                           session->endpointTypes, session->endpointMaxPacketBytes);
+        }
+    }
+
+    auto unlinkIt = session->pendingUnlinks.find(header.seqNum);
+    if (unlinkIt != session->pendingUnlinks.end()) {
+        uint32_t unlinkSeqnum = unlinkIt.value();
+        session->pendingUnlinks.erase(unlinkIt);
+
+        // If the URB completed normally before the cancel took effect the
+        // data is still delivered and the unlink reports "not found"
+        if (header.status == 0) {
+            sendRetSubmit(session, header, data);
+            sendRetUnlink(session, unlinkSeqnum, 0);
+        } else {
+            sendRetUnlink(session, unlinkSeqnum, -104); // ECONNRESET
+        }
+        return;
+    }
+
     sendRetSubmit(session, header, data);
 }
 
@@ -512,12 +831,46 @@ void UsbIpDaemon::sendRetSubmit(DaemonDeviceSession* session,
     wireHdr.u.ret_submit.number_of_packets = bswap32s(static_cast<int32_t>(mlptHdr.numIsoPackets));
     wireHdr.u.ret_submit.error_count      = 0;
 
-    session->socket->write(reinterpret_cast<const char*>(&wireHdr), sizeof(wireHdr));
+    if (mlptHdr.numIsoPackets == 0) {
+        session->socket->write(reinterpret_cast<const char*>(&wireHdr), sizeof(wireHdr));
+
+        // Write transfer data (for IN transfers)
+        if (!data.isEmpty()) {
+            session->socket->write(data);
+        }
+        return;
+    }
 
-    // Write transfer data (for IN transfers)
-    if (!data.isEmpty()) {
-        session->socket->write(data);
+    // ISO: packed IN data for all packets, then one descriptor per packet
+    int descBytes = static_cast<int>(mlptHdr.numIsoPackets * sizeof(MlptProtocol::UsbIpIsoPacket));
+    int dataBytes = qMax(0, data.size() - descBytes);
+
+    QByteArray isoDescs;
+    isoDescs.reserve(static_cast<int>(mlptHdr.numIsoPackets * sizeof(UsbIpWireIsoPacket)));
+    int32_t errorCount = 0;
+    for (uint32_t i = 0; i < mlptHdr.numIsoPackets; i++) {
+        MlptProtocol::UsbIpIsoPacket iso{};
+        if (dataBytes + static_cast<int>((i + 1) * sizeof(iso)) <= data.size()) {
+            memcpy(&iso, data.constData() + dataBytes + i * sizeof(iso), sizeof(iso));
+        }
+        if (iso.status != 0) {
+            errorCount++;
+        }
+
+        UsbIpWireIsoPacket wire;
+        wire.offset = bswap32(iso.offset);
+        wire.length = bswap32(iso.length);
+        wire.actual_length = bswap32(iso.actualLength);
+        wire.status = bswap32(static_cast<uint32_t>(iso.status));
+        isoDescs.append(reinterpret_cast<const char*>(&wire), sizeof(wire));
+    }
+    wireHdr.u.ret_submit.error_count = bswap32s(errorCount);
+
+    session->socket->write(reinterpret_cast<const char*>(&wireHdr), sizeof(wireHdr));
+    if (dataBytes > 0) {
+        session->socket->write(data.constData(), dataBytes);
     }
+    session->socket->write(isoDescs);
 }
 
 void UsbIpDaemon::sendRetUnlink(DaemonDeviceSession* session,
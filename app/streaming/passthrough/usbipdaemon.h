@@ -1,12 +1,16 @@
 // UsbIpDaemon — Runs a standard USB/IP server on the client side.
 // In usbip-win2 mode, the VHCI driver on the server connects directly
 // to this daemon to exchange URBs, bypassing the MLPT TCP relay.
+// It also speaks enough of the protocol (OP_REQ_DEVLIST, OP_REQ_IMPORT,
+// CMD_SUBMIT/CMD_UNLINK incl. ISO) for a stock Linux `usbip attach`.
 #pragma once
 
 #include <QObject>
+#include <QHostAddress>
 #include <QTcpServer>
 #include <QTcpSocket>
 #include <QHash>
+#include <QSet>
 #include <QMutex>
 #include <QByteArray>
 
@@ -27,6 +31,11 @@ struct UsbIpOpCommon {
     uint32_t status;    // 0 = OK
 };
 
+// OP_REP_DEVLIST: number of exported devices, each followed by its interfaces
+struct UsbIpOpDevlistReply {
+    uint32_t ndev;
+};
+
 // OP_REQ_IMPORT: client (driver) requests to import a device
 struct UsbIpOpImportRequest {
     char busid[32];
@@ -50,6 +59,14 @@ struct UsbIpUsbDevice {
     uint8_t  bNumInterfaces;
 };
 
+// usbip_usb_interface: per-interface info following a device in OP_REP_DEVLIST
+struct UsbIpUsbInterface {
+    uint8_t bInterfaceClass;
+    uint8_t bInterfaceSubClass;
+    uint8_t bInterfaceProtocol;
+    uint8_t padding;
+};
+
 // USB/IP URB header (48 bytes, network byte order on the wire)
 struct UsbIpWireHeader {
     uint32_t command;        // 1=CMD_SUBMIT, 2=CMD_UNLINK, 3=RET_SUBMIT, 4=RET_UNLINK
@@ -97,13 +114,26 @@ struct UsbIpWireIsoPacket {
 
 // USB/IP protocol constants
 static constexpr uint16_t USBIP_VERSION       = 0x0111;
+static constexpr uint16_t OP_REQ_DEVLIST      = 0x8005;
+static constexpr uint16_t OP_REP_DEVLIST      = 0x0005;
 static constexpr uint16_t OP_REQ_IMPORT       = 0x8003;
 static constexpr uint16_t OP_REP_IMPORT       = 0x0003;
+static constexpr uint32_t USBIP_ST_OK         = 0;
+static constexpr uint32_t USBIP_ST_NA         = 1;
+static constexpr uint32_t USBIP_ST_DEV_BUSY   = 2;
 static constexpr uint32_t USBIP_CMD_SUBMIT    = 0x00000001;
 static constexpr uint32_t USBIP_CMD_UNLINK    = 0x00000002;
 static constexpr uint32_t USBIP_RET_SUBMIT    = 0x00000003;
 static constexpr uint32_t USBIP_RET_UNLINK    = 0x00000004;
 
+// Limits on what a peer may ask us to buffer for a single CMD_SUBMIT
+static constexpr int32_t  USBIP_MAX_TRANSFER_LENGTH = 8 * 1024 * 1024;
+static constexpr int32_t  USBIP_MAX_ISO_PACKETS     = 1024;
+
+// Largest legal ISO packet (SuperSpeed: 1024 bytes x 16 burst x 3 mult),
+// used for endpoints missing from the configuration descriptor
+static constexpr uint32_t USBIP_MAX_ISO_PACKET_BYTES = 49152;
+
 // ============================================================================
 // Per-device connection: one TCP connection from the VHCI driver
 // ============================================================================
@@ -116,6 +146,22 @@ struct DaemonDeviceSession {
     uint32_t devid = 0;  // busnum<<16 | devnum, generated from deviceId
     QByteArray recvBuffer;
     bool importDone = false;
+
+    // Submitted URBs not yet completed, and CMD_UNLINKs waiting for their
+    // target URB to be cancelled: target seqnum -> unlink seqnum
+    QSet<uint32_t> inFlight;
+    QHash<uint32_t, uint32_t> pendingUnlinks;
+
+    // Endpoint address -> MlptProtocol::UsbTransferType and bytes per
+    // service interval for the active alternate settings
+    // (interface number -> bAlternateSetting)
+    QHash<uint8_t, uint8_t> endpointTypes;
+    QHash<uint8_t, uint32_t> endpointMaxPacketBytes;
+    QHash<uint8_t, uint8_t> altSettings;
+
+    // In-flight SET_INTERFACE (interface << 8 | alt) or SET_CONFIGURATION
+    // (0xFFFF) requests, applied when they complete successfully
+    QHash<uint32_t, uint16_t> pendingSetInterface;
 };
 
 // ============================================================================
@@ -130,13 +176,17 @@ public:
     explicit UsbIpDaemon(QObject* parent = nullptr);
     ~UsbIpDaemon();
 
-    // Start listening. port=0 means auto-assign.
-    bool start(uint16_t port = 0);
+    // Start listening. port=0 means auto-assign. Only the loopback
+    // interface is reachable unless a specific address is given.
+    bool start(uint16_t port = 0, const QHostAddress& address = QHostAddress::LocalHost);
     void stop();
 
     uint16_t port() const;
     bool isRunning() const { return m_Server.isListening(); }
 
+    // Reject connections from any other peer (null = accept any)
+    void setAllowedPeer(const QHostAddress& peer) { m_AllowedPeer = peer; }
+
     // Register a device for export with a given busid.
     // When the VHCI driver connects and sends OP_REQ_IMPORT with this busid,
     // the daemon will use the given UsbIpExporter to handle URBs.
@@ -159,17 +209,33 @@ private slots:
     void onUrbCompleted(uint32_t deviceId, const MlptProtocol::UsbIpHeader& header, const QByteArray& data);
 
 private:
+    bool handleOpRequest(DaemonDeviceSession* session);
+    void handleDevlistRequest(DaemonDeviceSession* session);
     bool handleImportRequest(DaemonDeviceSession* session);
+    static void fillUsbDevice(UsbIpUsbDevice* udev, const QString& busid,
+                              uint32_t deviceId, const UsbIpExporter* exporter);
     void handleUrbData(DaemonDeviceSession* session);
+    bool validateCmdSubmit(DaemonDeviceSession* session, const UsbIpWireHeader& hdr, const QByteArray* data);
+    void dropSession(DaemonDeviceSession* session, const char* reason);
     void processCmdSubmit(DaemonDeviceSession* session, const UsbIpWireHeader& hdr, const QByteArray& data);
     void processCmdUnlink(DaemonDeviceSession* session, const UsbIpWireHeader& hdr);
     void sendRetSubmit(DaemonDeviceSession* session, const MlptProtocol::UsbIpHeader& mlptHdr, const QByteArray& data);
     void sendRetUnlink(DaemonDeviceSession* session, uint32_t seqnum, int32_t status);
 
+    // Build the endpoint tables from a configuration descriptor
+    static void parseEndpoints(const QByteArray& configDescriptor,
+                               const QHash<uint8_t, uint8_t>& altSettings,
+                               QHash<uint8_t, uint8_t>& types,
+                               QHash<uint8_t, uint32_t>& maxPacketBytes);
+
+    // Transfer type from the endpoint table, guessed from the submit if unknown
+    static uint8_t transferTypeFor(const DaemonDeviceSession* session, const UsbIpWireHeader& hdr);
+
     // Byte-swap helpers for USB/IP wire format (network byte order)
     static void byteswapHeader(UsbIpWireHeader& hdr);
 
     QTcpServer m_Server;
+    QHostAddress m_AllowedPeer;
 
     // Exported devices: busid -> exporter (ready for import)
     QMutex m_ExportMutex;
@@ -39,9 +39,12 @@ void UsbIpExporter::shutdownLibusb()
 UsbIpExporter::UsbIpExporter(QObject* parent)
     : QObject(parent)
     , m_DeviceHandle(nullptr)
+    , m_Simulator(nullptr)
     , m_DeviceId(0)
+    , m_UrbTrace(nullptr)
     , m_UsbSpeed(0)
     , m_NumInterfaces(0)
+    , m_IsoStreamingEnabled(qgetenv("MLPT_ISO_STREAM") != "0")
     , m_EventThread(nullptr)
     , m_EventThreadRunning(false)
 {
@@ -205,6 +208,22 @@ bool UsbIpExporter::openDevice(uint16_t vendorId, uint16_t productId, const QStr
     return true;
 }
 
+bool UsbIpExporter::openSimulatedDevice(SimulatedUsbDevice::Kind kind)
+{
+    closeDevice();
+
+    m_Simulator = new SimulatedUsbDevice(kind, this);
+    connect(m_Simulator, &SimulatedUsbDevice::urbCompleted,
+            this, &UsbIpExporter::completeUrb);
+
+    m_DeviceDescriptor = m_Simulator->deviceDescriptor();
+    m_ConfigDescriptor = m_Simulator->configDescriptor();
+    m_UsbSpeed = m_Simulator->usbSpeed();
+
+    qInfo() << "UsbIpExporter: simulated device opened, id:" << m_DeviceId << "kind:" << kind;
+    return true;
+}
+
 bool UsbIpExporter::openDeviceByPath(uint8_t busNumber, uint8_t portNumber)
 {
     if (!s_LibusbCtx) return false;
@@ -254,6 +273,14 @@ struct UrbContext;
 
 void UsbIpExporter::closeDevice()
 {
+    if (m_Simulator) {
+        m_Simulator->cancelAll();
+        delete m_Simulator;
+        m_Simulator = nullptr;
+    }
+
+    retireIsoStreams();
+
     // Cancel all pending transfers FIRST so the event thread can process
     // cancellation callbacks cleanly before we shut it down.
     {
@@ -273,6 +300,10 @@ void UsbIpExporter::closeDevice()
     // Now stop the event thread — all cancellation callbacks should have fired.
     stopEventThread();
 
+    // No more callbacks can arrive, so drained or not the streams can go
+    qDeleteAll(m_RetiredIsoStreams);
+    m_RetiredIsoStreams.clear();
+
     // Free any transfers that weren't cleaned up by callbacks
     {
         QMutexLocker lock(&m_TransfersMutex);
@@ -430,14 +461,45 @@ struct UrbContext {
     uint8_t transferType;
 };
 
+void UsbIpExporter::completeUrb(const MlptProtocol::UsbIpHeader& resp, const QByteArray& data)
+{
+    if (m_UrbTrace) {
+        m_UrbTrace->recordComplete(resp);
+    }
+
+    emit urbCompleted(m_DeviceId, resp, data);
+}
+
 void UsbIpExporter::submitUrb(const MlptProtocol::UsbIpHeader& header, const QByteArray& data)
 {
+    if (m_UrbTrace) {
+        m_UrbTrace->recordSubmit(header);
+    }
+
+    if (header.transferType == MlptProtocol::USB_XFER_CONTROL &&
+        ((header.setupPacket[0] == 0x01 && header.setupPacket[1] == 0x0B) ||   // SET_INTERFACE
+         (header.setupPacket[0] == 0x00 && header.setupPacket[1] == 0x09))) {  // SET_CONFIGURATION
+        // Streams are bound to the current alternate setting
+        retireIsoStreams();
+    }
+
+    if (header.transferType == MlptProtocol::USB_XFER_ISOCHRONOUS &&
+        header.direction == MlptProtocol::USB_DIR_IN &&
+        (m_DeviceHandle || m_Simulator) && submitIsoStreamUrb(header, data)) {
+        return;
+    }
+
+    if (m_Simulator) {
+        m_Simulator->submitUrb(header, data);
+        return;
+    }
+
     if (!m_DeviceHandle) {
         // Send error response
         MlptProtocol::UsbIpHeader resp = header;
         resp.status = -1; // ENODEV
         resp.dataLen = 0;
-        emit urbCompleted(m_DeviceId, resp, QByteArray());
+        completeUrb(resp, QByteArray());
         return;
     }
 
@@ -447,7 +509,7 @@ void UsbIpExporter::submitUrb(const MlptProtocol::UsbIpHeader& header, const QBy
         MlptProtocol::UsbIpHeader resp = header;
         resp.status = -12; // ENOMEM
         resp.dataLen = 0;
-        emit urbCompleted(m_DeviceId, resp, QByteArray());
+        completeUrb(resp, QByteArray());
         return;
     }
 
@@ -474,7 +536,7 @@ void UsbIpExporter::submitUrb(const MlptProtocol::UsbIpHeader& header, const QBy
             MlptProtocol::UsbIpHeader resp = header;
             resp.status = -12;
             resp.dataLen = 0;
-            emit urbCompleted(m_DeviceId, resp, QByteArray());
+            completeUrb(resp, QByteArray());
             delete ctx;
             libusb_free_transfer(xfer);
             return;
@@ -499,7 +561,7 @@ void UsbIpExporter::submitUrb(const MlptProtocol::UsbIpHeader& header, const QBy
             MlptProtocol::UsbIpHeader resp = header;
             resp.status = -12;
             resp.dataLen = 0;
-            emit urbCompleted(m_DeviceId, resp, QByteArray());
+            completeUrb(resp, QByteArray());
             delete ctx;
             libusb_free_transfer(xfer);
             return;
@@ -520,7 +582,7 @@ void UsbIpExporter::submitUrb(const MlptProtocol::UsbIpHeader& header, const QBy
             MlptProtocol::UsbIpHeader resp = header;
             resp.status = -12;
             resp.dataLen = 0;
-            emit urbCompleted(m_DeviceId, resp, QByteArray());
+            completeUrb(resp, QByteArray());
             delete ctx;
             libusb_free_transfer(xfer);
             return;
@@ -541,7 +603,7 @@ void UsbIpExporter::submitUrb(const MlptProtocol::UsbIpHeader& header, const QBy
             MlptProtocol::UsbIpHeader resp = header;
             resp.status = -12;
             resp.dataLen = 0;
-            emit urbCompleted(m_DeviceId, resp, QByteArray());
+            completeUrb(resp, QByteArray());
             delete ctx;
             libusb_free_transfer(xfer);
             return;
@@ -553,10 +615,21 @@ void UsbIpExporter::submitUrb(const MlptProtocol::UsbIpHeader& header, const QBy
         libusb_fill_iso_transfer(xfer, m_DeviceHandle, ep, buf, bufLen,
             header.numIsoPackets, transferCallback, ctx, 5000);
 
-        // Set ISO packet lengths
+        // Set ISO packet lengths from the descriptors following the OUT data,
+        // falling back to an even split if the submitter didn't send any
         if (header.numIsoPackets > 0) {
+            int descOffset = header.direction == MlptProtocol::USB_DIR_OUT ? static_cast<int>(header.dataLen) : 0;
+            bool haveDescs = data.size() >= descOffset +
+                static_cast<int>(header.numIsoPackets * sizeof(MlptProtocol::UsbIpIsoPacket));
+
             for (uint32_t i = 0; i < header.numIsoPackets && i < static_cast<uint32_t>(xfer->num_iso_packets); i++) {
-                xfer->iso_packet_desc[i].length = bufLen / header.numIsoPackets;
+                if (haveDescs) {
+                    MlptProtocol::UsbIpIsoPacket iso;
+                    memcpy(&iso, data.constData() + descOffset + i * sizeof(iso), sizeof(iso));
+                    xfer->iso_packet_desc[i].length = iso.length;
+                } else {
+                    xfer->iso_packet_desc[i].length = bufLen / header.numIsoPackets;
+                }
             }
         }
         break;
@@ -568,7 +641,7 @@ void UsbIpExporter::submitUrb(const MlptProtocol::UsbIpHeader& header, const QBy
         MlptProtocol::UsbIpHeader resp = header;
         resp.status = -22; // EINVAL
         resp.dataLen = 0;
-        emit urbCompleted(m_DeviceId, resp, QByteArray());
+        completeUrb(resp, QByteArray());
         return;
     }
 
@@ -594,12 +667,23 @@ void UsbIpExporter::submitUrb(const MlptProtocol::UsbIpHeader& header, const QBy
         MlptProtocol::UsbIpHeader resp = header;
         resp.status = rc;
         resp.dataLen = 0;
-        emit urbCompleted(m_DeviceId, resp, QByteArray());
+        completeUrb(resp, QByteArray());
     }
 }
 
 void UsbIpExporter::unlinkUrb(uint32_t seqNum)
 {
+    for (IsoInStream* stream : m_IsoStreams) {
+        if (stream->unlinkHostUrb(seqNum)) {
+            return;
+        }
+    }
+
+    if (m_Simulator) {
+        m_Simulator->unlinkUrb(seqNum);
+        return;
+    }
+
     QMutexLocker lock(&m_TransfersMutex);
     auto it = m_PendingTransfers.find(seqNum);
     if (it != m_PendingTransfers.end()) {
@@ -607,6 +691,97 @@ void UsbIpExporter::unlinkUrb(uint32_t seqNum)
     }
 }
 
+// ─── Isochronous IN streaming ───
+
+bool UsbIpExporter::submitIsoStreamUrb(const MlptProtocol::UsbIpHeader& header, const QByteArray& data)
+{
+    uint8_t epAddr = header.endpoint | 0x80;
+
+    if (!m_IsoStreamingEnabled || header.numIsoPackets == 0 ||
+        m_IsoStreamUnsupported.contains(epAddr)) {
+        return false;
+    }
+
+    // Free streams whose transfers have all come back
+    for (int i = m_RetiredIsoStreams.size() - 1; i >= 0; i--) {
+        if (m_RetiredIsoStreams[i]->isIdle()) {
+            delete m_RetiredIsoStreams.takeAt(i);
+        }
+    }
+
+    IsoInStream* stream = m_IsoStreams.value(epAddr);
+    if (stream && !stream->isRunning()) {
+        // The ring collapsed (e.g. device errors); don't keep retrying it
+        m_IsoStreams.remove(epAddr);
+        m_RetiredIsoStreams.append(stream);
+        m_IsoStreamUnsupported.insert(epAddr);
+        return false;
+    }
+
+    if (!stream) {
+        // Size device-side packets like the host's (its max packet size)
+        uint32_t packetSize = 0;
+        for (uint32_t i = 0; i < header.numIsoPackets; i++) {
+            MlptProtocol::UsbIpIsoPacket iso;
+            if (static_cast<int>((i + 1) * sizeof(iso)) > data.size()) break;
+            memcpy(&iso, data.constData() + i * sizeof(iso), sizeof(iso));
+            packetSize = qMax(packetSize, iso.length);
+        }
+        if (packetSize == 0) {
+            packetSize = header.dataLen / header.numIsoPackets;
+        }
+
+        // The simulator has no libusb handle; it feeds the stream itself
+        stream = new IsoInStream(m_DeviceHandle, epAddr, packetSize,
+                                 static_cast<int>(header.numIsoPackets),
+                                 [this](const MlptProtocol::UsbIpHeader& resp, const QByteArray& respData) {
+                                     completeUrb(resp, respData);
+                                 });
+        bool started = stream->start();
+        if (started && m_Simulator) {
+            started = m_Simulator->startIsoStream(epAddr, static_cast<int>(header.numIsoPackets),
+                                                  [stream](const QList<QByteArray>& packets) {
+                                                      stream->deliverPackets(packets);
+                                                  });
+            if (!started) {
+                stream->stop();
+            }
+        }
+        if (!started) {
+            delete stream;
+            m_IsoStreamUnsupported.insert(epAddr);
+            return false;
+        }
+        m_IsoStreams.insert(epAddr, stream);
+    }
+
+    stream->submitHostUrb(header, data);
+    return true;
+}
+
+void UsbIpExporter::retireIsoStreams()
+{
+    if (m_Simulator) {
+        m_Simulator->stopIsoStream();
+    }
+
+    for (IsoInStream* stream : m_IsoStreams) {
+        stream->stop();
+        m_RetiredIsoStreams.append(stream);
+    }
+    m_IsoStreams.clear();
+    m_IsoStreamUnsupported.clear();
+}
+
+QList<IsoInStream::Stats> UsbIpExporter::isoStreamStats() const
+{
+    QList<IsoInStream::Stats> result;
+    for (const IsoInStream* stream : m_IsoStreams) {
+        result.append(stream->stats());
+    }
+    return result;
+}
+
 // ─── libusb async callback ───
 
 void MLPT_LIBUSB_CALL UsbIpExporter::transferCallback(libusb_transfer* transfer)
@@ -667,6 +842,50 @@ void UsbIpExporter::handleTransferComplete(libusb_transfer* transfer)
 
     // Extract response data
     QByteArray responseData;
+    if (ctx->transferType == MlptProtocol::USB_XFER_ISOCHRONOUS) {
+        // ISO: packed IN data of every packet, then one descriptor per
+        // packet (USB/IP RET_SUBMIT layout). actual_length is the sum.
+        // Descriptors are sent even on failure so the packet count matches.
+        bool completed = transfer->status == LIBUSB_TRANSFER_COMPLETED;
+        QByteArray isoDescs;
+        uint32_t offset = 0;
+        uint32_t totalActual = 0;
+        for (int i = 0; i < transfer->num_iso_packets; i++) {
+            const libusb_iso_packet_descriptor& pkt = transfer->iso_packet_desc[i];
+
+            MlptProtocol::UsbIpIsoPacket iso;
+            iso.offset = offset;
+            iso.length = pkt.length;
+            iso.actualLength = completed ? pkt.actual_length : 0;
+            switch (completed ? pkt.status : transfer->status) {
+            case LIBUSB_TRANSFER_COMPLETED: iso.status = 0; break;
+            case LIBUSB_TRANSFER_STALL:     iso.status = -32; break; // EPIPE
+            case LIBUSB_TRANSFER_OVERFLOW:  iso.status = -75; break; // EOVERFLOW
+            default:                        iso.status = -18; break; // EXDEV (missed frame)
+            }
+            isoDescs.append(reinterpret_cast<const char*>(&iso), sizeof(iso));
+
+            if (ctx->direction == MlptProtocol::USB_DIR_IN && iso.actualLength > 0) {
+                responseData.append(reinterpret_cast<const char*>(transfer->buffer + offset),
+                                    static_cast<int>(iso.actualLength));
+            }
+            offset += pkt.length;
+            totalActual += iso.actualLength;
+        }
+        responseData.append(isoDescs);
+
+        resp.startFrame = 0;
+        resp.numIsoPackets = static_cast<uint32_t>(transfer->num_iso_packets);
+        resp.dataLen = totalActual;
+
+        completeUrb(resp, responseData);
+
+        if (transfer->buffer) free(transfer->buffer);
+        delete ctx;
+        libusb_free_transfer(transfer);
+        return;
+    }
+
     if (transfer->status == LIBUSB_TRANSFER_COMPLETED &&
         ctx->direction == MlptProtocol::USB_DIR_IN) {
 
@@ -694,7 +913,7 @@ void UsbIpExporter::handleTransferComplete(libusb_transfer* transfer)
     // Receivers use data.size() for attached bytes, dataLen for actual_length.
     resp.dataLen = static_cast<uint32_t>(transfer->actual_length);
 
-    emit urbCompleted(m_DeviceId, resp, responseData);
+    completeUrb(resp, responseData);
 
     // Cleanup
     if (transfer->buffer) free(transfer->buffer);
@@ -5,11 +5,15 @@
 #include <QThread>
 #include <QMutex>
 #include <QHash>
+#include <QSet>
 #include <QByteArray>
 #include <functional>
 #include <atomic>
 
 #include "protocol.h"
+#include "urbtrace.h"
+#include "simulateddevice.h"
+#include "isostream.h"
 
 #include <QMetaType>
 Q_DECLARE_METATYPE(MlptProtocol::UsbIpHeader)
@@ -44,10 +48,13 @@ public:
     // Open a device by bus/port (more specific)
     bool openDeviceByPath(uint8_t busNumber, uint8_t portNumber);
 
+    // Serve a SimulatedUsbDevice instead of real hardware (see MLPT_SIMULATED_DEVICES)
+    bool openSimulatedDevice(SimulatedUsbDevice::Kind kind);
+
     // Close the device and release all interfaces
     void closeDevice();
 
-    bool isOpen() const { return m_DeviceHandle != nullptr; }
+    bool isOpen() const { return m_DeviceHandle != nullptr || m_Simulator != nullptr; }
 
     // Get USB descriptors for VHCI plugin on server
     QByteArray deviceDescriptor() const { return m_DeviceDescriptor; }
@@ -64,6 +71,12 @@ public:
     void setDeviceId(uint32_t id) { m_DeviceId = id; }
     uint32_t deviceId() const { return m_DeviceId; }
 
+    // Optional URB trace ring (owned by the caller, may be shared between exporters)
+    void setUrbTrace(MlptTrace::UrbTraceRing* trace) { m_UrbTrace = trace; }
+
+    // Jitter buffer statistics of the active isochronous IN streams
+    QList<IsoInStream::Stats> isoStreamStats() const;
+
 signals:
     // Emitted when a URB completes (submit result to send back to server)
     void urbCompleted(uint32_t deviceId, const MlptProtocol::UsbIpHeader& header, const QByteArray& data);
@@ -87,10 +100,22 @@ private:
     static void MLPT_LIBUSB_CALL transferCallback(libusb_transfer* transfer);
     void handleTransferComplete(libusb_transfer* transfer);
 
+    // Trace and emit a URB completion
+    void completeUrb(const MlptProtocol::UsbIpHeader& resp, const QByteArray& data);
+
+    // Serve an ISO IN URB from the endpoint's IsoInStream, starting one if
+    // needed. Returns false if the URB must go out as a one-off transfer.
+    bool submitIsoStreamUrb(const MlptProtocol::UsbIpHeader& header, const QByteArray& data);
+
+    // Stop all ISO streams (alt setting / configuration change, close)
+    void retireIsoStreams();
+
     static libusb_context* s_LibusbCtx;
 
     libusb_device_handle* m_DeviceHandle;
+    SimulatedUsbDevice* m_Simulator;
     uint32_t m_DeviceId;
+    MlptTrace::UrbTraceRing* m_UrbTrace;
 
     QByteArray m_DeviceDescriptor;   // 18-byte USB device descriptor
     QByteArray m_ConfigDescriptor;   // Full configuration descriptor
@@ -103,6 +128,13 @@ private:
     QMutex m_TransfersMutex;
     QHash<uint32_t, libusb_transfer*> m_PendingTransfers;
 
+    // Continuous ISO IN streams: endpoint address → stream. Stopped streams
+    // wait in m_RetiredIsoStreams until their transfers have drained.
+    bool m_IsoStreamingEnabled;
+    QHash<uint8_t, IsoInStream*> m_IsoStreams;
+    QList<IsoInStream*> m_RetiredIsoStreams;
+    QSet<uint8_t> m_IsoStreamUnsupported;
+
     // Event handling thread
     QThread* m_EventThread;
     std::atomic<bool> m_EventThreadRunning;
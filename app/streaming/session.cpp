@@ -48,12 +48,15 @@
 #include <QtEndian>
 #include <QCoreApplication>
 #include <QThreadPool>
+#include <QThread>
 #include <QSvgRenderer>
 #include <QPainter>
 #include <QImage>
 #include <QGuiApplication>
 #include <QCursor>
 #include <QScreen>
+#include <QTimer>
+#include <QElapsedTimer>
 
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
 #include <QQuickOpenGLUtils>
@@ -79,6 +82,7 @@ CONNECTION_LISTENER_CALLBACKS Session::k_ConnCallbacks = {
 
 Session* Session::s_ActiveSession;
 QSemaphore Session::s_ActiveSessionSemaphore(1);
+bool Session::s_DecoderCacheRevalidationPending = false;
 
 void Session::clStageStarting(int stage)
 {
@@ -398,50 +402,252 @@ int Session::drSubmitDecodeUnit(PDECODE_UNIT du)
     }
 }
 
+DecoderCapabilityCache::ProbeResult
+Session::runDecoderProbe(SDL_Window* window,
+                         StreamingPreferences::VideoDecoderSelection vds,
+                         int videoFormat, int width, int height, int frameRate)
+{
+    DecoderCapabilityCache::ProbeResult result = {};
+    IVideoDecoder* decoder;
+
+    if (!chooseDecoder(vds, window, videoFormat, width, height, frameRate, false, false, true, decoder)) {
+        result.ok = false;
+        return result;
+    }
+
+    result.ok = true;
+    result.isHardwareAccelerated = decoder->isHardwareAccelerated();
+    result.isAlwaysFullScreen = decoder->isAlwaysFullScreen();
+    result.isHdrSupported = decoder->isHdrSupported();
+    result.maxResolution = decoder->getDecoderMaxResolution();
+    result.capabilities = decoder->getDecoderCapabilities();
+    result.colorspace = decoder->getDecoderColorspace();
+    result.colorRange = decoder->getDecoderColorRange();
+
+    delete decoder;
+
+    return result;
+}
+
+bool Session::probeDecoder(SDL_Window* window,
+                           StreamingPreferences::VideoDecoderSelection vds,
+                           int videoFormat, int width, int height, int frameRate,
+                           DecoderCapabilityCache::ProbeResult& result)
+{
+    QString key = DecoderCapabilityCache::makeKey(vds, videoFormat, width, height, frameRate);
+
+    if (DecoderCapabilityCache::lookup(key, result)) {
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                    "Using cached decoder probe result for %s: %s",
+                    qPrintable(key),
+                    !result.ok ? "unavailable" : (result.isHardwareAccelerated ? "hardware" : "software"));
+        scheduleDecoderCacheRevalidation();
+        return result.ok;
+    }
+
+    result = runDecoderProbe(window, vds, videoFormat, width, height, frameRate);
+    DecoderCapabilityCache::store(key, result);
+    return result.ok;
+}
+
+void Session::scheduleDecoderCacheRevalidation()
+{
+    // Most cache hits don't need reprobing (see DecoderCapabilityCache)
+    if (s_DecoderCacheRevalidationPending || !DecoderCapabilityCache::hasUnverifiedKeys()) {
+        return;
+    }
+
+    // Give the UI (or the stream we're about to start) time to settle
+    s_DecoderCacheRevalidationPending = true;
+    QTimer::singleShot(10000, &Session::revalidateDecoderCache);
+}
+
+// Reprobes cached decoder configurations away from the main thread. The
+// test window is created, used and destroyed on this thread alone, and the
+// probes run one at a time, just like they do on the main thread.
+class DecoderCacheRevalidationThread : public QThread
+{
+public:
+    DecoderCacheRevalidationThread(const QSet<QString>& keys) :
+        QThread(nullptr),
+        m_Keys(keys)
+    {
+        setObjectName("Decoder Revalidation");
+    }
+
+    void run() override
+    {
+        SDL_Window* testWindow = SDL_CreateWindow("", 0, 0, 1280, 720,
+                                                  SDL_WINDOW_HIDDEN | StreamUtils::getPlatformWindowFlags());
+        if (!testWindow) {
+            testWindow = SDL_CreateWindow("", 0, 0, 1280, 720, SDL_WINDOW_HIDDEN);
+            if (!testWindow) {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                             "Failed to create window for decoder cache revalidation: %s",
+                             SDL_GetError());
+                return;
+            }
+        }
+
+        for (const QString& key : m_Keys) {
+            int vds, videoFormat, width, height, frameRate;
+            if (DecoderCapabilityCache::parseKey(key, vds, videoFormat, width, height, frameRate)) {
+                m_Results.insert(key, Session::runDecoderProbe(testWindow,
+                                                               (StreamingPreferences::VideoDecoderSelection)vds,
+                                                               videoFormat, width, height, frameRate));
+            }
+        }
+
+        SDL_DestroyWindow(testWindow);
+    }
+
+    QSet<QString> m_Keys;
+
+    // Only read on the main thread once the thread has finished
+    QHash<QString, DecoderCapabilityCache::ProbeResult> m_Results;
+};
+
+void Session::revalidateDecoderCache()
+{
+    if (!DecoderCapabilityCache::hasUnverifiedKeys()) {
+        s_DecoderCacheRevalidationPending = false;
+        return;
+    }
+
+    // Don't compete with an active stream for the GPU
+    if (s_ActiveSession != nullptr) {
+        QTimer::singleShot(10000, &Session::revalidateDecoderCache);
+        return;
+    }
+
+    // SDL's subsystem refcount isn't thread-safe, so video is initialized
+    // (and later quit) here on the main thread for the whole revalidation
+    if (SDL_InitSubSystem(SDL_INIT_VIDEO) != 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "SDL_InitSubSystem(SDL_INIT_VIDEO) failed: %s",
+                     SDL_GetError());
+        s_DecoderCacheRevalidationPending = false;
+        return;
+    }
+
+    // Pick up display changes since the entries were served
+    DecoderCapabilityCache::refresh();
+
+    QSet<QString> keys = DecoderCapabilityCache::takeUnverifiedKeys();
+    if (keys.isEmpty()) {
+        SDL_QuitSubSystem(SDL_INIT_VIDEO);
+        s_DecoderCacheRevalidationPending = false;
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    auto thread = new DecoderCacheRevalidationThread(keys);
+
+    auto onFinished = [thread, timer] {
+        int changed = 0;
+        for (auto it = thread->m_Results.constBegin(); it != thread->m_Results.constEnd(); ++it) {
+            // Only the keys we actually reprobed are marked verified
+            if (DecoderCapabilityCache::store(it.key(), it.value())) {
+                SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
+                            "Cached decoder probe result for %s was stale",
+                            qPrintable(it.key()));
+                changed++;
+            }
+        }
+
+        DecoderCapabilityCache::flush();
+
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                    "Revalidated %d cached decoder probes in %lld ms (%d changed)",
+                    (int)thread->m_Results.size(), timer.elapsed(), changed);
+
+        SDL_QuitSubSystem(SDL_INIT_VIDEO);
+        thread->deleteLater();
+
+        // Pick up anything served from the cache while we were busy
+        s_DecoderCacheRevalidationPending = false;
+        scheduleDecoderCacheRevalidation();
+    };
+
+    if (QString(SDL_GetCurrentVideoDriver()) == "cocoa") {
+        // Cocoa only allows windows on the main thread
+        thread->run();
+        onFinished();
+        return;
+    }
+
+    QObject::connect(thread, &QThread::finished, thread, onFinished);
+
+    // Probes are short, so let the last one finish rather than leave
+    // a decoder half torn down at exit
+    QObject::connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, thread, [thread] {
+        thread->wait();
+    });
+
+    thread->start(QThread::LowPriority);
+}
+
 void Session::getDecoderInfo(SDL_Window* window,
                              bool& isHardwareAccelerated, bool& isFullScreenOnly,
                              bool& isHdrSupported, QSize& maxResolution)
 {
-    IVideoDecoder* decoder;
+    QElapsedTimer timer;
+    timer.start();
+
+    DecoderCapabilityCache::refresh();
+    int hits = DecoderCapabilityCache::hits();
+    int misses = DecoderCapabilityCache::misses();
+
+    probeDecoderInfo(window, isHardwareAccelerated, isFullScreenOnly, isHdrSupported, maxResolution);
+
+    DecoderCapabilityCache::flush();
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                "Decoder capability probe took %lld ms (%d cached, %d probed)",
+                timer.elapsed(),
+                DecoderCapabilityCache::hits() - hits,
+                DecoderCapabilityCache::misses() - misses);
+}
+
+void Session::probeDecoderInfo(SDL_Window* window,
+                               bool& isHardwareAccelerated, bool& isFullScreenOnly,
+                               bool& isHdrSupported, QSize& maxResolution)
+{
+    DecoderCapabilityCache::ProbeResult result;
 
     // Since AV1 support on the host side is in its infancy, let's not consider
     // _only_ a working AV1 decoder to be acceptable and still show the warning
     // dialog indicating lack of hardware decoding support.
 
     // Try an HEVC Main10 decoder first to see if we have HDR support
-    if (chooseDecoder(StreamingPreferences::VDS_FORCE_HARDWARE,
-                      window, VIDEO_FORMAT_H265_MAIN10, 1920, 1080, 60,
-                      false, false, true, decoder)) {
-        isHardwareAccelerated = decoder->isHardwareAccelerated();
-        isFullScreenOnly = decoder->isAlwaysFullScreen();
-        isHdrSupported = decoder->isHdrSupported();
-        maxResolution = decoder->getDecoderMaxResolution();
-        delete decoder;
+    if (probeDecoder(window, StreamingPreferences::VDS_FORCE_HARDWARE,
+                     VIDEO_FORMAT_H265_MAIN10, 1920, 1080, 60, result)) {
+        isHardwareAccelerated = result.isHardwareAccelerated;
+        isFullScreenOnly = result.isAlwaysFullScreen;
+        isHdrSupported = result.isHdrSupported;
+        maxResolution = result.maxResolution;
 
         return;
     }
 
     // Try an AV1 Main10 decoder next to see if we have HDR support
-    if (chooseDecoder(StreamingPreferences::VDS_FORCE_HARDWARE,
-                      window, VIDEO_FORMAT_AV1_MAIN10, 1920, 1080, 60,
-                      false, false, true, decoder)) {
+    if (probeDecoder(window, StreamingPreferences::VDS_FORCE_HARDWARE,
+                     VIDEO_FORMAT_AV1_MAIN10, 1920, 1080, 60, result)) {
         // If we've got a working AV1 Main 10-bit decoder, we'll enable the HDR checkbox
         // but we will still continue probing to get other attributes for HEVC or H.264
         // decoders. See the AV1 comment at the top of the function for more info.
-        isHdrSupported = decoder->isHdrSupported();
-        delete decoder;
+        isHdrSupported = result.isHdrSupported;
     }
     else {
         // If we found no hardware decoders with HDR, check for a renderer
         // that supports HDR rendering with software decoded frames.
-        if (chooseDecoder(StreamingPreferences::VDS_FORCE_SOFTWARE,
-                          window, VIDEO_FORMAT_H265_MAIN10, 1920, 1080, 60,
-                          false, false, true, decoder) ||
-            chooseDecoder(StreamingPreferences::VDS_FORCE_SOFTWARE,
-                          window, VIDEO_FORMAT_AV1_MAIN10, 1920, 1080, 60,
-                          false, false, true, decoder)) {
-            isHdrSupported = decoder->isHdrSupported();
-            delete decoder;
+        if (probeDecoder(window, StreamingPreferences::VDS_FORCE_SOFTWARE,
+                         VIDEO_FORMAT_H265_MAIN10, 1920, 1080, 60, result) ||
+            probeDecoder(window, StreamingPreferences::VDS_FORCE_SOFTWARE,
+                         VIDEO_FORMAT_AV1_MAIN10, 1920, 1080, 60, result)) {
+            isHdrSupported = result.isHdrSupported;
         }
         else {
             // We weren't compiled with an HDR-capable renderer or we don't
@@ -451,26 +657,22 @@ void Session::getDecoderInfo(SDL_Window* window,
     }
 
     // Try a regular hardware accelerated HEVC decoder now
-    if (chooseDecoder(StreamingPreferences::VDS_FORCE_HARDWARE,
-                      window, VIDEO_FORMAT_H265, 1920, 1080, 60,
-                      false, false, true, decoder)) {
-        isHardwareAccelerated = decoder->isHardwareAccelerated();
-        isFullScreenOnly = decoder->isAlwaysFullScreen();
-        maxResolution = decoder->getDecoderMaxResolution();
-        delete decoder;
+    if (probeDecoder(window, StreamingPreferences::VDS_FORCE_HARDWARE,
+                     VIDEO_FORMAT_H265, 1920, 1080, 60, result)) {
+        isHardwareAccelerated = result.isHardwareAccelerated;
+        isFullScreenOnly = result.isAlwaysFullScreen;
+        maxResolution = result.maxResolution;
 
         return;
     }
 
 
 #if 0 // See AV1 comment at the top of this function
-    if (chooseDecoder(StreamingPreferences::VDS_FORCE_HARDWARE,
-                      window, VIDEO_FORMAT_AV1_MAIN8, 1920, 1080, 60,
-                      false, false, true, decoder)) {
-        isHardwareAccelerated = decoder->isHardwareAccelerated();
-        isFullScreenOnly = decoder->isAlwaysFullScreen();
-        maxResolution = decoder->getDecoderMaxResolution();
-        delete decoder;
+    if (probeDecoder(window, StreamingPreferences::VDS_FORCE_HARDWARE,
+                     VIDEO_FORMAT_AV1_MAIN8, 1920, 1080, 60, result)) {
+        isHardwareAccelerated = result.isHardwareAccelerated;
+        isFullScreenOnly = result.isAlwaysFullScreen;
+        maxResolution = result.maxResolution;
 
         return;
     }
@@ -478,13 +680,11 @@ void Session::getDecoderInfo(SDL_Window* window,
 
     // If we still didn't find a hardware decoder, try H.264 now.
     // This will fall back to software decoding, so it should always work.
-    if (chooseDecoder(StreamingPreferences::VDS_AUTO,
-                      window, VIDEO_FORMAT_H264, 1920, 1080, 60,
-                      false, false, true, decoder)) {
-        isHardwareAccelerated = decoder->isHardwareAccelerated();
-        isFullScreenOnly = decoder->isAlwaysFullScreen();
-        maxResolution = decoder->getDecoderMaxResolution();
-        delete decoder;
+    if (probeDecoder(window, StreamingPreferences::VDS_AUTO,
+                     VIDEO_FORMAT_H264, 1920, 1080, 60, result)) {
+        isHardwareAccelerated = result.isHardwareAccelerated;
+        isFullScreenOnly = result.isAlwaysFullScreen;
+        maxResolution = result.maxResolution;
 
         return;
     }
@@ -498,34 +698,30 @@ Session::getDecoderAvailability(SDL_Window* window,
                                 StreamingPreferences::VideoDecoderSelection vds,
                                 int videoFormat, int width, int height, int frameRate)
 {
-    IVideoDecoder* decoder;
+    DecoderCapabilityCache::ProbeResult result;
 
-    if (!chooseDecoder(vds, window, videoFormat, width, height, frameRate, false, false, true, decoder)) {
+    if (!probeDecoder(window, vds, videoFormat, width, height, frameRate, result)) {
         return DecoderAvailability::None;
     }
 
-    bool hw = decoder->isHardwareAccelerated();
-
-    delete decoder;
-
-    return hw ? DecoderAvailability::Hardware : DecoderAvailability::Software;
+    return result.isHardwareAccelerated ? DecoderAvailability::Hardware : DecoderAvailability::Software;
 }
 
 bool Session::populateDecoderProperties(SDL_Window* window)
 {
-    IVideoDecoder* decoder;
-
-    if (!chooseDecoder(m_Preferences->videoDecoderSelection,
-                       window,
-                       m_SupportedVideoFormats.first(),
-                       m_StreamConfig.width,
-                       m_StreamConfig.height,
-                       m_StreamConfig.fps,
-                       false, false, true, decoder)) {
+    DecoderCapabilityCache::ProbeResult result;
+
+    if (!probeDecoder(window,
+                      m_Preferences->videoDecoderSelection,
+                      m_SupportedVideoFormats.first(),
+                      m_StreamConfig.width,
+                      m_StreamConfig.height,
+                      m_StreamConfig.fps,
+                      result)) {
         return false;
     }
 
-    m_VideoCallbacks.capabilities = decoder->getDecoderCapabilities();
+    m_VideoCallbacks.capabilities = result.capabilities;
     if (m_VideoCallbacks.capabilities & CAPABILITY_PULL_RENDERER) {
         // It is an error to pass a push callback when in pull mode
         m_VideoCallbacks.submitDecodeUnit = nullptr;
@@ -544,7 +740,7 @@ bool Session::populateDecoderProperties(SDL_Window* window)
                         m_StreamConfig.colorSpace);
         }
         else {
-            m_StreamConfig.colorSpace = decoder->getDecoderColorspace();
+            m_StreamConfig.colorSpace = result.colorspace;
         }
 
         m_StreamConfig.colorRange = qEnvironmentVariableIntValue("COLOR_RANGE_OVERRIDE", &ok);
@@ -554,16 +750,14 @@ bool Session::populateDecoderProperties(SDL_Window* window)
                         m_StreamConfig.colorRange);
         }
         else {
-            m_StreamConfig.colorRange = decoder->getDecoderColorRange();
+            m_StreamConfig.colorRange = result.colorRange;
         }
     }
 
-    if (decoder->isAlwaysFullScreen()) {
+    if (result.isAlwaysFullScreen) {
         m_IsFullScreen = true;
     }
 
-    delete decoder;
-
     return true;
 }
 
@@ -588,8 +782,16 @@ Session::Session(NvComputer* computer, NvApp& app, StreamingPreferences *prefere
       m_AudioRenderer(nullptr),
       m_AudioSampleCount(0),
       m_DropAudioEndTime(0),
+      m_PendingLostAudioFrames(0),
+      m_LastAudioUnderrunCount(0),
+      m_ActiveWndAudioStats({}),
+      m_LastWndAudioStats({}),
+      m_GlobalAudioStats({}),
+      m_OverlayAudioStatsLock(0),
+      m_OverlayAudioStats({}),
       m_PassthroughClient(nullptr)
 {
+
     // If we don't have custom preferences and client has specific settings, load them
     if (!preferences && m_Computer && m_Preferences->hasClientSettings(m_Computer->uuid)) {
         qInfo() << "Loading client-specific settings for:" << m_Computer->name << "(" << m_Computer->uuid << ")";
@@ -671,6 +873,9 @@ bool Session::initialize(QQuickWindow* qtWindow)
         return false;
     }
 
+    QElapsedTimer startupTimer;
+    startupTimer.start();
+
     LiInitializeStreamConfiguration(&m_StreamConfig);
     m_StreamConfig.width = m_Preferences->width;
     m_StreamConfig.height = m_Preferences->height;
@@ -696,6 +901,13 @@ bool Session::initialize(QQuickWindow* qtWindow)
         }
     }
 
+    qint64 windowCreatedMs = startupTimer.elapsed();
+
+    // Drop cached probe results if the GPU, driver or displays changed
+    DecoderCapabilityCache::refresh();
+    int cacheHits = DecoderCapabilityCache::hits();
+    int cacheMisses = DecoderCapabilityCache::misses();
+
     qInfo() << "Server GPU:" << m_Computer->gpuModel;
     qInfo() << "Server GFE version:" << m_Computer->gfeVersion;
     qInfo() << "Stream request:" << m_StreamConfig.width << "x" << m_StreamConfig.height
@@ -963,10 +1175,14 @@ bool Session::initialize(QQuickWindow* qtWindow)
     }
 #endif
 
+    qint64 codecSelectedMs = startupTimer.elapsed();
+
     // Check for validation errors/warnings and emit
     // signals for them, if appropriate
     bool ret = validateLaunch(testWindow);
 
+    qint64 validatedMs = startupTimer.elapsed();
+
     if (ret) {
         // Video format is now locked in
         m_StreamConfig.supportedVideoFormats = m_SupportedVideoFormats.front();
@@ -978,6 +1194,18 @@ bool Session::initialize(QQuickWindow* qtWindow)
 
     SDL_DestroyWindow(testWindow);
 
+    DecoderCapabilityCache::flush();
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                "Startup timing: test window %lld ms, codec selection %lld ms, launch validation %lld ms, decoder properties %lld ms, total %lld ms (%d probes cached, %d run)",
+                windowCreatedMs,
+                codecSelectedMs - windowCreatedMs,
+                validatedMs - codecSelectedMs,
+                startupTimer.elapsed() - validatedMs,
+                startupTimer.elapsed(),
+                DecoderCapabilityCache::hits() - cacheHits,
+                DecoderCapabilityCache::misses() - cacheMisses);
+
     if (!ret) {
         SDL_QuitSubSystem(SDL_INIT_VIDEO);
         return false;
@@ -2060,6 +2288,9 @@ void Session::exec()
             case SDL_CODE_FLUSH_WINDOW_EVENT_BARRIER:
                 m_FlushingWindowEventsRef--;
                 break;
+            case SDL_CODE_GAMECONTROLLER_FLUSH_STATE:
+                m_InputHandler->flushPendingGamepadState();
+                break;
             case SDL_CODE_GAMECONTROLLER_RUMBLE:
                 m_InputHandler->rumble((uint16_t)(uintptr_t)event.user.data1,
                                        (uint16_t)((uintptr_t)event.user.data2 >> 16),
@@ -2269,6 +2500,10 @@ void Session::exec()
                     SDL_UnlockMutex(m_DecoderLock);
                     SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
                                  "Failed to recreate decoder after reset");
+
+                    // Our launch checks may have been answered from stale
+                    // cached probe results, so don't trust them next time.
+                    DecoderCapabilityCache::invalidate();
                     emit displayLaunchError(tr("Unable to initialize video decoder. Please check your streaming settings and try again."));
                     goto DispatchDeferredCleanup;
                 }
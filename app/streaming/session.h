@@ -10,6 +10,7 @@
 #include "video/decoder.h"
 #include "audio/renderers/renderer.h"
 #include "video/overlaymanager.h"
+#include "video/decodercache.h"
 
 class PassthroughClient;
 
@@ -98,6 +99,7 @@ class Session : public QObject
     friend class SdlInputHandler;
     friend class DeferredSessionCleanupTask;
     friend class AsyncConnectionStartThread;
+    friend class DecoderCacheRevalidationThread;
 
 public:
     explicit Session(NvComputer* computer, NvApp& app, StreamingPreferences *preferences = nullptr);
@@ -114,6 +116,13 @@ public:
                         bool& isHardwareAccelerated, bool& isFullScreenOnly,
                         bool& isHdrSupported, QSize& maxResolution);
 
+    // Reprobes decoder configurations that were served from the decoder
+    // cache and updates the cache with the results. Runs deferred while no
+    // stream is active, probing on a background thread where the window
+    // system allows it.
+    static
+    void revalidateDecoderCache();
+
     static Session* get()
     {
         return s_ActiveSession;
@@ -126,6 +135,9 @@ public:
 
     void flushWindowEvents();
 
+    // Appends audio statistics for the performance overlay
+    void stringifyAudioStats(char* output, int length);
+
     void setShouldExitAfterQuit();
 
 signals:
@@ -187,6 +199,26 @@ private:
                                                StreamingPreferences::VideoDecoderSelection vds,
                                                int videoFormat, int width, int height, int frameRate);
 
+    static
+    void probeDecoderInfo(SDL_Window* window,
+                          bool& isHardwareAccelerated, bool& isFullScreenOnly,
+                          bool& isHdrSupported, QSize& maxResolution);
+
+    // Runs a test-mode decoder probe, consulting the decoder cache first
+    static
+    bool probeDecoder(SDL_Window* window,
+                      StreamingPreferences::VideoDecoderSelection vds,
+                      int videoFormat, int width, int height, int frameRate,
+                      DecoderCapabilityCache::ProbeResult& result);
+
+    static
+    DecoderCapabilityCache::ProbeResult runDecoderProbe(SDL_Window* window,
+                                                        StreamingPreferences::VideoDecoderSelection vds,
+                                                        int videoFormat, int width, int height, int frameRate);
+
+    static
+    void scheduleDecoderCacheRevalidation();
+
     static
     bool chooseDecoder(StreamingPreferences::VideoDecoderSelection vds,
                        SDL_Window* window, int videoFormat, int width, int height,
@@ -238,6 +270,19 @@ private:
     static
     void arDecodeAndPlaySample(char* sampleData, int sampleLength);
 
+    void decodeAndPlayAudioFrame(unsigned char* sampleData, int sampleLength, bool decodeFec);
+
+    void updateAudioStatsWindow();
+
+    static
+    void addAudioStats(AUDIO_STATS& src, AUDIO_STATS& dst);
+
+    static
+    void stringifyAudioStats(AUDIO_STATS& stats, char* output, int length);
+
+    static
+    void logAudioStats(AUDIO_STATS& stats, const char* title);
+
     static
     int drSetup(int videoFormat, int width, int height, int frameRate, void*, int);
 
@@ -283,6 +328,15 @@ private:
     OPUS_MULTISTREAM_CONFIGURATION m_OriginalAudioConfig;
     int m_AudioSampleCount;
     Uint32 m_DropAudioEndTime;
+    int m_PendingLostAudioFrames;
+    int m_LastAudioUnderrunCount;
+    AUDIO_STATS m_ActiveWndAudioStats;
+    AUDIO_STATS m_LastWndAudioStats;
+    AUDIO_STATS m_GlobalAudioStats;
+
+    // The overlay reads audio stats from the video decoder thread
+    SDL_SpinLock m_OverlayAudioStatsLock;
+    AUDIO_STATS m_OverlayAudioStats;
 
     Overlay::OverlayManager m_OverlayManager;
 
@@ -291,4 +345,5 @@ private:
     static CONNECTION_LISTENER_CALLBACKS k_ConnCallbacks;
     static Session* s_ActiveSession;
     static QSemaphore s_ActiveSessionSemaphore;
+    static bool s_DecoderCacheRevalidationPending;
 };
@@ -23,12 +23,14 @@ typedef struct _VIDEO_STATS {
     uint64_t totalDecodeTimeUs;                // high-res (1us)
     uint64_t totalPacerTimeUs;                 // high-res (1us)
     uint64_t totalRenderTimeUs;                // high-res (1us)
+    uint32_t surfaceImports;                   // e.g. EGLImage creations
     uint32_t lastRtt;                          // low-res from enet (1ms)
     uint32_t lastRttVariance;                  // low-res from enet (1ms)
     double totalFps;                           // high-res
     double receivedFps;                        // high-res
     double decodedFps;                         // high-res
     double renderedFps;                        // high-res
+    double surfaceImportsPerSec;               // high-res
     double videoMegabitsPerSec;                // current video bitrate in Mbps, not including FEC overhead
     uint64_t measurementStartUs;               // microseconds
 } VIDEO_STATS, *PVIDEO_STATS;
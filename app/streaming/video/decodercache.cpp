@@ -0,0 +1,362 @@
+#include "decodercache.h"
+#include "path.h"
+
+#include "SDL_compat.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QGuiApplication>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+#include <QSysInfo>
+
+#ifdef HAVE_FFMPEG
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/avutil.h>
+}
+#endif
+
+#ifdef Q_OS_WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <dxgi.h>
+#include <wrl/client.h>
+
+using Microsoft::WRL::ComPtr;
+#endif
+
+#define CACHE_FILE_NAME "decodercaps.json"
+
+// Bump when ProbeResult or the probing logic changes meaning
+#define CACHE_FORMAT_VERSION 1
+
+// How long cache hits go without being reprobed in the background
+#define REVALIDATION_INTERVAL_MS (3LL * 24 * 60 * 60 * 1000)
+
+bool DecoderCapabilityCache::s_Loaded = false;
+bool DecoderCapabilityCache::s_Dirty = false;
+QString DecoderCapabilityCache::s_Fingerprint;
+QHash<QString, DecoderCapabilityCache::ProbeResult> DecoderCapabilityCache::s_Entries;
+QHash<QString, qint64> DecoderCapabilityCache::s_VerifiedMs;
+QSet<QString> DecoderCapabilityCache::s_UnverifiedKeys;
+int DecoderCapabilityCache::s_Hits = 0;
+int DecoderCapabilityCache::s_Misses = 0;
+
+bool DecoderCapabilityCache::ProbeResult::operator==(const ProbeResult& other) const
+{
+    return ok == other.ok &&
+           isHardwareAccelerated == other.isHardwareAccelerated &&
+           isAlwaysFullScreen == other.isAlwaysFullScreen &&
+           isHdrSupported == other.isHdrSupported &&
+           maxResolution == other.maxResolution &&
+           capabilities == other.capabilities &&
+           colorspace == other.colorspace &&
+           colorRange == other.colorRange;
+}
+
+bool DecoderCapabilityCache::isEnabled()
+{
+    static const bool enabled = qgetenv("ML_DECODER_CACHE") != "0";
+    return enabled;
+}
+
+QString DecoderCapabilityCache::makeKey(int vds, int videoFormat, int width, int height, int frameRate)
+{
+    return QString("%1/%2/%3x%4x%5").arg(vds).arg(videoFormat, 0, 16).arg(width).arg(height).arg(frameRate);
+}
+
+bool DecoderCapabilityCache::parseKey(const QString& key, int& vds, int& videoFormat, int& width, int& height, int& frameRate)
+{
+    QStringList fields = key.split('/');
+    if (fields.size() != 3) {
+        return false;
+    }
+
+    QStringList dimensions = fields[2].split('x');
+    if (dimensions.size() != 3) {
+        return false;
+    }
+
+    bool ok[5];
+    vds = fields[0].toInt(&ok[0]);
+    videoFormat = fields[1].toInt(&ok[1], 16);
+    width = dimensions[0].toInt(&ok[2]);
+    height = dimensions[1].toInt(&ok[3]);
+    frameRate = dimensions[2].toInt(&ok[4]);
+
+    return ok[0] && ok[1] && ok[2] && ok[3] && ok[4];
+}
+
+QString DecoderCapabilityCache::gpuFingerprint()
+{
+    QStringList parts;
+
+#if defined(Q_OS_WIN32)
+    ComPtr<IDXGIFactory1> factory;
+    if (SUCCEEDED(CreateDXGIFactory1(__uuidof(IDXGIFactory1), (void**)&factory))) {
+        ComPtr<IDXGIAdapter1> adapter;
+        for (UINT i = 0; factory->EnumAdapters1(i, &adapter) != DXGI_ERROR_NOT_FOUND; i++) {
+            DXGI_ADAPTER_DESC1 desc;
+            if (FAILED(adapter->GetDesc1(&desc))) {
+                continue;
+            }
+
+            // The UMD version is only exposed through this legacy query
+            LARGE_INTEGER umdVersion = {};
+            adapter->CheckInterfaceSupport(__uuidof(IDXGIDevice), &umdVersion);
+
+            parts.append(QString("%1:%2:%3:%4")
+                         .arg(desc.VendorId, 4, 16, QChar('0'))
+                         .arg(desc.DeviceId, 4, 16, QChar('0'))
+                         .arg(QString::fromWCharArray(desc.Description))
+                         .arg(umdVersion.QuadPart, 0, 16));
+        }
+    }
+#elif defined(Q_OS_DARWIN)
+    // VideoToolbox and the GPU drivers ship with the OS
+    parts.append(QSysInfo::productVersion());
+    parts.append(QSysInfo::kernelVersion());
+#else
+    // Kernel drivers are covered by the kernel version. Userspace drivers
+    // (Mesa, libva drivers) have no cheap version query, so updates to them
+    // are picked up by background revalidation instead.
+    parts.append(QSysInfo::kernelVersion());
+
+    QDir drmDir("/sys/class/drm");
+    for (const QString& card : drmDir.entryList({ "card*" }, QDir::Dirs | QDir::System, QDir::Name)) {
+        // Skip connectors like card0-HDMI-A-1
+        if (card.contains('-')) {
+            continue;
+        }
+
+        QString devicePath = drmDir.absoluteFilePath(card + "/device");
+        QString driver = QFileInfo(devicePath + "/driver").symLinkTarget().section('/', -1);
+
+        QString entry = card + ":" + driver;
+        for (const char* attr : { "/vendor", "/device" }) {
+            QFile file(devicePath + attr);
+            if (file.open(QIODevice::ReadOnly)) {
+                entry += ":" + QString::fromUtf8(file.readAll().trimmed());
+            }
+        }
+
+        QFile moduleVersion("/sys/module/" + driver + "/version");
+        if (moduleVersion.open(QIODevice::ReadOnly)) {
+            entry += ":" + QString::fromUtf8(moduleVersion.readAll().trimmed());
+        }
+
+        parts.append(entry);
+    }
+
+    QFile nvidiaVersion("/proc/driver/nvidia/version");
+    if (nvidiaVersion.open(QIODevice::ReadOnly)) {
+        parts.append(QString::fromUtf8(nvidiaVersion.readLine().trimmed()));
+    }
+#endif
+
+    return parts.join(';');
+}
+
+QString DecoderCapabilityCache::computeFingerprint()
+{
+    QStringList parts;
+
+    parts.append(QString("v%1").arg(CACHE_FORMAT_VERSION));
+    parts.append(VERSION_STR);
+
+#ifdef HAVE_FFMPEG
+    parts.append(QString("ffmpeg %1 (avcodec %2)").arg(av_version_info()).arg(avcodec_version()));
+#endif
+
+    {
+        SDL_version sdlVersion;
+        SDL_GetVersion(&sdlVersion);
+        parts.append(QString("SDL %1.%2.%3 %4")
+                     .arg(sdlVersion.major).arg(sdlVersion.minor).arg(sdlVersion.patch)
+                     .arg(SDL_GetCurrentVideoDriver()));
+    }
+
+    parts.append(QGuiApplication::platformName());
+    parts.append(gpuFingerprint());
+
+    for (int i = 0; i < SDL_GetNumVideoDisplays(); i++) {
+        SDL_DisplayMode mode;
+        if (SDL_GetDesktopDisplayMode(i, &mode) == 0) {
+            parts.append(QString("%1:%2x%3@%4:%5")
+                         .arg(SDL_GetDisplayName(i))
+                         .arg(mode.w).arg(mode.h).arg(mode.refresh_rate)
+                         .arg(mode.format, 0, 16));
+        }
+    }
+
+    // Overrides that change which decoder or renderer gets picked
+    for (const char* var : { "DECODER_CAPS", "PREFER_VULKAN", "H264_DECODER_HINT",
+                             "HEVC_DECODER_HINT", "AV1_DECODER_HINT",
+                             "LIBVA_DRIVER_NAME", "VDPAU_DRIVER" }) {
+        if (qEnvironmentVariableIsSet(var)) {
+            parts.append(QString("%1=%2").arg(var, qEnvironmentVariable(var)));
+        }
+    }
+
+    return parts.join('|');
+}
+
+void DecoderCapabilityCache::load()
+{
+    s_Loaded = true;
+
+    QFile file(Path::getCacheFileInfo(CACHE_FILE_NAME).absoluteFilePath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    s_Fingerprint = root.value("fingerprint").toString();
+
+    QJsonObject entries = root.value("entries").toObject();
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        QJsonObject obj = it.value().toObject();
+        ProbeResult result;
+
+        result.ok = obj.value("ok").toBool();
+        result.isHardwareAccelerated = obj.value("hw").toBool();
+        result.isAlwaysFullScreen = obj.value("fullscreen").toBool();
+        result.isHdrSupported = obj.value("hdr").toBool();
+        result.maxResolution = QSize(obj.value("maxWidth").toInt(), obj.value("maxHeight").toInt());
+        result.capabilities = obj.value("caps").toInt();
+        result.colorspace = obj.value("colorspace").toInt();
+        result.colorRange = obj.value("colorRange").toInt();
+
+        s_Entries.insert(it.key(), result);
+        s_VerifiedMs.insert(it.key(), (qint64)obj.value("verified").toDouble());
+    }
+}
+
+void DecoderCapabilityCache::refresh()
+{
+    if (!isEnabled()) {
+        return;
+    }
+
+    if (!s_Loaded) {
+        load();
+    }
+
+    QString fingerprint = computeFingerprint();
+    if (fingerprint != s_Fingerprint) {
+        if (!s_Entries.isEmpty()) {
+            SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                        "Decoder cache invalidated by system change: %s",
+                        qPrintable(fingerprint));
+        }
+
+        s_Fingerprint = fingerprint;
+        s_Entries.clear();
+        s_VerifiedMs.clear();
+        s_UnverifiedKeys.clear();
+        s_Dirty = true;
+    }
+}
+
+bool DecoderCapabilityCache::lookup(const QString& key, ProbeResult& result)
+{
+    if (!isEnabled()) {
+        return false;
+    }
+
+    auto it = s_Entries.constFind(key);
+    if (it == s_Entries.constEnd()) {
+        s_Misses++;
+        return false;
+    }
+
+    s_Hits++;
+    if (QDateTime::currentMSecsSinceEpoch() - s_VerifiedMs.value(key) >= REVALIDATION_INTERVAL_MS) {
+        s_UnverifiedKeys.insert(key);
+    }
+    result = it.value();
+    return true;
+}
+
+bool DecoderCapabilityCache::store(const QString& key, const ProbeResult& result)
+{
+    if (!isEnabled()) {
+        return false;
+    }
+
+    s_VerifiedMs.insert(key, QDateTime::currentMSecsSinceEpoch());
+    s_Dirty = true;
+
+    auto it = s_Entries.find(key);
+    if (it != s_Entries.end() && it.value() == result) {
+        return false;
+    }
+
+    s_Entries.insert(key, result);
+    return true;
+}
+
+void DecoderCapabilityCache::invalidate()
+{
+    if (!isEnabled() || s_Entries.isEmpty()) {
+        return;
+    }
+
+    SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
+                "Discarding decoder cache");
+
+    s_Entries.clear();
+    s_VerifiedMs.clear();
+    s_UnverifiedKeys.clear();
+    s_Dirty = true;
+    flush();
+}
+
+void DecoderCapabilityCache::flush()
+{
+    if (!isEnabled() || !s_Dirty) {
+        return;
+    }
+
+    QJsonObject entries;
+    for (auto it = s_Entries.constBegin(); it != s_Entries.constEnd(); ++it) {
+        const ProbeResult& result = it.value();
+        QJsonObject obj;
+
+        obj["ok"] = result.ok;
+        obj["hw"] = result.isHardwareAccelerated;
+        obj["fullscreen"] = result.isAlwaysFullScreen;
+        obj["hdr"] = result.isHdrSupported;
+        obj["maxWidth"] = result.maxResolution.width();
+        obj["maxHeight"] = result.maxResolution.height();
+        obj["caps"] = result.capabilities;
+        obj["colorspace"] = result.colorspace;
+        obj["colorRange"] = result.colorRange;
+        obj["verified"] = (double)s_VerifiedMs.value(it.key());
+
+        entries[it.key()] = obj;
+    }
+
+    QJsonObject root;
+    root["fingerprint"] = s_Fingerprint;
+    root["entries"] = entries;
+
+    Path::writeCacheFile(CACHE_FILE_NAME, QJsonDocument(root).toJson(QJsonDocument::Compact));
+    s_Dirty = false;
+}
+
+QSet<QString> DecoderCapabilityCache::takeUnverifiedKeys()
+{
+    QSet<QString> keys;
+    keys.swap(s_UnverifiedKeys);
+    return keys;
+}
+
+bool DecoderCapabilityCache::hasUnverifiedKeys()
+{
+    return !s_UnverifiedKeys.isEmpty();
+}
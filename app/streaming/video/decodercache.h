@@ -0,0 +1,87 @@
+#pragma once
+
+#include <QHash>
+#include <QSet>
+#include <QSize>
+#include <QString>
+
+// Persistent cache of test-mode decoder probe results.
+//
+// Every probe instantiates a decoder and renderer and pushes a test frame
+// through them, which costs hundreds of milliseconds per probe on some
+// VAAPI/Vulkan setups. Results are stored in the cache directory, keyed by
+// a fingerprint of the client version, FFmpeg/SDL versions, GPU/driver,
+// display configuration and the environment overrides that influence
+// decoder selection. Any change to the fingerprint discards all entries.
+//
+// Entries served from the cache are reprobed later by the caller (see
+// Session::revalidateDecoderCache()) so a driver update that doesn't
+// change the fingerprint is still picked up. That reprobe is as slow as
+// a cache miss, so it only happens once an entry hasn't been verified
+// for a few days.
+//
+// Set ML_DECODER_CACHE=0 to bypass the cache entirely.
+//
+// Not thread-safe: only call it from the main thread. Background
+// revalidation probes on its own thread but stores from the main thread.
+class DecoderCapabilityCache
+{
+public:
+    struct ProbeResult {
+        bool ok;
+        bool isHardwareAccelerated;
+        bool isAlwaysFullScreen;
+        bool isHdrSupported;
+        QSize maxResolution;
+        int capabilities;
+        int colorspace;
+        int colorRange;
+
+        bool operator==(const ProbeResult& other) const;
+        bool operator!=(const ProbeResult& other) const { return !(*this == other); }
+    };
+
+    static bool isEnabled();
+
+    // Loads the cache file on first use and recomputes the fingerprint,
+    // dropping all entries if the system configuration has changed.
+    // SDL video must be initialized.
+    static void refresh();
+
+    static QString makeKey(int vds, int videoFormat, int width, int height, int frameRate);
+    static bool parseKey(const QString& key, int& vds, int& videoFormat, int& width, int& height, int& frameRate);
+
+    static bool lookup(const QString& key, ProbeResult& result);
+
+    // Records a freshly probed result, which also marks the entry verified.
+    // Returns true if the entry was added or its value changed.
+    static bool store(const QString& key, const ProbeResult& result);
+
+    // Drops all entries (e.g. a cached decoder failed to initialize for real)
+    static void invalidate();
+
+    // Writes the cache file if anything changed since the last flush
+    static void flush();
+
+    // Keys served from the cache since the last call, cleared on return.
+    // Only tracked for entries that are due for revalidation.
+    static QSet<QString> takeUnverifiedKeys();
+    static bool hasUnverifiedKeys();
+
+    static int hits() { return s_Hits; }
+    static int misses() { return s_Misses; }
+
+private:
+    static QString computeFingerprint();
+    static QString gpuFingerprint();
+    static void load();
+
+    static bool s_Loaded;
+    static bool s_Dirty;
+    static QString s_Fingerprint;
+    static QHash<QString, ProbeResult> s_Entries;
+    static QHash<QString, qint64> s_VerifiedMs;
+    static QSet<QString> s_UnverifiedKeys;
+    static int s_Hits;
+    static int s_Misses;
+};
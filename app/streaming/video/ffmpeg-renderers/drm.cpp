@@ -1487,4 +1487,8 @@ void DrmRenderer::freeEGLImages(EGLDisplay dpy, EGLImage images[EGL_MAX_PLANES])
     m_EglImageFactory.freeEGLImages(dpy, images);
 }
 
+uint32_t DrmRenderer::takeSurfaceImportCount() {
+    return m_EglImageFactory.takeImageCreationCount();
+}
+
 #endif
@@ -2,6 +2,18 @@
 
 #include <vector>
 
+#include <errno.h>
+#include <sys/stat.h>
+
+extern "C" {
+#include <libavutil/hwcontext.h>
+}
+
+// Decoders cycle through a fixed pool of surfaces, which is normally
+// well under this size. This only bounds the cache for decoders that
+// allocate new buffers without creating a new hw_frames_ctx.
+#define MAX_CACHED_SURFACES 32
+
 // Don't take a dependency on libdrm just for these constants
 #ifndef DRM_FORMAT_MOD_INVALID
 #define DRM_FORMAT_MOD_INVALID ((1ULL << 56) - 1)
@@ -27,10 +39,19 @@ EglImageFactory::EglImageFactory(IFFmpegRenderer* renderer) :
     m_eglCreateImageKHR(nullptr),
     m_eglDestroyImageKHR(nullptr),
     m_eglQueryDmaBufFormatsEXT(nullptr),
-    m_eglQueryDmaBufModifiersEXT(nullptr)
+    m_eglQueryDmaBufModifiersEXT(nullptr),
+    m_ImageCacheFramesCtx(nullptr),
+    m_ImageCacheDisplay(EGL_NO_DISPLAY),
+    m_ImageCacheClock(0),
+    m_ImagesCreated(0)
 {
 }
 
+EglImageFactory::~EglImageFactory()
+{
+    flushImageCache();
+}
+
 bool EglImageFactory::initializeEGL(EGLDisplay,
                                     const EGLExtensions &ext)
 {
@@ -70,6 +91,31 @@ ssize_t EglImageFactory::exportDRMImages(AVFrame* frame, AVDRMFrameDescriptor* d
 
     // DRM requires composed layers rather than separate layers per plane
     SDL_assert(drmFrame->nb_layers == 1);
+    SDL_assert(drmFrame->nb_objects <= EGL_MAX_PLANES);
+
+    prepareImageCache(frame, dpy);
+
+    // The FD numbers may differ each time a buffer is handed to us, but the
+    // dma-buf inode identifies the underlying buffer. It can't be recycled
+    // for another buffer while our cached EGLImage holds a reference to it.
+    SurfaceKey key;
+    initializeKey(frame, key);
+    for (int i = 0; i < drmFrame->nb_objects; i++) {
+        struct stat st;
+        if (fstat(drmFrame->objects[i].fd, &st) < 0) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                         "fstat() failed on dma-buf: %d", errno);
+            return -1;
+        }
+        key.surfaceIds[i] = st.st_ino;
+    }
+    key.formats[0] = drmFrame->layers[0].format;
+    key.modifier = drmFrame->objects[0].format_modifier;
+
+    ssize_t cachedCount = findCachedImages(key, images);
+    if (cachedCount > 0) {
+        return cachedCount;
+    }
 
     // Max 33 attributes (1 key + 1 value for each)
     const int MAX_ATTRIB_COUNT = 33 * 2;
@@ -235,6 +281,8 @@ ssize_t EglImageFactory::exportDRMImages(AVFrame* frame, AVDRMFrameDescriptor* d
         }
     }
 
+    m_ImagesCreated++;
+    insertCachedImages(key, images, 1);
     return 1;
 }
 
@@ -242,6 +290,26 @@ ssize_t EglImageFactory::exportDRMImages(AVFrame* frame, AVDRMFrameDescriptor* d
 
 #ifdef HAVE_LIBVA
 
+void EglImageFactory::initializeVAKey(AVFrame* frame, SurfaceKey& key)
+{
+    auto hwFrameCtx = (AVHWFramesContext*)frame->hw_frames_ctx->data;
+
+    initializeKey(frame, key);
+    key.surfaceIds[0] = (VASurfaceID)(uintptr_t)frame->data[3];
+    key.formats[0] = hwFrameCtx->sw_format;
+}
+
+ssize_t EglImageFactory::getCachedVAImages(AVFrame* frame, EGLDisplay dpy, EGLImage images[EGL_MAX_PLANES])
+{
+    memset(images, 0, sizeof(EGLImage) * EGL_MAX_PLANES);
+
+    prepareImageCache(frame, dpy);
+
+    SurfaceKey key;
+    initializeVAKey(frame, key);
+    return findCachedImages(key, images);
+}
+
 ssize_t EglImageFactory::exportVAImages(AVFrame *frame, VADRMPRIMESurfaceDescriptor *vaFrame, EGLDisplay dpy, EGLImage images[EGL_MAX_PLANES])
 {
     ssize_t count = 0;
@@ -421,10 +489,19 @@ ssize_t EglImageFactory::exportVAImages(AVFrame *frame, VADRMPRIMESurfaceDescrip
         ++count;
     }
 
+    {
+        SurfaceKey key;
+        initializeVAKey(frame, key);
+
+        prepareImageCache(frame, dpy);
+        m_ImagesCreated += count;
+        insertCachedImages(key, images, count);
+    }
+
     return count;
 
 fail:
-    freeEGLImages(dpy, images);
+    destroyImages(dpy, images);
     return -1;
 }
 
@@ -511,7 +588,12 @@ bool EglImageFactory::supportsImportingModifier(EGLDisplay dpy, EGLint format, E
 
 #endif
 
-void EglImageFactory::freeEGLImages(EGLDisplay dpy, EGLImage images[EGL_MAX_PLANES]) {
+void EglImageFactory::freeEGLImages(EGLDisplay, EGLImage images[EGL_MAX_PLANES]) {
+    // These are owned by the image cache and will be reused for later frames
+    memset(images, 0, sizeof(EGLImage) * EGL_MAX_PLANES);
+}
+
+void EglImageFactory::destroyImages(EGLDisplay dpy, EGLImage images[EGL_MAX_PLANES]) {
     for (size_t i = 0; i < EGL_MAX_PLANES; ++i) {
         if (images[i] != nullptr) {
             if (m_eglDestroyImage) {
@@ -524,3 +606,89 @@ void EglImageFactory::freeEGLImages(EGLDisplay dpy, EGLImage images[EGL_MAX_PLAN
     }
     memset(images, 0, sizeof(EGLImage) * EGL_MAX_PLANES);
 }
+
+void EglImageFactory::initializeKey(AVFrame* frame, SurfaceKey& key)
+{
+    // Zero the padding too, since keys are compared with memcmp()
+    memset(&key, 0, sizeof(key));
+
+    // These are baked into the EGLImage attributes
+    key.width = frame->width;
+    key.height = frame->height;
+    key.colorspace = m_Renderer->getFrameColorspace(frame);
+    key.fullRange = m_Renderer->isFrameFullRange(frame);
+    key.chromaLocation = frame->chroma_location;
+}
+
+void EglImageFactory::prepareImageCache(AVFrame* frame, EGLDisplay dpy)
+{
+    uint8_t* framesCtx = frame->hw_frames_ctx ? frame->hw_frames_ctx->data : nullptr;
+    uint8_t* cachedFramesCtx = m_ImageCacheFramesCtx ? m_ImageCacheFramesCtx->data : nullptr;
+
+    // Surface IDs are only unique within a hw_frames_ctx, so start over
+    // when the decoder is reinitialized with a new pool of surfaces.
+    if (dpy != m_ImageCacheDisplay || framesCtx != cachedFramesCtx) {
+        flushImageCache();
+
+        // Our reference keeps the old context from being freed and its
+        // address reused by a new one before we notice the change.
+        m_ImageCacheDisplay = dpy;
+        if (frame->hw_frames_ctx != nullptr) {
+            m_ImageCacheFramesCtx = av_buffer_ref(frame->hw_frames_ctx);
+        }
+    }
+}
+
+ssize_t EglImageFactory::findCachedImages(const SurfaceKey& key, EGLImage images[EGL_MAX_PLANES])
+{
+    for (CachedImages& entry : m_ImageCache) {
+        if (memcmp(&entry.key, &key, sizeof(key)) == 0) {
+            entry.lastUsed = ++m_ImageCacheClock;
+            memcpy(images, entry.images, sizeof(entry.images));
+            return entry.count;
+        }
+    }
+
+    return -1;
+}
+
+void EglImageFactory::insertCachedImages(const SurfaceKey& key, EGLImage images[EGL_MAX_PLANES], ssize_t count)
+{
+    if (m_ImageCache.size() >= MAX_CACHED_SURFACES) {
+        // Evict the least recently used surface
+        auto lru = m_ImageCache.begin();
+        for (auto it = m_ImageCache.begin(); it != m_ImageCache.end(); ++it) {
+            if (it->lastUsed < lru->lastUsed) {
+                lru = it;
+            }
+        }
+
+        destroyImages(m_ImageCacheDisplay, lru->images);
+        m_ImageCache.erase(lru);
+    }
+
+    CachedImages entry;
+    entry.key = key;
+    memcpy(entry.images, images, sizeof(entry.images));
+    entry.count = count;
+    entry.lastUsed = ++m_ImageCacheClock;
+    m_ImageCache.push_back(entry);
+}
+
+void EglImageFactory::flushImageCache()
+{
+    for (CachedImages& entry : m_ImageCache) {
+        destroyImages(m_ImageCacheDisplay, entry.images);
+    }
+    m_ImageCache.clear();
+
+    av_buffer_unref(&m_ImageCacheFramesCtx);
+    m_ImageCacheDisplay = EGL_NO_DISPLAY;
+}
+
+uint32_t EglImageFactory::takeImageCreationCount()
+{
+    uint32_t count = m_ImagesCreated;
+    m_ImagesCreated = 0;
+    return count;
+}
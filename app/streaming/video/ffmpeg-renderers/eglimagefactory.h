@@ -2,6 +2,8 @@
 
 #include "renderer.h"
 
+#include <vector>
+
 #ifdef HAVE_LIBVA
 #include <va/va_drmcommon.h>
 #endif
@@ -10,13 +12,18 @@ class EglImageFactory
 {
 public:
     EglImageFactory(IFFmpegRenderer* renderer);
+    ~EglImageFactory();
     bool initializeEGL(EGLDisplay, const EGLExtensions &ext);
 
+    // Exported EGLImages are cached per decoder surface and reused when the
+    // decoder hands us that surface again, so callers must not destroy them.
 #ifdef HAVE_DRM
     ssize_t exportDRMImages(AVFrame* frame, AVDRMFrameDescriptor* drmFrame, EGLDisplay dpy, EGLImage images[EGL_MAX_PLANES]);
 #endif
 
 #ifdef HAVE_LIBVA
+    // Returns -1 if the frame's surface must be exported with exportVAImages()
+    ssize_t getCachedVAImages(AVFrame* frame, EGLDisplay dpy, EGLImage images[EGL_MAX_PLANES]);
     ssize_t exportVAImages(AVFrame* frame, VADRMPRIMESurfaceDescriptor* vaFrame, EGLDisplay dpy, EGLImage images[EGL_MAX_PLANES]);
 #endif
 
@@ -25,7 +32,40 @@ public:
 
     void freeEGLImages(EGLDisplay dpy, EGLImage images[EGL_MAX_PLANES]);
 
+    // Destroys all cached EGLImages and drops our hw_frames_ctx reference
+    void flushImageCache();
+
+    // Returns the number of EGLImages created since the last call
+    uint32_t takeImageCreationCount();
+
 private:
+    struct SurfaceKey {
+        uint64_t surfaceIds[EGL_MAX_PLANES]; // VASurfaceID or dma-buf inodes
+        uint32_t formats[EGL_MAX_PLANES];
+        uint64_t modifier;
+        int width;
+        int height;
+        int colorspace;
+        int fullRange;
+        int chromaLocation;
+    };
+
+    struct CachedImages {
+        SurfaceKey key;
+        EGLImage images[EGL_MAX_PLANES];
+        ssize_t count;
+        uint64_t lastUsed;
+    };
+
+    void initializeKey(AVFrame* frame, SurfaceKey& key);
+#ifdef HAVE_LIBVA
+    void initializeVAKey(AVFrame* frame, SurfaceKey& key);
+#endif
+    void prepareImageCache(AVFrame* frame, EGLDisplay dpy);
+    ssize_t findCachedImages(const SurfaceKey& key, EGLImage images[EGL_MAX_PLANES]);
+    void insertCachedImages(const SurfaceKey& key, EGLImage images[EGL_MAX_PLANES], ssize_t count);
+    void destroyImages(EGLDisplay dpy, EGLImage images[EGL_MAX_PLANES]);
+
     IFFmpegRenderer* m_Renderer;
     bool m_EGLExtDmaBuf;
     PFNEGLCREATEIMAGEPROC m_eglCreateImage;
@@ -34,4 +74,10 @@ private:
     PFNEGLDESTROYIMAGEKHRPROC m_eglDestroyImageKHR;
     PFNEGLQUERYDMABUFFORMATSEXTPROC m_eglQueryDmaBufFormatsEXT;
     PFNEGLQUERYDMABUFMODIFIERSEXTPROC m_eglQueryDmaBufModifiersEXT;
+
+    std::vector<CachedImages> m_ImageCache;
+    AVBufferRef* m_ImageCacheFramesCtx;
+    EGLDisplay m_ImageCacheDisplay;
+    uint64_t m_ImageCacheClock;
+    uint32_t m_ImagesCreated;
 };
@@ -163,6 +163,11 @@ bool EGLRenderer::notifyWindowChanged(PWINDOW_STATE_CHANGE_INFO info)
     return !(info->stateChangeFlags & ~(WINDOW_STATE_CHANGE_SIZE | WINDOW_STATE_CHANGE_DISPLAY));
 }
 
+uint32_t EGLRenderer::takeSurfaceImportCount()
+{
+    return m_Backend->takeSurfaceImportCount();
+}
+
 bool EGLRenderer::isPixelFormatSupported(int videoFormat, AVPixelFormat pixelFormat)
 {
     // Pixel format support should be determined by the backend renderer
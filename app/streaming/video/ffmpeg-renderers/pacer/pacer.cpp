@@ -342,6 +342,7 @@ void Pacer::renderFrame(AVFrame* frame)
 
     m_VideoStats->totalRenderTimeUs += (afterRender - beforeRender);
     m_VideoStats->renderedFrames++;
+    m_VideoStats->surfaceImports += m_VsyncRenderer->takeSurfaceImportCount();
     av_frame_free(&frame);
 
     // Drop frames if we have too many queued up for a while
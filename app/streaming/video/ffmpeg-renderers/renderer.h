@@ -286,6 +286,12 @@ public:
         return false;
     }
 
+    // Returns the number of decoder surfaces imported into the
+    // renderer (e.g. as EGLImages) since the last call
+    virtual uint32_t takeSurfaceImportCount() {
+        return 0;
+    }
+
     virtual void prepareToRender() {
         // Allow renderers to perform any final preparations for
         // rendering after they have been selected to render. Such
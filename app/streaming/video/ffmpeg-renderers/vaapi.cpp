@@ -50,6 +50,12 @@ VAAPIRenderer::VAAPIRenderer(int decoderSelectionPass)
 
 VAAPIRenderer::~VAAPIRenderer()
 {
+#ifdef HAVE_EGL
+    // Cached EGLImages hold a hw_frames_ctx reference that
+    // must be dropped before we terminate the VADisplay.
+    m_EglImageFactory.flushImageCache();
+#endif
+
     if (m_HwContext != nullptr) {
         AVHWDeviceContext* deviceContext = (AVHWDeviceContext*)m_HwContext->data;
         AVVAAPIDeviceContext* vaDeviceContext = (AVVAAPIDeviceContext*)deviceContext->hwctx;
@@ -1165,48 +1171,50 @@ VAAPIRenderer::exportEGLImages(AVFrame *frame, EGLDisplay dpy,
     AVVAAPIDeviceContext* vaDeviceContext = (AVVAAPIDeviceContext*)hwFrameCtx->device_ctx->hwctx;
     VASurfaceID surface_id = (VASurfaceID)(uintptr_t)frame->data[3];
 
-    VAStatus st = vaExportSurfaceHandle(vaDeviceContext->display,
-                                        surface_id,
-                                        VA_SURFACE_ATTRIB_MEM_TYPE_DRM_PRIME_2,
-                                        exportFlags,
-                                        &m_PrimeDescriptor);
+    VAStatus st = vaSyncSurface(vaDeviceContext->display, surface_id);
     if (st != VA_STATUS_SUCCESS) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
-                     "vaExportSurfaceHandle failed: %d", st);
+                     "vaSyncSurface() failed: %d", st);
         return -1;
     }
 
-    st = vaSyncSurface(vaDeviceContext->display, surface_id);
+    // Reuse the EGLImages from the last time the decoder gave us this surface
+    count = m_EglImageFactory.getCachedVAImages(frame, dpy, images);
+    if (count > 0) {
+        return count;
+    }
+
+    st = vaExportSurfaceHandle(vaDeviceContext->display,
+                               surface_id,
+                               VA_SURFACE_ATTRIB_MEM_TYPE_DRM_PRIME_2,
+                               exportFlags,
+                               &m_PrimeDescriptor);
     if (st != VA_STATUS_SUCCESS) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
-                     "vaSyncSurface() failed: %d", st);
-        goto fail;
+                     "vaExportSurfaceHandle failed: %d", st);
+        return -1;
     }
 
     count = m_EglImageFactory.exportVAImages(frame, &m_PrimeDescriptor, dpy, images);
-    if (count < 0) {
-        goto fail;
-    }
 
-    return count;
-
-fail:
+    // The EGLImages hold their own references to the dma-bufs
     for (size_t i = 0; i < m_PrimeDescriptor.num_objects; ++i) {
         close(m_PrimeDescriptor.objects[i].fd);
     }
     m_PrimeDescriptor.num_layers = 0;
     m_PrimeDescriptor.num_objects = 0;
-    return -1;
+
+    return count < 0 ? -1 : count;
 }
 
 void
 VAAPIRenderer::freeEGLImages(EGLDisplay dpy, EGLImage images[EGL_MAX_PLANES]) {
     m_EglImageFactory.freeEGLImages(dpy, images);
-    for (size_t i = 0; i < m_PrimeDescriptor.num_objects; ++i) {
-        close(m_PrimeDescriptor.objects[i].fd);
-    }
-    m_PrimeDescriptor.num_layers = 0;
-    m_PrimeDescriptor.num_objects = 0;
+}
+
+uint32_t
+VAAPIRenderer::takeSurfaceImportCount() {
+    return m_EglImageFactory.takeImageCreationCount();
 }
 
 #endif
@@ -1,11 +1,18 @@
 #include "overlaymanager.h"
 #include "path.h"
 
+#include <QVector>
+
+// Matches the wrap length we used to pass to TTF_RenderText_Blended_Wrapped()
+#define OVERLAY_WRAP_WIDTH 1024
+
 using namespace Overlay;
 
 OverlayManager::OverlayManager() :
     m_Renderer(nullptr),
-    m_FontData(Path::readDataFile("ModeSeven.ttf"))
+    m_FontData(Path::readDataFile("ModeSeven.ttf")),
+    m_OverlayThread(nullptr),
+    m_Stopping(false)
 {
     memset(m_Overlays, 0, sizeof(m_Overlays));
 
@@ -26,14 +33,35 @@ OverlayManager::OverlayManager() :
                     TTF_GetError());
         return;
     }
+
+    m_OverlayThread = SDL_CreateThread(OverlayManager::overlayThread, "Overlay", this);
+    if (m_OverlayThread == nullptr) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
+                    "Unable to create overlay thread: %s",
+                    SDL_GetError());
+    }
 }
 
 OverlayManager::~OverlayManager()
 {
+    if (m_OverlayThread != nullptr) {
+        m_UpdateLock.lock();
+        m_Stopping = true;
+        m_UpdatePending.wakeAll();
+        m_UpdateLock.unlock();
+
+        SDL_WaitThread(m_OverlayThread, nullptr);
+    }
+
     for (int i = 0; i < OverlayType::OverlayMax; i++) {
         if (m_Overlays[i].surface != nullptr) {
             SDL_FreeSurface(m_Overlays[i].surface);
         }
+        for (int j = 0; j < (int)SDL_arraysize(m_Overlays[i].glyphs); j++) {
+            if (m_Overlays[i].glyphs[j] != nullptr) {
+                SDL_FreeSurface(m_Overlays[i].glyphs[j]);
+            }
+        }
         if (m_Overlays[i].font != nullptr) {
             TTF_CloseFont(m_Overlays[i].font);
         }
@@ -115,12 +143,83 @@ SDL_Color OverlayManager::getOverlayColor(OverlayType type)
 
 void OverlayManager::setOverlayRenderer(IOverlayRenderer* renderer)
 {
+    // Wait for the overlay thread to finish with the old renderer
+    QMutexLocker lock(&m_RendererLock);
     m_Renderer = renderer;
+
+    // The new renderer has seen none of our surfaces yet, so the next
+    // update must be rendered even if its text hasn't changed
+    for (int i = 0; i < OverlayType::OverlayMax; i++) {
+        m_Overlays[i].renderedEnabled = false;
+        m_Overlays[i].renderedText[0] = 0;
+    }
 }
 
 void OverlayManager::notifyOverlayUpdated(OverlayType type)
 {
+    if (m_OverlayThread == nullptr) {
+        return;
+    }
+
+    // Snapshot the text now, since the caller may start writing the
+    // next update into it before the overlay thread gets to this one.
+    QMutexLocker lock(&m_UpdateLock);
+    m_Overlays[type].pendingEnabled = m_Overlays[type].enabled;
+    strncpy(m_Overlays[type].pendingText, m_Overlays[type].text, sizeof(m_Overlays[0].pendingText));
+    m_Overlays[type].pendingText[sizeof(m_Overlays[0].pendingText) - 1] = '\0';
+    m_Overlays[type].updatePending = true;
+    m_UpdatePending.wakeOne();
+}
+
+int OverlayManager::overlayThread(void* context)
+{
+    OverlayManager* me = reinterpret_cast<OverlayManager*>(context);
+    char text[sizeof(me->m_Overlays[0].pendingText)];
+
+    // Overlays must never compete with decoding or rendering
+    SDL_SetThreadPriority(SDL_THREAD_PRIORITY_LOW);
+
+    me->m_UpdateLock.lock();
+    while (!me->m_Stopping) {
+        int type;
+        for (type = 0; type < OverlayType::OverlayMax; type++) {
+            if (me->m_Overlays[type].updatePending) {
+                break;
+            }
+        }
+
+        if (type == OverlayType::OverlayMax) {
+            me->m_UpdatePending.wait(&me->m_UpdateLock);
+            continue;
+        }
+
+        // Only the latest update for each overlay is rendered
+        bool enabled = me->m_Overlays[type].pendingEnabled;
+        memcpy(text, me->m_Overlays[type].pendingText, sizeof(text));
+        me->m_Overlays[type].updatePending = false;
+
+        me->m_UpdateLock.unlock();
+        me->renderOverlay((OverlayType)type, enabled, text);
+        me->m_UpdateLock.lock();
+    }
+    me->m_UpdateLock.unlock();
+
+    return 0;
+}
+
+void OverlayManager::renderOverlay(OverlayType type, bool enabled, const char* text)
+{
+    QMutexLocker lock(&m_RendererLock);
+
     if (m_Renderer == nullptr) {
+        // Make sure the next renderer gets a fresh surface
+        m_Overlays[type].renderedEnabled = false;
+        return;
+    }
+
+    // Nothing to do if the visible state hasn't changed
+    if (enabled == m_Overlays[type].renderedEnabled &&
+            (!enabled || strcmp(text, m_Overlays[type].renderedText) == 0)) {
         return;
     }
 
@@ -146,22 +245,111 @@ void OverlayManager::notifyOverlayUpdated(OverlayType type)
         }
     }
 
-    SDL_Surface* oldSurface = (SDL_Surface*)SDL_AtomicSetPtr((void**)&m_Overlays[type].surface, nullptr);
+    SDL_Surface* newSurface = enabled ? rasterizeText(type, text) : nullptr;
+    SDL_Surface* oldSurface = (SDL_Surface*)SDL_AtomicSetPtr((void**)&m_Overlays[type].surface, newSurface);
 
-    // Free the old surface
+    // Free the old surface if the renderer never picked it up
     if (oldSurface != nullptr) {
         SDL_FreeSurface(oldSurface);
     }
 
-    if (m_Overlays[type].enabled) {
-        // The _Wrapped variant is required for line breaks to work
-        SDL_Surface* surface = TTF_RenderText_Blended_Wrapped(m_Overlays[type].font,
-                                                              m_Overlays[type].text,
-                                                              m_Overlays[type].color,
-                                                              1024);
-        SDL_AtomicSetPtr((void**)&m_Overlays[type].surface, surface);
-    }
+    m_Overlays[type].renderedEnabled = enabled;
+    strcpy(m_Overlays[type].renderedText, text);
 
     // Notify the renderer
     m_Renderer->notifyOverlayUpdated(type);
 }
+
+SDL_Surface* OverlayManager::getGlyph(OverlayType type, unsigned char ch)
+{
+    if (m_Overlays[type].glyphs[ch] == nullptr) {
+        SDL_Surface* glyph = TTF_RenderGlyph_Blended(m_Overlays[type].font, ch, m_Overlays[type].color);
+        if (glyph == nullptr) {
+            return nullptr;
+        }
+
+        int advance;
+        if (TTF_GlyphMetrics(m_Overlays[type].font, ch, nullptr, nullptr, nullptr, nullptr, &advance) != 0) {
+            advance = glyph->w;
+        }
+
+        SDL_assert(!SDL_MUSTLOCK(glyph));
+        SDL_assert(glyph->format->format == SDL_PIXELFORMAT_ARGB8888);
+
+        m_Overlays[type].glyphs[ch] = glyph;
+        m_Overlays[type].glyphAdvances[ch] = advance;
+    }
+
+    return m_Overlays[type].glyphs[ch];
+}
+
+SDL_Surface* OverlayManager::rasterizeText(OverlayType type, const char* text)
+{
+    struct PlacedGlyph {
+        SDL_Surface* glyph;
+        int x;
+        int y;
+    };
+
+    int lineSkip = TTF_FontLineSkip(m_Overlays[type].font);
+    int fontHeight = TTF_FontHeight(m_Overlays[type].font);
+
+    // Each glyph is only rasterized the first time we see it. After that,
+    // an update (which is usually just a few changed digits) is laid out
+    // by copying cached glyphs into place.
+    QVector<PlacedGlyph> placedGlyphs;
+    int x = 0, y = 0;
+    int width = 0, height = 0;
+    for (const unsigned char* p = (const unsigned char*)text; *p != 0; p++) {
+        if (*p == '\n') {
+            x = 0;
+            y += lineSkip;
+            continue;
+        }
+
+        SDL_Surface* glyph = getGlyph(type, *p);
+        if (glyph == nullptr) {
+            continue;
+        }
+
+        int advance = m_Overlays[type].glyphAdvances[*p];
+        if (x > 0 && x + advance > OVERLAY_WRAP_WIDTH) {
+            x = 0;
+            y += lineSkip;
+        }
+
+        placedGlyphs.append({ glyph, x, y });
+        width = SDL_max(width, x + glyph->w);
+        height = SDL_max(height, y + SDL_max(glyph->h, fontHeight));
+
+        x += advance;
+    }
+
+    if (placedGlyphs.isEmpty()) {
+        return nullptr;
+    }
+
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (surface == nullptr) {
+        return nullptr;
+    }
+
+    SDL_assert(!SDL_MUSTLOCK(surface));
+    memset(surface->pixels, 0, surface->pitch * surface->h);
+
+    for (const PlacedGlyph& placed : placedGlyphs) {
+        // Glyph boxes may overlap their neighbors, and they all share a
+        // single color, so keep the most opaque pixel of any glyph.
+        for (int row = 0; row < placed.glyph->h; row++) {
+            const Uint32* src = (const Uint32*)((const Uint8*)placed.glyph->pixels + row * placed.glyph->pitch);
+            Uint32* dst = (Uint32*)((Uint8*)surface->pixels + (placed.y + row) * surface->pitch) + placed.x;
+            for (int i = 0; i < placed.glyph->w; i++) {
+                if ((src[i] >> 24) > (dst[i] >> 24)) {
+                    dst[i] = src[i];
+                }
+            }
+        }
+    }
+
+    return surface;
+}
@@ -1,10 +1,16 @@
 #pragma once
 
 #include <QString>
+#include <QMutex>
+#include <QWaitCondition>
 
 #include "SDL_compat.h"
 #include <SDL_ttf.h>
 
+// Includes the null terminator. The pending and rendered copies of the
+// text are the same size, so the overlay thread never truncates it.
+#define OVERLAY_TEXT_SIZE 2048
+
 namespace Overlay {
 
 enum OverlayType {
@@ -42,17 +48,44 @@ public:
 private:
     void notifyOverlayUpdated(OverlayType type);
 
+    static int overlayThread(void* context);
+    void renderOverlay(OverlayType type, bool enabled, const char* text);
+    SDL_Surface* rasterizeText(OverlayType type, const char* text);
+    SDL_Surface* getGlyph(OverlayType type, unsigned char ch);
+
     struct {
         bool enabled;
         int fontSize;
         SDL_Color color;
-        char text[1024];
+        char text[OVERLAY_TEXT_SIZE];
 
         TTF_Font* font;
         SDL_Surface* surface;
+
+        // Owned by the overlay thread
+        SDL_Surface* glyphs[256];
+        int glyphAdvances[256];
+        char renderedText[OVERLAY_TEXT_SIZE];
+        bool renderedEnabled;
+
+        // Protected by m_UpdateLock
+        bool updatePending;
+        bool pendingEnabled;
+        char pendingText[OVERLAY_TEXT_SIZE];
     } m_Overlays[OverlayMax];
     IOverlayRenderer* m_Renderer;
     QByteArray m_FontData;
+
+    // Text is rasterized on a low priority thread, so callers like the
+    // decoder thread never block on font rendering.
+    SDL_Thread* m_OverlayThread;
+    QMutex m_UpdateLock;
+    QWaitCondition m_UpdatePending;
+    bool m_Stopping;
+
+    // Held while calling into the renderer, so it can't be
+    // torn down underneath the overlay thread.
+    QMutex m_RendererLock;
 };
 
 }
@@ -50,6 +50,7 @@ void printUsage(const char* argv0)
     printf("  --port N     Listen port (default: %d)\n", MlptProtocol::DEFAULT_PORT);
     printf("  --legacy     Force legacy usbip-win backend (ReadFile/WriteFile URB relay)\n");
     printf("  --no-tray    Run without system tray icon\n");
+    printf("  --urb-trace FILE  Write a usbmon pcap of relayed URBs to FILE on exit\n");
     printf("  --help       Show this help\n");
     printf("\nBy default, the server tries usbip-win2 first, then falls back to legacy.\n");
     printf("In usbip-win2 mode, the VHCI driver connects directly to the client's\n");
@@ -61,6 +62,7 @@ int main(int argc, char* argv[])
     uint16_t port = MlptProtocol::DEFAULT_PORT;
     bool enableTray = true;
     VhciBackendType forceBackend = VhciBackendType::WIN2;  // default: try win2 first
+    std::string urbTraceFile;
 
     // Parse arguments
     for (int i = 1; i < argc; i++) {
@@ -68,6 +70,8 @@ int main(int argc, char* argv[])
             port = static_cast<uint16_t>(atoi(argv[++i]));
         } else if (strcmp(argv[i], "--no-tray") == 0) {
             enableTray = false;
+        } else if (strcmp(argv[i], "--urb-trace") == 0 && i + 1 < argc) {
+            urbTraceFile = argv[++i];
         } else if (strcmp(argv[i], "--legacy") == 0) {
             forceBackend = VhciBackendType::LEGACY;
         } else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
@@ -97,6 +101,7 @@ int main(int argc, char* argv[])
     ServerConfig config;
     config.port = port;
     config.forceBackend = forceBackend;
+    config.urbTraceFile = urbTraceFile;
 
     printf("===========================================\n");
     printf(" Moonlight Passthrough Server v%d.%d\n",
@@ -7,6 +7,7 @@
 PassthroughServer::PassthroughServer()
     : m_ListenSocket(INVALID_SOCKET)
     , m_Running(false)
+    , m_UrbTrace(MlptTrace::BUS_SERVER)
 {
 }
 
@@ -70,7 +71,7 @@ bool PassthroughServer::start(const ServerConfig& config)
 
 void PassthroughServer::stop()
 {
-    m_Running = false;
+    bool wasRunning = m_Running.exchange(false);
 
     if (m_ListenSocket != INVALID_SOCKET) {
         closesocket(m_ListenSocket);
@@ -113,6 +114,10 @@ void PassthroughServer::stop()
         m_Clients.clear();
     }
 
+    if (wasRunning) {
+        dumpUrbTrace();
+    }
+
     log("Server stopped");
 }
 
@@ -631,6 +636,8 @@ void PassthroughServer::forwardVhciUrbToClient(uint32_t deviceId,
         mlptHdr.numIsoPackets = static_cast<uint32_t>(native->u.cmd_submit.number_of_packets);
         memcpy(mlptHdr.setupPacket, native->u.cmd_submit.setup, 8);
 
+        m_UrbTrace.recordSubmit(mlptHdr);
+
         // Build payload: UsbIpHeader + trailing data (OUT data / ISO descriptors)
         std::vector<uint8_t> payload(sizeof(mlptHdr) + trailingLen);
         memcpy(payload.data(), &mlptHdr, sizeof(mlptHdr));
@@ -674,6 +681,8 @@ void PassthroughServer::handleUsbIpReturn(ClientConnection* client,
     }
 
     auto* mlptHdr = reinterpret_cast<const MlptProtocol::UsbIpHeader*>(payload.data());
+    m_UrbTrace.recordComplete(*mlptHdr);
+
     const uint8_t* responseData = payload.data() + sizeof(MlptProtocol::UsbIpHeader);
     size_t responseDataLen = payload.size() - sizeof(MlptProtocol::UsbIpHeader);
 
@@ -705,6 +714,38 @@ void PassthroughServer::handleUsbIpReturn(ClientConnection* client,
     }
 }
 
+void PassthroughServer::dumpUrbTrace()
+{
+    if (m_UrbTrace.totalRecords() == 0) {
+        return;
+    }
+
+    std::vector<MlptTrace::EndpointStats> stats = m_UrbTrace.aggregate();
+    log("URB statistics (" + std::to_string(stats.size()) + " endpoints):");
+    for (const auto& s : stats) {
+        char line[256];
+        snprintf(line, sizeof(line),
+                 "  dev %u ep 0x%02x %-4s  %8llu done  %6llu err  %4llu pending  "
+                 "avg %.2f ms  max %.2f ms  %.0f URB/s  %.1f KB/s",
+                 s.deviceId, s.endpointAddress,
+                 MlptTrace::UrbTraceRing::transferTypeName(s.transferType),
+                 static_cast<unsigned long long>(s.completed),
+                 static_cast<unsigned long long>(s.errors),
+                 static_cast<unsigned long long>(s.inFlight),
+                 s.avgLatencyUs() / 1000.0, s.maxLatencyUs / 1000.0,
+                 s.urbsPerSec(), s.bytesPerSec() / 1024.0);
+        log(line);
+    }
+
+    if (!m_Config.urbTraceFile.empty()) {
+        if (m_UrbTrace.writePcap(m_Config.urbTraceFile.c_str())) {
+            log("URB trace written to " + m_Config.urbTraceFile);
+        } else {
+            log("Failed to write URB trace to " + m_Config.urbTraceFile);
+        }
+    }
+}
+
 void PassthroughServer::log(const std::string& msg)
 {
     if (m_LogCallback) {
@@ -15,6 +15,7 @@
 #endif
 
 #include "protocol.h"
+#include "urbtrace.h"
 #include "vhci_manager.h"
 
 struct ClientConnection {
@@ -34,6 +35,7 @@ struct ServerConfig {
     uint16_t port = MlptProtocol::DEFAULT_PORT;
     bool vhciAvailable = false;
     VhciBackendType forceBackend = VhciBackendType::WIN2;  // default: try win2 first
+    std::string urbTraceFile;  // usbmon pcap written on stop (empty = don't write)
 };
 
 class PassthroughServer {
@@ -81,6 +83,9 @@ private:
     void log(const std::string& msg);
     void notifyStatusChange();
 
+    // Log the per-endpoint table and write the pcap file (if configured)
+    void dumpUrbTrace();
+
     SOCKET m_ListenSocket;
     std::thread m_AcceptThread;
     std::atomic<bool> m_Running;
@@ -95,6 +100,10 @@ private:
 
     std::unique_ptr<VhciManager> m_VhciManager;
 
+    // URB submit/complete trace (legacy relay mode only; in win2 mode the
+    // driver talks to the client daemon directly and we never see URBs)
+    MlptTrace::UrbTraceRing m_UrbTrace;
+
     LogCallback m_LogCallback;
     StatusCallback m_StatusCallback;
 };
@@ -0,0 +1,25 @@
+# Standalone benchmark of app list handling for a host with a very large
+# library. It isn't part of the main build. Built and run from tests.pro, or
+# alone:
+#   qmake && make && ./applist
+TEMPLATE = app
+TARGET = applist
+QT = core gui network
+CONFIG += console c++11 testcase
+CONFIG -= app_bundle
+
+INCLUDEPATH += \
+    $$PWD/../../app \
+    $$PWD/../../moonlight-common-c/moonlight-common-c/src
+
+SOURCES += \
+    main.cpp \
+    standins.cpp \
+    ../../app/backend/nvhttp.cpp \
+    ../../app/backend/nvcomputer.cpp \
+    ../../app/backend/nvxmlindex.cpp \
+    ../../app/backend/nvaddress.cpp \
+    ../../app/backend/nvapp.cpp
+
+HEADERS += \
+    ../../app/backend/nvhttp.h
@@ -0,0 +1,171 @@
+// Measures the cost of app list refreshes for a host with 2000 apps: a
+// full parse, the digest check that skips parsing when nothing changed,
+// and merging the result into the NvComputer, along with the memory the
+// response and the parsed list take up.
+//
+// Exits with a non-zero status if the list doesn't parse, hidden apps
+// lose their client-side attributes in a merge, or skipping the parse
+// isn't much cheaper than doing it.
+
+#include "backend/nvcomputer.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+
+#define APP_COUNT 2000
+#define HIDDEN_EVERY 20
+#define ITERATIONS 20
+
+// The digest check must be at least this much cheaper than a full parse
+#define MIN_SKIP_SPEEDUP 5
+
+static QByteArray createAppListXml(int renamedAppId)
+{
+    QByteArray xml = "<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+                     "<root protocol_version=\"0.1\" query=\"applist\" status_code=\"200\">";
+
+    for (int i = 0; i < APP_COUNT; i++) {
+        int appId = 100000 + i * 7;
+        QString name = appId == renamedAppId ?
+                    QString("Renamed Game") :
+                    QString("Game %1 - Definitive Edition").arg(i, 4, 10, QChar('0'));
+
+        xml += "<App>"
+               "<IsHdrSupported>" + QByteArray(i % 3 == 0 ? "1" : "0") + "</IsHdrSupported>"
+               "<AppTitle>" + name.toUtf8() + "</AppTitle>"
+               "<UUID>" + QByteArray::number(appId, 16).toUpper() + "</UUID>"
+               "<ID>" + QByteArray::number(appId) + "</ID>"
+               "</App>";
+    }
+
+    xml += "</root>";
+    return xml;
+}
+
+// Roughly what a parsed list keeps on the heap
+static qint64 getAppListBytes(const QVector<NvApp>& apps)
+{
+    qint64 bytes = apps.capacity() * (qint64)sizeof(NvApp);
+    for (const NvApp& app : apps) {
+        bytes += app.name.capacity() * (qint64)sizeof(QChar);
+    }
+    return bytes;
+}
+
+// Runs the same steps getAppListAsync() does with a response
+static QVector<NvApp> handleResponse(const QByteArray& response, const QByteArray& knownDigest)
+{
+    QByteArray digest = QCryptographicHash::hash(response, QCryptographicHash::Sha1);
+    if (!knownDigest.isEmpty() && digest == knownDigest) {
+        return QVector<NvApp>();
+    }
+
+    QString appxml = QString::fromUtf8(response);
+    NvHTTP::verifyResponseStatus(appxml);
+    return NvHTTP::parseAppList(appxml);
+}
+
+static double timeResponse(const QByteArray& response, const QByteArray& knownDigest, double& cpuMs)
+{
+    QElapsedTimer timer;
+    std::clock_t cpuStart = std::clock();
+
+    timer.start();
+    for (int i = 0; i < ITERATIONS; i++) {
+        handleResponse(response, knownDigest);
+    }
+
+    cpuMs = (std::clock() - cpuStart) * 1000.0 / CLOCKS_PER_SEC / ITERATIONS;
+    return timer.nsecsElapsed() / 1000000.0 / ITERATIONS;
+}
+
+static double timeUpdate(NvComputer& computer, const NvComputer& polled)
+{
+    QElapsedTimer timer;
+    timer.start();
+    computer.update(polled);
+    return timer.nsecsElapsed() / 1000000.0;
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    bool passed = true;
+    double cpuMs;
+
+    QByteArray response = createAppListXml(0);
+    QByteArray digest = QCryptographicHash::hash(response, QCryptographicHash::Sha1);
+
+    QVector<NvApp> apps = handleResponse(response, QByteArray());
+    printf("%d apps: %d byte response, about %lld bytes once parsed\n",
+           (int)apps.size(), (int)response.size(), (long long)getAppListBytes(apps));
+    if (apps.size() != APP_COUNT) {
+        printf("FAIL: expected %d apps\n", APP_COUNT);
+        passed = false;
+    }
+
+    double parseMs = timeResponse(response, QByteArray(), cpuMs);
+    printf("full parse:       %7.3f ms (%.3f ms CPU)\n", parseMs, cpuMs);
+
+    double skipMs = timeResponse(response, digest, cpuMs);
+    printf("unchanged digest: %7.3f ms (%.3f ms CPU)\n", skipMs, cpuMs);
+    if (skipMs * MIN_SKIP_SPEEDUP > parseMs) {
+        printf("FAIL: skipping the parse saves less than %dx\n", MIN_SKIP_SPEEDUP);
+        passed = false;
+    }
+
+    // A stored host with some apps hidden by the user
+    QTemporaryDir tempDir;
+    QSettings emptySettings(tempDir.filePath("empty.ini"), QSettings::IniFormat);
+    NvComputer computer(emptySettings);
+    computer.uuid = "0123456789ABCDEF";
+    computer.appList = apps;
+    for (int i = 0; i < computer.appList.size(); i += HIDDEN_EVERY) {
+        computer.appList[i].hidden = true;
+    }
+    QVector<NvApp> storedApps = computer.appList;
+
+    // A poll that fetched the same list again
+    NvComputer polled = computer;
+    polled.appList = handleResponse(response, QByteArray());
+    double mergeMs = timeUpdate(computer, polled);
+    printf("merge, unchanged: %7.3f ms\n", mergeMs);
+    if (computer.appList != storedApps) {
+        printf("FAIL: merging the same list changed it\n");
+        passed = false;
+    }
+
+    // One app renamed on the host
+    int renamedAppId = storedApps[HIDDEN_EVERY].id;
+    polled.appList = handleResponse(createAppListXml(renamedAppId), QByteArray());
+    mergeMs = timeUpdate(computer, polled);
+    printf("merge, one rename: %6.3f ms\n", mergeMs);
+
+    int changedApps = 0, hiddenApps = 0;
+    for (const NvApp& nvApp : computer.appList) {
+        auto it = std::find_if(storedApps.begin(), storedApps.end(), [&nvApp](const NvApp& stored) {
+            return stored.id == nvApp.id;
+        });
+        if (it == storedApps.end() || *it != nvApp) {
+            changedApps++;
+        }
+        if (nvApp.hidden) {
+            hiddenApps++;
+        }
+    }
+    printf("%d apps changed, %d hidden after the rename\n", changedApps, hiddenApps);
+    if (changedApps != 1 || hiddenApps != (APP_COUNT + HIDDEN_EVERY - 1) / HIDDEN_EVERY) {
+        printf("FAIL: expected 1 changed app and hidden apps to stay hidden\n");
+        passed = false;
+    }
+
+    printf("%s\n", passed ? "PASS" : "FAIL");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,30 @@
+// Stand-ins for what nvhttp.cpp and nvcomputer.cpp link against outside of
+// parsing and merging app lists, so they can be built without OpenSSL, the
+// streaming library or the settings code.
+
+#include "backend/identitymanager.h"
+#include "settings/compatfetcher.h"
+
+#include <Limelight.h>
+
+IdentityManager* IdentityManager::s_Im = nullptr;
+
+IdentityManager* IdentityManager::get()
+{
+    Q_UNREACHABLE();
+}
+
+QSslConfiguration IdentityManager::getSslConfig()
+{
+    Q_UNREACHABLE();
+}
+
+bool CompatFetcher::isGfeVersionSupported(QString)
+{
+    Q_UNREACHABLE();
+}
+
+const char* LiGetLaunchUrlQueryParameters()
+{
+    Q_UNREACHABLE();
+}
@@ -0,0 +1,17 @@
+# Standalone check of the audio jitter buffer against drifting clocks.
+# It isn't part of the main build. Built and run from tests.pro, or alone:
+#   qmake && make && ./audiojitter
+TEMPLATE = app
+TARGET = audiojitter
+CONFIG += console c++11 testcase
+CONFIG -= qt app_bundle
+
+CONFIG += link_pkgconfig
+PKGCONFIG += sdl2
+
+INCLUDEPATH += $$PWD/../../app
+
+SOURCES += \
+    main.cpp \
+    ../../app/streaming/audio/audioring.cpp \
+    ../../app/streaming/audio/jitterbuffer.cpp
@@ -0,0 +1,148 @@
+// Drives AudioJitterBuffer and AudioRing with a simulated host and audio
+// device whose clocks drift apart, the same way the SDL audio renderer uses
+// them. Each run checks that the queue settles at the latency target, the
+// rate correction tracks the drift, and the device never runs dry.
+//
+// Exits with a non-zero status if any scenario fails.
+
+#include "streaming/audio/audioring.h"
+#include "streaming/audio/jitterbuffer.h"
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#define SAMPLE_RATE 48000
+#define CHANNEL_COUNT 2
+#define SAMPLES_PER_FRAME 240
+#define DEVICE_SAMPLES 720
+#define RING_SLOT_COUNT 64
+
+// Long enough for the controller to converge and then hold steady
+#define RUN_SECONDS 600
+#define SETTLE_SECONDS 60
+
+struct Scenario
+{
+    const char* name;
+    int driftPpm;
+    int jitterMs;
+};
+
+static bool runScenario(const Scenario& scenario)
+{
+    // Same target the SDL renderer uses for this device
+    int targetLatencyMs = AudioJitterBuffer::getMinimumTargetLatencyMs(SAMPLE_RATE, DEVICE_SAMPLES, SAMPLES_PER_FRAME);
+    int frameSize = SAMPLES_PER_FRAME * CHANNEL_COUNT * (int)sizeof(float);
+
+    AudioRing ring;
+    AudioJitterBuffer jitterBuffer;
+    if (!ring.initialize(RING_SLOT_COUNT, frameSize) ||
+            !jitterBuffer.initialize(CHANNEL_COUNT, SAMPLE_RATE, targetLatencyMs, DEVICE_SAMPLES)) {
+        printf("%s: initialization failed\n", scenario.name);
+        return false;
+    }
+
+    std::vector<float> output((size_t)DEVICE_SAMPLES * CHANNEL_COUNT);
+
+    // The host sends audio on its own clock, which runs slightly fast or slow
+    // relative to ours. Packets arrive up to jitterMs late, but in order.
+    double framePeriod = (double)SAMPLES_PER_FRAME / SAMPLE_RATE / (1.0 + scenario.driftPpm / 1000000.0);
+    double callbackPeriod = (double)DEVICE_SAMPLES / SAMPLE_RATE;
+    unsigned int seed = 1;
+    double lastArrival = 0;
+    long frameIndex = 0;
+
+    bool playbackStarted = false;
+    int underruns = 0;
+    int overruns = 0;
+    int minLatencyMs = 0, maxLatencyMs = 0;
+    double correctionSum = 0;
+    int correctionSamples = 0;
+
+    for (long callback = 0; callback * callbackPeriod < RUN_SECONDS; callback++) {
+        double now = callback * callbackPeriod;
+
+        // Deliver everything that has arrived before this callback
+        for (;;) {
+            seed = seed * 1103515245 + 12345;
+            double delay = scenario.jitterMs / 1000.0 * ((seed >> 16) % 1000) / 1000.0;
+            double arrival = SDL_max(lastArrival, frameIndex * framePeriod + delay);
+            if (arrival > now) {
+                break;
+            }
+
+            float* buffer = (float*)ring.beginWrite();
+            if (buffer == nullptr) {
+                overruns++;
+            }
+            else {
+                for (int i = 0; i < SAMPLES_PER_FRAME * CHANNEL_COUNT; i++) {
+                    buffer[i] = 0.25f;
+                }
+                ring.commitWrite(frameSize);
+            }
+
+            lastArrival = arrival;
+            frameIndex++;
+        }
+
+        int framesRead = jitterBuffer.read(ring, output.data(), DEVICE_SAMPLES);
+        if (framesRead < DEVICE_SAMPLES && playbackStarted) {
+            underruns++;
+        }
+        if (framesRead > 0) {
+            playbackStarted = true;
+        }
+
+        if (now >= SETTLE_SECONDS) {
+            int latencyMs = jitterBuffer.getBufferedLatencyMs();
+            if (correctionSamples == 0) {
+                minLatencyMs = maxLatencyMs = latencyMs;
+            }
+            minLatencyMs = SDL_min(minLatencyMs, latencyMs);
+            maxLatencyMs = SDL_max(maxLatencyMs, latencyMs);
+            correctionSum += jitterBuffer.getRateCorrectionPpm();
+            correctionSamples++;
+        }
+    }
+
+    int meanCorrectionPpm = (int)(correctionSum / correctionSamples);
+
+    // A fast host clock fills the queue faster than the device drains it, so
+    // we expect to play faster by about the same amount, and vice versa.
+    bool passed = underruns == 0 && overruns == 0 &&
+                  std::abs(meanCorrectionPpm - scenario.driftPpm) <= 100 &&
+                  minLatencyMs >= targetLatencyMs - 5 &&
+                  maxLatencyMs <= targetLatencyMs + 5;
+
+    printf("%-24s %s: target %d ms, latency %d-%d ms, correction %d ppm, %d underruns, %d overruns\n",
+           scenario.name,
+           passed ? "PASS" : "FAIL",
+           targetLatencyMs,
+           minLatencyMs,
+           maxLatencyMs,
+           meanCorrectionPpm,
+           underruns,
+           overruns);
+
+    return passed;
+}
+
+int main(int, char**)
+{
+    static const Scenario scenarios[] = {
+        { "matched clocks", 0, 0 },
+        { "host fast", 300, 0 },
+        { "host slow", -300, 0 },
+        { "host fast with jitter", 300, 3 },
+        { "host slow with jitter", -300, 3 },
+    };
+
+    bool passed = true;
+    for (const Scenario& scenario : scenarios) {
+        passed = runScenario(scenario) && passed;
+    }
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,23 @@
+# Standalone comparison of delay and underruns for the ALSA and SDL renderers.
+# It isn't part of the main build. Built and run from tests.pro, or alone:
+#   qmake && make && ./audiolatency [alsa device]
+TEMPLATE = app
+TARGET = audiolatency
+QT = core
+CONFIG += console c++11 testcase
+CONFIG -= app_bundle
+
+CONFIG += link_pkgconfig
+PKGCONFIG += sdl2 alsa opus
+
+INCLUDEPATH += \
+    $$PWD/../../app \
+    $$PWD/../../moonlight-common-c/moonlight-common-c/src
+
+SOURCES += \
+    main.cpp \
+    ../../app/streaming/audio/audioring.cpp \
+    ../../app/streaming/audio/jitterbuffer.cpp \
+    ../../app/streaming/audio/sampleconverter.cpp \
+    ../../app/streaming/audio/renderers/alsa.cpp \
+    ../../app/streaming/audio/renderers/sdlaud.cpp
@@ -0,0 +1,117 @@
+// Plays the same stream of 5 ms stereo frames through the ALSA and SDL audio
+// renderers in real time, the way the audio decoder thread feeds them, and
+// reports how much audio each keeps queued ahead of the device and how often
+// the device runs dry.
+//
+// Both use ALSA's "null" device by default so this runs without sound
+// hardware. The null device has no clock of its own, so for figures that
+// mean something, load snd-aloop and pass its playback device instead:
+//   sudo modprobe snd-aloop && ./audiolatency hw:Loopback,0
+//
+// Exits with a non-zero status if either renderer fails.
+
+#include "streaming/audio/renderers/alsa.h"
+#include "streaming/audio/renderers/sdl.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+
+#define SAMPLE_RATE 48000
+#define CHANNEL_COUNT 2
+#define SAMPLES_PER_FRAME 240
+#define RUN_SECONDS 10
+#define TONE_HZ 440
+
+static bool playStream(const char* name, IAudioRenderer* renderer)
+{
+    OPUS_MULTISTREAM_CONFIGURATION opusConfig = {};
+    opusConfig.sampleRate = SAMPLE_RATE;
+    opusConfig.channelCount = CHANNEL_COUNT;
+    opusConfig.streams = 1;
+    opusConfig.coupledStreams = 1;
+    opusConfig.samplesPerFrame = SAMPLES_PER_FRAME;
+    opusConfig.mapping[0] = 0;
+    opusConfig.mapping[1] = 1;
+
+    renderer->remapChannels(&opusConfig);
+    if (!renderer->prepareForPlayback(&opusConfig)) {
+        printf("%-4s FAIL: renderer initialization failed\n", name);
+        return false;
+    }
+
+    auto period = std::chrono::microseconds(SAMPLES_PER_FRAME * 1000000LL / SAMPLE_RATE);
+    auto nextFrame = std::chrono::steady_clock::now();
+    double phase = 0;
+
+    long long totalDelayMs = 0;
+    int delaySamples = 0;
+    int maxDelayMs = 0;
+
+    for (int frame = 0; frame < RUN_SECONDS * SAMPLE_RATE / SAMPLES_PER_FRAME; frame++) {
+        std::this_thread::sleep_until(nextFrame);
+        nextFrame += period;
+
+        int size = SAMPLES_PER_FRAME * CHANNEL_COUNT * (int)sizeof(float);
+        float* buffer = (float*)renderer->getAudioBuffer(&size);
+        if (buffer == nullptr) {
+            continue;
+        }
+
+        // A quiet sine tone
+        for (int i = 0; i < SAMPLES_PER_FRAME; i++) {
+            float sample = 0.1f * (float)sin(phase);
+            phase += 2 * 3.14159265358979 * TONE_HZ / SAMPLE_RATE;
+            for (int channel = 0; channel < CHANNEL_COUNT; channel++) {
+                buffer[i * CHANNEL_COUNT + channel] = sample;
+            }
+        }
+
+        if (!renderer->submitAudio(size)) {
+            printf("%-4s FAIL: renderer failed after %d frames\n", name, frame);
+            return false;
+        }
+
+        int delayMs = renderer->getBufferedLatencyMs();
+        if (delayMs >= 0) {
+            totalDelayMs += delayMs;
+            delaySamples++;
+            maxDelayMs = SDL_max(maxDelayMs, delayMs);
+        }
+    }
+
+    printf("%-4s PASS: delay %.1f ms average, %d ms max, %d underruns, %d ppm rate correction\n",
+           name,
+           delaySamples != 0 ? (double)totalDelayMs / delaySamples : 0.0,
+           maxDelayMs,
+           renderer->getUnderrunCount(),
+           renderer->getRateCorrectionPpm());
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    const char* device = argc > 1 ? argv[1] : "null";
+
+    // The ALSA renderer takes its device from ML_ALSA_DEVICE, and SDL's ALSA
+    // backend from AUDIODEV, so both end up on the same device
+    SDL_setenv("ML_ALSA_DEVICE", device, 1);
+    SDL_setenv("SDL_AUDIODRIVER", "alsa", 0);
+    SDL_setenv("AUDIODEV", device, 1);
+
+    printf("Playing %d s of %d ms frames on '%s'\n",
+           RUN_SECONDS, SAMPLES_PER_FRAME * 1000 / SAMPLE_RATE, device);
+
+    bool passed = true;
+    {
+        AlsaAudioRenderer renderer;
+        passed = playStream("alsa", &renderer) && passed;
+    }
+    {
+        SdlAudioRenderer renderer;
+        passed = playStream("sdl", &renderer) && passed;
+    }
+
+    return passed ? 0 : 1;
+}
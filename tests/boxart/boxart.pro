@@ -0,0 +1,25 @@
+# Standalone check of BoxArtManager against fake hosts. It isn't part of the
+# main build. Built and run from tests.pro, or alone:
+#   qmake && make && ./boxart
+TEMPLATE = app
+TARGET = boxart
+QT = core gui network
+CONFIG += console c++11 testcase
+CONFIG -= app_bundle
+
+INCLUDEPATH += \
+    $$PWD/../../app \
+    $$PWD/../../moonlight-common-c/moonlight-common-c/src
+
+SOURCES += \
+    main.cpp \
+    fakehosts.cpp \
+    ../../app/path.cpp \
+    ../../app/backend/boxartmanager.cpp \
+    ../../app/backend/nvaddress.cpp \
+    ../../app/backend/nvapp.cpp
+
+HEADERS += \
+    fakehosts.h \
+    ../../app/backend/boxartmanager.h \
+    ../../app/backend/nvhttp.h
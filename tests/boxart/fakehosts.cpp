@@ -0,0 +1,88 @@
+// Stand-ins for the parts of NvHTTP used by BoxArtManager. Box art is
+// served from the FakeHost table after a short delay instead of going
+// over the network.
+
+#include "fakehosts.h"
+
+#include "backend/nvcomputer.h"
+
+#include <QBuffer>
+#include <QImage>
+#include <QTimer>
+
+static QHash<uint16_t, FakeHost*> s_Hosts;
+static int s_RequestsInFlight;
+static int s_MaxRequestsInFlight;
+
+void FakeHosts::add(FakeHost* host)
+{
+    host->requestsInFlight = 0;
+    host->maxRequestsInFlight = 0;
+    s_Hosts.insert(host->port, host);
+}
+
+int FakeHosts::maxRequestsInFlight()
+{
+    return s_MaxRequestsInFlight;
+}
+
+static QByteArray getBoxArtImage()
+{
+    static QByteArray s_Image;
+
+    if (s_Image.isEmpty()) {
+        QImage image(157, 222, QImage::Format_RGB32);
+        image.fill(Qt::darkCyan);
+
+        QBuffer buffer(&s_Image);
+        buffer.open(QIODevice::WriteOnly);
+        image.save(&buffer, "PNG");
+    }
+
+    return s_Image;
+}
+
+NvHTTP::NvHTTP(NvAddress address, uint16_t, QSslCertificate serverCert, QNetworkAccessManager* nam) :
+    m_Address(address),
+    m_Nam(nam),
+    m_ServerCert(serverCert),
+    m_AllowConnectionReuse(false)
+{
+}
+
+NvHTTP::NvHTTP(NvComputer* computer, QNetworkAccessManager* nam) :
+    NvHTTP(computer->activeAddress, computer->activeHttpsPort, computer->serverCert, nam)
+{
+}
+
+void NvHTTP::getBoxArtAsync(int appId, ResultCallback callback)
+{
+    FakeHost* host = s_Hosts.value(m_Address.port());
+    if (host == nullptr) {
+        qFatal("No fake host on port %u", m_Address.port());
+    }
+
+    int attempt = ++host->attempts[appId];
+    host->requests.append({ appId, attempt });
+
+    host->maxRequestsInFlight = qMax(host->maxRequestsInFlight, ++host->requestsInFlight);
+    s_MaxRequestsInFlight = qMax(s_MaxRequestsInFlight, ++s_RequestsInFlight);
+
+    QTimer::singleShot(5 + appId % 10, this, [host, appId, attempt, callback]() {
+        host->requestsInFlight--;
+        s_RequestsInFlight--;
+
+        NvHttpResult result;
+        if (appId < 1 || appId > host->imageCount) {
+            result.error = std::make_exception_ptr(GfeHttpResponseException(404, "Not found"));
+        }
+        else if (attempt == 1 && appId % host->failEvery == 0) {
+            result.error = std::make_exception_ptr(QtNetworkReplyException(QNetworkReply::RemoteHostClosedError, "Connection closed"));
+        }
+        else {
+            result.data = getBoxArtImage();
+        }
+
+        callback(result);
+    });
+}
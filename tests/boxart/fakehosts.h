@@ -0,0 +1,35 @@
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+// A host serving box art for apps 1 to imageCount on a loopback port
+struct FakeHost
+{
+    QString uuid;
+    uint16_t port;
+    int imageCount;
+
+    // The first request for every app ID divisible by this fails
+    int failEvery;
+
+    // Every box art request, in the order they were sent
+    struct Request {
+        int appId;
+        int attempt;
+    };
+    QVector<Request> requests;
+
+    QHash<int, int> attempts;
+    int requestsInFlight;
+    int maxRequestsInFlight;
+};
+
+namespace FakeHosts
+{
+    void add(FakeHost* host);
+
+    // Most requests in flight at once across all hosts
+    int maxRequestsInFlight();
+}
@@ -0,0 +1,221 @@
+// Loads box art for two fake hosts with 500 apps each through
+// BoxArtManager, the way the app grid asks for it: every tile in order,
+// then some tiles scroll away and one scrolls back.
+//
+// Checks that each host gets at most 4 requests at once and all hosts at
+// most 8, that the most recently requested art is fetched first, that
+// failed fetches are retried once behind the rest, and that cancelled art
+// is never fetched.
+//
+// Exits with a non-zero status if any check fails.
+
+#include "fakehosts.h"
+
+#include "backend/boxartmanager.h"
+#include "path.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QSet>
+#include <QTemporaryDir>
+#include <QTimer>
+
+#include <cstdio>
+
+// Must match boxartmanager.cpp
+#define MAX_FETCHES_PER_HOST 4
+#define MAX_CONCURRENT_FETCHES 8
+
+#define IMAGE_COUNT 500
+#define FAIL_EVERY 50
+#define BASE_PORT 47989
+
+// Tiles that scroll out of view on the first host, and one that comes back
+#define CANCEL_FIRST 201
+#define CANCEL_LAST 300
+#define REQUEST_AGAIN 250
+
+#define TIMEOUT_MS 30000
+
+static bool isCancelled(int hostIndex, int appId)
+{
+    return hostIndex == 0 && appId >= CANCEL_FIRST && appId <= CANCEL_LAST && appId != REQUEST_AGAIN;
+}
+
+// First attempts go out newest request first, after the ones that started
+// right away while the host had free slots
+static QVector<int> getExpectedOrder(int hostIndex)
+{
+    QVector<int> order;
+
+    for (int appId = 1; appId <= MAX_FETCHES_PER_HOST; appId++) {
+        order.append(appId);
+    }
+    if (hostIndex == 0) {
+        order.append(REQUEST_AGAIN);
+    }
+    for (int appId = IMAGE_COUNT; appId > MAX_FETCHES_PER_HOST; appId--) {
+        if (!isCancelled(hostIndex, appId) && !(hostIndex == 0 && appId == REQUEST_AGAIN)) {
+            order.append(appId);
+        }
+    }
+
+    return order;
+}
+
+static bool checkHost(int hostIndex, const FakeHost& host, int completions)
+{
+    QVector<int> firstAttempts;
+    int lastFirstAttempt = -1, firstRetry = -1;
+    int retries = 0, wrongRetries = 0;
+
+    for (int i = 0; i < host.requests.size(); i++) {
+        const FakeHost::Request& request = host.requests[i];
+        if (request.attempt == 1) {
+            firstAttempts.append(request.appId);
+            lastFirstAttempt = i;
+        }
+        else {
+            if (firstRetry < 0) {
+                firstRetry = i;
+            }
+            if (request.attempt > 2 || request.appId % FAIL_EVERY != 0) {
+                wrongRetries++;
+            }
+            retries++;
+        }
+    }
+
+    int cancelledFetches = 0;
+    for (int appId = 1; appId <= IMAGE_COUNT; appId++) {
+        if (isCancelled(hostIndex, appId) && host.attempts.contains(appId)) {
+            cancelledFetches++;
+        }
+    }
+
+    QVector<int> expectedOrder = getExpectedOrder(hostIndex);
+    int expectedRetries = 0;
+    for (int appId : expectedOrder) {
+        if (appId % FAIL_EVERY == 0) {
+            expectedRetries++;
+        }
+    }
+
+    bool inOrder = firstAttempts == expectedOrder;
+    bool retriesLast = firstRetry < 0 || firstRetry > lastFirstAttempt;
+
+    bool passed = inOrder && retriesLast &&
+                  retries == expectedRetries && wrongRetries == 0 &&
+                  cancelledFetches == 0 &&
+                  completions == expectedOrder.size() &&
+                  host.maxRequestsInFlight == MAX_FETCHES_PER_HOST;
+
+    printf("%s %s: %d loaded, %d requests, %d retries, %d cancelled fetched, %d at once, %s, retries %s\n",
+           qPrintable(host.uuid),
+           passed ? "PASS" : "FAIL",
+           completions,
+           (int)host.requests.size(),
+           retries,
+           cancelledFetches,
+           host.maxRequestsInFlight,
+           inOrder ? "newest first" : "out of order",
+           retriesLast ? "last" : "early");
+
+    return passed;
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    // Keep the cache away from a real install
+    QTemporaryDir tempDir;
+    if (!tempDir.isValid()) {
+        printf("FAIL: unable to create a temporary directory\n");
+        return 1;
+    }
+    QDir::setCurrent(tempDir.path());
+    Path::initialize(true);
+
+    FakeHost hosts[2];
+    NvComputer computers[2];
+    QVector<NvApp> appLists[2];
+    for (int i = 0; i < 2; i++) {
+        hosts[i].uuid = QString("HOST-%1").arg((char)('A' + i));
+        hosts[i].port = (uint16_t)(BASE_PORT + i);
+        hosts[i].imageCount = IMAGE_COUNT;
+        hosts[i].failEvery = FAIL_EVERY;
+        FakeHosts::add(&hosts[i]);
+
+        computers[i].name = hosts[i].uuid;
+        computers[i].uuid = hosts[i].uuid;
+        computers[i].activeAddress = NvAddress(QString("127.0.0.1"), hosts[i].port);
+        computers[i].activeHttpsPort = 0;
+
+        for (int appId = 1; appId <= IMAGE_COUNT; appId++) {
+            NvApp nvApp;
+            nvApp.id = appId;
+            nvApp.name = QString("Game %1").arg(appId);
+            appLists[i].append(nvApp);
+        }
+    }
+
+    BoxArtManager manager;
+
+    int completions[2] = {};
+    int expectedCompletions = getExpectedOrder(0).size() + getExpectedOrder(1).size();
+    QObject::connect(&manager, &BoxArtManager::boxArtLoadComplete,
+                     [&](NvComputer* computer, NvApp, QUrl) {
+        completions[computer == &computers[0] ? 0 : 1]++;
+        if (completions[0] + completions[1] == expectedCompletions) {
+            app.quit();
+        }
+    });
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // Tiles are created in order, alternating between the hosts' grids
+    int placeholders = 0;
+    for (int i = 0; i < IMAGE_COUNT; i++) {
+        for (int j = 0; j < 2; j++) {
+            if (manager.loadBoxArt(&computers[j], appLists[j][i]).scheme() == "qrc") {
+                placeholders++;
+            }
+        }
+    }
+
+    for (int appId = CANCEL_FIRST; appId <= CANCEL_LAST; appId++) {
+        manager.cancelBoxArt(&computers[0], appId);
+    }
+    manager.loadBoxArt(&computers[0], appLists[0][REQUEST_AGAIN - 1]);
+
+    QTimer::singleShot(TIMEOUT_MS, &app, &QCoreApplication::quit);
+    app.exec();
+
+    printf("%d images loaded in %lld ms, %d requests at once\n",
+           completions[0] + completions[1], (long long)timer.elapsed(), FakeHosts::maxRequestsInFlight());
+
+    bool passed = placeholders == IMAGE_COUNT * 2;
+    if (!passed) {
+        printf("FAIL: %d of %d uncached tiles got a placeholder\n", placeholders, IMAGE_COUNT * 2);
+    }
+
+    if (FakeHosts::maxRequestsInFlight() != MAX_CONCURRENT_FETCHES) {
+        printf("FAIL: expected %d requests at once\n", MAX_CONCURRENT_FETCHES);
+        passed = false;
+    }
+
+    for (int i = 0; i < 2; i++) {
+        passed = checkHost(i, hosts[i], completions[i]) && passed;
+    }
+
+    // Everything fetched is now served from the disk cache
+    if (manager.loadBoxArt(&computers[1], appLists[1][0]).scheme() != "file") {
+        printf("FAIL: loaded box art wasn't cached\n");
+        passed = false;
+    }
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,22 @@
+# Standalone benchmark of host persistence. It isn't part of the main build.
+# Built and run from tests.pro, or alone:
+#   qmake && make && ./hoststore
+TEMPLATE = app
+TARGET = hoststore
+QT = core network
+CONFIG += console c++11 testcase
+CONFIG -= app_bundle
+
+INCLUDEPATH += \
+    $$PWD/../../app \
+    $$PWD/../../moonlight-common-c/moonlight-common-c/src
+
+SOURCES += \
+    main.cpp \
+    standins.cpp \
+    ../../app/path.cpp \
+    ../../app/backend/hoststore.cpp \
+    ../../app/backend/nvcomputer.cpp \
+    ../../app/backend/nvxmlindex.cpp \
+    ../../app/backend/nvaddress.cpp \
+    ../../app/backend/nvapp.cpp
@@ -0,0 +1,192 @@
+// Measures how long it takes to persist 100 hosts with 200 apps each, and
+// how much is written, using the old single settings array and HostStore.
+// The HostStore flush follows the delayed flush thread in ComputerManager:
+// only hosts whose serialized digest changed are written.
+//
+// Exits with a non-zero status if a flush writes hosts that didn't change
+// or the stored hosts don't load back intact.
+
+#include "backend/hoststore.h"
+#include "path.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QHash>
+#include <QTemporaryDir>
+
+#include <algorithm>
+#include <cstdio>
+
+#define HOST_COUNT 100
+#define APPS_PER_HOST 200
+
+// Same keys as the legacy host array in hoststore.cpp
+#define SER_HOSTS "hosts"
+#define SER_HOSTS_BACKUP "hostsbackup"
+
+static NvComputer* createHost(int index)
+{
+    NvComputer* computer = new NvComputer();
+
+    computer->name = QString("Host %1").arg(index);
+    computer->uuid = QString("6E8B1D9C-0000-4000-8000-%1").arg(index, 12, 10, QChar('0'));
+    computer->hasCustomName = false;
+    computer->macAddress = QByteArray::fromHex("0011223344") + (char)index;
+    computer->localAddress = NvAddress(QString("192.168.1.%1").arg(index + 1), DEFAULT_HTTP_PORT);
+    computer->remoteAddress = NvAddress(QString("203.0.113.%1").arg(index + 1), DEFAULT_HTTP_PORT);
+    computer->isNvidiaServerSoftware = false;
+
+    for (int i = 0; i < APPS_PER_HOST; i++) {
+        NvApp app;
+        app.id = 1000 + i;
+        // Already in the order NvComputer sorts apps by when loading
+        app.name = QString("Game %1 on host %2").arg(i, 3, 10, QChar('0')).arg(index);
+        app.hdrSupported = i % 3 == 0;
+        computer->appList.append(app);
+    }
+
+    return computer;
+}
+
+static bool isSameHost(const NvComputer* a, const NvComputer* b)
+{
+    return a->name == b->name &&
+           a->uuid == b->uuid &&
+           a->macAddress == b->macAddress &&
+           a->localAddress.address() == b->localAddress.address() &&
+           a->localAddress.port() == b->localAddress.port() &&
+           a->remoteAddress.address() == b->remoteAddress.address() &&
+           a->remoteAddress.port() == b->remoteAddress.port() &&
+           a->appList == b->appList;
+}
+
+// What ComputerManager did on every flush before HostStore
+static qint64 flushLegacy(const QVector<NvComputer*>& computers, const QString& filePath)
+{
+    QSettings settings(filePath, QSettings::IniFormat);
+
+    settings.beginWriteArray(SER_HOSTS_BACKUP);
+    for (int i = 0; i < computers.size(); i++) {
+        settings.setArrayIndex(i);
+        computers[i]->serialize(settings, false);
+    }
+    settings.endArray();
+
+    settings.remove(SER_HOSTS);
+    settings.beginWriteArray(SER_HOSTS);
+    for (int i = 0; i < computers.size(); i++) {
+        settings.setArrayIndex(i);
+        computers[i]->serialize(settings, true);
+    }
+    settings.endArray();
+
+    settings.remove(SER_HOSTS_BACKUP);
+    settings.sync();
+
+    return QFileInfo(filePath).size();
+}
+
+static qint64 flushHostStore(const QVector<NvComputer*>& computers, QHash<QString, QByteArray>& lastSerializedHosts, int& hostsWritten)
+{
+    qint64 bytesWritten = 0;
+
+    hostsWritten = 0;
+    for (const NvComputer* computer : computers) {
+        QByteArray digest = computer->serializedDigest();
+        if (lastSerializedHosts.value(computer->uuid) == digest) {
+            continue;
+        }
+
+        qint64 bytes = HostStore::save(computer);
+        if (bytes < 0) {
+            return -1;
+        }
+
+        bytesWritten += bytes;
+        lastSerializedHosts[computer->uuid] = digest;
+        hostsWritten++;
+    }
+
+    return bytesWritten;
+}
+
+static void printFlush(const char* name, qint64 elapsedUs, int hostsWritten, qint64 bytesWritten)
+{
+    printf("%-28s %8.2f ms, %3d hosts, %9lld bytes\n",
+           name, elapsedUs / 1000.0, hostsWritten, (long long)bytesWritten);
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    // Keep the hosts and the legacy settings away from a real install
+    QTemporaryDir tempDir;
+    if (!tempDir.isValid()) {
+        printf("FAIL: unable to create a temporary directory\n");
+        return 1;
+    }
+    QDir::setCurrent(tempDir.path());
+    QSettings::setDefaultFormat(QSettings::IniFormat);
+    QSettings::setPath(QSettings::IniFormat, QSettings::UserScope, tempDir.path());
+    Path::initialize(true);
+
+    QVector<NvComputer*> computers;
+    for (int i = 0; i < HOST_COUNT; i++) {
+        computers.append(createHost(i));
+    }
+
+    bool passed = true;
+    QElapsedTimer timer;
+    qint64 bytes;
+    int hostsWritten;
+
+    timer.start();
+    bytes = flushLegacy(computers, tempDir.filePath("legacy.ini"));
+    printFlush("legacy array", timer.nsecsElapsed() / 1000, HOST_COUNT, bytes);
+
+    // The first flush after a migration writes every host
+    QHash<QString, QByteArray> lastSerializedHosts;
+    timer.restart();
+    bytes = flushHostStore(computers, lastSerializedHosts, hostsWritten);
+    printFlush("HostStore, all hosts", timer.nsecsElapsed() / 1000, hostsWritten, bytes);
+    passed = bytes >= 0 && hostsWritten == HOST_COUNT && passed;
+
+    // A poll that finds nothing new
+    timer.restart();
+    bytes = flushHostStore(computers, lastSerializedHosts, hostsWritten);
+    printFlush("HostStore, no changes", timer.nsecsElapsed() / 1000, hostsWritten, bytes);
+    passed = bytes == 0 && hostsWritten == 0 && passed;
+
+    // A host that came online at a new address
+    computers[HOST_COUNT / 2]->localAddress = NvAddress(QString("192.168.2.1"), DEFAULT_HTTP_PORT);
+    timer.restart();
+    bytes = flushHostStore(computers, lastSerializedHosts, hostsWritten);
+    printFlush("HostStore, one host changed", timer.nsecsElapsed() / 1000, hostsWritten, bytes);
+    passed = bytes > 0 && hostsWritten == 1 && passed;
+
+    timer.restart();
+    bool migrated;
+    QVector<NvComputer*> loaded = HostStore::load(migrated);
+    printf("%-28s %8.2f ms, %3d hosts\n", "HostStore load", timer.nsecsElapsed() / 1000000.0, (int)loaded.size());
+
+    int mismatches = 0;
+    for (const NvComputer* computer : computers) {
+        auto it = std::find_if(loaded.begin(), loaded.end(), [computer](const NvComputer* other) {
+            return other->uuid == computer->uuid;
+        });
+        if (it == loaded.end() || !isSameHost(*it, computer)) {
+            mismatches++;
+        }
+    }
+    printf("%d of %d hosts didn't load back intact\n", mismatches, HOST_COUNT);
+    passed = !migrated && loaded.size() == HOST_COUNT && mismatches == 0 && passed;
+
+    qDeleteAll(loaded);
+    qDeleteAll(computers);
+
+    printf("%s\n", passed ? "PASS" : "FAIL");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,36 @@
+// Stand-ins for the NvHTTP and CompatFetcher members that nvcomputer.cpp
+// links against. Only the serverinfo constructor uses them, and this
+// benchmark never calls it.
+
+#include "backend/nvhttp.h"
+#include "settings/compatfetcher.h"
+
+NvAddress NvHTTP::address()
+{
+    Q_UNREACHABLE();
+}
+
+QSslCertificate NvHTTP::serverCert()
+{
+    Q_UNREACHABLE();
+}
+
+uint16_t NvHTTP::httpPort()
+{
+    Q_UNREACHABLE();
+}
+
+int NvHTTP::getCurrentGame(const NvXmlIndex&)
+{
+    Q_UNREACHABLE();
+}
+
+QVector<NvDisplayMode> NvHTTP::getDisplayModeList(const NvXmlIndex&)
+{
+    Q_UNREACHABLE();
+}
+
+bool CompatFetcher::isGfeVersionSupported(QString)
+{
+    Q_UNREACHABLE();
+}
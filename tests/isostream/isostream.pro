@@ -0,0 +1,23 @@
+# Standalone check of isochronous IN streaming against the simulated device.
+# It isn't part of the main build. Built and run from tests.pro, or alone:
+#   qmake && make && ./isostream
+TEMPLATE = app
+TARGET = isostream
+QT = core
+CONFIG += console c++11 testcase
+CONFIG -= app_bundle
+
+CONFIG += link_pkgconfig
+PKGCONFIG += libusb-1.0
+
+INCLUDEPATH += $$PWD/../../app
+
+SOURCES += \
+    main.cpp \
+    ../../app/streaming/passthrough/usbipexporter.cpp \
+    ../../app/streaming/passthrough/simulateddevice.cpp \
+    ../../app/streaming/passthrough/isostream.cpp
+
+HEADERS += \
+    ../../app/streaming/passthrough/usbipexporter.h \
+    ../../app/streaming/passthrough/simulateddevice.h
@@ -0,0 +1,202 @@
+// Streams isochronous IN URBs from the simulated USB audio device through
+// UsbIpExporter, with the host keeping several URBs in flight the way a USB
+// audio driver does, and then stalling for a while before it resumes.
+//
+// Checks that the URBs are served by the exporter's IsoInStream, complete in
+// submission order with every frame in device order, that the jitter buffer
+// never grows past its cap, and that the only frames lost are the ones the
+// buffer reports dropping while the host was stalled.
+//
+// Exits with a non-zero status if any check fails.
+
+#include "streaming/passthrough/usbipexporter.h"
+
+#include <QCoreApplication>
+#include <QTimer>
+
+#include <cstdio>
+#include <cstring>
+
+#define PACKETS_PER_URB 8
+#define PACKET_BYTES 192
+#define URBS_IN_FLIGHT 3
+
+// IsoInStream holds at most four refills of its (default four) transfer ring
+#define MAX_BUFFERED_PACKETS (PACKETS_PER_URB * 4 * 4)
+
+#define STALL_AT_MS 1500
+#define STALL_MS 300
+#define RUN_MS 3000
+
+using MlptProtocol::UsbIpHeader;
+using MlptProtocol::UsbIpIsoPacket;
+
+int main(int argc, char** argv)
+{
+    qputenv("MLPT_SIMULATED_DEVICES", "iso");
+    QCoreApplication app(argc, argv);
+
+    UsbIpExporter exporter;
+    exporter.setDeviceId(1);
+    if (!exporter.openSimulatedDevice(SimulatedUsbDevice::KIND_ISO_AUDIO)) {
+        printf("FAIL: unable to open the simulated device\n");
+        return 1;
+    }
+
+    uint32_t nextSeqNum = 1;
+    uint32_t setInterfaceSeqNum = 0;
+    uint32_t lastSeqNum = 0;
+    int64_t lastFrame = -1;
+    uint64_t skippedFrames = 0;
+    uint64_t completions = 0;
+    int errors = 0;
+    int maxBuffered = 0;
+    bool stalled = false;
+    IsoInStream::Stats finalStats = {};
+    bool haveStats = false;
+
+    auto submitIsoUrb = [&]() {
+        UsbIpHeader header = {};
+        header.seqNum = nextSeqNum++;
+        header.deviceId = 1;
+        header.direction = MlptProtocol::USB_DIR_IN;
+        header.endpoint = 3;
+        header.transferType = MlptProtocol::USB_XFER_ISOCHRONOUS;
+        header.dataLen = PACKETS_PER_URB * PACKET_BYTES;
+        header.numIsoPackets = PACKETS_PER_URB;
+
+        QByteArray isoDescs;
+        for (int i = 0; i < PACKETS_PER_URB; i++) {
+            UsbIpIsoPacket iso = {};
+            iso.offset = i * PACKET_BYTES;
+            iso.length = PACKET_BYTES;
+            isoDescs.append(reinterpret_cast<const char*>(&iso), sizeof(iso));
+        }
+
+        exporter.submitUrb(header, isoDescs);
+    };
+
+    auto sampleStats = [&]() {
+        QList<IsoInStream::Stats> stats = exporter.isoStreamStats();
+        if (!stats.isEmpty()) {
+            finalStats = stats.first();
+            haveStats = true;
+            maxBuffered = qMax(maxBuffered, finalStats.bufferedPackets);
+        }
+    };
+
+    QObject::connect(&exporter, &UsbIpExporter::urbCompleted,
+                     [&](uint32_t, const UsbIpHeader& resp, const QByteArray& data) {
+        if (resp.seqNum == setInterfaceSeqNum) {
+            for (int i = 0; i < URBS_IN_FLIGHT; i++) {
+                submitIsoUrb();
+            }
+            return;
+        }
+
+        completions++;
+
+        if (resp.seqNum <= lastSeqNum) {
+            printf("URB %u completed after URB %u\n", resp.seqNum, lastSeqNum);
+            errors++;
+        }
+        lastSeqNum = resp.seqNum;
+
+        uint32_t descOffset = resp.dataLen;
+        if (resp.status != 0 || resp.numIsoPackets != PACKETS_PER_URB ||
+                data.size() != static_cast<int>(descOffset + PACKETS_PER_URB * sizeof(UsbIpIsoPacket))) {
+            printf("URB %u failed with status %d (%d bytes)\n", resp.seqNum, resp.status, data.size());
+            errors++;
+            return;
+        }
+
+        // Packed frames followed by their descriptors
+        uint32_t frameOffset = 0;
+        for (int i = 0; i < PACKETS_PER_URB; i++) {
+            UsbIpIsoPacket iso;
+            memcpy(&iso, data.constData() + descOffset + i * sizeof(iso), sizeof(iso));
+            if (iso.status != 0 || iso.actualLength != PACKET_BYTES) {
+                printf("URB %u packet %d: status %d, %u bytes\n", resp.seqNum, i, iso.status, iso.actualLength);
+                errors++;
+                return;
+            }
+
+            uint32_t frame;
+            memcpy(&frame, data.constData() + frameOffset, sizeof(frame));
+            frameOffset += iso.actualLength;
+
+            if (static_cast<int64_t>(frame) <= lastFrame) {
+                printf("URB %u packet %d: frame %u after frame %lld\n",
+                       resp.seqNum, i, frame, static_cast<long long>(lastFrame));
+                errors++;
+            }
+            else {
+                skippedFrames += frame - (lastFrame + 1);
+            }
+            lastFrame = frame;
+        }
+
+        sampleStats();
+
+        // Like a USB audio driver, resubmit from the completion
+        if (!stalled) {
+            submitIsoUrb();
+        }
+    });
+
+    // Select the streaming alternate setting, then start the URBs
+    UsbIpHeader setInterface = {};
+    setInterface.seqNum = setInterfaceSeqNum = nextSeqNum++;
+    setInterface.deviceId = 1;
+    setInterface.direction = MlptProtocol::USB_DIR_OUT;
+    setInterface.transferType = MlptProtocol::USB_XFER_CONTROL;
+    setInterface.flags = 1;
+    const uint8_t setup[8] = { 0x01, 0x0B, 1, 0, 0, 0, 0, 0 };
+    memcpy(setInterface.setupPacket, setup, sizeof(setup));
+    exporter.submitUrb(setInterface, QByteArray());
+
+    // The buffer only fills up while nothing is completing, so watch it from a timer too
+    QTimer sampleTimer;
+    QObject::connect(&sampleTimer, &QTimer::timeout, sampleStats);
+    sampleTimer.start(5);
+
+    QTimer::singleShot(STALL_AT_MS, [&]() {
+        stalled = true;
+    });
+    QTimer::singleShot(STALL_AT_MS + STALL_MS, [&]() {
+        stalled = false;
+        for (int i = 0; i < URBS_IN_FLIGHT; i++) {
+            submitIsoUrb();
+        }
+    });
+    QTimer::singleShot(RUN_MS, &app, &QCoreApplication::quit);
+
+    app.exec();
+    sampleStats();
+
+    // Every frame the host missed must have been dropped by the buffer (the
+    // first frame served is frame 0, so skippedFrames also covers the start)
+    uint64_t expectedCompletions = (RUN_MS - STALL_MS) / PACKETS_PER_URB / 2;
+    bool passed = errors == 0 && haveStats &&
+                  completions >= expectedCompletions &&
+                  finalStats.hostUrbs == completions &&
+                  maxBuffered <= MAX_BUFFERED_PACKETS &&
+                  finalStats.overruns > 0 &&
+                  skippedFrames == finalStats.overruns &&
+                  finalStats.underruns == 0;
+
+    printf("%s: %llu URBs in order, %llu device packets, buffer peak %d packets (target %d), "
+           "%llu overruns, %llu frames skipped, %llu underruns, turnaround %.1f ms\n",
+           passed ? "PASS" : "FAIL",
+           static_cast<unsigned long long>(completions),
+           static_cast<unsigned long long>(finalStats.devicePackets),
+           maxBuffered,
+           finalStats.targetDepth,
+           static_cast<unsigned long long>(finalStats.overruns),
+           static_cast<unsigned long long>(skippedFrames),
+           static_cast<unsigned long long>(finalStats.underruns),
+           finalStats.turnaroundMs);
+
+    exporter.closeDevice();
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,26 @@
+# Standalone check of NvHTTP connection reuse against a local TLS server. It
+# isn't part of the main build. Built and run from tests.pro, or alone:
+#   qmake && make && ./keepalive
+TEMPLATE = app
+TARGET = keepalive
+QT = core gui network
+CONFIG += console c++11 testcase
+CONFIG -= app_bundle
+
+INCLUDEPATH += \
+    $$PWD/../../app \
+    $$PWD/../../moonlight-common-c/moonlight-common-c/src
+
+SOURCES += \
+    main.cpp \
+    standins.cpp \
+    tlsserver.cpp \
+    ../../app/backend/nvhttp.cpp \
+    ../../app/backend/nvxmlindex.cpp \
+    ../../app/backend/nvaddress.cpp \
+    ../../app/backend/nvapp.cpp
+
+HEADERS += \
+    testidentity.h \
+    tlsserver.h \
+    ../../app/backend/nvhttp.h
@@ -0,0 +1,106 @@
+// Polls a local TLS server with NvHTTP, first as for a GFE host (a new
+// connection per request) and then as for a host that allows connection
+// reuse, counting the TLS handshakes each one takes on both ends.
+//
+// Exits with a non-zero status if requests fail, a reused connection is
+// handshaken more than once, or NvHTTP's own handshake count disagrees
+// with the server's.
+
+#include "tlsserver.h"
+#include "testidentity.h"
+
+#include "backend/nvhttp.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTimer>
+
+#include <cstdio>
+#include <functional>
+
+#define REQUEST_COUNT 50
+
+// Requests are spaced out like polls, just closer together
+#define REQUEST_INTERVAL_MS 20
+
+#define TIMEOUT_MS 30000
+
+static bool runScenario(TlsServer& server, const char* name, bool connectionReuse)
+{
+    NvHTTP http(NvAddress(QString("127.0.0.1"), server.serverPort()), server.serverPort(),
+                QSslCertificate(QByteArray(TEST_CERTIFICATE_PEM)));
+    http.setConnectionReuse(connectionReuse);
+
+    int requests, tlsHandshakes;
+    qint64 totalRequestTimeMs;
+    NvHTTP::takeConnectionStats(requests, tlsHandshakes, totalRequestTimeMs);
+    server.resetCounters();
+
+    int completed = 0, failed = 0;
+    QEventLoop loop;
+    QElapsedTimer timer;
+
+    std::function<void()> sendRequest = [&]() {
+        http.getServerInfoAsync(NvHTTP::NVLL_ERROR, false, [&](const NvHttpResult& result) {
+            if (!result.ok()) {
+                failed++;
+            }
+
+            if (++completed == REQUEST_COUNT) {
+                loop.quit();
+            }
+            else {
+                QTimer::singleShot(REQUEST_INTERVAL_MS, &loop, sendRequest);
+            }
+        });
+    };
+
+    timer.start();
+    sendRequest();
+    QTimer::singleShot(TIMEOUT_MS, &loop, &QEventLoop::quit);
+    loop.exec();
+    qint64 elapsedMs = timer.elapsed();
+
+    NvHTTP::takeConnectionStats(requests, tlsHandshakes, totalRequestTimeMs);
+
+    int expectedHandshakes = connectionReuse ? 1 : REQUEST_COUNT;
+    bool passed = completed == REQUEST_COUNT && failed == 0 &&
+                  server.tlsHandshakes() == expectedHandshakes &&
+                  tlsHandshakes == server.tlsHandshakes();
+
+    printf("%-20s %s: %d requests (%d failed) over %d connections, %d TLS handshakes (%d counted by NvHTTP), "
+           "%.1f ms per request, %lld ms total\n",
+           name,
+           passed ? "PASS" : "FAIL",
+           completed,
+           failed,
+           server.connections(),
+           server.tlsHandshakes(),
+           tlsHandshakes,
+           requests > 0 ? (double)totalRequestTimeMs / requests : 0.0,
+           (long long)elapsedMs);
+
+    return passed;
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    TlsServer server;
+    if (!server.listen(QHostAddress::LocalHost)) {
+        printf("FAIL: unable to listen: %s\n", qPrintable(server.errorString()));
+        return 1;
+    }
+
+    bool passed = true;
+    passed = runScenario(server, "no reuse (GFE)", false) && passed;
+    passed = runScenario(server, "keep-alive", true) && passed;
+
+    // Let NvHTTP shut its network thread down the way it does when the app exits
+    QTimer::singleShot(0, &app, &QCoreApplication::quit);
+    app.exec();
+
+    return passed ? 0 : 1;
+}
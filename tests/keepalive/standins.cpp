@@ -0,0 +1,37 @@
+// Stand-ins for the client identity and the moonlight-common-c function
+// that nvhttp.cpp links against, so it can be built without OpenSSL or
+// the streaming library.
+
+#include "testidentity.h"
+
+#include "backend/identitymanager.h"
+
+#include <Limelight.h>
+
+IdentityManager* IdentityManager::s_Im = nullptr;
+
+IdentityManager::IdentityManager()
+{
+}
+
+IdentityManager* IdentityManager::get()
+{
+    if (s_Im == nullptr) {
+        s_Im = new IdentityManager();
+    }
+    return s_Im;
+}
+
+QSslConfiguration IdentityManager::getSslConfig()
+{
+    QSslConfiguration sslConfig(QSslConfiguration::defaultConfiguration());
+    sslConfig.setLocalCertificate(QSslCertificate(QByteArray(TEST_CERTIFICATE_PEM)));
+    sslConfig.setPrivateKey(QSslKey(QByteArray(TEST_PRIVATE_KEY_PEM), QSsl::Rsa));
+    return sslConfig;
+}
+
+const char* LiGetLaunchUrlQueryParameters()
+{
+    // Only used to launch apps, which this test never does
+    return "";
+}
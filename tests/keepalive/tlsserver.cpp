@@ -0,0 +1,87 @@
+#include "tlsserver.h"
+#include "testidentity.h"
+
+#include <QSslKey>
+
+#define SERVERINFO_RESPONSE \
+    "<?xml version=\"1.0\" encoding=\"utf-8\"?>" \
+    "<root status_code=\"200\">" \
+    "<hostname>KEEPALIVE-TEST</hostname>" \
+    "<uniqueid>0123456789ABCDEF</uniqueid>" \
+    "<PairStatus>1</PairStatus>" \
+    "<state>SUNSHINE_SERVER_FREE</state>" \
+    "</root>"
+
+TlsServer::TlsServer(QObject* parent) :
+    QTcpServer(parent)
+{
+    resetCounters();
+}
+
+void TlsServer::resetCounters()
+{
+    m_Connections = 0;
+    m_TlsHandshakes = 0;
+    m_Requests = 0;
+}
+
+void TlsServer::incomingConnection(qintptr socketDescriptor)
+{
+    QSslSocket* socket = new QSslSocket(this);
+    if (!socket->setSocketDescriptor(socketDescriptor)) {
+        delete socket;
+        return;
+    }
+
+    m_Connections++;
+
+    // Ask for the client certificate like a host does, so each handshake
+    // costs what it would in practice
+    socket->setLocalCertificate(QSslCertificate(QByteArray(TEST_CERTIFICATE_PEM)));
+    socket->setPrivateKey(QSslKey(QByteArray(TEST_PRIVATE_KEY_PEM), QSsl::Rsa));
+    socket->setPeerVerifyMode(QSslSocket::QueryPeer);
+
+    connect(socket, &QSslSocket::encrypted, this, [this]() {
+        m_TlsHandshakes++;
+    });
+    connect(socket, &QSslSocket::readyRead, this, &TlsServer::handleReadyRead);
+    connect(socket, &QSslSocket::disconnected, this, [this, socket]() {
+        m_Buffers.remove(socket);
+        socket->deleteLater();
+    });
+
+    socket->startServerEncryption();
+}
+
+void TlsServer::handleReadyRead()
+{
+    QSslSocket* socket = qobject_cast<QSslSocket*>(sender());
+    QByteArray& buffer = m_Buffers[socket];
+
+    buffer += socket->readAll();
+
+    // Requests are all GETs, so each one ends with its headers
+    int end;
+    while ((end = buffer.indexOf("\r\n\r\n")) >= 0) {
+        QByteArray headers = buffer.left(end).toLower();
+        buffer.remove(0, end + 4);
+        m_Requests++;
+
+        bool close = headers.contains("\r\nconnection: close");
+
+        QByteArray body(SERVERINFO_RESPONSE);
+        QByteArray response = "HTTP/1.1 200 OK\r\n"
+                              "Content-Type: application/xml\r\n"
+                              "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+        if (close) {
+            response += "Connection: close\r\n";
+        }
+        response += "\r\n" + body;
+
+        socket->write(response);
+        if (close) {
+            socket->disconnectFromHost();
+            break;
+        }
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <QHash>
+#include <QSslSocket>
+#include <QTcpServer>
+
+// Answers HTTPS serverinfo requests the way a host does, keeping each
+// connection open between requests unless the client asks to close it.
+class TlsServer : public QTcpServer
+{
+    Q_OBJECT
+
+public:
+    explicit TlsServer(QObject* parent = nullptr);
+
+    void resetCounters();
+
+    int connections() const { return m_Connections; }
+    int tlsHandshakes() const { return m_TlsHandshakes; }
+    int requests() const { return m_Requests; }
+
+protected:
+    void incomingConnection(qintptr socketDescriptor) override;
+
+private slots:
+    void handleReadyRead();
+
+private:
+    QHash<QSslSocket*, QByteArray> m_Buffers;
+    int m_Connections;
+    int m_TlsHandshakes;
+    int m_Requests;
+};
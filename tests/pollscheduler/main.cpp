@@ -0,0 +1,223 @@
+// Runs PollScheduler against a few hundred simulated hosts: most answer
+// after a short delay, some are only reachable on the second of their two
+// addresses, a few never answer, and one is shown in the UI.
+//
+// Checks that no more hosts are polled at once than the scheduler allows,
+// that online hosts are polled at the normal rate and the focused one at
+// the fast rate, that a host's addresses are raced rather than tried in
+// turn, and that offline hosts back off exponentially.
+//
+// Exits with a non-zero status if any check fails.
+
+#include "simulatedhosts.h"
+
+#include "backend/nvcomputer.h"
+#include "backend/pollscheduler.h"
+
+#include <QCoreApplication>
+#include <QTimer>
+
+#include <cstdio>
+#include <ctime>
+#include <memory>
+#include <vector>
+
+// Must match pollscheduler.cpp
+#define MAX_CONCURRENT_POLLS 8
+#define FOCUSED_POLL_INTERVAL_MS 1000
+#define POLL_INTERVAL_MS 3000
+#define MAX_OFFLINE_POLL_INTERVAL_MS 30000
+
+#define ONLINE_HOSTS 240
+#define RACING_HOSTS 20
+#define OFFLINE_HOSTS 10
+#define BASE_PORT 40000
+
+// Long enough for offline hosts to back off twice
+#define RUN_MS 25000
+#define SETTLE_MS 5000
+
+enum HostKind {
+    HOST_ONLINE,
+    HOST_FOCUSED,
+    HOST_RACING,
+    HOST_OFFLINE,
+};
+
+struct TestHost {
+    HostKind kind;
+    SimulatedHost sim;
+    NvComputer computer;
+};
+
+static double meanPollIntervalMs(const std::vector<std::unique_ptr<TestHost>>& hosts, HostKind kind, int& worstMs)
+{
+    qint64 total = 0;
+    int intervals = 0;
+    worstMs = 0;
+
+    for (const auto& host : hosts) {
+        if (host->kind != kind) {
+            continue;
+        }
+
+        const QVector<SimulatedHost::Request>& requests = host->sim.requests;
+        for (int i = 1; i < requests.size(); i++) {
+            if (requests[i - 1].startMs < SETTLE_MS) {
+                continue;
+            }
+            int intervalMs = (int)(requests[i].startMs - requests[i - 1].startMs);
+            worstMs = qMax(worstMs, intervalMs);
+            total += intervalMs;
+            intervals++;
+        }
+    }
+
+    return intervals > 0 ? (double)total / intervals : 0;
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    std::vector<std::unique_ptr<TestHost>> hosts;
+    for (int i = 0; i < ONLINE_HOSTS + RACING_HOSTS + OFFLINE_HOSTS; i++) {
+        auto host = std::unique_ptr<TestHost>(new TestHost());
+        uint16_t port = (uint16_t)(BASE_PORT + i);
+
+        if (i == 0) {
+            host->kind = HOST_FOCUSED;
+        }
+        else if (i < ONLINE_HOSTS) {
+            host->kind = HOST_ONLINE;
+        }
+        else if (i < ONLINE_HOSTS + RACING_HOSTS) {
+            host->kind = HOST_RACING;
+        }
+        else {
+            host->kind = HOST_OFFLINE;
+        }
+
+        host->sim.uuid = QString("HOST-%1").arg(i);
+        host->sim.port = port;
+        host->sim.online = host->kind != HOST_OFFLINE;
+        host->sim.latencyMs = 5 + (i * 7) % 40;
+        SimulatedHosts::add(&host->sim);
+
+        NvComputer& computer = host->computer;
+        computer.name = host->sim.uuid;
+        computer.uuid = host->sim.uuid;
+        computer.state = NvComputer::CS_UNKNOWN;
+        computer.pairState = NvComputer::PS_UNKNOWN;
+        computer.activeHttpsPort = 0;
+        computer.isNvidiaServerSoftware = false;
+        computer.hasCustomName = false;
+        if (host->kind == HOST_RACING) {
+            // The first candidate address never answers
+            computer.localAddress = NvAddress(QString("127.0.0.2"), port);
+            computer.remoteAddress = NvAddress(QString(SimulatedHosts::REACHABLE_ADDRESS), port);
+        }
+        else {
+            computer.localAddress = NvAddress(QString(SimulatedHosts::REACHABLE_ADDRESS), port);
+        }
+        computer.activeAddress = computer.localAddress;
+
+        hosts.push_back(std::move(host));
+    }
+
+    QObject focusOwner;
+    PollScheduler scheduler;
+    for (const auto& host : hosts) {
+        scheduler.addComputer(&host->computer);
+    }
+    scheduler.setFocusedComputer(&hosts[0]->computer, &focusOwner);
+
+    std::clock_t cpuStart = std::clock();
+    QTimer::singleShot(RUN_MS, &app, &QCoreApplication::quit);
+    app.exec();
+    double cpuMs = (std::clock() - cpuStart) * 1000.0 / CLOCKS_PER_SEC;
+
+    int failures = 0;
+
+    int polls = 0, requests = 0;
+    for (const auto& host : hosts) {
+        requests += host->sim.requests.size();
+        polls += host->kind == HOST_RACING ? host->sim.requests.size() / 2 : host->sim.requests.size();
+    }
+
+    int maxBusyHosts = SimulatedHosts::maxBusyHosts();
+    printf("%d hosts: %.1f polls/sec, %.1f requests/sec, %d hosts polled at once, %.0f ms CPU\n",
+           (int)hosts.size(), polls * 1000.0 / RUN_MS, requests * 1000.0 / RUN_MS, maxBusyHosts, cpuMs);
+    if (maxBusyHosts > MAX_CONCURRENT_POLLS) {
+        printf("FAIL: more than %d hosts were polled at once\n", MAX_CONCURRENT_POLLS);
+        failures++;
+    }
+
+    // Scheduling delays only ever stretch intervals, so allow for them above
+    int worstMs;
+    double onlineMs = meanPollIntervalMs(hosts, HOST_ONLINE, worstMs);
+    printf("online:  %.0f ms between polls on average, %d ms at worst\n", onlineMs, worstMs);
+    if (onlineMs < POLL_INTERVAL_MS || onlineMs > POLL_INTERVAL_MS * 1.3) {
+        printf("FAIL: online hosts aren't polled every %d ms\n", POLL_INTERVAL_MS);
+        failures++;
+    }
+
+    double focusedMs = meanPollIntervalMs(hosts, HOST_FOCUSED, worstMs);
+    printf("focused: %.0f ms between polls on average, %d ms at worst\n", focusedMs, worstMs);
+    if (focusedMs < FOCUSED_POLL_INTERVAL_MS || focusedMs > FOCUSED_POLL_INTERVAL_MS * 1.5) {
+        printf("FAIL: the focused host isn't polled every %d ms\n", FOCUSED_POLL_INTERVAL_MS);
+        failures++;
+    }
+
+    // Both addresses of a racing host are asked at once, so the poll takes
+    // as long as the reachable one and not the timeout of the other
+    int racedPolls = 0, slowRaces = 0;
+    for (const auto& host : hosts) {
+        if (host->kind != HOST_RACING) {
+            continue;
+        }
+
+        const QVector<SimulatedHost::Request>& requests = host->sim.requests;
+        for (int i = 0; i + 1 < requests.size(); i += 2) {
+            const SimulatedHost::Request& reachable =
+                    requests[i].address == QLatin1String(SimulatedHosts::REACHABLE_ADDRESS) ? requests[i] : requests[i + 1];
+            if (requests[i].address == requests[i + 1].address ||
+                    qAbs(requests[i + 1].startMs - requests[i].startMs) > 50 ||
+                    !reachable.ok || reachable.endMs - requests[i].startMs > SimulatedHosts::UNREACHABLE_TIMEOUT_MS / 2) {
+                slowRaces++;
+            }
+            racedPolls++;
+        }
+    }
+    printf("racing:  %d polls, %d not raced\n", racedPolls, slowRaces);
+    if (racedPolls == 0 || slowRaces > 0) {
+        printf("FAIL: candidate addresses weren't raced\n");
+        failures++;
+    }
+
+    // Each failed poll doubles the wait before the next one
+    int offlinePolls = 0, shortWaits = 0;
+    for (const auto& host : hosts) {
+        if (host->kind != HOST_OFFLINE) {
+            continue;
+        }
+
+        const QVector<SimulatedHost::Request>& requests = host->sim.requests;
+        for (int i = 1; i < requests.size(); i++) {
+            qint64 waitMs = requests[i].startMs - requests[i - 1].endMs;
+            int backoffMs = qMin(POLL_INTERVAL_MS << qMin(i - 1, 4), MAX_OFFLINE_POLL_INTERVAL_MS);
+            if (requests[i - 1].endMs < 0 || waitMs < backoffMs - 50) {
+                shortWaits++;
+            }
+        }
+        offlinePolls += requests.size();
+    }
+    printf("offline: %d polls, %d without backoff\n", offlinePolls, shortWaits);
+    if (offlinePolls == 0 || shortWaits > 0) {
+        printf("FAIL: offline hosts didn't back off\n");
+        failures++;
+    }
+
+    printf("%s\n", failures == 0 ? "PASS" : "FAIL");
+    return failures == 0 ? 0 : 1;
+}
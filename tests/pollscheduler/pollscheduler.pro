@@ -0,0 +1,25 @@
+# Standalone check of PollScheduler against simulated hosts. It isn't part of
+# the main build. Built and run from tests.pro, or alone:
+#   qmake && make && ./pollscheduler
+TEMPLATE = app
+TARGET = pollscheduler
+QT = core network
+CONFIG += console c++11 testcase
+CONFIG -= app_bundle
+
+INCLUDEPATH += \
+    $$PWD/../../app \
+    $$PWD/../../moonlight-common-c/moonlight-common-c/src
+
+SOURCES += \
+    main.cpp \
+    simulatedhosts.cpp \
+    ../../app/backend/pollscheduler.cpp \
+    ../../app/backend/nvxmlindex.cpp \
+    ../../app/backend/nvaddress.cpp \
+    ../../app/backend/nvapp.cpp
+
+HEADERS += \
+    simulatedhosts.h \
+    ../../app/backend/nvhttp.h \
+    ../../app/backend/pollscheduler.h
@@ -0,0 +1,197 @@
+// Stand-ins for the parts of NvHTTP and NvComputer used by PollScheduler.
+// Requests are answered from the SimulatedHost table after the host's
+// latency instead of going over the network.
+
+#include "simulatedhosts.h"
+
+#include "backend/nvcomputer.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QTimer>
+
+#include <memory>
+
+static QHash<uint16_t, SimulatedHost*> s_Hosts;
+static QElapsedTimer s_Clock;
+static int s_BusyHosts;
+static int s_MaxBusyHosts;
+
+void SimulatedHosts::add(SimulatedHost* host)
+{
+    if (!s_Clock.isValid()) {
+        s_Clock.start();
+    }
+
+    host->requestsInFlight = 0;
+    s_Hosts.insert(host->port, host);
+}
+
+qint64 SimulatedHosts::elapsedMs()
+{
+    return s_Clock.elapsed();
+}
+
+int SimulatedHosts::maxBusyHosts()
+{
+    return s_MaxBusyHosts;
+}
+
+// Tracks one request for the busy host count until it completes or its
+// NvHTTP is deleted, which drops the pending callback holding this
+class InFlightRequest
+{
+public:
+    InFlightRequest(SimulatedHost* host, int index)
+        : m_Host(host), m_Index(index), m_Done(false)
+    {
+        if (m_Host->requestsInFlight++ == 0) {
+            s_MaxBusyHosts = qMax(s_MaxBusyHosts, ++s_BusyHosts);
+        }
+    }
+
+    ~InFlightRequest()
+    {
+        finish();
+    }
+
+    void complete(bool ok)
+    {
+        m_Host->requests[m_Index].endMs = SimulatedHosts::elapsedMs();
+        m_Host->requests[m_Index].ok = ok;
+        finish();
+    }
+
+private:
+    void finish()
+    {
+        if (!m_Done) {
+            m_Done = true;
+            if (--m_Host->requestsInFlight == 0) {
+                s_BusyHosts--;
+            }
+        }
+    }
+
+    SimulatedHost* m_Host;
+    int m_Index;
+    bool m_Done;
+};
+
+// ─── NvHTTP ───
+
+NvHTTP::NvHTTP(NvAddress address, uint16_t, QSslCertificate serverCert, QNetworkAccessManager* nam) :
+    m_Address(address),
+    m_Nam(nam),
+    m_ServerCert(serverCert),
+    m_AllowConnectionReuse(false)
+{
+}
+
+NvHTTP::NvHTTP(NvComputer* computer, QNetworkAccessManager* nam) :
+    NvHTTP(computer->activeAddress, computer->activeHttpsPort, computer->serverCert, nam)
+{
+}
+
+bool NvHTTP::isConnectionReuseSupported(const NvComputer*)
+{
+    return false;
+}
+
+void NvHTTP::setConnectionReuse(bool allow)
+{
+    m_AllowConnectionReuse = allow;
+}
+
+void NvHTTP::takeConnectionStats(int& requests, int& tlsHandshakes, qint64& totalRequestTimeMs)
+{
+    requests = tlsHandshakes = 0;
+    totalRequestTimeMs = 0;
+}
+
+NvAddress NvHTTP::address()
+{
+    return m_Address;
+}
+
+void NvHTTP::getServerInfoAsync(NvLogLevel, bool, ResultCallback callback)
+{
+    SimulatedHost* host = s_Hosts.value(m_Address.port());
+    if (host == nullptr) {
+        qFatal("No simulated host on port %u", m_Address.port());
+    }
+
+    bool answers = host->online && m_Address.address() == QLatin1String(SimulatedHosts::REACHABLE_ADDRESS);
+
+    host->requests.append({ m_Address.address(), SimulatedHosts::elapsedMs(), -1, false });
+    auto request = std::make_shared<InFlightRequest>(host, host->requests.size() - 1);
+
+    QTimer::singleShot(answers ? host->latencyMs : SimulatedHosts::UNREACHABLE_TIMEOUT_MS, this,
+                       [host, answers, request, callback]() {
+        NvHttpResult result;
+        if (answers) {
+            result.data = QStringLiteral("<root status_code=\"200\"><hostname>%1</hostname>"
+                                         "<uniqueid>%1</uniqueid><PairStatus>0</PairStatus></root>")
+                              .arg(host->uuid).toUtf8();
+        }
+        else {
+            result.error = std::make_exception_ptr(QtNetworkReplyException(QNetworkReply::TimeoutError, "Request timed out"));
+        }
+
+        request->complete(answers);
+        callback(result);
+    });
+}
+
+void NvHTTP::getAppListAsync(QByteArray, AppListDigestCallback callback)
+{
+    // Simulated hosts are unpaired, so the scheduler never asks
+    NvHttpResult result;
+    result.error = std::make_exception_ptr(QtNetworkReplyException(QNetworkReply::ContentAccessDenied, "Not paired"));
+    callback(result, QVector<NvApp>(), QByteArray());
+}
+
+// ─── NvComputer ───
+
+NvComputer::NvComputer(NvHTTP& http, QString serverInfo)
+{
+    NvXmlIndex serverInfoIndex(serverInfo);
+
+    this->name = serverInfoIndex.value("hostname");
+    this->uuid = serverInfoIndex.value("uniqueid");
+    this->state = CS_ONLINE;
+    this->pairState = PS_NOT_PAIRED;
+    this->activeAddress = http.address();
+    this->activeHttpsPort = 0;
+    this->isNvidiaServerSoftware = false;
+}
+
+bool NvComputer::update(const NvComputer& that)
+{
+    QWriteLocker lock(&this->lock);
+
+    bool changed = state != that.state || pairState != that.pairState || activeAddress != that.activeAddress;
+    state = that.state;
+    pairState = that.pairState;
+    activeAddress = that.activeAddress;
+    return changed;
+}
+
+bool NvComputer::updateAppList(QVector<NvApp> newAppList)
+{
+    appList = newAppList;
+    return true;
+}
+
+QVector<NvAddress> NvComputer::uniqueAddresses() const
+{
+    QReadLocker readLocker(&lock);
+
+    QVector<NvAddress> uniqueAddressList;
+    for (const NvAddress& address : { localAddress, remoteAddress, ipv6Address, manualAddress }) {
+        if (!address.isNull() && !uniqueAddressList.contains(address)) {
+            uniqueAddressList.append(address);
+        }
+    }
+    return uniqueAddressList;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <QString>
+#include <QVector>
+
+// A host answering serverinfo requests on a loopback port. Requests to any
+// address it doesn't answer on time out like an unreachable host would.
+struct SimulatedHost
+{
+    QString uuid;
+    uint16_t port;
+    bool online;
+    int latencyMs;
+
+    // Requests from every poll, in the order they were sent
+    struct Request {
+        QString address;
+        qint64 startMs;
+        qint64 endMs;   // -1 until completed, stays -1 if cancelled
+        bool ok;
+    };
+    QVector<Request> requests;
+
+    int requestsInFlight;
+};
+
+namespace SimulatedHosts
+{
+    // Same as NvHTTP's fast fail timeout for serverinfo polls
+    static constexpr int UNREACHABLE_TIMEOUT_MS = 2000;
+
+    // Hosts answer on this address; anything else is unreachable
+    static constexpr const char* REACHABLE_ADDRESS = "127.0.0.1";
+
+    void add(SimulatedHost* host);
+
+    qint64 elapsedMs();
+
+    // Most hosts that had requests in flight at the same time
+    int maxBusyHosts();
+}
@@ -0,0 +1,93 @@
+// Checks AudioSampleConverter::floatToS16() against a plain scalar
+// conversion and times both on 7.1 frames, the worst case for the ALSA
+// renderer's S16 path.
+//
+// Exits with a non-zero status if any sample differs.
+
+#include "streaming/audio/sampleconverter.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#define CHANNEL_COUNT 8
+#define SAMPLES_PER_FRAME 240
+#define FRAME_COUNT 20000
+
+static void referenceFloatToS16(const float* input, short* output, int sampleCount)
+{
+    for (int i = 0; i < sampleCount; i++) {
+        float sample = input[i] * 32768.0f;
+
+        if (sample >= 32767.0f) {
+            output[i] = 32767;
+        }
+        else if (sample <= -32768.0f) {
+            output[i] = -32768;
+        }
+        else {
+            output[i] = (short)lrintf(sample);
+        }
+    }
+}
+
+template <typename Converter>
+static double timeConversion(Converter convert, const std::vector<float>& input, std::vector<short>& output)
+{
+    const int frameSamples = SAMPLES_PER_FRAME * CHANNEL_COUNT;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < FRAME_COUNT; frame++) {
+        convert(&input[(size_t)(frame % 16) * frameSamples], &output[0], frameSamples);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    return std::chrono::duration<double, std::nano>(elapsed).count() / FRAME_COUNT;
+}
+
+int main(int, char**)
+{
+    const int frameSamples = SAMPLES_PER_FRAME * CHANNEL_COUNT;
+
+    // Odd length so the scalar tail after the SIMD loop is exercised too.
+    // Slightly over full scale, since decoded Opus can overshoot.
+    std::vector<float> input((size_t)frameSamples * 16 + 5);
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> dist(-1.2f, 1.2f);
+    for (float& sample : input) {
+        sample = dist(rng);
+    }
+
+    // Values right at the rounding and clipping boundaries
+    const float edges[] = { 1.0f, -1.0f, 32767.0f / 32768, 32766.5f / 32768,
+                            -32767.5f / 32768, 0.5f / 32768, -0.5f / 32768, 0.0f };
+    for (size_t i = 0; i < sizeof(edges) / sizeof(edges[0]); i++) {
+        input[i] = edges[i];
+    }
+
+    std::vector<short> expected(input.size());
+    std::vector<short> actual(input.size());
+    referenceFloatToS16(input.data(), expected.data(), (int)input.size());
+    AudioSampleConverter::floatToS16(input.data(), actual.data(), (int)input.size());
+
+    int mismatches = 0;
+    for (size_t i = 0; i < input.size(); i++) {
+        if (expected[i] != actual[i]) {
+            if (mismatches < 10) {
+                printf("sample %zu (%.9f): expected %d, got %d\n", i, input[i], expected[i], actual[i]);
+            }
+            mismatches++;
+        }
+    }
+
+    std::vector<short> output(frameSamples);
+    double referenceNs = timeConversion(referenceFloatToS16, input, output);
+    double converterNs = timeConversion(AudioSampleConverter::floatToS16, input, output);
+
+    printf("%d channel frames of %d samples: scalar %.0f ns, converter %.0f ns (%.1fx), %d mismatches\n",
+           CHANNEL_COUNT, SAMPLES_PER_FRAME, referenceNs, converterNs, referenceNs / converterNs, mismatches);
+
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,13 @@
+# Standalone check and benchmark of the float to s16 sample converter.
+# It isn't part of the main build. Built and run from tests.pro, or alone:
+#   qmake && make && ./sampleconvert
+TEMPLATE = app
+TARGET = sampleconvert
+CONFIG += console c++11 testcase
+CONFIG -= qt app_bundle
+
+INCLUDEPATH += $$PWD/../../app
+
+SOURCES += \
+    main.cpp \
+    ../../app/streaming/audio/sampleconverter.cpp
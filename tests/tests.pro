@@ -0,0 +1,16 @@
+# Standalone checks and benchmarks for individual modules of the client.
+# They aren't part of the main build. To build and run them all:
+#   qmake6 tests.pro && make && make check
+TEMPLATE = subdirs
+SUBDIRS = \
+    applist \
+    audiojitter \
+    audiolatency \
+    boxart \
+    hoststore \
+    isostream \
+    keepalive \
+    pollscheduler \
+    sampleconvert \
+    usbipbench \
+    xmlparse
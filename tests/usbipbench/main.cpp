@@ -0,0 +1,216 @@
+// Measures the USB/IP daemon path end to end: a mock VHCI driver imports a
+// simulated bulk device from UsbIpDaemon over loopback TCP, the way the
+// usbip-win2 driver or `usbip attach` would, and keeps a fixed number of
+// URBs in flight against UsbIpExporter. Each run prints URBs per second,
+// payload throughput and the submit to RET_SUBMIT latency percentiles.
+//
+// The simulated device completes URBs on a 1 ms tick, so single URB runs
+// are bounded at about 1000 URB/s; deeper queues show what the daemon and
+// exporter add on top of that.
+//
+// Exits with a non-zero status if the import or any URB fails.
+
+#include "streaming/passthrough/usbipdaemon.h"
+#include "streaming/passthrough/usbipexporter.h"
+
+#include <QCoreApplication>
+#include <QMetaObject>
+#include <QTcpSocket>
+#include <QtEndian>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#define DEVICE_ID 1
+#define RUN_MS 2000
+
+using Clock = std::chrono::steady_clock;
+
+struct Scenario
+{
+    const char* name;
+    bool in;
+    int transferBytes;
+    int queueDepth;
+};
+
+static bool readExact(QTcpSocket& socket, char* buffer, qint64 size)
+{
+    while (size > 0) {
+        if (socket.bytesAvailable() == 0 && !socket.waitForReadyRead(5000)) {
+            return false;
+        }
+        qint64 n = socket.read(buffer, size);
+        if (n < 0) {
+            return false;
+        }
+        buffer += n;
+        size -= n;
+    }
+    return true;
+}
+
+static bool importDevice(QTcpSocket& socket, const QString& busid)
+{
+    QByteArray request(sizeof(UsbIpOpCommon) + sizeof(UsbIpOpImportRequest), 0);
+    auto* common = reinterpret_cast<UsbIpOpCommon*>(request.data());
+    common->version = qToBigEndian(USBIP_VERSION);
+    common->code = qToBigEndian(OP_REQ_IMPORT);
+    QByteArray busidUtf8 = busid.toUtf8();
+    memcpy(request.data() + sizeof(UsbIpOpCommon), busidUtf8.constData(), busidUtf8.size());
+    socket.write(request);
+    socket.flush();
+
+    UsbIpOpCommon reply;
+    UsbIpUsbDevice device;
+    if (!readExact(socket, reinterpret_cast<char*>(&reply), sizeof(reply)) ||
+            qFromBigEndian(reply.status) != USBIP_ST_OK ||
+            !readExact(socket, reinterpret_cast<char*>(&device), sizeof(device))) {
+        printf("FAIL: OP_REQ_IMPORT for %s was refused\n", qPrintable(busid));
+        return false;
+    }
+
+    return true;
+}
+
+static bool runScenario(QTcpSocket& socket, const Scenario& scenario, uint32_t& nextSeqNum)
+{
+    std::unordered_map<uint32_t, Clock::time_point> submitTimes;
+    std::vector<int64_t> latenciesUs;
+    QByteArray outData(scenario.in ? 0 : scenario.transferBytes, 0x5A);
+    QByteArray inData(scenario.transferBytes, 0);
+    uint64_t bytes = 0;
+
+    auto submit = [&]() {
+        UsbIpWireHeader hdr;
+        memset(&hdr, 0, sizeof(hdr));
+        hdr.command = qToBigEndian(USBIP_CMD_SUBMIT);
+        hdr.seqnum = qToBigEndian(nextSeqNum);
+        hdr.devid = qToBigEndian<uint32_t>(DEVICE_ID);
+        hdr.direction = qToBigEndian<uint32_t>(scenario.in ? 1 : 0);
+        hdr.ep = qToBigEndian<uint32_t>(scenario.in ? 1 : 2);
+        hdr.u.cmd_submit.transfer_buffer_length = qToBigEndian<int32_t>(scenario.transferBytes);
+        hdr.u.cmd_submit.number_of_packets = qToBigEndian<int32_t>(-1); // Not ISO, as Linux sends it
+
+        submitTimes[nextSeqNum++] = Clock::now();
+        socket.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+        if (!outData.isEmpty()) {
+            socket.write(outData);
+        }
+        socket.flush();
+    };
+
+    Clock::time_point start = Clock::now();
+    Clock::time_point end = start + std::chrono::milliseconds(RUN_MS);
+
+    for (int i = 0; i < scenario.queueDepth; i++) {
+        submit();
+    }
+
+    while (!submitTimes.empty()) {
+        UsbIpWireHeader hdr;
+        if (!readExact(socket, reinterpret_cast<char*>(&hdr), sizeof(hdr))) {
+            printf("%-28s FAIL: connection lost\n", scenario.name);
+            return false;
+        }
+
+        Clock::time_point now = Clock::now();
+        uint32_t seqNum = qFromBigEndian(hdr.seqnum);
+        int32_t status = qFromBigEndian(hdr.u.ret_submit.status);
+        int32_t actualLength = qFromBigEndian(hdr.u.ret_submit.actual_length);
+        auto it = submitTimes.find(seqNum);
+
+        if (qFromBigEndian(hdr.command) != USBIP_RET_SUBMIT || it == submitTimes.end() ||
+                status != 0 || actualLength != scenario.transferBytes) {
+            printf("%-28s FAIL: URB %u returned status %d with %d bytes\n",
+                   scenario.name, seqNum, status, actualLength);
+            return false;
+        }
+
+        if (scenario.in && !readExact(socket, inData.data(), actualLength)) {
+            printf("%-28s FAIL: connection lost\n", scenario.name);
+            return false;
+        }
+
+        latenciesUs.push_back(std::chrono::duration_cast<std::chrono::microseconds>(now - it->second).count());
+        submitTimes.erase(it);
+        bytes += actualLength;
+
+        if (now < end) {
+            submit();
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    std::sort(latenciesUs.begin(), latenciesUs.end());
+
+    printf("%-28s %7.0f URB/s %8.2f MB/s, latency p50 %lld us, p99 %lld us, max %lld us\n",
+           scenario.name,
+           latenciesUs.size() / seconds,
+           bytes / seconds / 1000000.0,
+           static_cast<long long>(latenciesUs[latenciesUs.size() / 2]),
+           static_cast<long long>(latenciesUs[latenciesUs.size() * 99 / 100]),
+           static_cast<long long>(latenciesUs.back()));
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    qputenv("MLPT_SIMULATED_DEVICES", "bulk");
+    QCoreApplication app(argc, argv);
+
+    UsbIpExporter exporter;
+    exporter.setDeviceId(DEVICE_ID);
+    UsbIpDaemon daemon;
+    if (!exporter.openSimulatedDevice(SimulatedUsbDevice::KIND_BULK) || !daemon.start()) {
+        printf("FAIL: unable to start the daemon\n");
+        return 1;
+    }
+
+    QString busid = UsbIpDaemon::makeBusid(DEVICE_ID);
+    daemon.exportDevice(busid, DEVICE_ID, &exporter);
+
+    static const Scenario scenarios[] = {
+        { "bulk IN 512 B, 1 in flight", true, 512, 1 },
+        { "bulk IN 512 B, 8 in flight", true, 512, 8 },
+        { "bulk IN 64 KiB, 1 in flight", true, 65536, 1 },
+        { "bulk IN 64 KiB, 8 in flight", true, 65536, 8 },
+        { "bulk OUT 64 KiB, 8 in flight", false, 65536, 8 },
+    };
+
+    // The daemon and exporter run on this thread's event loop, like in the
+    // client; the driver side gets a thread of its own
+    bool passed = false;
+    uint16_t port = daemon.port();
+    std::thread vhci([&]() {
+        QTcpSocket socket;
+        socket.connectToHost(QHostAddress::LocalHost, port);
+        socket.setSocketOption(QAbstractSocket::LowDelayOption, 1);
+
+        if (socket.waitForConnected(5000) && importDevice(socket, busid)) {
+            uint32_t nextSeqNum = 1;
+            passed = true;
+            for (const Scenario& scenario : scenarios) {
+                passed = runScenario(socket, scenario, nextSeqNum) && passed;
+            }
+        }
+        else {
+            printf("FAIL: unable to connect to the daemon\n");
+        }
+
+        socket.disconnectFromHost();
+        QMetaObject::invokeMethod(&app, "quit", Qt::QueuedConnection);
+    });
+
+    app.exec();
+    vhci.join();
+
+    daemon.stop();
+    exporter.closeDevice();
+    return passed ? 0 : 1;
+}
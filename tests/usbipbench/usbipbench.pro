@@ -0,0 +1,26 @@
+# Standalone throughput and latency benchmark of UsbIpDaemon and UsbIpExporter
+# over loopback. It isn't part of the main build. Built and run from
+# tests.pro, or alone:
+#   qmake && make && ./usbipbench
+TEMPLATE = app
+TARGET = usbipbench
+QT = core network
+CONFIG += console c++11 testcase
+CONFIG -= app_bundle
+
+CONFIG += link_pkgconfig
+PKGCONFIG += libusb-1.0
+
+INCLUDEPATH += $$PWD/../../app
+
+SOURCES += \
+    main.cpp \
+    ../../app/streaming/passthrough/usbipdaemon.cpp \
+    ../../app/streaming/passthrough/usbipexporter.cpp \
+    ../../app/streaming/passthrough/simulateddevice.cpp \
+    ../../app/streaming/passthrough/isostream.cpp
+
+HEADERS += \
+    ../../app/streaming/passthrough/usbipdaemon.h \
+    ../../app/streaming/passthrough/usbipexporter.h \
+    ../../app/streaming/passthrough/simulateddevice.h
@@ -0,0 +1,195 @@
+// Times the per-poll serverinfo parsing done by NvComputer: the lookups it
+// makes with NvXmlIndex against the previous approach of rescanning the
+// whole response with a new QXmlStreamReader for every tag. The responses
+// have the layout of GeForce Experience and Sunshine serverinfo replies.
+//
+// Exits with a non-zero status if the two approaches disagree on any value.
+
+#include "backend/nvxmlindex.h"
+
+#include <QElapsedTimer>
+#include <QXmlStreamReader>
+
+#include <cstdio>
+
+#define ITERATIONS 20000
+
+// Results of the timed loops go here so the work can't be optimized away
+static volatile int s_Checksum;
+
+// Every tag NvComputer and getCurrentGame() read on each poll
+static const char* const k_PollTags[] = {
+    "hostname", "uniqueid", "mac", "ServerCodecModeSupport", "MaxLumaPixelsHEVC",
+    "LocalIP", "HttpsPort", "ExternalPort", "ExternalIP", "state", "PairStatus",
+    "currentgame", "appversion", "GfeVersion", "gputype",
+};
+
+static const char k_GfeServerInfo[] =
+    "<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+    "<root protocol_version=\"0.1\" query=\"serverinfo\" status_code=\"200\" status_message=\"OK\">"
+    "<hostname>DESKTOP-GAMING</hostname>"
+    "<appversion>7.1.431.-1</appversion>"
+    "<GfeVersion>3.27.0.120</GfeVersion>"
+    "<uniqueid>7C8A1D2B3E4F5A6B</uniqueid>"
+    "<HttpsPort>47984</HttpsPort>"
+    "<ExternalPort>47989</ExternalPort>"
+    "<MaxLumaPixelsHEVC>1869578240</MaxLumaPixelsHEVC>"
+    "<mac>a8:a1:59:12:34:56</mac>"
+    "<Permission>4294967295</Permission>"
+    "<LocalIP>192.168.1.20</LocalIP>"
+    "<ServerCodecModeSupport>3843</ServerCodecModeSupport>"
+    "<SupportedDisplayMode>"
+    "<DisplayMode><Width>3840</Width><Height>2160</Height><RefreshRate>120</RefreshRate></DisplayMode>"
+    "<DisplayMode><Width>3840</Width><Height>2160</Height><RefreshRate>60</RefreshRate></DisplayMode>"
+    "<DisplayMode><Width>2560</Width><Height>1440</Height><RefreshRate>144</RefreshRate></DisplayMode>"
+    "<DisplayMode><Width>2560</Width><Height>1440</Height><RefreshRate>60</RefreshRate></DisplayMode>"
+    "<DisplayMode><Width>1920</Width><Height>1080</Height><RefreshRate>240</RefreshRate></DisplayMode>"
+    "<DisplayMode><Width>1920</Width><Height>1080</Height><RefreshRate>144</RefreshRate></DisplayMode>"
+    "<DisplayMode><Width>1920</Width><Height>1080</Height><RefreshRate>60</RefreshRate></DisplayMode>"
+    "<DisplayMode><Width>1280</Width><Height>720</Height><RefreshRate>60</RefreshRate></DisplayMode>"
+    "</SupportedDisplayMode>"
+    "<PairStatus>1</PairStatus>"
+    "<currentgame>0</currentgame>"
+    "<currentgameuniqueid>0</currentgameuniqueid>"
+    "<state>MJOLNIR_STATE_SERVER_AVAILABLE</state>"
+    "<numofapps>12</numofapps>"
+    "<gputype>NVIDIA GeForce RTX 4080</gputype>"
+    "<ExternalIP>203.0.113.7</ExternalIP>"
+    "</root>";
+
+static const char k_SunshineServerInfo[] =
+    "<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+    "<root status_code=\"200\">"
+    "<hostname>living-room</hostname>"
+    "<appversion>7.1.431.-1</appversion>"
+    "<GfeVersion>3.23.0.74</GfeVersion>"
+    "<uniqueid>0123456789ABCDEF</uniqueid>"
+    "<HttpsPort>47984</HttpsPort>"
+    "<ExternalPort>47989</ExternalPort>"
+    "<MaxLumaPixelsHEVC>1869449984</MaxLumaPixelsHEVC>"
+    "<mac>00:00:00:00:00:00</mac>"
+    "<Permission>4294967295</Permission>"
+    "<LocalIP>192.168.1.30</LocalIP>"
+    "<ServerCodecModeSupport>3841</ServerCodecModeSupport>"
+    "<PairStatus>1</PairStatus>"
+    "<currentgame>1234</currentgame>"
+    "<state>SUNSHINE_SERVER_BUSY</state>"
+    "</root>";
+
+// What NvHTTP::getXmlString() did before NvXmlIndex
+static QString rescanForTag(const QString& xml, const QString& tagName)
+{
+    QXmlStreamReader xmlReader(xml);
+
+    while (!xmlReader.atEnd()) {
+        if (xmlReader.readNext() != QXmlStreamReader::StartElement) {
+            continue;
+        }
+
+        if (xmlReader.name() == tagName) {
+            return xmlReader.readElementText();
+        }
+    }
+
+    return nullptr;
+}
+
+// What NvHTTP::verifyResponseStatus() and getDisplayModeList() scanned for
+static QString rescanForStatus(const QString& xml)
+{
+    QXmlStreamReader xmlReader(xml);
+
+    while (xmlReader.readNextStartElement()) {
+        if (xmlReader.name() == QLatin1String("root")) {
+            return xmlReader.attributes().value("status_code").toString();
+        }
+    }
+
+    return nullptr;
+}
+
+static int rescanForDisplayModes(const QString& xml)
+{
+    QXmlStreamReader xmlReader(xml);
+    int modes = 0;
+
+    while (!xmlReader.atEnd()) {
+        while (xmlReader.readNextStartElement()) {
+            if (xmlReader.name() == QLatin1String("DisplayMode")) {
+                modes++;
+            }
+        }
+    }
+
+    return modes;
+}
+
+static int countDisplayModes(const NvXmlIndex& index)
+{
+    int modes = 0;
+    for (const NvXmlIndex::Element& element : index.elements()) {
+        if (element.name == QLatin1String("DisplayMode")) {
+            modes++;
+        }
+    }
+    return modes;
+}
+
+static bool runSample(const char* name, const QString& xml)
+{
+    int mismatches = 0;
+
+    // Both approaches must see the same response
+    NvXmlIndex index(xml);
+    index.verifyResponseStatus();
+    for (const char* tag : k_PollTags) {
+        QString expected = rescanForTag(xml, tag);
+        QString actual = index.value(tag);
+        if (expected != actual || expected.isNull() != actual.isNull()) {
+            printf("%s: <%s> was '%s', expected '%s'\n", name, tag, qPrintable(actual), qPrintable(expected));
+            mismatches++;
+        }
+    }
+    if (countDisplayModes(index) != rescanForDisplayModes(xml)) {
+        printf("%s: display mode count differs\n", name);
+        mismatches++;
+    }
+
+    int checksum = 0;
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < ITERATIONS; i++) {
+        checksum += rescanForStatus(xml).size();
+        for (const char* tag : k_PollTags) {
+            checksum += rescanForTag(xml, tag).size();
+        }
+        checksum += rescanForDisplayModes(xml);
+    }
+    double rescanUs = timer.nsecsElapsed() / 1000.0 / ITERATIONS;
+
+    timer.restart();
+    for (int i = 0; i < ITERATIONS; i++) {
+        NvXmlIndex pollIndex(xml);
+        pollIndex.verifyResponseStatus();
+        for (const char* tag : k_PollTags) {
+            checksum += pollIndex.value(tag).size();
+        }
+        checksum += countDisplayModes(pollIndex);
+    }
+    double indexUs = timer.nsecsElapsed() / 1000.0 / ITERATIONS;
+
+    s_Checksum = checksum;
+
+    printf("%-20s %5d chars: rescanning %.1f us, index %.1f us per poll (%.1fx), %d mismatches\n",
+           name, xml.size(), rescanUs, indexUs, rescanUs / indexUs, mismatches);
+
+    return mismatches == 0;
+}
+
+int main(int, char**)
+{
+    bool passed = runSample("GFE serverinfo", QString::fromUtf8(k_GfeServerInfo));
+    passed = runSample("Sunshine serverinfo", QString::fromUtf8(k_SunshineServerInfo)) && passed;
+    return passed ? 0 : 1;
+}
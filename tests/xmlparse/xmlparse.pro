@@ -0,0 +1,16 @@
+# Standalone check and benchmark of serverinfo parsing with NvXmlIndex.
+# It isn't part of the main build. Built and run from tests.pro, or alone:
+#   qmake && make && ./xmlparse
+TEMPLATE = app
+TARGET = xmlparse
+QT = core network
+CONFIG += console c++11 testcase
+CONFIG -= app_bundle
+
+INCLUDEPATH += \
+    $$PWD/../../app \
+    $$PWD/../../moonlight-common-c/moonlight-common-c/src
+
+SOURCES += \
+    main.cpp \
+    ../../app/backend/nvxmlindex.cpp